@@ -9,6 +9,7 @@
 #include "avogadrocore.h"
 
 #include <algorithm>
+#include <atomic>
 #include <vector>
 
 namespace Avogadro {
@@ -57,22 +58,20 @@ public:
   {
   }
 
-  // Increment the reference count.
-  void reref() { ++m_ref; }
+  // Increment the reference count. Only an existing reference can add one,
+  // so no ordering is needed.
+  void reref() { m_ref.fetch_add(1, std::memory_order_relaxed); }
 
   // Decrement the reference count, return true unless the reference count has
   // dropped to zero. When it returns false, this object should be deleted.
-  bool deref()
-  {
-    if (m_ref)
-      --m_ref;
-    return m_ref > 0;
-  }
+  // Releasing orders all reads of the data by this owner before the deletion
+  // or the in place modification by the last one.
+  bool deref() { return m_ref.fetch_sub(1, std::memory_order_acq_rel) != 1; }
 
-  unsigned int ref() const { return m_ref; }
+  unsigned int ref() const { return m_ref.load(std::memory_order_acquire); }
 
   // Reference count
-  unsigned int m_ref;
+  std::atomic<unsigned int> m_ref;
   // Container for our data
   std::vector<T> data;
 };
@@ -91,6 +90,12 @@ public:
  * non-const function will trigger a detach call. This is a no-op when the
  * reference count is 1, and will perform a deep copy when the reference count
  * is greater than 1.
+ *
+ * The reference count is atomic, so copies sharing the same data can be used
+ * and modified on different threads, e.g. a copy of the atom positions handed
+ * to a worker while the molecule keeps changing. As with the standard
+ * containers, one Array object must not be modified on one thread while it is
+ * read or copied on another.
  */
 template <typename T>
 class Array
@@ -323,9 +328,11 @@ public:
 
   Array& operator=(const Array& v)
   {
-    if (this != &v) {
-      detach();
-      d->data = v.d->data;
+    if (d != v.d) {
+      v.d->reref();
+      if (d && !d->deref())
+        delete d;
+      d = v.d;
     }
     return *this;
   }
@@ -351,8 +358,11 @@ template <typename T>
 inline void Array<T>::detachWithCopy()
 {
   if (d && d->ref() != 1) {
+    // The other owners may have let go in the meantime, in which case the
+    // old container is ours to delete.
     Container* o = new Container(*d);
-    d->deref();
+    if (!d->deref())
+      delete d;
     d = o;
   }
 }
@@ -361,7 +371,8 @@ template <typename T>
 inline void Array<T>::detach()
 {
   if (d && d->ref() != 1) {
-    d->deref();
+    if (!d->deref())
+      delete d;
     d = new Container;
   }
 }
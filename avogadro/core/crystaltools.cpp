@@ -20,7 +20,9 @@
 #include "unitcell.h"
 
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <vector>
 
 namespace Avogadro {
 namespace Core {
@@ -34,6 +36,19 @@ struct WrapAtomsToCellFunctor
 
   void operator()(Vector3& pos) { unitCell.wrapCartesian(pos, pos); }
 };
+
+// Repeat the per atom (or per bond) values in @a array for each subcell of a
+// supercell, if the array holds a value for every atom.
+template <typename T>
+void replicateAtomData(Array<T>& array, Index numAtoms, Index images)
+{
+  if (numAtoms == 0 || array.size() != numAtoms)
+    return;
+  const Array<T> original(array);
+  array.reserve(numAtoms * images);
+  for (Index image = 1; image < images; ++image)
+    array.insert(array.end(), original.begin(), original.end());
+}
 }
 
 bool CrystalTools::wrapAtomsToUnitCell(Molecule& molecule)
@@ -568,25 +583,106 @@ bool CrystalTools::buildSupercell(Molecule& molecule, unsigned int a,
   Vector3 newB = oldB * b;
   Vector3 newC = oldC * c;
 
-  // Add in the atoms to the new subcells of the supercell
   Index numAtoms = molecule.atomCount();
-  Array<Vector3> atoms = molecule.atomPositions3d();
-  Array<unsigned char> atomicNums = molecule.atomicNumbers();
+  const Array<Vector3>& positions = molecule.atomPositions3d();
+  if (positions.size() != numAtoms)
+    return false;
+
+  // The offsets of the subcells, the first one is the existing cell.
+  const Index images = static_cast<Index>(a) * b * c;
+  std::vector<Vector3> displacements;
+  displacements.reserve(images);
   for (Index ind_a = 0; ind_a < a; ++ind_a) {
     for (Index ind_b = 0; ind_b < b; ++ind_b) {
-      for (Index ind_c = 0; ind_c < c; ++ind_c) {
-        // Skip over the subcell that already exists
-        if (ind_a == 0 && ind_b == 0 && ind_c == 0)
-          continue;
-        // The positions of the new atoms are displacements of the old atoms
-        Vector3 displacement = ind_a * oldA + ind_b * oldB + ind_c * oldC;
-        for (Index i = 0; i < numAtoms; ++i) {
-          Atom newAtom = molecule.addAtom(atomicNums.at(i));
-          newAtom.setPosition3d(atoms.at(i) + displacement);
-        }
+      for (Index ind_c = 0; ind_c < c; ++ind_c)
+        displacements.push_back(ind_a * oldA + ind_b * oldB + ind_c * oldC);
+    }
+  }
+
+  // Bonds that cross the cell boundary connect to the atom in a neighboring
+  // subcell, find the lattice translation of the bonded image of each bond.
+  const UnitCell& cell = *molecule.unitCell();
+  const Array<std::pair<Index, Index>> bondPairs = molecule.bondPairs();
+  const Array<unsigned char> bondOrders = molecule.bondOrders();
+  std::vector<Vector3i> bondShifts(bondPairs.size());
+  for (Index bond = 0; bond < bondPairs.size(); ++bond) {
+    Vector3 delta = cell.toFractional(positions[bondPairs[bond].second]) -
+                    cell.toFractional(positions[bondPairs[bond].first]);
+    for (int i = 0; i < 3; ++i)
+      bondShifts[bond][i] = -static_cast<int>(std::floor(delta[i] + 0.5));
+  }
+
+  // Add in the atoms to the new subcells of the supercell, in one step.
+  Array<unsigned char> newAtomicNums;
+  Array<Vector3> newPositions(numAtoms * (images - 1));
+  newAtomicNums.reserve(numAtoms * (images - 1));
+  const Array<unsigned char>& atomicNums = molecule.atomicNumbers();
+  for (Index image = 1; image < images; ++image) {
+    // The positions of the new atoms are displacements of the old atoms
+    const Vector3& displacement = displacements[image];
+    Vector3* newPos = &newPositions[(image - 1) * numAtoms];
+    for (Index i = 0; i < numAtoms; ++i)
+      newPos[i] = positions[i] + displacement;
+    newAtomicNums.insert(newAtomicNums.end(), atomicNums.begin(),
+                         atomicNums.end());
+  }
+  replicateAtomData(molecule.hybridizations(), numAtoms, images);
+  replicateAtomData(molecule.formalCharges(), numAtoms, images);
+  replicateAtomData(molecule.colors(), numAtoms, images);
+  molecule.addAtoms(newAtomicNums, newPositions);
+
+  // addAtoms() padded the named property columns with zeros, repeat them too.
+  const std::vector<std::string> atomPropertyNames =
+    molecule.atomPropertyNames();
+  for (size_t i = 0; i < atomPropertyNames.size(); ++i) {
+    Array<Real> values = molecule.atomProperty(atomPropertyNames[i]);
+    values.resize(numAtoms);
+    replicateAtomData(values, numAtoms, images);
+    molecule.setAtomProperty(atomPropertyNames[i], values);
+  }
+
+  // Copy the bonds into every subcell, connecting bonds that cross the cell
+  // boundary to the neighboring subcell. The supercell is periodic, so the
+  // neighbor of the last subcell is the first one.
+  Array<std::pair<Index, Index>> newBondPairs;
+  Array<unsigned char> newBondOrders;
+  newBondPairs.reserve(bondPairs.size() * (images - 1));
+  newBondOrders.reserve(bondPairs.size() * (images - 1));
+  const Vector3i dims(a, b, c);
+  for (Index image = 0; image < images; ++image) {
+    const Vector3i index(static_cast<int>(image / (b * c)),
+                         static_cast<int>((image / c) % b),
+                         static_cast<int>(image % c));
+    for (Index bond = 0; bond < bondPairs.size(); ++bond) {
+      Vector3i other = index + bondShifts[bond];
+      for (int i = 0; i < 3; ++i)
+        other[i] = (other[i] % dims[i] + dims[i]) % dims[i];
+      Index otherImage = (static_cast<Index>(other[0]) * b + other[1]) * c +
+                         static_cast<Index>(other[2]);
+      std::pair<Index, Index> pair(image * numAtoms + bondPairs[bond].first,
+                                   otherImage * numAtoms +
+                                     bondPairs[bond].second);
+      if (pair.first > pair.second)
+        std::swap(pair.first, pair.second);
+      if (image == 0) {
+        molecule.setBondPair(bond, pair);
+      } else {
+        newBondPairs.push_back(pair);
+        newBondOrders.push_back(bondOrders[bond]);
       }
     }
   }
+  molecule.addBonds(newBondPairs, newBondOrders);
+
+  // The bonds of each subcell follow in the same order as those of the first.
+  const std::vector<std::string> bondPropertyNames =
+    molecule.bondPropertyNames();
+  for (size_t i = 0; i < bondPropertyNames.size(); ++i) {
+    Array<Real> values = molecule.bondProperty(bondPropertyNames[i]);
+    values.resize(bondPairs.size());
+    replicateAtomData(values, bondPairs.size(), images);
+    molecule.setBondProperty(bondPropertyNames[i], values);
+  }
 
   // Now set the unit cell
   molecule.unitCell()->setAVector(newA);
@@ -103,9 +103,11 @@ public:
   static bool isNiggliReduced(const Molecule& mol);
 
   /**
-   * Build a supercell by expanding upon the unit cell of @a molecule. It will
-   * only return false if the molecule does not have a unit cell or if a, b, or
-   * c is set to zero.
+   * Build a supercell by expanding upon the unit cell of @a molecule. The
+   * atoms are added in bulk, and the bonds are copied into every subcell.
+   * Bonds that cross the cell boundary connect neighboring subcells, wrapping
+   * around the supercell. It will only return false if the molecule does not
+   * have a unit cell or 3D coordinates, or if a, b, or c is set to zero.
    * @param a The number of units along lattice vector a for the supercell
    * @param b The number of units along lattice vector b for the supercell
    * @param c The number of units along lattice vector c for the supercell
@@ -30,6 +30,14 @@ Cube::Cube()
 {
 }
 
+Cube::Cube(const Cube& other)
+  : m_data(other.m_data), m_min(other.m_min), m_max(other.m_max),
+    m_spacing(other.m_spacing), m_points(other.m_points),
+    m_minValue(other.m_minValue), m_maxValue(other.m_maxValue),
+    m_name(other.m_name), m_cubeType(other.m_cubeType), m_lock(new Mutex)
+{
+}
+
 Cube::~Cube()
 {
   delete m_lock;
@@ -290,5 +298,22 @@ bool Cube::setValue(int i, int j, int k, double value_)
   }
 }
 
+Cube& Cube::operator=(const Cube& other)
+{
+  if (this != &other) {
+    m_data = other.m_data;
+    m_min = other.m_min;
+    m_max = other.m_max;
+    m_spacing = other.m_spacing;
+    m_points = other.m_points;
+    m_minValue = other.m_minValue;
+    m_maxValue = other.m_maxValue;
+    m_name = other.m_name;
+    m_cubeType = other.m_cubeType;
+  }
+
+  return *this;
+}
+
 } // End Core namespace
 } // End Avogadro namespace
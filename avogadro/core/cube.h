@@ -40,8 +40,19 @@ class AVOGADROCORE_EXPORT Cube
 {
 public:
   Cube();
+
+  /**
+   * Copy constructor, the copy gets its own lock.
+   */
+  Cube(const Cube& other);
+
   ~Cube();
 
+  /**
+   * Assignment operator, copies the data but not the lock.
+   */
+  Cube& operator=(const Cube& other);
+
   /**
    * \enum Type
    * Different Cube types relating to the data
@@ -21,6 +21,7 @@
 #include "cube.h"
 #include "gaussianset.h"
 #include "molecule.h"
+#include "moleculesnapshot.h"
 
 #include <iostream>
 
@@ -38,6 +39,22 @@ GaussianSetTools::GaussianSetTools(Molecule* mol) : m_molecule(mol)
     m_basis = dynamic_cast<GaussianSet*>(m_molecule->basisSet());
 }
 
+GaussianSetTools::GaussianSetTools(const MoleculeSnapshot& snapshot)
+  : m_molecule(nullptr), m_positions(snapshot.atomPositions3d())
+{
+  const GaussianSet* basis =
+    dynamic_cast<const GaussianSet*>(snapshot.basisSet());
+  if (m_positions.empty())
+    m_positions.resize(snapshot.atomCount(), Vector3::Zero());
+  if (basis) {
+    // The set is initialized lazily, which writes to it, so the tools keep a
+    // copy they can initialize before any calculation starts.
+    m_ownBasis.reset(basis->clone());
+    m_ownBasis->initCalculation();
+    m_basis = m_ownBasis.get();
+  }
+}
+
 GaussianSetTools::~GaussianSetTools()
 {
 }
@@ -136,7 +153,9 @@ double GaussianSetTools::calculateSpinDensity(const Vector3& position) const
 
 bool GaussianSetTools::isValid() const
 {
-  if (m_molecule && dynamic_cast<GaussianSet*>(m_molecule->basisSet()))
+  if (!m_molecule)
+    return m_basis != nullptr;
+  if (dynamic_cast<GaussianSet*>(m_molecule->basisSet()))
     return true;
   else
     return false;
@@ -150,11 +169,19 @@ inline bool GaussianSetTools::isSmall(double val) const
     return false;
 }
 
+inline const Array<Vector3>& GaussianSetTools::atomPositions() const
+{
+  // The const overload, the non-const one would detach shared positions.
+  const Molecule* molecule = m_molecule;
+  return molecule ? molecule->atomPositions3d() : m_positions;
+}
+
 inline vector<double> GaussianSetTools::calculateValues(
   const Vector3& position) const
 {
   m_basis->initCalculation();
-  Index atomsSize = m_molecule->atomCount();
+  const Array<Vector3>& positions = atomPositions();
+  Index atomsSize = m_molecule ? m_molecule->atomCount() : positions.size();
   size_t basisSize = m_basis->symmetry().size();
   const std::vector<int>& basis = m_basis->symmetry();
   const std::vector<unsigned int>& atomIndices = m_basis->atomIndices();
@@ -168,8 +195,8 @@ inline vector<double> GaussianSetTools::calculateValues(
 
   // Calculate the deltas for the position
   for (Index i = 0; i < atomsSize; ++i) {
-    deltas.push_back(pos -
-                     (m_molecule->atom(i).position3d() * ANGSTROM_TO_BOHR));
+    Vector3 atomPosition = positions.empty() ? Vector3::Zero() : positions[i];
+    deltas.push_back(pos - (atomPosition * ANGSTROM_TO_BOHR));
     dr2.push_back(deltas[i].squaredNorm());
   }
 
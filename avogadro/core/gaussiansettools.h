@@ -21,9 +21,11 @@
 
 #include "avogadrocore.h"
 
+#include "array.h"
 #include "basisset.h"
 #include "vector.h"
 
+#include <memory>
 #include <vector>
 
 namespace Avogadro {
@@ -32,6 +34,7 @@ namespace Core {
 class Cube;
 class GaussianSet;
 class Molecule;
+class MoleculeSnapshot;
 
 /**
  * @class GaussianSetTools gaussiansettools.h <avogadro/core/gaussiansettools.h>
@@ -44,6 +47,13 @@ class AVOGADROCORE_EXPORT GaussianSetTools
 {
 public:
   explicit GaussianSetTools(Molecule* mol = 0);
+
+  /**
+   * @brief Calculate from a snapshot of a molecule. The tools keep their own
+   * copy of the basis set and the atom positions, so they can be used on other
+   * threads while the molecule is edited.
+   */
+  explicit GaussianSetTools(const MoleculeSnapshot& snapshot);
   ~GaussianSetTools();
 
   /**
@@ -108,11 +118,18 @@ public:
 
 private:
   Molecule* m_molecule;
-  GaussianSet* m_basis;
+  GaussianSet* m_basis = nullptr;
   BasisSet::ElectronType m_type = BasisSet::Paired;
 
+  // Only set when constructed from a snapshot.
+  std::unique_ptr<GaussianSet> m_ownBasis;
+  Array<Vector3> m_positions;
+
   bool isSmall(double value) const;
 
+  /** The atom positions, from the molecule or the snapshot. */
+  const Array<Vector3>& atomPositions() const;
+
   /**
    * @brief Calculate the values at this position in space. The public calculate
    * functions call this function to prepare values before multiplying by the
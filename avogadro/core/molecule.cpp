@@ -21,6 +21,7 @@
 #include "cube.h"
 #include "elements.h"
 #include "mesh.h"
+#include "neighborlist.h"
 #include "residue.h"
 #include "unitcell.h"
 
@@ -30,9 +31,7 @@
 namespace Avogadro {
 namespace Core {
 
-Molecule::Molecule()
-  : m_graphDirty(false), m_basisSet(nullptr), m_unitCell(nullptr)
-{}
+Molecule::Molecule() : m_graphDirty(false), m_unitCell(nullptr) {}
 
 Molecule::Molecule(const Molecule& other)
   : m_graph(other.m_graph), m_graphDirty(true), m_data(other.m_data),
@@ -44,8 +43,12 @@ Molecule::Molecule(const Molecule& other)
     m_vibrationFrequencies(other.m_vibrationFrequencies),
     m_vibrationIntensities(other.m_vibrationIntensities),
     m_vibrationLx(other.m_vibrationLx), m_bondPairs(other.m_bondPairs),
-    m_bondOrders(other.m_bondOrders), m_selectedAtoms(other.m_selectedAtoms),
-    m_meshes(std::vector<Mesh*>()), m_cubes(std::vector<Cube*>()),
+    m_bondOrders(other.m_bondOrders),
+    m_atomProperties(other.m_atomProperties),
+    m_bondProperties(other.m_bondProperties),
+    m_selectedAtoms(other.m_selectedAtoms),
+    m_selectedBonds(other.m_selectedBonds),
+    m_meshes(std::vector<Mesh*>()),
     m_basisSet(other.m_basisSet ? other.m_basisSet->clone() : nullptr),
     m_unitCell(other.m_unitCell ? new UnitCell(*other.m_unitCell) : nullptr),
     m_residues(other.m_residues)
@@ -57,10 +60,8 @@ Molecule::Molecule(const Molecule& other)
   }
 
   // Copy over any cubes
-  for (Index i = 0; i < other.cubeCount(); ++i) {
-    Cube* c = addCube();
-    *c = *other.cube(i);
-  }
+  for (Index i = 0; i < other.cubeCount(); ++i)
+    m_cubes.push_back(std::make_shared<Cube>(*other.m_cubes[i]));
 }
 
 Molecule::Molecule(Molecule&& other) noexcept
@@ -81,13 +82,15 @@ Molecule::Molecule(Molecule&& other) noexcept
     m_vibrationLx(std::move(other.m_vibrationLx)),
     m_bondPairs(std::move(other.m_bondPairs)),
     m_bondOrders(std::move(other.m_bondOrders)),
+    m_atomProperties(std::move(other.m_atomProperties)),
+    m_bondProperties(std::move(other.m_bondProperties)),
     m_selectedAtoms(std::move(other.m_selectedAtoms)),
+    m_selectedBonds(std::move(other.m_selectedBonds)),
     m_meshes(std::move(other.m_meshes)), m_cubes(std::move(other.m_cubes)),
+    m_basisSet(std::move(other.m_basisSet)),
+    m_snapshotBasisSet(std::move(other.m_snapshotBasisSet)),
     m_residues(std::move(other.m_residues))
 {
-  m_basisSet = other.m_basisSet;
-  other.m_basisSet = nullptr;
-
   m_unitCell = other.m_unitCell;
   other.m_unitCell = nullptr;
 }
@@ -112,7 +115,10 @@ Molecule& Molecule::operator=(const Molecule& other)
     m_vibrationLx = other.m_vibrationLx;
     m_bondPairs = other.m_bondPairs;
     m_bondOrders = other.m_bondOrders;
+    m_atomProperties = other.m_atomProperties;
+    m_bondProperties = other.m_bondProperties;
     m_selectedAtoms = other.m_selectedAtoms;
+    m_selectedBonds = other.m_selectedBonds;
     m_residues = other.m_residues;
 
     clearMeshes();
@@ -126,13 +132,11 @@ Molecule& Molecule::operator=(const Molecule& other)
     clearCubes();
 
     // Copy over any cubes
-    for (Index i = 0; i < other.cubeCount(); ++i) {
-      Cube* c = addCube();
-      *c = *other.cube(i);
-    }
+    for (Index i = 0; i < other.cubeCount(); ++i)
+      m_cubes.push_back(std::make_shared<Cube>(*other.m_cubes[i]));
 
-    delete m_basisSet;
-    m_basisSet = other.m_basisSet ? other.m_basisSet->clone() : nullptr;
+    m_basisSet.reset(other.m_basisSet ? other.m_basisSet->clone() : nullptr);
+    m_snapshotBasisSet.reset();
     delete m_unitCell;
     m_unitCell = other.m_unitCell ? new UnitCell(*other.m_unitCell) : nullptr;
   }
@@ -160,18 +164,18 @@ Molecule& Molecule::operator=(Molecule&& other) noexcept
     m_vibrationLx = std::move(other.m_vibrationLx);
     m_bondPairs = std::move(other.m_bondPairs);
     m_bondOrders = std::move(other.m_bondOrders);
+    m_atomProperties = std::move(other.m_atomProperties);
+    m_bondProperties = std::move(other.m_bondProperties);
     m_selectedAtoms = std::move(other.m_selectedAtoms);
+    m_selectedBonds = std::move(other.m_selectedBonds);
     m_residues = std::move(other.m_residues);
 
     clearMeshes();
     m_meshes = std::move(other.m_meshes);
 
-    clearCubes();
     m_cubes = std::move(other.m_cubes);
-
-    delete m_basisSet;
-    m_basisSet = other.m_basisSet;
-    other.m_basisSet = nullptr;
+    m_basisSet = std::move(other.m_basisSet);
+    m_snapshotBasisSet = std::move(other.m_snapshotBasisSet);
 
     delete m_unitCell;
     m_unitCell = other.m_unitCell;
@@ -183,10 +187,41 @@ Molecule& Molecule::operator=(Molecule&& other) noexcept
 
 Molecule::~Molecule()
 {
-  delete m_basisSet;
   delete m_unitCell;
   clearMeshes();
+}
+
+void Molecule::clear()
+{
+  m_graph.clear();
+  m_graphDirty = false;
+  m_data.clear();
+  m_customElementMap.clear();
+  m_atomicNumbers.clear();
+  m_positions2d.clear();
+  m_positions3d.clear();
+  m_coordinates3d.clear();
+  m_timesteps.clear();
+  m_hybridizations.clear();
+  m_formalCharges.clear();
+  m_forceVectors.clear();
+  m_colors.clear();
+  m_vibrationFrequencies.clear();
+  m_vibrationIntensities.clear();
+  m_vibrationLx.clear();
+  m_bondPairs.clear();
+  m_bondOrders.clear();
+  m_atomProperties.clear();
+  m_bondProperties.clear();
+  m_selectedAtoms.clear();
+  m_selectedBonds.clear();
+  clearMeshes();
   clearCubes();
+  m_basisSet.reset();
+  m_snapshotBasisSet.reset();
+  delete m_unitCell;
+  m_unitCell = nullptr;
+  m_residues.clear();
 }
 
 void Molecule::setData(const std::string& name, const Variant& value)
@@ -339,10 +374,34 @@ Molecule::AtomType Molecule::addAtom(unsigned char number)
 
   // Add the atomic number.
   m_atomicNumbers.push_back(number);
+  resizeProperties(m_atomProperties, atomCount());
 
   return AtomType(this, static_cast<Index>(m_atomicNumbers.size() - 1));
 }
 
+Index Molecule::addAtoms(const Array<unsigned char>& atomicNumbers,
+                         const Array<Vector3>& positions)
+{
+  Index first = atomCount();
+  if (atomicNumbers.empty())
+    return first;
+  assert(positions.empty() || positions.size() == atomicNumbers.size());
+
+  // Mark the graph as dirty.
+  m_graphDirty = true;
+
+  m_atomicNumbers.insert(m_atomicNumbers.end(), atomicNumbers.begin(),
+                         atomicNumbers.end());
+  if (!positions.empty()) {
+    m_positions3d.reserve(m_atomicNumbers.size());
+    m_positions3d.resize(first, Vector3::Zero());
+    m_positions3d.insert(m_positions3d.end(), positions.begin(),
+                         positions.end());
+  }
+  resizeProperties(m_atomProperties, atomCount());
+  return first;
+}
+
 bool Molecule::removeAtom(Index index)
 {
   if (index >= atomCount())
@@ -394,6 +453,8 @@ bool Molecule::removeAtom(Index index)
     m_formalCharges.pop_back();
   if (m_colors.size() == m_atomicNumbers.size())
     m_colors.pop_back();
+  removePropertyRow(m_atomProperties, index);
+  m_selectedAtoms.swapRemove(index, newSize);
   m_atomicNumbers.pop_back();
 
   return true;
@@ -468,6 +529,7 @@ Molecule::BondType Molecule::addBond(Index atom1, Index atom2,
   m_graphDirty = true;
   m_bondPairs.push_back(makeBondPair(atom1, atom2));
   m_bondOrders.push_back(order);
+  resizeProperties(m_bondProperties, bondCount());
 
   return BondType(this, bondCount() - 1);
 }
@@ -481,6 +543,27 @@ Molecule::BondType Molecule::addBond(const AtomType& a, const AtomType& b,
   return addBond(a.index(), b.index(), order);
 }
 
+Index Molecule::addBonds(const Array<std::pair<Index, Index>>& pairs,
+                         const Array<unsigned char>& orders)
+{
+  assert(pairs.size() == orders.size());
+  Index first = bondCount();
+  if (pairs.empty())
+    return first;
+
+  m_graphDirty = true;
+  m_bondPairs.reserve(m_bondPairs.size() + pairs.size());
+  for (Array<std::pair<Index, Index>>::const_iterator it = pairs.begin(),
+                                                      itEnd = pairs.end();
+       it != itEnd; ++it) {
+    assert(it->first < atomCount() && it->second < atomCount());
+    m_bondPairs.push_back(makeBondPair(it->first, it->second));
+  }
+  m_bondOrders.insert(m_bondOrders.end(), orders.begin(), orders.end());
+  resizeProperties(m_bondProperties, bondCount());
+  return first;
+}
+
 bool Molecule::removeBond(Index index)
 {
   if (index >= bondCount())
@@ -493,6 +576,8 @@ bool Molecule::removeBond(Index index)
   }
   m_bondOrders.pop_back();
   m_bondPairs.pop_back();
+  removePropertyRow(m_bondProperties, index);
+  m_selectedBonds.swapRemove(index, newSize);
   return true;
 }
 
@@ -606,32 +691,61 @@ void Molecule::clearMeshes()
 
 Cube* Molecule::addCube()
 {
-  m_cubes.push_back(new Cube);
-  return m_cubes.back();
+  m_cubes.push_back(std::make_shared<Cube>());
+  return m_cubes.back().get();
 }
 
 Cube* Molecule::cube(Index index)
 {
-  if (index < static_cast<Index>(m_cubes.size()))
-    return m_cubes[index];
-  else
+  if (index >= static_cast<Index>(m_cubes.size()))
     return nullptr;
+  // Only a snapshot can hold another reference, it keeps the old cube.
+  if (m_cubes[index].use_count() > 1)
+    m_cubes[index] = std::make_shared<Cube>(*m_cubes[index]);
+  return m_cubes[index].get();
 }
 
 const Cube* Molecule::cube(Index index) const
 {
   if (index < static_cast<Index>(m_cubes.size()))
-    return m_cubes[index];
+    return m_cubes[index].get();
   else
     return nullptr;
 }
 
 void Molecule::clearCubes()
 {
-  while (!m_cubes.empty()) {
-    delete m_cubes.back();
-    m_cubes.pop_back();
-  }
+  m_cubes.clear();
+}
+
+std::vector<Cube*> Molecule::cubes()
+{
+  std::vector<Cube*> result;
+  for (Index i = 0; i < cubeCount(); ++i)
+    result.push_back(cube(i));
+  return result;
+}
+
+std::vector<const Cube*> Molecule::cubes() const
+{
+  std::vector<const Cube*> result;
+  for (size_t i = 0; i < m_cubes.size(); ++i)
+    result.push_back(m_cubes[i].get());
+  return result;
+}
+
+void Molecule::setBasisSet(BasisSet* basis)
+{
+  if (basis != m_basisSet.get())
+    m_basisSet.reset(basis);
+  m_snapshotBasisSet.reset();
+}
+
+BasisSet* Molecule::basisSet()
+{
+  // The caller may change the basis set, the next snapshot needs a new copy.
+  m_snapshotBasisSet.reset();
+  return m_basisSet.get();
 }
 
 std::string Molecule::formula(const std::string& delimiter, int over) const
@@ -764,28 +878,39 @@ void Molecule::perceiveBondsSimple(const double tolerance, const double min)
 
   // cache atomic radii
   std::vector<double> radii(atomCount());
+  double maxRadius = 0.0;
   for (size_t i = 0; i < radii.size(); i++) {
     radii[i] = Elements::radiusCovalent(m_atomicNumbers[i]);
     if (radii[i] <= 0.0)
       radii[i] = 2.0;
+    maxRadius = std::max(maxRadius, radii[i]);
   }
 
+  // only visit the atoms close enough to bond
+  NeighborList neighbors;
+  neighbors.build(m_positions3d, 2.0 * maxRadius + tolerance);
+
   // check for bonds
+  std::vector<Index> partners;
   for (Index i = 0; i < atomCount(); i++) {
-    Vector3 ipos = m_positions3d[i];
-    for (Index j = i + 1; j < atomCount(); j++) {
-      double cutoff = radii[i] + radii[j] + tolerance;
-      Vector3 jpos = m_positions3d[j];
-      Vector3 diff = jpos - ipos;
-
-      if (std::fabs(diff[0]) > cutoff || std::fabs(diff[1]) > cutoff ||
-          std::fabs(diff[2]) > cutoff ||
-          (m_atomicNumbers[i] == 1 && m_atomicNumbers[j] == 1))
+    partners.clear();
+    neighbors.forEachNeighbor(
+      m_positions3d[i], radii[i] + maxRadius + tolerance,
+      [i, &partners](Index j, Real) {
+        if (j > i)
+          partners.push_back(j);
+      });
+    std::sort(partners.begin(), partners.end());
+
+    for (size_t p = 0; p < partners.size(); ++p) {
+      Index j = partners[p];
+      if (m_atomicNumbers[i] == 1 && m_atomicNumbers[j] == 1)
         continue;
 
       // check radius and add bond if needed
+      double cutoff = radii[i] + radii[j] + tolerance;
       double cutoffSq = cutoff * cutoff;
-      double diffsq = diff.squaredNorm();
+      double diffsq = (m_positions3d[j] - m_positions3d[i]).squaredNorm();
       if (diffsq < cutoffSq && diffsq > min * min)
         addBond(atom(i), atom(j), 1);
     }
@@ -799,7 +924,7 @@ void Molecule::perceiveBondsFromResidueData()
   }
 }
 
-int Molecule::coordinate3dCount()
+int Molecule::coordinate3dCount() const
 {
   return static_cast<int>(m_coordinates3d.size());
 }
@@ -818,6 +943,13 @@ Array<Vector3> Molecule::coordinate3d(int index) const
   return m_coordinates3d[index];
 }
 
+Array<Vector3>* Molecule::coordinate3dArray(int index)
+{
+  if (index < 0 || index >= coordinate3dCount())
+    return nullptr;
+  return &m_coordinates3d[index];
+}
+
 bool Molecule::setCoordinate3d(const Array<Vector3>& coords, int index)
 {
   if (static_cast<int>(m_coordinates3d.size()) <= index)
@@ -867,6 +999,153 @@ const Array<Vector3>& Molecule::forceVectors() const
   return m_forceVectors;
 }
 
+namespace {
+typedef Molecule::PropertyMap Properties;
+
+const Array<Real>& findProperty(const Properties& properties,
+                                const std::string& name)
+{
+  static const Array<Real> empty;
+  Properties::const_iterator it = properties.find(name);
+  return it != properties.end() ? it->second : empty;
+}
+
+Real propertyValue(const Properties& properties, Index index,
+                   const std::string& name)
+{
+  const Array<Real>& values = findProperty(properties, name);
+  return index < values.size() ? values[index] : Real(0);
+}
+
+void setPropertyValue(Properties& properties, Index index, Index size,
+                      const std::string& name, Real value)
+{
+  Array<Real>& values = properties[name];
+  if (values.size() != size)
+    values.resize(size, Real(0));
+  values[index] = value;
+}
+
+std::vector<std::string> propertyNames(const Properties& properties)
+{
+  std::vector<std::string> names;
+  names.reserve(properties.size());
+  for (Properties::const_iterator it = properties.begin(),
+                                  itEnd = properties.end();
+       it != itEnd; ++it) {
+    names.push_back(it->first);
+  }
+  return names;
+}
+} // namespace
+
+bool Molecule::hasAtomProperty(const std::string& name) const
+{
+  return m_atomProperties.find(name) != m_atomProperties.end();
+}
+
+const Array<Real>& Molecule::atomProperty(const std::string& name) const
+{
+  return findProperty(m_atomProperties, name);
+}
+
+Real Molecule::atomProperty(Index atomId, const std::string& name) const
+{
+  return propertyValue(m_atomProperties, atomId, name);
+}
+
+bool Molecule::setAtomProperty(const std::string& name,
+                               const Array<Real>& values)
+{
+  if (values.size() != atomCount())
+    return false;
+  m_atomProperties[name] = values;
+  return true;
+}
+
+bool Molecule::setAtomProperty(Index atomId, const std::string& name,
+                               Real value)
+{
+  if (atomId >= atomCount())
+    return false;
+  setPropertyValue(m_atomProperties, atomId, atomCount(), name, value);
+  return true;
+}
+
+void Molecule::removeAtomProperty(const std::string& name)
+{
+  m_atomProperties.erase(name);
+}
+
+std::vector<std::string> Molecule::atomPropertyNames() const
+{
+  return propertyNames(m_atomProperties);
+}
+
+bool Molecule::hasBondProperty(const std::string& name) const
+{
+  return m_bondProperties.find(name) != m_bondProperties.end();
+}
+
+const Array<Real>& Molecule::bondProperty(const std::string& name) const
+{
+  return findProperty(m_bondProperties, name);
+}
+
+Real Molecule::bondProperty(Index bondId, const std::string& name) const
+{
+  return propertyValue(m_bondProperties, bondId, name);
+}
+
+bool Molecule::setBondProperty(const std::string& name,
+                               const Array<Real>& values)
+{
+  if (values.size() != bondCount())
+    return false;
+  m_bondProperties[name] = values;
+  return true;
+}
+
+bool Molecule::setBondProperty(Index bondId, const std::string& name,
+                               Real value)
+{
+  if (bondId >= bondCount())
+    return false;
+  setPropertyValue(m_bondProperties, bondId, bondCount(), name, value);
+  return true;
+}
+
+void Molecule::removeBondProperty(const std::string& name)
+{
+  m_bondProperties.erase(name);
+}
+
+std::vector<std::string> Molecule::bondPropertyNames() const
+{
+  return propertyNames(m_bondProperties);
+}
+
+void Molecule::resizeProperties(PropertyMap& properties, Index size)
+{
+  for (PropertyMap::iterator it = properties.begin(), itEnd = properties.end();
+       it != itEnd; ++it) {
+    it->second.resize(size, Real(0));
+  }
+}
+
+void Molecule::removePropertyRow(PropertyMap& properties, Index index)
+{
+  for (PropertyMap::iterator it = properties.begin(), itEnd = properties.end();
+       it != itEnd; ++it) {
+    Array<Real>& values = it->second;
+    if (index >= values.size())
+      continue;
+    if (index != values.size() - 1)
+      values[index] = values.back();
+    values.pop_back();
+  }
+}
+
 Residue& Molecule::addResidue(std::string& name, Index& number, char& id)
 {
   Residue newResidue(name, number, id);
@@ -20,12 +20,15 @@
 #include "avogadrocore.h"
 
 #include <map>
+#include <memory>
 #include <string>
+#include <vector>
 
 #include "array.h"
 #include "bond.h"
 #include "elements.h"
 #include "graph.h"
+#include "selection.h"
 #include "variantmap.h"
 #include "vector.h"
 
@@ -34,6 +37,7 @@ namespace Core {
 class BasisSet;
 class Cube;
 class Mesh;
+class MoleculeSnapshot;
 class Residue;
 class UnitCell;
 
@@ -58,6 +62,9 @@ public:
   /** Type for custom element map. */
   typedef std::map<unsigned char, std::string> CustomElementMap;
 
+  /** Type for the named per atom and per bond property columns. */
+  typedef std::map<std::string, Array<Real>> PropertyMap;
+
   /** Creates a new, empty molecule. */
   Molecule();
 
@@ -76,6 +83,14 @@ public:
   /** Destroys the molecule object. */
   virtual ~Molecule();
 
+  /**
+   * Reset the molecule to the state of a new, empty molecule. Unlike assigning
+   * a new molecule, the atom and bond arrays keep their capacity, so reading
+   * many records into one molecule and clearing it in between avoids most
+   * allocations.
+   */
+  virtual void clear();
+
   /** Sets the data value with @p name to @p value. */
   void setData(const std::string& name, const Variant& value);
 
@@ -282,9 +297,31 @@ public:
    */
   bool atomSelected(Index atomId) const;
 
-  /** Returns whether the selection is empty or not */
+  /** Returns whether the atom selection is empty or not */
   bool isSelectionEmpty() const;
 
+  /**
+   * The selected atoms. The const version may cover fewer or more indices
+   * than atomCount() after edits, Selection::test() handles both. The
+   * non-const version is resized to atomCount() first, ready for range
+   * operations.
+   * @{
+   */
+  const Selection& atomSelection() const { return m_selectedAtoms; }
+  Selection& atomSelection();
+  /** @} */
+
+  /** Set whether the specified bond is selected or not. */
+  void setBondSelected(Index bondId, bool selected);
+
+  /** Query whether the supplied bond index has been selected. */
+  bool bondSelected(Index bondId) const;
+
+  /** The selected bonds, see atomSelection(). @{ */
+  const Selection& bondSelection() const { return m_selectedBonds; }
+  Selection& bondSelection();
+  /** @} */
+
   /** Returns a vector of pairs of atom indices of the bonds in the molecule. */
   Array<std::pair<Index, Index>>& bondPairs();
 
@@ -375,6 +412,15 @@ public:
   /**  Adds an atom to the molecule. */
   virtual AtomType addAtom(unsigned char atomicNumber);
 
+  /**
+   * Append atoms with @a atomicNumbers at @a positions, growing each array
+   * once instead of once per atom. @a positions must either be empty or have
+   * one entry per new atom.
+   * @return The index of the first new atom.
+   */
+  virtual Index addAtoms(const Array<unsigned char>& atomicNumbers,
+                         const Array<Vector3>& positions);
+
   /**
    * @brief Remove the specified atom from the molecule.
    * @param index The index of the atom to be removed.
@@ -426,6 +472,15 @@ public:
                            unsigned char order = 1);
   /** @} */
 
+  /**
+   * Append bonds between the atom @a pairs with the bond @a orders in one
+   * step. Unlike addBond() the existing bonds are not searched, so the new
+   * bonds must not already exist and must not contain duplicates.
+   * @return The index of the first new bond.
+   */
+  virtual Index addBonds(const Array<std::pair<Index, Index>>& pairs,
+                         const Array<unsigned char>& orders);
+
   /**
    * @brief Remove the specified bond.
    * @param index The index of the bond to be removed.
@@ -509,8 +564,8 @@ public:
    * @brief Get the cubes vector set (if present) for the molecule.
    * @return The cube vector for the molecule
    */
-  std::vector<Cube*> cubes() { return m_cubes; }
-  const std::vector<Cube*> cubes() const { return m_cubes; }
+  std::vector<Cube*> cubes();
+  std::vector<const Cube*> cubes() const;
 
   /**
    * Returns the chemical formula of the molecule.
@@ -548,13 +603,16 @@ public:
    * Set the basis set for the molecule, note that the molecule takes ownership
    * of the object.
    */
-  void setBasisSet(BasisSet* basis) { m_basisSet = basis; }
+  void setBasisSet(BasisSet* basis);
 
   /**
-   * Get the basis set (if present) for the molecule.
+   * Get the basis set (if present) for the molecule. Snapshots get their own
+   * copy of the basis set, which is made again after the non-const accessor
+   * is called. Changes made through a pointer obtained before a snapshot was
+   * taken are not seen by later snapshots, call basisSet() again instead.
    */
-  BasisSet* basisSet() { return m_basisSet; }
-  const BasisSet* basisSet() const { return m_basisSet; }
+  BasisSet* basisSet();
+  const BasisSet* basisSet() const { return m_basisSet.get(); }
 
   /**
    * The unit cell for this molecule. May be nullptr for non-periodic
@@ -588,11 +646,17 @@ public:
    */
   void perceiveBondsFromResidueData();
 
-  int coordinate3dCount();
+  int coordinate3dCount() const;
   bool setCoordinate3d(int coord);
   Array<Vector3> coordinate3d(int index) const;
   bool setCoordinate3d(const Array<Vector3>& coords, int index);
 
+  /**
+   * @return The positions of frame @p index for editing in place, nullptr if
+   * there is no such frame.
+   */
+  Array<Vector3>* coordinate3dArray(int index);
+
   /**
    * Timestep property is used when molecular dynamics trajectories are read
    */
@@ -628,6 +692,57 @@ public:
    */
   bool setForceVector(Index atomId, const Vector3& force);
 
+  /**
+   * Named per atom properties, such as partial charges, B-factors or
+   * occupancies. Each property is a contiguous array of one value per atom,
+   * kept in step with the atoms as they are added and removed. Atoms added
+   * after a property was set have a value of 0 for it. @{
+   */
+  bool hasAtomProperty(const std::string& name) const;
+
+  /** The values of property @a name, or an empty array if it is not set. */
+  const Array<Real>& atomProperty(const std::string& name) const;
+
+  /**
+   * The value of property @a name for a single atom, or 0 if the atom or the
+   * property do not exist.
+   */
+  Real atomProperty(Index atomId, const std::string& name) const;
+
+  /**
+   * Replace the values of property @a name, adding it if it is not set.
+   * @param values The new values. Must be of length atomCount().
+   * @return True on success, false otherwise.
+   */
+  bool setAtomProperty(const std::string& name, const Array<Real>& values);
+
+  /**
+   * Set the value of property @a name for a single atom, adding the property
+   * if it is not set.
+   * @return True on success, false otherwise.
+   */
+  bool setAtomProperty(Index atomId, const std::string& name, Real value);
+
+  /** Remove property @a name from all atoms. */
+  void removeAtomProperty(const std::string& name);
+
+  /** The names of all per atom properties, in alphabetical order. */
+  std::vector<std::string> atomPropertyNames() const;
+  /** @} */
+
+  /**
+   * Named per bond properties, stored and kept in step with the bonds in the
+   * same way as the per atom properties. @{
+   */
+  bool hasBondProperty(const std::string& name) const;
+  const Array<Real>& bondProperty(const std::string& name) const;
+  Real bondProperty(Index bondId, const std::string& name) const;
+  bool setBondProperty(const std::string& name, const Array<Real>& values);
+  bool setBondProperty(Index bondId, const std::string& name, Real value);
+  void removeBondProperty(const std::string& name);
+  std::vector<std::string> bondPropertyNames() const;
+  /** @} */
+
   Residue& addResidue(std::string& name, Index& number, char& id);
   void addResidue(Residue& residue);
   Residue& residue(int index);
@@ -655,18 +770,41 @@ protected:
   Array<std::pair<Index, Index>> m_bondPairs;
   Array<unsigned char> m_bondOrders;
 
-  // Array declaring whether atoms are selected or not.
-  std::vector<bool> m_selectedAtoms;
+  // Named property columns, all of them have one value per atom or bond.
+  PropertyMap m_atomProperties;
+  PropertyMap m_bondProperties;
+
+  // The selected atoms and bonds.
+  Selection m_selectedAtoms;
+  Selection m_selectedBonds;
 
   std::vector<Mesh*> m_meshes;
-  std::vector<Cube*> m_cubes;
 
-  BasisSet* m_basisSet;
+  // The cubes may be shared with snapshots, the non-const accessors copy them
+  // before handing them out if they are.
+  std::vector<std::shared_ptr<Cube>> m_cubes;
+  std::shared_ptr<BasisSet> m_basisSet;
+
+  // The copy of the basis set handed to snapshots. It is detached from this
+  // molecule, made on demand and dropped when the basis set may change.
+  mutable std::shared_ptr<const BasisSet> m_snapshotBasisSet;
+
   UnitCell* m_unitCell;
   Array<Residue> m_residues;
 
   /** Update the graph to correspond to the current molecule. */
   void updateGraph() const;
+
+  /** Set the length of all columns of @a properties, padding with 0. */
+  static void resizeProperties(PropertyMap& properties, Index size);
+
+  /**
+   * Remove row @a index from all columns of @a properties, moving the last row
+   * into its place as removeAtom() and removeBond() do.
+   */
+  static void removePropertyRow(PropertyMap& properties, Index index);
+
+  friend class MoleculeSnapshot;
 };
 
 class AVOGADROCORE_EXPORT Atom : public AtomTemplate<Molecule>
@@ -850,23 +988,45 @@ inline void Molecule::setAtomSelected(Index atomId, bool selected)
 {
   if (atomId < atomCount()) {
     if (atomId >= m_selectedAtoms.size())
-      m_selectedAtoms.resize(atomCount(), false);
-    m_selectedAtoms[atomId] = selected;
+      m_selectedAtoms.resize(atomCount());
+    m_selectedAtoms.set(atomId, selected);
   }
 }
 
 inline bool Molecule::atomSelected(Index atomId) const
 {
-  return atomId < m_selectedAtoms.size() ? m_selectedAtoms[atomId] : false;
+  return m_selectedAtoms.test(atomId);
 }
 
 inline bool Molecule::isSelectionEmpty() const
 {
-  for (Index i = 0; i < m_selectedAtoms.size(); ++i) {
-    if (m_selectedAtoms[i])
-      return false;
+  return m_selectedAtoms.none();
+}
+
+inline Selection& Molecule::atomSelection()
+{
+  m_selectedAtoms.resize(atomCount());
+  return m_selectedAtoms;
+}
+
+inline void Molecule::setBondSelected(Index bondId, bool selected)
+{
+  if (bondId < bondCount()) {
+    if (bondId >= m_selectedBonds.size())
+      m_selectedBonds.resize(bondCount());
+    m_selectedBonds.set(bondId, selected);
   }
-  return true;
+}
+
+inline bool Molecule::bondSelected(Index bondId) const
+{
+  return m_selectedBonds.test(bondId);
+}
+
+inline Selection& Molecule::bondSelection()
+{
+  m_selectedBonds.resize(bondCount());
+  return m_selectedBonds;
 }
 
 inline std::pair<Index, Index> Molecule::bondPair(Index bondId) const
@@ -0,0 +1,81 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "moleculesnapshot.h"
+
+#include "basisset.h"
+#include "cube.h"
+#include "molecule.h"
+#include "unitcell.h"
+
+namespace Avogadro {
+namespace Core {
+
+MoleculeSnapshot::MoleculeSnapshot()
+{
+}
+
+MoleculeSnapshot::MoleculeSnapshot(const Molecule& molecule)
+  : m_atomicNumbers(molecule.m_atomicNumbers),
+    m_positions2d(molecule.m_positions2d),
+    m_positions3d(molecule.m_positions3d),
+    m_coordinates3d(molecule.m_coordinates3d),
+    m_hybridizations(molecule.m_hybridizations),
+    m_formalCharges(molecule.m_formalCharges), m_colors(molecule.m_colors),
+    m_bondPairs(molecule.m_bondPairs), m_bondOrders(molecule.m_bondOrders),
+    m_atomProperties(molecule.m_atomProperties),
+    m_bondProperties(molecule.m_bondProperties),
+    m_cubes(molecule.m_cubes.begin(), molecule.m_cubes.end())
+{
+  // The unit cell is small and edited in place, it is copied.
+  if (molecule.m_unitCell)
+    m_unitCell = std::make_shared<const UnitCell>(*molecule.m_unitCell);
+
+  // The basis set refers back to its molecule, so the snapshot gets a copy
+  // without that link. Later snapshots share the copy until the basis set may
+  // have changed.
+  if (molecule.m_basisSet && !molecule.m_snapshotBasisSet) {
+    BasisSet* copy = molecule.m_basisSet->clone();
+    copy->setMolecule(nullptr);
+    molecule.m_snapshotBasisSet.reset(copy);
+  }
+  m_basisSet = molecule.m_snapshotBasisSet;
+}
+
+MoleculeSnapshot::~MoleculeSnapshot()
+{
+}
+
+Array<Vector3> MoleculeSnapshot::coordinate3d(int index) const
+{
+  if (index < 0 || index >= coordinate3dCount())
+    return Array<Vector3>();
+  return m_coordinates3d[index];
+}
+
+const Array<Real>& MoleculeSnapshot::atomProperty(
+  const std::string& name) const
+{
+  static const Array<Real> empty;
+  auto it = m_atomProperties.find(name);
+  return it != m_atomProperties.end() ? it->second : empty;
+}
+
+const Array<Real>& MoleculeSnapshot::bondProperty(
+  const std::string& name) const
+{
+  static const Array<Real> empty;
+  auto it = m_bondProperties.find(name);
+  return it != m_bondProperties.end() ? it->second : empty;
+}
+
+const Cube* MoleculeSnapshot::cube(Index index) const
+{
+  if (index < static_cast<Index>(m_cubes.size()))
+    return m_cubes[index].get();
+  else
+    return nullptr;
+}
+
+} // End namespace Core
+} // End namespace Avogadro
@@ -0,0 +1,134 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_CORE_MOLECULESNAPSHOT_H
+#define AVOGADRO_CORE_MOLECULESNAPSHOT_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "atom.h"
+#include "vector.h"
+
+#include <map>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class BasisSet;
+class Cube;
+class Molecule;
+class UnitCell;
+
+/**
+ * @class MoleculeSnapshot moleculesnapshot.h
+ * <avogadro/core/moleculesnapshot.h>
+ * @brief An immutable copy of the atoms, bonds, basis set and cubes of a
+ * Molecule for background computations.
+ *
+ * Taking a snapshot copies little data: the atom and bond arrays are shared
+ * copy-on-write with the molecule, and the cubes are shared until the
+ * molecule hands out a non-const pointer to them, at which point the molecule
+ * makes its own copy. The basis set is copied for the first snapshot after it
+ * may have changed, see Molecule::basisSet(). Copies of a snapshot share all
+ * of its data.
+ *
+ * A snapshot has to be taken on the thread that edits the molecule, after
+ * that it can be read on any thread without locking while the molecule
+ * changes. Pointers to cubes obtained from the molecule before the snapshot
+ * was taken must not be used to modify them while it is alive. The basis set
+ * of a snapshot is not linked to a molecule, BasisSet::molecule() is nullptr,
+ * use the atoms of the snapshot instead.
+ */
+class AVOGADROCORE_EXPORT MoleculeSnapshot
+{
+public:
+  /** An empty snapshot. */
+  MoleculeSnapshot();
+
+  /** A snapshot of the current state of @a molecule. */
+  explicit MoleculeSnapshot(const Molecule& molecule);
+
+  ~MoleculeSnapshot();
+
+  /** The number of atoms and bonds. @{ */
+  Index atomCount() const { return m_atomicNumbers.size(); }
+  Index bondCount() const { return m_bondPairs.size(); }
+  /** @} */
+
+  /** The per atom data, as in Molecule. @{ */
+  const Array<unsigned char>& atomicNumbers() const { return m_atomicNumbers; }
+  const Array<Vector2>& atomPositions2d() const { return m_positions2d; }
+  const Array<Vector3>& atomPositions3d() const { return m_positions3d; }
+  const Array<AtomHybridization>& hybridizations() const
+  {
+    return m_hybridizations;
+  }
+  const Array<signed char>& formalCharges() const { return m_formalCharges; }
+  const Array<Vector3ub>& colors() const { return m_colors; }
+  /** @} */
+
+  /** The per bond data, as in Molecule. @{ */
+  const Array<std::pair<Index, Index>>& bondPairs() const
+  {
+    return m_bondPairs;
+  }
+  const Array<unsigned char>& bondOrders() const { return m_bondOrders; }
+  /** @} */
+
+  /**
+   * The named per atom and per bond properties, as in Molecule. An empty array
+   * is returned for properties that are not set. @{
+   */
+  const Array<Real>& atomProperty(const std::string& name) const;
+  const Array<Real>& bondProperty(const std::string& name) const;
+  /** @} */
+
+  /**
+   * The coordinate sets (conformers or trajectory frames). An index out of
+   * range gives an empty array. @{
+   */
+  int coordinate3dCount() const
+  {
+    return static_cast<int>(m_coordinates3d.size());
+  }
+  Array<Vector3> coordinate3d(int index) const;
+  /** @} */
+
+  /** The unit cell, or nullptr for non-periodic structures. */
+  const UnitCell* unitCell() const { return m_unitCell.get(); }
+
+  /** The basis set, or nullptr if the molecule has none. */
+  const BasisSet* basisSet() const { return m_basisSet.get(); }
+
+  /** The cubes of the molecule. @{ */
+  Index cubeCount() const { return static_cast<Index>(m_cubes.size()); }
+  const Cube* cube(Index index) const;
+  /** @} */
+
+private:
+  Array<unsigned char> m_atomicNumbers;
+  Array<Vector2> m_positions2d;
+  Array<Vector3> m_positions3d;
+  Array<Array<Vector3>> m_coordinates3d;
+  Array<AtomHybridization> m_hybridizations;
+  Array<signed char> m_formalCharges;
+  Array<Vector3ub> m_colors;
+  Array<std::pair<Index, Index>> m_bondPairs;
+  Array<unsigned char> m_bondOrders;
+  std::map<std::string, Array<Real>> m_atomProperties;
+  std::map<std::string, Array<Real>> m_bondProperties;
+
+  std::shared_ptr<const UnitCell> m_unitCell;
+  std::shared_ptr<const BasisSet> m_basisSet;
+  std::vector<std::shared_ptr<const Cube>> m_cubes;
+};
+
+} // End namespace Core
+} // End namespace Avogadro
+
+#endif // AVOGADRO_CORE_MOLECULESNAPSHOT_H
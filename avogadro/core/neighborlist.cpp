@@ -0,0 +1,276 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "neighborlist.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+
+// Keep the grid from growing much larger than the number of points when the
+// points are sparse or the requested cell size is tiny.
+const Real maxCellsPerPoint = 8.0;
+const Real minCells = 64.0;
+
+int clampCell(Real cell, int dim)
+{
+  if (cell < 0.0)
+    return 0;
+  if (cell >= static_cast<Real>(dim))
+    return dim - 1;
+  return static_cast<int>(cell);
+}
+}
+
+NeighborList::NeighborList()
+  : m_cells(1), m_periodic(false), m_origin(Vector3::Zero()),
+    m_cellSize(Vector3::Ones()), m_widths(Vector3::Ones())
+{
+  m_dims[0] = m_dims[1] = m_dims[2] = 1;
+}
+
+NeighborList::~NeighborList()
+{
+}
+
+void NeighborList::build(const Array<Vector3>& positions, Real cellSize,
+                         const UnitCell* unitCell)
+{
+  m_positions.assign(positions.begin(), positions.end());
+  m_periodic = unitCell != nullptr;
+  if (cellSize <= 0.0)
+    cellSize = 1.0;
+
+  Vector3 extent(Vector3::Zero());
+  if (m_periodic) {
+    m_unitCell = *unitCell;
+    const Vector3 a = m_unitCell.aVector();
+    const Vector3 b = m_unitCell.bVector();
+    const Vector3 c = m_unitCell.cVector();
+    const Real volume = std::fabs(a.dot(b.cross(c)));
+    m_widths = Vector3(volume / b.cross(c).norm(), volume / c.cross(a).norm(),
+                       volume / a.cross(b).norm());
+    m_origin = Vector3::Zero();
+    extent = m_widths;
+  } else if (!m_positions.empty()) {
+    Vector3 lower = m_positions[0];
+    Vector3 upper = m_positions[0];
+    for (size_t i = 1; i < m_positions.size(); ++i) {
+      lower = lower.cwiseMin(m_positions[i]);
+      upper = upper.cwiseMax(m_positions[i]);
+    }
+    m_origin = lower;
+    extent = upper - lower;
+  } else {
+    m_origin = Vector3::Zero();
+  }
+
+  const Real maxCells =
+    std::max(minCells, maxCellsPerPoint * static_cast<Real>(size()));
+  for (;;) {
+    Real cells = 1.0;
+    for (int i = 0; i < 3; ++i) {
+      Real dim = m_periodic ? std::floor(extent[i] / cellSize)
+                            : std::floor(extent[i] / cellSize) + 1.0;
+      dim = std::max(dim, static_cast<Real>(1.0));
+      m_dims[i] = static_cast<int>(std::min(dim, maxCells));
+      cells *= m_dims[i];
+    }
+    if (cells <= maxCells)
+      break;
+    cellSize *= 1.25;
+  }
+
+  if (m_periodic) {
+    m_cellSize = Vector3(1.0 / m_dims[0], 1.0 / m_dims[1], 1.0 / m_dims[2]);
+  } else {
+    m_cellSize = Vector3::Constant(cellSize);
+    m_widths = extent;
+  }
+
+  m_cells.assign(static_cast<size_t>(m_dims[0]) * m_dims[1] * m_dims[2],
+                 std::vector<Index>());
+  m_pointCells.resize(m_positions.size());
+  int cell[3];
+  for (Index i = 0; i < size(); ++i) {
+    cellCoordinates(m_positions[i], cell);
+    m_pointCells[i] = cellIndex(cell);
+    m_cells[m_pointCells[i]].push_back(i);
+  }
+}
+
+void NeighborList::clear()
+{
+  build(Array<Vector3>(), 1.0);
+}
+
+void NeighborList::updatePosition(Index index, const Vector3& position)
+{
+  if (index >= size())
+    return;
+  m_positions[index] = position;
+  int cell[3];
+  cellCoordinates(position, cell);
+  Index newCell = cellIndex(cell);
+  if (newCell == m_pointCells[index])
+    return;
+  removeFromCell(index);
+  m_pointCells[index] = newCell;
+  m_cells[newCell].push_back(index);
+}
+
+Index NeighborList::addPosition(const Vector3& position)
+{
+  Index index = size();
+  m_positions.push_back(position);
+  int cell[3];
+  cellCoordinates(position, cell);
+  m_pointCells.push_back(cellIndex(cell));
+  m_cells[m_pointCells.back()].push_back(index);
+  return index;
+}
+
+Real NeighborList::squaredDistance(const Vector3& a, const Vector3& b) const
+{
+  if (m_periodic)
+    return m_unitCell.minimumImage(b - a).squaredNorm();
+  return (b - a).squaredNorm();
+}
+
+std::vector<Index> NeighborList::neighbors(const Vector3& position,
+                                           Real radius) const
+{
+  std::vector<Index> result;
+  forEachNeighbor(position, radius,
+                  [&result](Index i, Real) { result.push_back(i); });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+std::vector<Index> NeighborList::neighbors(Index index, Real radius) const
+{
+  std::vector<Index> result;
+  if (index >= size())
+    return result;
+  forEachNeighbor(m_positions[index], radius, [&](Index i, Real) {
+    if (i != index)
+      result.push_back(i);
+  });
+  std::sort(result.begin(), result.end());
+  return result;
+}
+
+std::vector<Index> NeighborList::nearest(const Vector3& position,
+                                         Index k) const
+{
+  std::vector<std::pair<Real, Index>> found;
+  k = std::min(k, size());
+  if (k == 0)
+    return std::vector<Index>();
+
+  // Grow the search sphere until it holds k points. Once it spans the whole
+  // grid, fall back to measuring every point.
+  Real radius = m_periodic ? m_widths.cwiseProduct(m_cellSize).minCoeff()
+                           : m_cellSize[0];
+  for (;;) {
+    int lower[3];
+    int upper[3];
+    cellRange(position, radius, lower, upper);
+    bool everyCell = true;
+    for (int i = 0; i < 3; ++i)
+      everyCell = everyCell && (upper[i] - lower[i] + 1 >= m_dims[i]);
+    found.clear();
+    if (everyCell) {
+      for (Index i = 0; i < size(); ++i) {
+        found.push_back(
+          std::make_pair(squaredDistance(position, m_positions[i]), i));
+      }
+      break;
+    }
+    forEachNeighbor(position, radius, [&found](Index i, Real distance) {
+      found.push_back(std::make_pair(distance, i));
+    });
+    if (found.size() >= k)
+      break;
+    radius *= 2.0;
+  }
+
+  std::partial_sort(found.begin(), found.begin() + k, found.end());
+  std::vector<Index> result(k);
+  for (Index i = 0; i < k; ++i)
+    result[i] = found[i].second;
+  return result;
+}
+
+std::vector<std::pair<Index, Index>> NeighborList::pairs(Real radius) const
+{
+  std::vector<std::pair<Index, Index>> result;
+  std::vector<Index> partners;
+  for (Index i = 0; i < size(); ++i) {
+    partners.clear();
+    forEachNeighbor(m_positions[i], radius, [i, &partners](Index j, Real) {
+      if (j > i)
+        partners.push_back(j);
+    });
+    std::sort(partners.begin(), partners.end());
+    for (size_t j = 0; j < partners.size(); ++j)
+      result.push_back(std::make_pair(i, partners[j]));
+  }
+  return result;
+}
+
+void NeighborList::cellCoordinates(const Vector3& position, int cell[3]) const
+{
+  Vector3 local =
+    m_periodic ? m_unitCell.wrapFractional(m_unitCell.toFractional(position))
+               : Vector3(position - m_origin);
+  for (int i = 0; i < 3; ++i)
+    cell[i] = clampCell(std::floor(local[i] / m_cellSize[i]), m_dims[i]);
+}
+
+void NeighborList::cellRange(const Vector3& position, Real radius,
+                             int lower[3], int upper[3]) const
+{
+  if (m_periodic) {
+    // Wrapped cell indices, the caller takes them modulo the grid size.
+    Vector3 frac =
+      m_unitCell.wrapFractional(m_unitCell.toFractional(position));
+    for (int i = 0; i < 3; ++i) {
+      Real reach = radius / m_widths[i];
+      Real low = std::floor((frac[i] - reach) / m_cellSize[i]);
+      Real high = std::floor((frac[i] + reach) / m_cellSize[i]);
+      if (high - low + 1.0 >= m_dims[i]) {
+        lower[i] = 0;
+        upper[i] = m_dims[i] - 1;
+      } else {
+        lower[i] = static_cast<int>(low);
+        upper[i] = static_cast<int>(high);
+      }
+    }
+  } else {
+    Vector3 local = position - m_origin;
+    for (int i = 0; i < 3; ++i) {
+      lower[i] =
+        clampCell(std::floor((local[i] - radius) / m_cellSize[i]), m_dims[i]);
+      upper[i] =
+        clampCell(std::floor((local[i] + radius) / m_cellSize[i]), m_dims[i]);
+    }
+  }
+}
+
+void NeighborList::removeFromCell(Index index)
+{
+  std::vector<Index>& cell = m_cells[m_pointCells[index]];
+  std::vector<Index>::iterator it = std::find(cell.begin(), cell.end(), index);
+  if (it != cell.end()) {
+    *it = cell.back();
+    cell.pop_back();
+  }
+}
+
+} // End namespace Core
+} // End namespace Avogadro
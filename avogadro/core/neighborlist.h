@@ -0,0 +1,166 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_CORE_NEIGHBORLIST_H
+#define AVOGADRO_CORE_NEIGHBORLIST_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "unitcell.h"
+#include "vector.h"
+
+#include <utility>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class NeighborList neighborlist.h <avogadro/core/neighborlist.h>
+ * @brief Find the points within a distance of a position using a cell list.
+ *
+ * The points are sorted into a grid of cubic cells whose edge is at least the
+ * cell size passed to build(). A query only visits the cells that overlap the
+ * search sphere, so for a cell size close to the typical query radius each
+ * query takes constant time instead of a scan over all points.
+ *
+ * If a unit cell is set the points are periodic: the grid spans the unit cell
+ * in fractional coordinates and distances are measured to the minimum image,
+ * UnitCell::minimumImage(). Each point is returned at most once per query, so
+ * radii beyond half the shortest cell width do not report further images.
+ *
+ * Points can be moved with updatePosition() and added with addPosition()
+ * without rebuilding the grid. Points moved far outside the initial bounding
+ * box are still found, but queries near them slow down; rebuild the list if
+ * the geometry changes substantially.
+ */
+class AVOGADROCORE_EXPORT NeighborList
+{
+public:
+  NeighborList();
+  ~NeighborList();
+
+  /**
+   * Sort @a positions into cells with an edge of at least @a cellSize. If
+   * @a unitCell is not null, the points are treated as periodic in it.
+   */
+  void build(const Array<Vector3>& positions, Real cellSize,
+             const UnitCell* unitCell = nullptr);
+
+  /** Remove all points. */
+  void clear();
+
+  /** @return The number of points in the list. */
+  Index size() const { return static_cast<Index>(m_positions.size()); }
+
+  /** @return True if the points are periodic. */
+  bool isPeriodic() const { return m_periodic; }
+
+  /** @return The position of the point @a index. */
+  const Vector3& position(Index index) const { return m_positions[index]; }
+
+  /** Move the point @a index to @a position. */
+  void updatePosition(Index index, const Vector3& position);
+
+  /** Add a point at @a position. @return The index of the new point. */
+  Index addPosition(const Vector3& position);
+
+  /**
+   * @return The squared distance between the points @a a and @a b, using the
+   * minimum image if the list is periodic.
+   */
+  Real squaredDistance(const Vector3& a, const Vector3& b) const;
+
+  /**
+   * @return The indices of the points within @a radius of @a position, in
+   * ascending order.
+   */
+  std::vector<Index> neighbors(const Vector3& position, Real radius) const;
+
+  /**
+   * @return The indices of the points within @a radius of the point
+   * @a index, excluding itself, in ascending order.
+   */
+  std::vector<Index> neighbors(Index index, Real radius) const;
+
+  /**
+   * @return The indices of the @a k points closest to @a position, nearest
+   * first. Fewer are returned if the list has less than @a k points.
+   */
+  std::vector<Index> nearest(const Vector3& position, Index k) const;
+
+  /**
+   * @return All pairs of points (i, j) with i < j that are within @a radius
+   * of each other, sorted by i and then j.
+   */
+  std::vector<std::pair<Index, Index>> pairs(Real radius) const;
+
+  /**
+   * Call @a visit(index, squaredDistance) for every point within @a radius of
+   * @a position, in no particular order.
+   */
+  template <typename Visitor>
+  void forEachNeighbor(const Vector3& position, Real radius,
+                       const Visitor& visit) const;
+
+private:
+  void cellCoordinates(const Vector3& position, int cell[3]) const;
+  Index cellIndex(const int cell[3]) const
+  {
+    return static_cast<Index>(cell[0]) +
+           m_dims[0] * (static_cast<Index>(cell[1]) +
+                        m_dims[1] * static_cast<Index>(cell[2]));
+  }
+  void cellRange(const Vector3& position, Real radius, int lower[3],
+                 int upper[3]) const;
+  void removeFromCell(Index index);
+
+  std::vector<Vector3> m_positions;
+  std::vector<Index> m_pointCells;
+  std::vector<std::vector<Index>> m_cells;
+
+  bool m_periodic;
+  UnitCell m_unitCell;
+  Vector3 m_origin;
+  // Cartesian cell edge, or the fractional edge of each axis if periodic.
+  Vector3 m_cellSize;
+  // The width of the unit cell perpendicular to each pair of lattice vectors.
+  Vector3 m_widths;
+  int m_dims[3];
+};
+
+template <typename Visitor>
+void NeighborList::forEachNeighbor(const Vector3& position, Real radius,
+                                   const Visitor& visit) const
+{
+  if (m_positions.empty() || radius < 0.0)
+    return;
+
+  int lower[3];
+  int upper[3];
+  cellRange(position, radius, lower, upper);
+  const Real radiusSquared = radius * radius;
+  int cell[3];
+  for (int k = lower[2]; k <= upper[2]; ++k) {
+    cell[2] = m_periodic ? (k % m_dims[2] + m_dims[2]) % m_dims[2] : k;
+    for (int j = lower[1]; j <= upper[1]; ++j) {
+      cell[1] = m_periodic ? (j % m_dims[1] + m_dims[1]) % m_dims[1] : j;
+      for (int i = lower[0]; i <= upper[0]; ++i) {
+        cell[0] = m_periodic ? (i % m_dims[0] + m_dims[0]) % m_dims[0] : i;
+        const std::vector<Index>& points = m_cells[cellIndex(cell)];
+        for (size_t p = 0; p < points.size(); ++p) {
+          Real distanceSquared =
+            squaredDistance(position, m_positions[points[p]]);
+          if (distanceSquared <= radiusSquared)
+            visit(points[p], distanceSquared);
+        }
+      }
+    }
+  }
+}
+
+} // End namespace Core
+} // End namespace Avogadro
+
+#endif // AVOGADRO_CORE_NEIGHBORLIST_H
@@ -0,0 +1,45 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_CORE_PARALLEL_P_H
+#define AVOGADRO_CORE_PARALLEL_P_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * Run task(i) for i in [0, count) on all hardware threads, the calling thread
+ * included. The tasks are handed out one at a time, so they may take
+ * different amounts of time. @a task is called concurrently and must only
+ * write to state owned by its index.
+ */
+template <typename Task>
+void runParallel(size_t count, const Task& task)
+{
+  std::atomic<size_t> next(0);
+  auto worker = [&]() {
+    for (size_t i = next++; i < count; i = next++)
+      task(i);
+  };
+
+  size_t threadCount = std::min(
+    count,
+    static_cast<size_t>(std::max(std::thread::hardware_concurrency(), 1u)));
+  std::vector<std::thread> threads;
+  for (size_t i = 1; i < threadCount; ++i)
+    threads.push_back(std::thread(worker));
+  worker();
+  for (size_t i = 0; i < threads.size(); ++i)
+    threads[i].join();
+}
+
+} // End namespace Core
+} // End namespace Avogadro
+
+#endif // AVOGADRO_CORE_PARALLEL_P_H
@@ -17,6 +17,7 @@
 #include "ringperceiver.h"
 
 #include "molecule.h"
+#include "parallel_p.h"
 
 #include <algorithm>
 #include <cstring>
@@ -326,7 +327,7 @@ bool Sssr::isUnique(const std::vector<size_t>& path) const
     if (ring.size() >= path.size())
       continue;
 
-    for (size_t i = 0; i < ring.size(); i++) {
+    for (size_t i = 0; i < ring.size() - 1; i++) {
       pathBonds.erase(std::make_pair(std::min(ring[i], ring[i + 1]),
                                      std::max(ring[i], ring[i + 1])));
     }
@@ -365,14 +366,13 @@ bool Sssr::isUnique(const std::vector<size_t>& path) const
   return true;
 }
 
-std::vector<std::vector<size_t>> perceiveRings(const Graph& graph)
+// Find the sssr of a single ring system with the path-included distance
+// matrix algorithm, ringCount is the number of rings in the system.
+std::vector<std::vector<size_t>> perceiveRingSystem(const Graph& graph,
+                                                    size_t ringCount)
 {
   size_t n = graph.size();
 
-  size_t ringCount = graph.vertexCount() - graph.edgeCount() + 1;
-  if (ringCount == 0)
-    return std::vector<std::vector<size_t>>();
-
   // Algorithm 1 - create the distance and pid matrices.
   DistanceMatrix D(n);
   PidMatrix P(n);
@@ -491,6 +491,139 @@ std::vector<std::vector<size_t>> perceiveRings(const Graph& graph)
   return sssr.rings();
 }
 
+// Split the graph into its ring systems, the biconnected components that
+// contain a cycle. Acyclic atoms and bridges are left out. Each system is
+// returned as the sorted list of its vertices, with its number of edges.
+void findRingSystems(const Graph& graph,
+                     std::vector<std::vector<size_t>>& systems,
+                     std::vector<size_t>& systemEdges)
+{
+  const size_t n = graph.size();
+  const size_t unvisited = std::numeric_limits<size_t>::max();
+  std::vector<size_t> discovery(n, unvisited);
+  std::vector<size_t> low(n, 0);
+  std::vector<std::pair<size_t, size_t>> edgeStack;
+
+  // Iterative depth first search, large molecules are too deep to recurse.
+  struct Frame
+  {
+    size_t vertex;
+    size_t parent;
+    size_t next;
+  };
+  std::vector<Frame> stack;
+  size_t time = 0;
+
+  for (size_t root = 0; root < n; ++root) {
+    if (discovery[root] != unvisited)
+      continue;
+    discovery[root] = low[root] = time++;
+    stack.push_back(Frame{ root, unvisited, 0 });
+
+    while (!stack.empty()) {
+      Frame& frame = stack.back();
+      const size_t v = frame.vertex;
+      const std::vector<size_t>& neighbors = graph.neighbors(v);
+
+      if (frame.next < neighbors.size()) {
+        size_t w = neighbors[frame.next++];
+        if (discovery[w] == unvisited) {
+          edgeStack.push_back(std::make_pair(v, w));
+          discovery[w] = low[w] = time++;
+          stack.push_back(Frame{ w, v, 0 });
+        } else if (w != frame.parent && discovery[w] < discovery[v]) {
+          edgeStack.push_back(std::make_pair(v, w));
+          low[v] = std::min(low[v], discovery[w]);
+        }
+        continue;
+      }
+
+      const size_t parent = frame.parent;
+      stack.pop_back();
+      if (parent == unvisited)
+        continue;
+      low[parent] = std::min(low[parent], low[v]);
+      if (low[v] < discovery[parent])
+        continue;
+
+      // The edges above (parent, v) form a biconnected component.
+      std::vector<size_t> vertices;
+      size_t edges = 0;
+      std::pair<size_t, size_t> edge;
+      do {
+        edge = edgeStack.back();
+        edgeStack.pop_back();
+        vertices.push_back(edge.first);
+        vertices.push_back(edge.second);
+        ++edges;
+      } while (edge.first != parent || edge.second != v);
+      std::sort(vertices.begin(), vertices.end());
+      vertices.erase(std::unique(vertices.begin(), vertices.end()),
+                     vertices.end());
+
+      // A bridge has one edge and two vertices, anything else is cyclic.
+      if (edges >= vertices.size()) {
+        systems.push_back(vertices);
+        systemEdges.push_back(edges);
+      }
+    }
+  }
+}
+
+// Perceive the rings of one ring system, mapping them back to the vertices
+// of the full graph.
+std::vector<std::vector<size_t>> perceiveRings(
+  const Graph& graph, const std::vector<size_t>& vertices, size_t edges)
+{
+  Graph system(vertices.size());
+  for (size_t i = 0; i < vertices.size(); ++i) {
+    const std::vector<size_t>& neighbors = graph.neighbors(vertices[i]);
+    for (size_t j = 0; j < neighbors.size(); ++j) {
+      // Two ring systems share at most one vertex, so any edge between two
+      // vertices of this system belongs to it.
+      std::vector<size_t>::const_iterator it =
+        std::lower_bound(vertices.begin(), vertices.end(), neighbors[j]);
+      if (it != vertices.end() && *it == neighbors[j]) {
+        size_t local = static_cast<size_t>(it - vertices.begin());
+        if (i < local)
+          system.addEdge(i, local);
+      }
+    }
+  }
+
+  std::vector<std::vector<size_t>> rings =
+    perceiveRingSystem(system, edges - vertices.size() + 1);
+  for (size_t i = 0; i < rings.size(); ++i)
+    for (size_t j = 0; j < rings[i].size(); ++j)
+      rings[i][j] = vertices[rings[i][j]];
+  return rings;
+}
+
+bool compareRingSize(const std::vector<size_t>& a,
+                     const std::vector<size_t>& b)
+{
+  return a.size() < b.size();
+}
+
+std::vector<std::vector<size_t>> perceiveRings(const Graph& graph)
+{
+  std::vector<std::vector<size_t>> systems;
+  std::vector<size_t> systemEdges;
+  findRingSystems(graph, systems, systemEdges);
+
+  // The ring systems are independent, perceive them in parallel.
+  std::vector<std::vector<std::vector<size_t>>> systemRings(systems.size());
+  runParallel(systems.size(), [&](size_t i) {
+    systemRings[i] = perceiveRings(graph, systems[i], systemEdges[i]);
+  });
+
+  std::vector<std::vector<size_t>> rings;
+  for (size_t i = 0; i < systemRings.size(); ++i)
+    rings.insert(rings.end(), systemRings[i].begin(), systemRings[i].end());
+  std::stable_sort(rings.begin(), rings.end(), compareRingSize);
+  return rings;
+}
+
 } // end anonymous namespace
 
 RingPerceiver::RingPerceiver(const Molecule* m)
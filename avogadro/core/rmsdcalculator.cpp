@@ -0,0 +1,232 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "rmsdcalculator.h"
+
+#include "array.h"
+#include "molecule.h"
+#include "parallel_p.h"
+
+#include <Eigen/SVD>
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro {
+namespace Core {
+
+struct RmsdCalculator::Frame
+{
+  // Centered on the centroid if the frames are aligned.
+  std::vector<Vector3> points;
+  // The sum of the squared norms of the points.
+  Real squaredNorm;
+};
+
+namespace {
+
+Vector3 centroid(const Vector3* points, size_t count)
+{
+  Vector3 sum(Vector3::Zero());
+  for (size_t i = 0; i < count; ++i)
+    sum += points[i];
+  return count > 0 ? Vector3(sum / static_cast<Real>(count)) : sum;
+}
+
+// The Kabsch algorithm: the optimal rotation of the centered points b onto
+// the centered points a follows from the singular value decomposition of
+// their covariance matrix H = sum(b a^T). The minimal squared deviation is
+// the sum of the squared norms less twice the trace of the rotated
+// covariance, which is the sum of the singular values with the smallest one
+// negated if the optimal orthogonal transform would be a reflection.
+Real alignedSquaredDeviation(const Vector3* a, const Vector3* b, size_t count,
+                             Real squaredNorms, Matrix3* rotation)
+{
+  Matrix3 covariance(Matrix3::Zero());
+  for (size_t i = 0; i < count; ++i)
+    covariance.noalias() += b[i] * a[i].transpose();
+
+  Eigen::JacobiSVD<Matrix3> svd(covariance,
+                                Eigen::ComputeFullU | Eigen::ComputeFullV);
+  const Vector3& singular = svd.singularValues();
+  Real sign = (svd.matrixV() * svd.matrixU().transpose()).determinant() < 0.0
+                ? -1.0
+                : 1.0;
+  if (rotation) {
+    Matrix3 correction(Matrix3::Identity());
+    correction(2, 2) = sign;
+    *rotation = svd.matrixV() * correction * svd.matrixU().transpose();
+  }
+  Real deviation = squaredNorms -
+                   2.0 * (singular[0] + singular[1] + sign * singular[2]);
+  // Rounding can make nearly identical frames slightly negative.
+  return std::max(deviation, static_cast<Real>(0.0));
+}
+
+} // End anonymous namespace
+
+RmsdCalculator::RmsdCalculator(const Molecule* molecule)
+  : m_molecule(molecule), m_align(true)
+{
+}
+
+RmsdCalculator::~RmsdCalculator()
+{
+}
+
+void RmsdCalculator::setMolecule(const Molecule* molecule)
+{
+  m_molecule = molecule;
+}
+
+int RmsdCalculator::frameCount() const
+{
+  if (!m_molecule)
+    return 0;
+  return std::max(m_molecule->coordinate3dCount(), 1);
+}
+
+std::vector<Real> RmsdCalculator::rmsdToFrame(int reference) const
+{
+  std::vector<Real> result;
+  std::vector<Frame> frames;
+  if (reference < 0 || reference >= frameCount() || !extractFrames(frames))
+    return result;
+
+  result.resize(frames.size());
+  const Frame& ref = frames[reference];
+  runParallel(frames.size(),
+              [&](size_t i) { result[i] = rmsd(ref, frames[i]); });
+  return result;
+}
+
+MatrixX RmsdCalculator::pairwiseRmsd() const
+{
+  std::vector<Frame> frames;
+  if (!extractFrames(frames))
+    return MatrixX();
+
+  Index count = static_cast<Index>(frames.size());
+  MatrixX result(MatrixX::Zero(count, count));
+  // Each task fills one row of the upper triangle, the rows are handed out
+  // in order so the long ones start first.
+  runParallel(count, [&](size_t i) {
+    for (Index j = i + 1; j < count; ++j)
+      result(i, j) = rmsd(frames[i], frames[j]);
+  });
+  for (Index i = 0; i < count; ++i) {
+    for (Index j = 0; j < i; ++j)
+      result(i, j) = result(j, i);
+  }
+  return result;
+}
+
+Real RmsdCalculator::rmsd(const Vector3* a, const Vector3* b, size_t count,
+                          bool align, Matrix3* rotation, Vector3* translation)
+{
+  if (count == 0) {
+    if (rotation)
+      *rotation = Matrix3::Identity();
+    if (translation)
+      *translation = Vector3::Zero();
+    return 0.0;
+  }
+
+  if (!align) {
+    Real sum = 0.0;
+    for (size_t i = 0; i < count; ++i)
+      sum += (a[i] - b[i]).squaredNorm();
+    if (rotation)
+      *rotation = Matrix3::Identity();
+    if (translation)
+      *translation = Vector3::Zero();
+    return std::sqrt(sum / static_cast<Real>(count));
+  }
+
+  Vector3 centerA = centroid(a, count);
+  Vector3 centerB = centroid(b, count);
+  std::vector<Vector3> centeredA(count);
+  std::vector<Vector3> centeredB(count);
+  Real squaredNorms = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    centeredA[i] = a[i] - centerA;
+    centeredB[i] = b[i] - centerB;
+    squaredNorms += centeredA[i].squaredNorm() + centeredB[i].squaredNorm();
+  }
+
+  Matrix3 rot;
+  Real deviation = alignedSquaredDeviation(
+    centeredA.data(), centeredB.data(), count, squaredNorms, &rot);
+  if (rotation)
+    *rotation = rot;
+  if (translation)
+    *translation = centerA - rot * centerB;
+  return std::sqrt(deviation / static_cast<Real>(count));
+}
+
+Real RmsdCalculator::rmsd(const std::vector<Vector3>& a,
+                          const std::vector<Vector3>& b, bool align,
+                          Matrix3* rotation, Vector3* translation)
+{
+  return rmsd(a.data(), b.data(), std::min(a.size(), b.size()), align,
+              rotation, translation);
+}
+
+bool RmsdCalculator::extractFrames(std::vector<Frame>& frames) const
+{
+  if (!m_molecule)
+    return false;
+
+  Index atomCount = m_molecule->atomCount();
+  for (size_t i = 0; i < m_atoms.size(); ++i) {
+    if (m_atoms[i] >= atomCount)
+      return false;
+  }
+
+  // Copy the selected atoms of every frame into contiguous storage on this
+  // thread, the workers then only read the frames.
+  int count = frameCount();
+  frames.resize(count);
+  for (int f = 0; f < count; ++f) {
+    const Array<Vector3> positions = m_molecule->coordinate3dCount() > 0
+                                       ? m_molecule->coordinate3d(f)
+                                       : m_molecule->atomPositions3d();
+    if (positions.size() < atomCount)
+      return false;
+
+    std::vector<Vector3>& points = frames[f].points;
+    if (m_atoms.empty()) {
+      points.assign(positions.begin(), positions.begin() + atomCount);
+    } else {
+      points.resize(m_atoms.size());
+      for (size_t i = 0; i < m_atoms.size(); ++i)
+        points[i] = positions[m_atoms[i]];
+    }
+
+    frames[f].squaredNorm = 0.0;
+    if (m_align) {
+      Vector3 center = centroid(points.data(), points.size());
+      for (size_t i = 0; i < points.size(); ++i) {
+        points[i] -= center;
+        frames[f].squaredNorm += points[i].squaredNorm();
+      }
+    }
+  }
+  return true;
+}
+
+Real RmsdCalculator::rmsd(const Frame& a, const Frame& b) const
+{
+  size_t count = a.points.size();
+  if (count == 0)
+    return 0.0;
+  if (!m_align)
+    return rmsd(a.points.data(), b.points.data(), count, false);
+  Real deviation =
+    alignedSquaredDeviation(a.points.data(), b.points.data(), count,
+                            a.squaredNorm + b.squaredNorm, nullptr);
+  return std::sqrt(deviation / static_cast<Real>(count));
+}
+
+} // End namespace Core
+} // End namespace Avogadro
@@ -0,0 +1,109 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_CORE_RMSDCALCULATOR_H
+#define AVOGADRO_CORE_RMSDCALCULATOR_H
+
+#include "avogadrocore.h"
+
+#include "matrix.h"
+#include "vector.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+
+/**
+ * @class RmsdCalculator rmsdcalculator.h <avogadro/core/rmsdcalculator.h>
+ * @brief Root mean square deviations between the frames of a trajectory.
+ *
+ * The frames are the coordinate sets stored with Molecule::coordinate3d(), or
+ * the current atom positions if the molecule has no coordinate sets. They are
+ * read with const accessors, so the molecule and the frame it displays are
+ * left untouched. By default all atoms are compared after the frames have
+ * been optimally superimposed with the Kabsch algorithm; setAtoms() restricts
+ * the calculation (and the superposition) to a subset of the atoms, e.g. the
+ * backbone of a protein.
+ *
+ * The frames are evaluated concurrently, one row of results per task.
+ */
+class AVOGADROCORE_EXPORT RmsdCalculator
+{
+public:
+  explicit RmsdCalculator(const Molecule* molecule = nullptr);
+  ~RmsdCalculator();
+
+  /** The molecule the frames are taken from. @{ */
+  void setMolecule(const Molecule* molecule);
+  const Molecule* molecule() const { return m_molecule; }
+  /** @} */
+
+  /**
+   * The indices of the atoms to compare, an empty list compares all atoms.
+   * @{
+   */
+  void setAtoms(const std::vector<Index>& atoms) { m_atoms = atoms; }
+  const std::vector<Index>& atoms() const { return m_atoms; }
+  /** @} */
+
+  /**
+   * Whether the frames are superimposed before they are compared. If false
+   * the RMSD of the raw coordinates is returned. Defaults to true. @{
+   */
+  void setAlign(bool align) { m_align = align; }
+  bool align() const { return m_align; }
+  /** @} */
+
+  /** @return The number of frames in the molecule. */
+  int frameCount() const;
+
+  /**
+   * @return The RMSD of each frame to the frame @a reference, in Angstrom.
+   * The result is empty if there is no molecule, the reference frame does not
+   * exist or a selected atom is out of range.
+   */
+  std::vector<Real> rmsdToFrame(int reference = 0) const;
+
+  /**
+   * @return The symmetric frameCount() x frameCount() matrix of the RMSD
+   * between every pair of frames, or an empty matrix on error.
+   */
+  MatrixX pairwiseRmsd() const;
+
+  /**
+   * Calculate the RMSD between @a count points at @a a and @a b.
+   * If @a align is true, @a b is first rotated and translated onto @a a to
+   * minimize the deviation. @a rotation and @a translation, if not null, are
+   * set to the transform that maps @a b onto @a a, rotation * b + translation.
+   */
+  static Real rmsd(const Vector3* a, const Vector3* b, size_t count,
+                   bool align = true, Matrix3* rotation = nullptr,
+                   Vector3* translation = nullptr);
+
+  /** @overload */
+  static Real rmsd(const std::vector<Vector3>& a,
+                   const std::vector<Vector3>& b, bool align = true,
+                   Matrix3* rotation = nullptr, Vector3* translation = nullptr);
+
+private:
+  // Not implemented.
+  RmsdCalculator(const RmsdCalculator&);
+  RmsdCalculator& operator=(const RmsdCalculator&);
+
+  struct Frame;
+  bool extractFrames(std::vector<Frame>& frames) const;
+  Real rmsd(const Frame& a, const Frame& b) const;
+
+  const Molecule* m_molecule;
+  std::vector<Index> m_atoms;
+  bool m_align;
+};
+
+} // End namespace Core
+} // End namespace Avogadro
+
+#endif // AVOGADRO_CORE_RMSDCALCULATOR_H
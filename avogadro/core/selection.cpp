@@ -0,0 +1,255 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "selection.h"
+
+#include <algorithm>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+typedef uint64_t Word;
+const Index wordBits = 64;
+const Word allBits = ~Word(0);
+
+Index wordCount(Index size)
+{
+  return (size + wordBits - 1) / wordBits;
+}
+
+Index popCount(Word word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<Index>(__builtin_popcountll(word));
+#else
+  const Word m1 = 0x5555555555555555ULL;
+  const Word m2 = 0x3333333333333333ULL;
+  const Word m4 = 0x0f0f0f0f0f0f0f0fULL;
+  word = word - ((word >> 1) & m1);
+  word = (word & m2) + ((word >> 2) & m2);
+  word = (word + (word >> 4)) & m4;
+  return static_cast<Index>((word * 0x0101010101010101ULL) >> 56);
+#endif
+}
+
+// The index of the lowest set bit, word must not be zero.
+Index lowestBit(Word word)
+{
+#if defined(__GNUC__) || defined(__clang__)
+  return static_cast<Index>(__builtin_ctzll(word));
+#else
+  Index bit = 0;
+  while (!(word & 1)) {
+    word >>= 1;
+    ++bit;
+  }
+  return bit;
+#endif
+}
+
+// Call op(word, mask) for each word overlapping [first, end), with mask
+// holding the bits of that word in the range.
+template <typename Op>
+void forRange(std::vector<Word>& words, Index first, Index end, Op op)
+{
+  if (first >= end)
+    return;
+  Index firstWord = first / wordBits;
+  Index lastWord = (end - 1) / wordBits;
+  Word firstMask = allBits << (first % wordBits);
+  Word lastMask = allBits >> (wordBits - 1 - (end - 1) % wordBits);
+  if (firstWord == lastWord) {
+    op(words[firstWord], firstMask & lastMask);
+    return;
+  }
+  op(words[firstWord], firstMask);
+  for (Index i = firstWord + 1; i < lastWord; ++i)
+    op(words[i], allBits);
+  op(words[lastWord], lastMask);
+}
+
+void setBits(Word& word, Word mask)
+{
+  word |= mask;
+}
+
+void clearBits(Word& word, Word mask)
+{
+  word &= ~mask;
+}
+
+void flipBits(Word& word, Word mask)
+{
+  word ^= mask;
+}
+} // namespace
+
+Selection::Selection() : m_size(0) {}
+
+Selection::Selection(Index size) : m_words(wordCount(size), 0), m_size(size)
+{
+}
+
+void Selection::resize(Index size)
+{
+  m_words.resize(wordCount(size), 0);
+  m_size = size;
+  trim();
+}
+
+void Selection::clear()
+{
+  m_words.clear();
+  m_size = 0;
+}
+
+bool Selection::test(Index index) const
+{
+  if (index >= m_size)
+    return false;
+  return (m_words[index / wordBits] >> (index % wordBits)) & 1;
+}
+
+void Selection::set(Index index, bool selected)
+{
+  if (index >= m_size)
+    return;
+  Word mask = Word(1) << (index % wordBits);
+  if (selected)
+    m_words[index / wordBits] |= mask;
+  else
+    m_words[index / wordBits] &= ~mask;
+}
+
+void Selection::setRange(Index first, Index end, bool selected)
+{
+  forRange(m_words, first, std::min(end, m_size),
+           selected ? setBits : clearBits);
+}
+
+void Selection::setAll(bool selected)
+{
+  std::fill(m_words.begin(), m_words.end(), selected ? allBits : 0);
+  trim();
+}
+
+void Selection::flip(Index index)
+{
+  if (index < m_size)
+    m_words[index / wordBits] ^= Word(1) << (index % wordBits);
+}
+
+void Selection::flipRange(Index first, Index end)
+{
+  forRange(m_words, first, std::min(end, m_size), flipBits);
+}
+
+void Selection::flipAll()
+{
+  for (size_t i = 0; i < m_words.size(); ++i)
+    m_words[i] = ~m_words[i];
+  trim();
+}
+
+Index Selection::count() const
+{
+  Index result = 0;
+  for (size_t i = 0; i < m_words.size(); ++i)
+    result += popCount(m_words[i]);
+  return result;
+}
+
+bool Selection::any() const
+{
+  for (size_t i = 0; i < m_words.size(); ++i) {
+    if (m_words[i])
+      return true;
+  }
+  return false;
+}
+
+Index Selection::first() const
+{
+  return test(0) ? 0 : next(0);
+}
+
+Index Selection::next(Index index) const
+{
+  ++index;
+  if (index >= m_size)
+    return MaxIndex;
+  Index word = index / wordBits;
+  Word bits = m_words[word] & (allBits << (index % wordBits));
+  while (!bits) {
+    if (++word == m_words.size())
+      return MaxIndex;
+    bits = m_words[word];
+  }
+  return word * wordBits + lowestBit(bits);
+}
+
+std::vector<Index> Selection::indices() const
+{
+  std::vector<Index> result;
+  result.reserve(count());
+  for (Index i = first(); i != MaxIndex; i = next(i))
+    result.push_back(i);
+  return result;
+}
+
+void Selection::swapRemove(Index index, Index last)
+{
+  set(index, test(last));
+  if (m_size > last)
+    resize(last);
+}
+
+Selection& Selection::operator|=(const Selection& other)
+{
+  size_t n = std::min(m_words.size(), other.m_words.size());
+  for (size_t i = 0; i < n; ++i)
+    m_words[i] |= other.m_words[i];
+  trim();
+  return *this;
+}
+
+Selection& Selection::operator&=(const Selection& other)
+{
+  size_t n = std::min(m_words.size(), other.m_words.size());
+  for (size_t i = 0; i < n; ++i)
+    m_words[i] &= other.m_words[i];
+  std::fill(m_words.begin() + n, m_words.end(), 0);
+  return *this;
+}
+
+Selection& Selection::operator^=(const Selection& other)
+{
+  size_t n = std::min(m_words.size(), other.m_words.size());
+  for (size_t i = 0; i < n; ++i)
+    m_words[i] ^= other.m_words[i];
+  trim();
+  return *this;
+}
+
+Selection& Selection::subtract(const Selection& other)
+{
+  size_t n = std::min(m_words.size(), other.m_words.size());
+  for (size_t i = 0; i < n; ++i)
+    m_words[i] &= ~other.m_words[i];
+  return *this;
+}
+
+bool Selection::operator==(const Selection& other) const
+{
+  return m_size == other.m_size && m_words == other.m_words;
+}
+
+void Selection::trim()
+{
+  if (m_size % wordBits)
+    m_words.back() &= allBits >> (wordBits - m_size % wordBits);
+}
+
+} // namespace Core
+} // namespace Avogadro
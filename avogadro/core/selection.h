@@ -0,0 +1,120 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_CORE_SELECTION_H
+#define AVOGADRO_CORE_SELECTION_H
+
+#include "avogadrocore.h"
+
+#include <cstdint>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+/**
+ * @class Selection selection.h <avogadro/core/selection.h>
+ * @brief A dense set of selected atom or bond indices, stored one bit per
+ * index.
+ *
+ * Indices at or past size() are never selected, and setting them is ignored.
+ * Counting, range updates and the set operations work a 64 bit word at a
+ * time. To visit the selected indices use:
+ * @code
+ * for (Index i = selection.first(); i != MaxIndex; i = selection.next(i))
+ * @endcode
+ */
+class AVOGADROCORE_EXPORT Selection
+{
+public:
+  /** Creates an empty selection. */
+  Selection();
+
+  /** Creates a selection of @p size indices, none of them selected. */
+  explicit Selection(Index size);
+
+  /** @return The number of indices covered by the selection. */
+  Index size() const { return m_size; }
+
+  /** Set the number of indices covered, new ones are not selected. */
+  void resize(Index size);
+
+  /** Remove all indices. */
+  void clear();
+
+  /** @return True if @p index is selected. */
+  bool test(Index index) const;
+
+  /** Select or deselect @p index. */
+  void set(Index index, bool selected = true);
+
+  /** Select or deselect the indices in [first, end). */
+  void setRange(Index first, Index end, bool selected = true);
+
+  /** Select or deselect all indices. */
+  void setAll(bool selected = true);
+
+  /** Toggle whether @p index is selected. */
+  void flip(Index index);
+
+  /** Toggle the indices in [first, end). */
+  void flipRange(Index first, Index end);
+
+  /** Toggle all indices. */
+  void flipAll();
+
+  /** @return The number of selected indices. */
+  Index count() const;
+
+  /** @return True if any index is selected. */
+  bool any() const;
+
+  /** @return True if no index is selected. */
+  bool none() const { return !any(); }
+
+  /** @return The first selected index, MaxIndex if there is none. */
+  Index first() const;
+
+  /** @return The first selected index after @p index, MaxIndex if none. */
+  Index next(Index index) const;
+
+  /** @return The selected indices in increasing order. */
+  std::vector<Index> indices() const;
+
+  /**
+   * Move the state of @p last into @p index, then shrink to @p last indices
+   * if larger. This mirrors how Molecule removes atoms and bonds, with @p last
+   * the index of the last atom or bond.
+   */
+  void swapRemove(Index index, Index last);
+
+  /**
+   * Set operations with @p other. Indices past the end of @p other count as
+   * not selected, and the size of this selection does not change.
+   * @{
+   */
+  Selection& operator|=(const Selection& other);
+  Selection& operator&=(const Selection& other);
+  Selection& operator^=(const Selection& other);
+  /** Deselect the indices selected in @p other. */
+  Selection& subtract(const Selection& other);
+  /** @} */
+
+  bool operator==(const Selection& other) const;
+  bool operator!=(const Selection& other) const { return !(*this == other); }
+
+private:
+  typedef uint64_t Word;
+
+  // Clear the bits past m_size in the last word, so whole words can be
+  // counted and compared.
+  void trim();
+
+  std::vector<Word> m_words;
+  Index m_size;
+};
+
+} // namespace Core
+} // namespace Avogadro
+
+#endif // AVOGADRO_CORE_SELECTION_H
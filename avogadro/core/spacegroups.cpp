@@ -17,11 +17,14 @@
 #include <algorithm> // for std::count()
 #include <cassert>
 #include <cctype> // for isdigit()
+#include <cmath>
 #include <iostream>
+#include <mutex>
 
 #include "array.h"
 #include "crystaltools.h"
 #include "molecule.h"
+#include "neighborlist.h"
 #include "spacegroupdata.h"
 #include "unitcell.h"
 #include "utilities.h"
@@ -217,20 +220,64 @@ Vector3 getSingleTransform(const std::string& transform, const Vector3& v)
   return ret;
 }
 
+namespace {
+
+// A symmetry operation acting on fractional coordinates, rotation * v +
+// translation.
+struct SymmetryOperation
+{
+  Matrix3 rotation;
+  Vector3 translation;
+
+  Vector3 apply(const Vector3& v) const { return rotation * v + translation; }
+};
+
+// Parsing the transform strings dominates applying them, so each hall number
+// is only parsed once. The operations are affine, so evaluating a transform
+// at the origin gives its translation and at the unit vectors its rotation.
+const std::vector<SymmetryOperation>& symmetryOperations(
+  unsigned short hallNumber, const char* transformsStr)
+{
+  static std::vector<SymmetryOperation> operations[531];
+  static std::once_flag parsed[531];
+  std::call_once(parsed[hallNumber], [&]() {
+    std::vector<std::string> transforms = split(transformsStr, ' ');
+    for (Index i = 0; i < transforms.size(); ++i) {
+      SymmetryOperation operation;
+      operation.translation =
+        getSingleTransform(transforms[i], Vector3::Zero());
+      for (int j = 0; j < 3; ++j) {
+        operation.rotation.col(j) =
+          getSingleTransform(transforms[i], Vector3::Unit(j)) -
+          operation.translation;
+      }
+      operations[hallNumber].push_back(operation);
+    }
+  });
+  return operations[hallNumber];
+}
+
+// Choose a grid cell of roughly one atom once the cell has been filled.
+Real gridCellSize(const UnitCell& uc, Index atomCount, double cartTol)
+{
+  Real atomVolume =
+    uc.volume() / static_cast<Real>(std::max(atomCount, Index(1)));
+  return std::max(static_cast<Real>(cartTol), std::cbrt(atomVolume));
+}
+} // end anonymous namespace
+
 Array<Vector3> SpaceGroups::getTransforms(unsigned short hallNumber,
                                           const Vector3& v)
 {
   if (hallNumber == 0 || hallNumber > 530)
     return Array<Vector3>();
 
+  const std::vector<SymmetryOperation>& operations =
+    symmetryOperations(hallNumber, transformsString(hallNumber));
   Array<Vector3> ret;
-
-  std::string transformsStr = transformsString(hallNumber);
-  // These transforms are separated by spaces
-  std::vector<std::string> transforms = split(transformsStr, ' ');
-
-  for (Index i = 0; i < transforms.size(); ++i)
-    ret.push_back(getSingleTransform(transforms[i], v));
+  ret.reserve(operations.size());
+  for (Index i = 0; i < operations.size(); ++i)
+    ret.push_back(operations[i].apply(v));
 
   return ret;
 }
@@ -246,30 +293,36 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
   Array<Vector3> positions = mol.atomPositions3d();
   Index numAtoms = mol.atomCount();
 
+  std::vector<SymmetryOperation> noOperations;
+  const std::vector<SymmetryOperation>& operations =
+    hallNumber == 0 || hallNumber > 530
+      ? noOperations
+      : symmetryOperations(hallNumber, transformsString(hallNumber));
+
+  // Look for atoms already present on a periodic grid in the cell, which
+  // receives the new atoms as they are added.
+  Real cellSize = gridCellSize(*uc, numAtoms * operations.size(), cartTol);
+  NeighborList neighbors;
+  neighbors.build(positions, cellSize, uc);
+
   // We are going to loop through the original atoms. That is why
   // we have numAtoms cached instead of using atomCount().
   for (Index i = 0; i < numAtoms; ++i) {
     unsigned char atomicNum = atomicNumbers[i];
     Vector3 pos = uc->toFractional(positions[i]);
 
-    Array<Vector3> newAtoms = getTransforms(hallNumber, pos);
-
     // We skip 0 because it is the original atom.
-    for (Index j = 1; j < newAtoms.size(); ++j) {
+    for (Index j = 1; j < operations.size(); ++j) {
       // The new atoms are in fractional coordinates. Convert to cartesian.
-      Vector3 newCandidate = uc->toCartesian(newAtoms[j]);
+      Vector3 newCandidate = uc->toCartesian(operations[j].apply(pos));
 
       // If there is already an atom in this location within a
       // certain tolerance, do not add the atom.
       bool atomAlreadyPresent = false;
-      for (Index k = 0; k < mol.atomCount(); k++) {
-        // If it does not have the same atomic number, skip over it.
-        if (mol.atomicNumber(k) != atomicNum)
-          continue;
-        Real distance = uc->distance(mol.atomPosition3d(k), newCandidate);
-        if (distance <= cartTol)
+      neighbors.forEachNeighbor(newCandidate, cartTol, [&](Index k, Real) {
+        if (mol.atomicNumber(k) == atomicNum)
           atomAlreadyPresent = true;
-      }
+      });
 
       // If there is already an atom present here, just continue
       if (atomAlreadyPresent)
@@ -278,6 +331,7 @@ void SpaceGroups::fillUnitCell(Molecule& mol, unsigned short hallNumber,
       // If we got this far, add the atom!
       Atom newAtom = mol.addAtom(atomicNum);
       newAtom.setPosition3d(newCandidate);
+      neighbors.addPosition(newCandidate);
     }
   }
   CrystalTools::wrapAtomsToUnitCell(mol);
@@ -290,40 +344,43 @@ void SpaceGroups::reduceToAsymmetricUnit(Molecule& mol,
   if (!mol.unitCell())
     return;
   UnitCell* uc = mol.unitCell();
+  if (hallNumber == 0 || hallNumber > 530)
+    return;
 
-  // The number of atoms may change as we remove atoms, so don't cache
-  // the number of atoms, atomic positions, or atomic numbers
-  // There's no point in looking at the last atom
-  for (Index i = 0; i + 1 < mol.atomCount(); ++i) {
-    unsigned char atomicNum = mol.atomicNumber(i);
-    Vector3 pos = uc->toFractional(mol.atomPosition3d(i));
-    Array<Vector3> transformAtoms = getTransforms(hallNumber, pos);
-
-    // Loop through the rest of the atoms in this crystal and see if any match
-    // up with a transform
-    for (Index j = i + 1; j < mol.atomCount(); ++j) {
-      // If the atomic number does not match, skip over it
-      if (mol.atomicNumber(j) != atomicNum)
-        continue;
+  const std::vector<SymmetryOperation>& operations =
+    symmetryOperations(hallNumber, transformsString(hallNumber));
+  Array<unsigned char> atomicNumbers = mol.atomicNumbers();
+  Array<Vector3> positions = mol.atomPositions3d();
+  Index numAtoms = mol.atomCount();
 
-      Vector3 trialPos = mol.atomPosition3d(j);
-      // Loop through the transform atoms
-      // We skip 0 because it is the original atom.
-      for (Index k = 1; k < transformAtoms.size(); ++k) {
-        // The transform atoms are in fractional coordinates. Convert to
-        // cartesian.
-        Vector3 transformPos = uc->toCartesian(transformAtoms[k]);
-        Real distance = uc->distance(trialPos, transformPos);
-        // Is the atom within the cartesian tolerance distance?
-        if (distance <= cartTol) {
-          // Remove this atom and adjust the index
-          mol.removeAtom(j);
-          --j;
-          break;
-        }
-      }
+  NeighborList neighbors;
+  neighbors.build(positions, gridCellSize(*uc, numAtoms, cartTol), uc);
+
+  // Mark every atom that is the image of an earlier atom that is kept.
+  std::vector<bool> remove(numAtoms, false);
+  for (Index i = 0; i + 1 < numAtoms; ++i) {
+    if (remove[i])
+      continue;
+    unsigned char atomicNum = atomicNumbers[i];
+    Vector3 pos = uc->toFractional(positions[i]);
+
+    // We skip 0 because it is the original atom.
+    for (Index k = 1; k < operations.size(); ++k) {
+      // The transform atoms are in fractional coordinates. Convert to
+      // cartesian.
+      Vector3 transformPos = uc->toCartesian(operations[k].apply(pos));
+      neighbors.forEachNeighbor(transformPos, cartTol, [&](Index j, Real) {
+        if (j > i && atomicNumbers[j] == atomicNum)
+          remove[j] = true;
+      });
     }
   }
+
+  // Remove from the back, so the atoms still to be removed keep their index.
+  for (Index i = numAtoms; i > 0; --i) {
+    if (remove[i - 1])
+      mol.removeAtom(i - 1);
+  }
 }
 
 const char* SpaceGroups::transformsString(unsigned short hallNumber)
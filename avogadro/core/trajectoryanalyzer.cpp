@@ -0,0 +1,307 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "trajectoryanalyzer.h"
+
+#include "molecule.h"
+#include "neighborlist.h"
+#include "parallel_p.h"
+#include "unitcell.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+
+// The shortest distance between opposite faces of the unit cell along each
+// lattice vector.
+Vector3 cellWidths(const UnitCell& cell)
+{
+  const Real volume = cell.volume();
+  const Vector3 a = cell.aVector();
+  const Vector3 b = cell.bVector();
+  const Vector3 c = cell.cVector();
+  return Vector3(volume / b.cross(c).norm(), volume / c.cross(a).norm(),
+                 volume / a.cross(b).norm());
+}
+
+// The volume of the bounding box of the first count positions.
+Real boundingVolume(const Array<Vector3>& positions, size_t count)
+{
+  if (count == 0)
+    return 0.0;
+  Vector3 lower(positions[0]);
+  Vector3 upper(positions[0]);
+  for (size_t i = 1; i < count; ++i) {
+    lower = lower.cwiseMin(positions[i]);
+    upper = upper.cwiseMax(positions[i]);
+  }
+  return (upper - lower).prod();
+}
+
+// Sort the first atomCount positions into a neighbor list for queries up to
+// radius. Up to half the cell width the minimum image is enough. Beyond that
+// the images within radius of the cell are added explicitly after the atoms
+// themselves, so point j of the list is always atom j % atomCount and the
+// first atomCount points are the query positions.
+void buildNeighborList(NeighborList& list, const Array<Vector3>& positions,
+                       Index atomCount, Real radius, const UnitCell* cell)
+{
+  Array<Vector3> points;
+  const Vector3 widths = cell ? cellWidths(*cell) : Vector3::Zero();
+  if (!cell || 2.0 * radius <= widths.minCoeff()) {
+    points.reserve(atomCount);
+    for (Index i = 0; i < atomCount; ++i)
+      points.push_back(positions[i]);
+    list.build(points, radius, cell);
+    return;
+  }
+
+  const int na = static_cast<int>(std::ceil(radius / widths[0]));
+  const int nb = static_cast<int>(std::ceil(radius / widths[1]));
+  const int nc = static_cast<int>(std::ceil(radius / widths[2]));
+  points.reserve(atomCount * (2 * na + 1) * (2 * nb + 1) * (2 * nc + 1));
+  for (Index i = 0; i < atomCount; ++i)
+    points.push_back(cell->wrapCartesian(positions[i]));
+  for (int a = -na; a <= na; ++a) {
+    for (int b = -nb; b <= nb; ++b) {
+      for (int c = -nc; c <= nc; ++c) {
+        if (a == 0 && b == 0 && c == 0)
+          continue;
+        const Vector3 offset = cell->imageOffset(a, b, c);
+        for (Index i = 0; i < atomCount; ++i)
+          points.push_back(points[i] + offset);
+      }
+    }
+  }
+  list.build(points, radius);
+}
+} // End anonymous namespace
+
+TrajectoryAnalyzer::TrajectoryAnalyzer(const Molecule* molecule)
+  : m_molecule(molecule)
+{
+}
+
+TrajectoryAnalyzer::~TrajectoryAnalyzer()
+{
+}
+
+int TrajectoryAnalyzer::frameCount() const
+{
+  if (!m_molecule)
+    return 0;
+  return std::max(m_molecule->coordinate3dCount(), 1);
+}
+
+TrajectoryAnalyzer::RadialDistribution TrajectoryAnalyzer::radialDistribution(
+  unsigned char center, unsigned char neighbor, Real maxRadius,
+  size_t binCount) const
+{
+  RadialDistribution result;
+  std::vector<Array<Vector3>> frames;
+  if (binCount == 0 || !extractFrames(frames))
+    return result;
+
+  std::vector<Index> centers = selectAtoms(center);
+  std::vector<Index> neighbors = selectAtoms(neighbor);
+  if (maxRadius <= 0.0 || centers.empty() || neighbors.empty())
+    return result;
+
+  const Index atomCount = m_molecule->atomCount();
+  std::vector<bool> isNeighbor(atomCount, false);
+  for (size_t i = 0; i < neighbors.size(); ++i)
+    isNeighbor[neighbors[i]] = true;
+  // Pairs of an atom with itself are not counted.
+  Real pairCount = static_cast<Real>(centers.size()) * neighbors.size();
+  for (size_t i = 0; i < centers.size(); ++i) {
+    if (isNeighbor[centers[i]])
+      pairCount -= 1.0;
+  }
+  if (pairCount <= 0.0)
+    return result;
+
+  const UnitCell* cell = m_molecule->unitCell();
+  const Real binWidth = maxRadius / binCount;
+  std::vector<std::vector<Real>> counts(frames.size());
+  std::vector<Real> volumes(frames.size());
+  runParallel(frames.size(), [&](size_t f) {
+    const Array<Vector3>& positions = frames[f];
+    std::vector<Real>& histogram = counts[f];
+    histogram.assign(binCount, 0.0);
+    volumes[f] = cell ? cell->volume() : boundingVolume(positions, atomCount);
+
+    NeighborList list;
+    buildNeighborList(list, positions, atomCount, maxRadius, cell);
+    for (size_t c = 0; c < centers.size(); ++c) {
+      const Index i = centers[c];
+      list.forEachNeighbor(list.position(i), maxRadius,
+                           [&](Index j, Real distanceSquared) {
+                             if (j == i || !isNeighbor[j % atomCount])
+                               return;
+                             size_t bin = static_cast<size_t>(
+                               std::sqrt(distanceSquared) / binWidth);
+                             if (bin < binCount)
+                               histogram[bin] += 1.0;
+                           });
+    }
+  });
+
+  // Each frame is normalized by its own density, then the frames are
+  // averaged.
+  result.radii.resize(binCount);
+  result.values.assign(binCount, 0.0);
+  result.coordination.assign(binCount, 0.0);
+  const Real frameCount = static_cast<Real>(frames.size());
+  for (size_t f = 0; f < frames.size(); ++f) {
+    for (size_t bin = 0; bin < binCount; ++bin) {
+      result.values[bin] += counts[f][bin] * volumes[f] / pairCount;
+      result.coordination[bin] += counts[f][bin];
+    }
+  }
+  Real running = 0.0;
+  for (size_t bin = 0; bin < binCount; ++bin) {
+    const Real inner = bin * binWidth;
+    const Real outer = inner + binWidth;
+    const Real shell =
+      4.0 / 3.0 * M_PI * (outer * outer * outer - inner * inner * inner);
+    result.radii[bin] = inner + 0.5 * binWidth;
+    result.values[bin] /= frameCount * shell;
+    running += result.coordination[bin] / (frameCount * centers.size());
+    result.coordination[bin] = running;
+  }
+  return result;
+}
+
+std::vector<Real> TrajectoryAnalyzer::coordinationHistogram(
+  unsigned char center, unsigned char neighbor, Real cutoff) const
+{
+  std::vector<Real> result;
+  std::vector<Array<Vector3>> frames;
+  if (cutoff <= 0.0 || !extractFrames(frames))
+    return result;
+
+  std::vector<Index> centers = selectAtoms(center);
+  std::vector<Index> neighbors = selectAtoms(neighbor);
+  if (centers.empty())
+    return result;
+
+  const Index atomCount = m_molecule->atomCount();
+  std::vector<bool> isNeighbor(atomCount, false);
+  for (size_t i = 0; i < neighbors.size(); ++i)
+    isNeighbor[neighbors[i]] = true;
+
+  const UnitCell* cell = m_molecule->unitCell();
+  std::vector<std::vector<size_t>> histograms(frames.size());
+  runParallel(frames.size(), [&](size_t f) {
+    const Array<Vector3>& positions = frames[f];
+    std::vector<size_t>& histogram = histograms[f];
+
+    NeighborList list;
+    buildNeighborList(list, positions, atomCount, cutoff, cell);
+    for (size_t c = 0; c < centers.size(); ++c) {
+      const Index i = centers[c];
+      size_t count = 0;
+      list.forEachNeighbor(list.position(i), cutoff, [&](Index j, Real) {
+        if (j != i && isNeighbor[j % atomCount])
+          ++count;
+      });
+      if (count >= histogram.size())
+        histogram.resize(count + 1, 0);
+      ++histogram[count];
+    }
+  });
+
+  const Real total = static_cast<Real>(frames.size() * centers.size());
+  for (size_t f = 0; f < histograms.size(); ++f) {
+    if (histograms[f].size() > result.size())
+      result.resize(histograms[f].size(), 0.0);
+    for (size_t n = 0; n < histograms[f].size(); ++n)
+      result[n] += histograms[f][n] / total;
+  }
+  return result;
+}
+
+std::vector<Real> TrajectoryAnalyzer::meanSquareDisplacement(
+  unsigned char element) const
+{
+  std::vector<Real> result;
+  std::vector<Array<Vector3>> frames;
+  if (!extractFrames(frames))
+    return result;
+  std::vector<Index> atoms = selectAtoms(element);
+  if (atoms.empty())
+    return result;
+
+  // Gather the selected atoms of every frame, unwrapping periodic
+  // trajectories by following the shortest step between frames.
+  const UnitCell* cell = m_molecule->unitCell();
+  const size_t atomCount = atoms.size();
+  std::vector<Vector3> points(frames.size() * atomCount);
+  for (size_t f = 0; f < frames.size(); ++f) {
+    const Array<Vector3>& positions = frames[f];
+    for (size_t i = 0; i < atomCount; ++i) {
+      const Vector3& position = positions[atoms[i]];
+      Vector3& point = points[f * atomCount + i];
+      if (cell && f > 0) {
+        const Vector3& previous = points[(f - 1) * atomCount + i];
+        const Array<Vector3>& last = frames[f - 1];
+        point = previous + cell->minimumImage(position - last[atoms[i]]);
+      } else {
+        point = position;
+      }
+    }
+  }
+
+  result.assign(frames.size(), 0.0);
+  runParallel(frames.size(), [&](size_t lag) {
+    const size_t origins = frames.size() - lag;
+    Real sum = 0.0;
+    for (size_t t = 0; t < origins; ++t) {
+      const Vector3* from = &points[t * atomCount];
+      const Vector3* to = &points[(t + lag) * atomCount];
+      for (size_t i = 0; i < atomCount; ++i)
+        sum += (to[i] - from[i]).squaredNorm();
+    }
+    result[lag] = sum / static_cast<Real>(origins * atomCount);
+  });
+  return result;
+}
+
+std::vector<Index> TrajectoryAnalyzer::selectAtoms(unsigned char element) const
+{
+  std::vector<Index> atoms;
+  const Array<unsigned char>& atomicNumbers = m_molecule->atomicNumbers();
+  for (Index i = 0; i < atomicNumbers.size(); ++i) {
+    if (element == 0 || atomicNumbers[i] == element)
+      atoms.push_back(i);
+  }
+  return atoms;
+}
+
+bool TrajectoryAnalyzer::extractFrames(
+  std::vector<Array<Vector3>>& frames) const
+{
+  if (!m_molecule || m_molecule->atomCount() == 0)
+    return false;
+
+  // The copies share their data with the molecule. They are taken on this
+  // thread, the workers only use the const accessors, which never detach.
+  const Index atomCount = m_molecule->atomCount();
+  int count = frameCount();
+  frames.resize(count);
+  for (int f = 0; f < count; ++f) {
+    frames[f] = m_molecule->coordinate3dCount() > 0
+                  ? m_molecule->coordinate3d(f)
+                  : m_molecule->atomPositions3d();
+    if (frames[f].size() < atomCount)
+      return false;
+  }
+  return true;
+}
+
+} // End namespace Core
+} // End namespace Avogadro
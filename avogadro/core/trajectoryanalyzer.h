@@ -0,0 +1,106 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_CORE_TRAJECTORYANALYZER_H
+#define AVOGADRO_CORE_TRAJECTORYANALYZER_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+
+/**
+ * @class TrajectoryAnalyzer trajectoryanalyzer.h
+ * <avogadro/core/trajectoryanalyzer.h>
+ * @brief Structural analysis of the frames of a trajectory.
+ *
+ * The frames are the coordinate sets stored with Molecule::coordinate3d(), or
+ * the current atom positions if the molecule has no coordinate sets. Atoms
+ * are selected by atomic number, 0 selects every atom.
+ *
+ * If the molecule has a unit cell the frames are treated as periodic: every
+ * periodic image within the radius of interest is counted, and the number
+ * density is taken from the cell volume. Otherwise the volume of the bounding
+ * box of each frame is used, which only gives a rough normalization of g(r).
+ *
+ * The frames are shared with the molecule, not copied. The radial
+ * distribution and the coordination numbers are evaluated one frame per task
+ * with a NeighborList, the mean square displacement one lag per task.
+ */
+class AVOGADROCORE_EXPORT TrajectoryAnalyzer
+{
+public:
+  /** A radial distribution function, sampled at the centers of its bins. */
+  struct RadialDistribution
+  {
+    /** The center of each bin, in Angstrom. */
+    std::vector<Real> radii;
+    /** The pair distribution g(r) of each bin. */
+    std::vector<Real> values;
+    /**
+     * The running coordination number, the mean number of neighbors within
+     * the outer edge of each bin.
+     */
+    std::vector<Real> coordination;
+  };
+
+  explicit TrajectoryAnalyzer(const Molecule* molecule = nullptr);
+  ~TrajectoryAnalyzer();
+
+  /** The molecule the frames are taken from. @{ */
+  void setMolecule(const Molecule* molecule) { m_molecule = molecule; }
+  const Molecule* molecule() const { return m_molecule; }
+  /** @} */
+
+  /** @return The number of frames in the molecule. */
+  int frameCount() const;
+
+  /**
+   * @return The radial distribution of the atoms @a neighbor around the atoms
+   * @a center, averaged over all frames, in @a binCount bins up to
+   * @a maxRadius. The result is empty if no pair of atoms matches.
+   */
+  RadialDistribution radialDistribution(unsigned char center = 0,
+                                        unsigned char neighbor = 0,
+                                        Real maxRadius = 10.0,
+                                        size_t binCount = 200) const;
+
+  /**
+   * @return The fraction of the atoms @a center, over all frames, with n
+   * atoms @a neighbor within @a cutoff at index n.
+   */
+  std::vector<Real> coordinationHistogram(unsigned char center,
+                                          unsigned char neighbor,
+                                          Real cutoff) const;
+
+  /**
+   * @return The mean square displacement of the atoms @a element in square
+   * Angstrom, for lags of 0 to frameCount() - 1 frames, averaged over all
+   * time origins. Periodic frames are unwrapped first, assuming no atom
+   * moves by more than half a cell between consecutive frames.
+   */
+  std::vector<Real> meanSquareDisplacement(unsigned char element = 0) const;
+
+private:
+  // Not implemented.
+  TrajectoryAnalyzer(const TrajectoryAnalyzer&);
+  TrajectoryAnalyzer& operator=(const TrajectoryAnalyzer&);
+
+  std::vector<Index> selectAtoms(unsigned char element) const;
+  bool extractFrames(std::vector<Array<Vector3>>& frames) const;
+
+  const Molecule* m_molecule;
+};
+
+} // End namespace Core
+} // End namespace Avogadro
+
+#endif // AVOGADRO_CORE_TRAJECTORYANALYZER_H
@@ -37,6 +37,11 @@ bool VariantMap::isEmpty() const
   return m_map.empty();
 }
 
+void VariantMap::clear()
+{
+  m_map.clear();
+}
+
 std::vector<std::string> VariantMap::names() const
 {
   std::vector<std::string> result;
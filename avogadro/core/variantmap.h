@@ -52,6 +52,9 @@ public:
   /** Returns \c true if the variant map is empty (i.e. size() == \c 0). */
   bool isEmpty() const;
 
+  /** Removes all entries from the map. */
+  void clear();
+
   /** Returns the names of the entries in the map. */
   std::vector<std::string> names() const;
 
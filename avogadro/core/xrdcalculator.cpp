@@ -0,0 +1,550 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "xrdcalculator.h"
+
+#include "molecule.h"
+#include "parallel_p.h"
+#include "unitcell.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace Avogadro {
+namespace Core {
+
+namespace {
+
+const Real pi = 3.14159265358979323846;
+const Real degreesToRadians = pi / 180.0;
+
+// Cromer-Mann coefficients a1, b1, a2, b2, a3, b3, a4, b4, c of the neutral
+// atoms H to Cf, from the International Tables for Crystallography, Vol. C,
+// Table 6.1.1.4.
+const unsigned char cromerMannElements = 98;
+const Real cromerMannCoefficients[cromerMannElements][9] = {
+  { 0.489918, 20.6593, 0.262003, 7.74039, 0.196767, 49.5519, 0.049879, 2.20159,
+    0.001305 }, // H
+  { 0.8734, 9.1037, 0.6309, 3.3568, 0.3112, 22.9276, 0.178, 0.9821,
+    0.0064 }, // He
+  { 1.1282, 3.9546, 0.7508, 1.0524, 0.6175, 85.3905, 0.4653, 168.261,
+    0.0377 }, // Li
+  { 1.5919, 43.6427, 1.1278, 1.8623, 0.5391, 103.483, 0.7029, 0.542,
+    0.0385 }, // Be
+  { 2.0545, 23.2185, 1.3326, 1.021, 1.0979, 60.3498, 0.7068, 0.1403,
+    -0.1932 }, // B
+  { 2.31, 20.8439, 1.02, 10.2075, 1.5886, 0.5687, 0.865, 51.6512, 0.2156 }, // C
+  { 12.2126, 0.0057, 3.1322, 9.8933, 2.0125, 28.9975, 1.1663, 0.5826,
+    -11.529 }, // N
+  { 3.0485, 13.2771, 2.2868, 5.7011, 1.5463, 0.3239, 0.867, 32.9089,
+    0.2508 }, // O
+  { 3.5392, 10.2825, 2.6412, 4.2944, 1.517, 0.2615, 1.0243, 26.1476,
+    0.2776 }, // F
+  { 3.9553, 8.4042, 3.1125, 3.4262, 1.4546, 0.2306, 1.1251, 21.7184,
+    0.3515 }, // Ne
+  { 4.7626, 3.285, 3.1736, 8.8422, 1.2674, 0.3136, 1.1128, 129.424,
+    0.676 }, // Na
+  { 5.4204, 2.8275, 2.1735, 79.2611, 1.2269, 0.3808, 2.3073, 7.1937,
+    0.8584 }, // Mg
+  { 6.4202, 3.0387, 1.9002, 0.7426, 1.5936, 31.5472, 1.9646, 85.0886,
+    1.1151 }, // Al
+  { 6.2915, 2.4386, 3.0353, 32.3337, 1.9891, 0.6785, 1.541, 81.6937,
+    1.1407 }, // Si
+  { 6.4345, 1.9067, 4.1791, 27.157, 1.78, 0.526, 1.4908, 68.1645, 1.1149 }, // P
+  { 6.9053, 1.4679, 5.2034, 22.2151, 1.4379, 0.2536, 1.5863, 56.172,
+    0.8669 }, // S
+  { 11.4604, 0.0104, 7.1962, 1.1662, 6.2556, 18.5194, 1.6455, 47.7784,
+    -9.5574 }, // Cl
+  { 7.4845, 0.9072, 6.7723, 14.8407, 0.6539, 43.8983, 1.6442, 33.3929,
+    1.4445 }, // Ar
+  { 8.2186, 12.7949, 7.4398, 0.7748, 1.0519, 213.187, 0.8659, 41.6841,
+    1.4228 }, // K
+  { 8.6266, 10.4421, 7.3873, 0.6599, 1.5899, 85.7484, 1.0211, 178.437,
+    1.3751 }, // Ca
+  { 9.189, 9.0213, 7.3679, 0.5729, 1.6409, 136.108, 1.468, 51.3531,
+    1.3329 }, // Sc
+  { 9.7595, 7.8508, 7.3558, 0.5, 1.6991, 35.6338, 1.9021, 116.105,
+    1.2807 }, // Ti
+  { 10.2971, 6.8657, 7.3511, 0.4385, 2.0703, 26.8938, 2.0571, 102.478,
+    1.2199 }, // V
+  { 10.6406, 6.1038, 7.3537, 0.392, 3.324, 20.2626, 1.4922, 98.7399,
+    1.1832 }, // Cr
+  { 11.2819, 5.3409, 7.3573, 0.3432, 3.0193, 17.8674, 2.2441, 83.7543,
+    1.0896 }, // Mn
+  { 11.7695, 4.7611, 7.3573, 0.3072, 3.5222, 15.3535, 2.3045, 76.8805,
+    1.0369 }, // Fe
+  { 12.2841, 4.2791, 7.3409, 0.2784, 4.0034, 13.5359, 2.3488, 71.1692,
+    1.0118 }, // Co
+  { 12.8376, 3.8785, 7.292, 0.2565, 4.4438, 12.1763, 2.38, 66.3421,
+    1.0341 }, // Ni
+  { 13.338, 3.5828, 7.1676, 0.247, 5.6158, 11.3966, 1.6735, 64.8126,
+    1.191 }, // Cu
+  { 14.0743, 3.2655, 7.0318, 0.2333, 5.1652, 10.3163, 2.41, 58.7097,
+    1.3041 }, // Zn
+  { 15.2354, 3.0669, 6.7006, 0.2412, 4.3591, 10.7805, 2.9623, 61.4135,
+    1.7189 }, // Ga
+  { 16.0816, 2.8509, 6.3747, 0.2516, 3.7068, 11.4468, 3.683, 54.7625,
+    2.1313 }, // Ge
+  { 16.6723, 2.6345, 6.0701, 0.2647, 3.4313, 12.9479, 4.2779, 47.7972,
+    2.531 }, // As
+  { 17.0006, 2.4098, 5.8196, 0.2726, 3.9731, 15.2372, 4.3543, 43.8163,
+    2.8409 }, // Se
+  { 17.1789, 2.1723, 5.2358, 16.5796, 5.6377, 0.2609, 3.9851, 41.4328,
+    2.9557 }, // Br
+  { 17.3555, 1.9384, 6.7286, 16.5623, 5.5493, 0.2261, 3.5375, 39.3972,
+    2.825 }, // Kr
+  { 17.1784, 1.7888, 9.6435, 17.3151, 5.1399, 0.2748, 1.5292, 164.934,
+    3.4873 }, // Rb
+  { 17.5663, 1.5564, 9.8184, 14.0988, 5.422, 0.1664, 2.6694, 132.376,
+    2.5064 }, // Sr
+  { 17.776, 1.4029, 10.2946, 12.8006, 5.72629, 0.125599, 3.26588, 104.354,
+    1.91213 }, // Y
+  { 17.8765, 1.27618, 10.948, 11.916, 5.41732, 0.117622, 3.65721, 87.6627,
+    2.06929 }, // Zr
+  { 17.6142, 1.18865, 12.0144, 11.766, 4.04183, 0.204785, 3.53346, 69.7957,
+    3.75591 }, // Nb
+  { 3.7025, 0.2772, 17.2356, 1.0958, 12.8876, 11.004, 3.7429, 61.6584,
+    4.3875 }, // Mo
+  { 19.1301, 0.864132, 11.0948, 8.14487, 4.64901, 21.5707, 2.71263, 86.8472,
+    5.40428 }, // Tc
+  { 19.2674, 0.80852, 12.9182, 8.43467, 4.86337, 24.7997, 1.56756, 94.2928,
+    5.37874 }, // Ru
+  { 19.2957, 0.751536, 14.3501, 8.21758, 4.73425, 25.8749, 1.28918, 98.6062,
+    5.328 }, // Rh
+  { 19.3319, 0.698655, 15.5017, 7.98929, 5.29537, 25.2052, 0.605844, 76.8986,
+    5.26593 }, // Pd
+  { 19.2808, 0.6446, 16.6885, 7.4726, 4.8045, 24.6605, 1.0463, 99.8156,
+    5.179 }, // Ag
+  { 19.2214, 0.5946, 17.6444, 6.9089, 4.461, 24.7008, 1.6029, 87.4825,
+    5.0694 }, // Cd
+  { 19.1624, 0.5476, 18.5596, 6.3776, 4.2948, 25.8499, 2.0396, 92.8029,
+    4.9391 }, // In
+  { 19.1889, 5.8303, 19.1005, 0.5031, 4.4585, 26.8909, 2.4663, 83.9571,
+    4.7821 }, // Sn
+  { 19.6418, 5.3034, 19.0455, 0.4607, 5.0371, 27.9074, 2.6827, 75.2825,
+    4.5909 }, // Sb
+  { 19.9644, 4.81742, 19.0138, 0.420885, 6.14487, 28.5284, 2.5239, 70.8403,
+    4.352 }, // Te
+  { 20.1472, 4.347, 18.9949, 0.3814, 7.5138, 27.766, 2.2735, 66.8776,
+    4.0712 }, // I
+  { 20.2933, 3.9282, 19.0298, 0.344, 8.9767, 26.4659, 1.99, 64.2658,
+    3.7118 }, // Xe
+  { 20.3892, 3.569, 19.1062, 0.3107, 10.662, 24.3879, 1.4953, 213.904,
+    3.3352 }, // Cs
+  { 20.3361, 3.216, 19.297, 0.2756, 10.888, 20.2073, 2.6959, 167.202,
+    2.7731 }, // Ba
+  { 20.578, 2.94817, 19.599, 0.244475, 11.3727, 18.7726, 3.28719, 133.124,
+    2.14678 }, // La
+  { 21.1671, 2.81219, 19.7695, 0.226836, 11.8513, 17.6083, 3.33049, 127.113,
+    1.86264 }, // Ce
+  { 22.044, 2.77393, 19.6697, 0.222087, 12.3856, 16.7669, 2.82428, 143.644,
+    2.0583 }, // Pr
+  { 22.6845, 2.66248, 19.6847, 0.210628, 12.774, 15.885, 2.85137, 137.903,
+    1.98486 }, // Nd
+  { 23.3405, 2.5627, 19.6095, 0.202088, 13.1235, 15.1009, 2.87516, 132.721,
+    2.02876 }, // Pm
+  { 24.0042, 2.47274, 19.4258, 0.196451, 13.4396, 14.3996, 2.89604, 128.007,
+    2.20963 }, // Sm
+  { 24.6274, 2.3879, 19.0886, 0.1942, 13.7603, 13.7546, 2.9227, 123.174,
+    2.5745 }, // Eu
+  { 25.0709, 2.25341, 19.0798, 0.181951, 13.8518, 12.9331, 3.54545, 101.398,
+    2.4196 }, // Gd
+  { 25.8976, 2.24256, 18.2185, 0.196143, 14.3167, 12.6648, 2.95354, 115.362,
+    3.58324 }, // Tb
+  { 26.507, 2.1802, 17.6383, 0.202172, 14.5596, 12.1899, 2.96577, 111.874,
+    4.29728 }, // Dy
+  { 26.9049, 2.07051, 17.294, 0.19794, 14.5583, 11.4407, 3.63837, 92.6566,
+    4.56796 }, // Ho
+  { 27.6563, 2.07356, 16.4285, 0.223545, 14.9779, 11.3604, 2.98233, 105.703,
+    5.92046 }, // Er
+  { 28.1819, 2.02859, 15.8851, 0.238849, 15.1542, 10.9975, 2.98706, 102.961,
+    6.75621 }, // Tm
+  { 28.6641, 1.9889, 15.4345, 0.257119, 15.3087, 10.6647, 2.98963, 100.417,
+    7.56672 }, // Yb
+  { 28.9476, 1.90182, 15.2208, 9.98519, 15.1, 0.261033, 3.71601, 84.3298,
+    7.97628 }, // Lu
+  { 29.144, 1.83262, 15.1726, 9.5999, 14.7586, 0.275116, 4.30013, 72.029,
+    8.58154 }, // Hf
+  { 29.2024, 1.77333, 15.2293, 9.37046, 14.5135, 0.295977, 4.76492, 63.3644,
+    9.24354 }, // Ta
+  { 29.0818, 1.72029, 15.43, 9.2259, 14.4327, 0.321703, 5.11982, 57.056,
+    9.8875 }, // W
+  { 28.7621, 1.67191, 15.7189, 9.09227, 14.5564, 0.3505, 5.44174, 52.0861,
+    10.472 }, // Re
+  { 28.1894, 1.62903, 16.155, 8.97948, 14.9305, 0.382661, 5.67589, 48.1647,
+    11.0005 }, // Os
+  { 27.3049, 1.59279, 16.7296, 8.86553, 15.6115, 0.417916, 5.83377, 45.0011,
+    11.4722 }, // Ir
+  { 27.0059, 1.51293, 17.7639, 8.81174, 15.7131, 0.424593, 5.7837, 38.6103,
+    11.6883 }, // Pt
+  { 16.8819, 0.4611, 18.5913, 8.6216, 25.5582, 1.4826, 5.86, 36.3956,
+    12.0658 }, // Au
+  { 20.6809, 0.545, 19.0417, 8.4484, 21.6575, 1.5729, 5.9676, 38.3246,
+    12.6089 }, // Hg
+  { 27.5446, 0.65515, 19.1584, 8.70751, 15.538, 1.96347, 5.52593, 45.8149,
+    13.1746 }, // Tl
+  { 31.0617, 0.6902, 13.0637, 2.3576, 18.442, 8.618, 5.9696, 47.2579,
+    13.4118 }, // Pb
+  { 33.3689, 0.704, 12.951, 2.9238, 16.5877, 8.7937, 6.4692, 48.0093,
+    13.5782 }, // Bi
+  { 34.6726, 0.700999, 15.4733, 3.55078, 13.1138, 9.55642, 7.02588, 47.0045,
+    13.677 }, // Po
+  { 35.3163, 0.68587, 19.0211, 3.97458, 9.49887, 11.3824, 7.42518, 45.4715,
+    13.7108 }, // At
+  { 35.5631, 0.6631, 21.2816, 4.0691, 8.0037, 14.0422, 7.4433, 44.2473,
+    13.6905 }, // Rn
+  { 35.9299, 0.646453, 23.0547, 4.17619, 12.1439, 23.1052, 2.11253, 150.645,
+    13.7247 }, // Fr
+  { 35.763, 0.616341, 22.9064, 3.87135, 12.4739, 19.9887, 3.21097, 142.325,
+    13.6211 }, // Ra
+  { 35.6597, 0.589092, 23.1032, 3.65155, 12.5977, 18.599, 4.08655, 117.02,
+    13.5266 }, // Ac
+  { 35.5645, 0.563359, 23.4219, 3.46204, 12.7473, 17.8309, 4.80703, 99.1722,
+    13.4314 }, // Th
+  { 35.8847, 0.547751, 23.2948, 3.41519, 14.1891, 16.9235, 4.17287, 105.251,
+    13.4287 }, // Pa
+  { 36.0228, 0.5293, 23.4128, 3.3253, 14.9491, 16.0927, 4.188, 100.613,
+    13.3966 }, // U
+  { 36.1874, 0.511929, 23.5964, 3.25396, 15.6402, 15.3622, 4.1855, 97.4908,
+    13.3573 }, // Np
+  { 36.5254, 0.499384, 23.8083, 3.26371, 16.7707, 14.9455, 3.47947, 105.98,
+    13.3812 }, // Pu
+  { 36.6706, 0.483629, 24.0992, 3.20647, 17.3415, 14.3136, 3.49331, 102.273,
+    13.3592 }, // Am
+  { 36.6488, 0.465154, 24.4096, 3.08997, 17.399, 13.4346, 4.21665, 88.4834,
+    13.2887 }, // Cm
+  { 36.7881, 0.451018, 24.7736, 3.04619, 17.8919, 12.8946, 4.23284, 86.003,
+    13.2754 }, // Bk
+  { 36.9185, 0.437533, 25.1995, 3.00775, 18.3317, 12.4044, 4.24391, 83.7881,
+    13.2674 } // Cf
+};
+
+// The form factor of the Moliere approximation to the Thomas-Fermi atom,
+// whose screening function is a sum of three exponentials.
+Real moliereFormFactor(unsigned char atomicNumber, Real s)
+{
+  if (atomicNumber == 0)
+    return 0.0;
+  const Real alpha[3] = { 0.35, 0.55, 0.10 };
+  const Real beta[3] = { 0.3, 1.2, 6.0 };
+  const Real z = static_cast<Real>(atomicNumber);
+  // The Thomas-Fermi screening length in Angstrom.
+  const Real screening = 0.8853 * 0.529177 / std::cbrt(z);
+  const Real qa = 4.0 * pi * s * screening;
+  Real f = 0.0;
+  for (int i = 0; i < 3; ++i)
+    f += alpha[i] * beta[i] * beta[i] / (beta[i] * beta[i] + qa * qa);
+  return z * f;
+}
+
+// The atoms of one element, with the coefficients of its form factor.
+struct Species
+{
+  unsigned char atomicNumber;
+  const std::vector<Real>* coefficients;
+  std::vector<Vector3> positions;
+};
+
+Real speciesFormFactor(const Species& species, Real s)
+{
+  if (!species.coefficients)
+    return moliereFormFactor(species.atomicNumber, s);
+  const std::vector<Real>& c = *species.coefficients;
+  Real s2 = s * s;
+  return c[0] * std::exp(-c[1] * s2) + c[2] * std::exp(-c[3] * s2) +
+         c[4] * std::exp(-c[5] * s2) + c[6] * std::exp(-c[7] * s2) + c[8];
+}
+
+bool compareTwoTheta(const XrdCalculator::Reflection& a,
+                     const XrdCalculator::Reflection& b)
+{
+  return a.twoTheta < b.twoTheta;
+}
+
+// Prefer positive Miller indices to label a merged peak.
+bool preferredIndices(const XrdCalculator::Reflection& a,
+                      const XrdCalculator::Reflection& b)
+{
+  if (a.h != b.h)
+    return a.h > b.h;
+  if (a.k != b.k)
+    return a.k > b.k;
+  return a.l > b.l;
+}
+} // End anonymous namespace
+
+XrdCalculator::XrdCalculator()
+  : m_wavelength(1.5056), m_peakWidth(0.52958), m_numberOfPoints(1000),
+    m_maximumTwoTheta(162.0)
+{
+  for (unsigned char i = 0; i < cromerMannElements; ++i)
+    setFormFactorCoefficients(i + 1, cromerMannCoefficients[i]);
+}
+
+XrdCalculator::~XrdCalculator()
+{
+}
+
+void XrdCalculator::setFormFactorCoefficients(unsigned char atomicNumber,
+                                              const Real coefficients[9])
+{
+  m_coefficients[atomicNumber].assign(coefficients, coefficients + 9);
+}
+
+Real XrdCalculator::formFactor(unsigned char atomicNumber, Real s) const
+{
+  Species species;
+  species.atomicNumber = atomicNumber;
+  std::map<unsigned char, std::vector<Real>>::const_iterator it =
+    m_coefficients.find(atomicNumber);
+  species.coefficients = it != m_coefficients.end() ? &it->second : nullptr;
+  return speciesFormFactor(species, s);
+}
+
+std::vector<XrdCalculator::Reflection> XrdCalculator::reflections(
+  const UnitCell& unitCell, const Array<unsigned char>& atomicNumbers,
+  const Array<Vector3>& fractional) const
+{
+  return reflections(unitCell, atomicNumbers, fractional, true);
+}
+
+std::vector<XrdCalculator::Reflection> XrdCalculator::reflections(
+  const Molecule& molecule, int frame) const
+{
+  return reflections(molecule, frame, true);
+}
+
+XrdCalculator::Pattern XrdCalculator::pattern(
+  const std::vector<Reflection>& reflections) const
+{
+  Pattern result;
+  if (m_numberOfPoints == 0)
+    return result;
+
+  const Real step = m_numberOfPoints > 1
+                      ? m_maximumTwoTheta / (m_numberOfPoints - 1)
+                      : m_maximumTwoTheta;
+  result.resize(m_numberOfPoints);
+  for (size_t i = 0; i < m_numberOfPoints; ++i)
+    result[i] = std::make_pair(i * step, 0.0);
+  if (step <= 0.0)
+    return result;
+
+  // Gaussian peaks, cut off where they have decayed to below 10^-5.
+  const Real sigma = m_peakWidth / (2.0 * std::sqrt(2.0 * std::log(2.0)));
+  const Real reach = 5.0 * sigma;
+  for (size_t r = 0; r < reflections.size(); ++r) {
+    const Reflection& peak = reflections[r];
+    if (sigma <= 0.0) {
+      size_t i = static_cast<size_t>(std::floor(peak.twoTheta / step + 0.5));
+      if (i < m_numberOfPoints)
+        result[i].second += peak.intensity;
+      continue;
+    }
+    Real first = std::max(std::ceil((peak.twoTheta - reach) / step), 0.0);
+    Real last = std::min(std::floor((peak.twoTheta + reach) / step),
+                         static_cast<Real>(m_numberOfPoints - 1));
+    for (Real x = first; x <= last; ++x) {
+      Real delta = (x * step - peak.twoTheta) / sigma;
+      result[static_cast<size_t>(x)].second +=
+        peak.intensity * std::exp(-0.5 * delta * delta);
+    }
+  }
+  return result;
+}
+
+XrdCalculator::Pattern XrdCalculator::pattern(const Molecule& molecule,
+                                              int frame) const
+{
+  return pattern(reflections(molecule, frame, true));
+}
+
+std::vector<XrdCalculator::Pattern> XrdCalculator::patterns(
+  const std::vector<const Molecule*>& molecules) const
+{
+  std::vector<Pattern> result(molecules.size());
+  runParallel(molecules.size(), [&](size_t i) {
+    if (molecules[i] && molecules[i]->unitCell())
+      result[i] = pattern(reflections(*molecules[i], -1, false));
+  });
+  return result;
+}
+
+std::vector<XrdCalculator::Pattern> XrdCalculator::framePatterns(
+  const Molecule& molecule) const
+{
+  std::vector<Pattern> result;
+  const UnitCell* unitCell = molecule.unitCell();
+  if (!unitCell)
+    return result;
+
+  // Convert the frames on this thread, the workers only read them.
+  int count = molecule.coordinate3dCount();
+  std::vector<Array<Vector3>> frames(count);
+  for (int f = 0; f < count; ++f) {
+    frames[f] = molecule.coordinate3d(f);
+    for (size_t i = 0; i < frames[f].size(); ++i)
+      frames[f][i] = unitCell->toFractional(frames[f][i]);
+  }
+
+  const Array<unsigned char>& atomicNumbers = molecule.atomicNumbers();
+  result.resize(count);
+  runParallel(frames.size(), [&](size_t f) {
+    result[f] =
+      pattern(reflections(*unitCell, atomicNumbers, frames[f], false));
+  });
+  return result;
+}
+
+std::vector<XrdCalculator::Reflection> XrdCalculator::reflections(
+  const Molecule& molecule, int frame, bool parallel) const
+{
+  const UnitCell* unitCell = molecule.unitCell();
+  if (!unitCell || frame >= molecule.coordinate3dCount())
+    return std::vector<Reflection>();
+
+  Array<Vector3> fractional =
+    frame < 0 ? molecule.atomPositions3d() : molecule.coordinate3d(frame);
+  for (size_t i = 0; i < fractional.size(); ++i)
+    fractional[i] = unitCell->toFractional(fractional[i]);
+  return reflections(*unitCell, molecule.atomicNumbers(), fractional,
+                     parallel);
+}
+
+std::vector<XrdCalculator::Reflection> XrdCalculator::reflections(
+  const UnitCell& unitCell, const Array<unsigned char>& atomicNumbers,
+  const Array<Vector3>& fractional, bool parallel) const
+{
+  std::vector<Reflection> result;
+  if (atomicNumbers.empty() || atomicNumbers.size() != fractional.size() ||
+      m_wavelength <= 0.0)
+    return result;
+
+  // Group the atoms by element, so each form factor is evaluated once per
+  // reflection.
+  std::vector<Species> species;
+  for (size_t i = 0; i < atomicNumbers.size(); ++i) {
+    size_t s = 0;
+    while (s < species.size() && species[s].atomicNumber != atomicNumbers[i])
+      ++s;
+    if (s == species.size()) {
+      Species newSpecies;
+      newSpecies.atomicNumber = atomicNumbers[i];
+      std::map<unsigned char, std::vector<Real>>::const_iterator it =
+        m_coefficients.find(atomicNumbers[i]);
+      newSpecies.coefficients =
+        it != m_coefficients.end() ? &it->second : nullptr;
+      species.push_back(newSpecies);
+    }
+    species[s].positions.push_back(fractional[i] * (2.0 * pi));
+  }
+
+  // The reciprocal lattice vectors are the rows of the fractional matrix,
+  // a reflection is observed if 1 / d = |G| <= 2 sin(theta_max) / lambda.
+  const Matrix3 reciprocal = unitCell.fractionalMatrix().transpose();
+  const Real maxTheta =
+    0.5 * std::min(m_maximumTwoTheta, static_cast<Real>(180.0)) *
+    degreesToRadians;
+  const Real maxG = 2.0 * std::sin(maxTheta) / m_wavelength;
+  const int maxH = static_cast<int>(std::floor(unitCell.a() * maxG));
+  const int maxK = static_cast<int>(std::floor(unitCell.b() * maxG));
+  const int maxL = static_cast<int>(std::floor(unitCell.c() * maxG));
+
+  // Each task computes the reflections of one plane of constant h.
+  std::vector<std::vector<Reflection>> planes(2 * maxH + 1);
+  auto computePlane = [&](size_t plane) {
+    const int h = static_cast<int>(plane) - maxH;
+    std::vector<Reflection>& reflections = planes[plane];
+    for (int k = -maxK; k <= maxK; ++k) {
+      for (int l = -maxL; l <= maxL; ++l) {
+        const Vector3 hkl(h, k, l);
+        const Real g = (reciprocal * hkl).norm();
+        if (g == 0.0 || g > maxG)
+          continue;
+        const Real sinTheta = 0.5 * g * m_wavelength;
+        const Real theta = std::asin(std::min(sinTheta, 1.0));
+        const Real cosTheta = std::cos(theta);
+        if (cosTheta < 1e-8)
+          continue;
+
+        const Real s = 0.5 * g;
+        Real real = 0.0;
+        Real imaginary = 0.0;
+        for (size_t e = 0; e < species.size(); ++e) {
+          const std::vector<Vector3>& positions = species[e].positions;
+          Real sumCos = 0.0;
+          Real sumSin = 0.0;
+          for (size_t i = 0; i < positions.size(); ++i) {
+            const Real phase = hkl.dot(positions[i]);
+            sumCos += std::cos(phase);
+            sumSin += std::sin(phase);
+          }
+          const Real f = speciesFormFactor(species[e], s);
+          real += f * sumCos;
+          imaginary += f * sumSin;
+        }
+
+        const Real cos2Theta = std::cos(2.0 * theta);
+        const Real lorentzPolarization =
+          (1.0 + cos2Theta * cos2Theta) / (sinTheta * sinTheta * cosTheta);
+        Reflection reflection;
+        reflection.h = h;
+        reflection.k = k;
+        reflection.l = l;
+        reflection.twoTheta = 2.0 * theta / degreesToRadians;
+        reflection.dSpacing = 1.0 / g;
+        reflection.intensity =
+          (real * real + imaginary * imaginary) * lorentzPolarization;
+        reflection.multiplicity = 1;
+        reflections.push_back(reflection);
+      }
+    }
+  };
+  if (parallel) {
+    runParallel(planes.size(), computePlane);
+  } else {
+    for (size_t plane = 0; plane < planes.size(); ++plane)
+      computePlane(plane);
+  }
+
+  std::vector<Reflection> all;
+  for (size_t plane = 0; plane < planes.size(); ++plane)
+    all.insert(all.end(), planes[plane].begin(), planes[plane].end());
+  std::stable_sort(all.begin(), all.end(), compareTwoTheta);
+
+  // Merge reflections at the same angle into one peak.
+  const Real angleTolerance = 1e-6;
+  Real maxIntensity = 0.0;
+  for (size_t i = 0; i < all.size(); ++i) {
+    if (!result.empty() &&
+        all[i].twoTheta - result.back().twoTheta < angleTolerance) {
+      Reflection& peak = result.back();
+      peak.intensity += all[i].intensity;
+      ++peak.multiplicity;
+      if (preferredIndices(all[i], peak)) {
+        peak.h = all[i].h;
+        peak.k = all[i].k;
+        peak.l = all[i].l;
+      }
+    } else {
+      result.push_back(all[i]);
+    }
+    maxIntensity = std::max(maxIntensity, result.back().intensity);
+  }
+
+  // Drop systematic absences, which only differ from zero by rounding, and
+  // scale the strongest peak to 100.
+  if (maxIntensity <= 0.0)
+    return std::vector<Reflection>();
+  std::vector<Reflection> peaks;
+  for (size_t i = 0; i < result.size(); ++i) {
+    if (result[i].intensity > 1e-10 * maxIntensity) {
+      peaks.push_back(result[i]);
+      peaks.back().intensity *= 100.0 / maxIntensity;
+    }
+  }
+  return peaks;
+}
+
+} // End namespace Core
+} // End namespace Avogadro
@@ -0,0 +1,159 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_CORE_XRDCALCULATOR_H
+#define AVOGADRO_CORE_XRDCALCULATOR_H
+
+#include "avogadrocore.h"
+
+#include "array.h"
+#include "vector.h"
+
+#include <map>
+#include <utility>
+#include <vector>
+
+namespace Avogadro {
+namespace Core {
+
+class Molecule;
+class UnitCell;
+
+/**
+ * @class XrdCalculator xrdcalculator.h <avogadro/core/xrdcalculator.h>
+ * @brief Calculate theoretical powder X-ray diffraction patterns.
+ *
+ * The structure factor of every reflection inside the limiting sphere set by
+ * the wavelength and maximumTwoTheta() is summed over the atoms of the cell:
+ *
+ * F(hkl) = sum_j f_j(s) exp(2 pi i (h x_j + k y_j + l z_j)), s = sin(theta) /
+ * lambda
+ *
+ * The intensity of a reflection is |F|^2 times the Lorentz-polarization
+ * factor (1 + cos^2(2 theta)) / (sin^2(theta) cos(theta)). Reflections with
+ * the same Bragg angle, e.g. symmetry equivalents, are merged into one peak
+ * so multiplicities are accounted for. The peak intensities are scaled so the
+ * strongest one is 100, and pattern() broadens them into Gaussians.
+ *
+ * The atomic form factors use the Cromer-Mann coefficients of the
+ * International Tables for H to Cf, and the analytic form factor of the
+ * Moliere screened atom for heavier elements. Other coefficients, e.g. for
+ * ions, can be supplied with setFormFactorCoefficients(). The form factor of
+ * each element is evaluated once per reflection, not once per atom.
+ *
+ * The reflections of a single structure are enumerated concurrently, batches
+ * of structures or trajectory frames are evaluated one structure per thread.
+ */
+class AVOGADROCORE_EXPORT XrdCalculator
+{
+public:
+  /** A merged diffraction peak. */
+  struct Reflection
+  {
+    /** The Miller indices of one of the merged reflections. */
+    int h, k, l;
+    /** The Bragg angle 2 theta, in degrees. */
+    Real twoTheta;
+    /** The interplanar spacing, in Angstrom. */
+    Real dSpacing;
+    /** The relative intensity, the strongest peak is 100. */
+    Real intensity;
+    /** The number of reflections merged into this peak. */
+    int multiplicity;
+  };
+
+  /** Points of a pattern, 2 theta in degrees and the intensity. */
+  typedef std::vector<std::pair<Real, Real>> Pattern;
+
+  XrdCalculator();
+  ~XrdCalculator();
+
+  /** The X-ray wavelength in Angstrom, default 1.5056. @{ */
+  void setWavelength(Real wavelength) { m_wavelength = wavelength; }
+  Real wavelength() const { return m_wavelength; }
+  /** @} */
+
+  /** The full width at half maximum of the peaks in degrees. @{ */
+  void setPeakWidth(Real width) { m_peakWidth = width; }
+  Real peakWidth() const { return m_peakWidth; }
+  /** @} */
+
+  /** The number of points of a pattern, from 0 to maximumTwoTheta(). @{ */
+  void setNumberOfPoints(size_t points) { m_numberOfPoints = points; }
+  size_t numberOfPoints() const { return m_numberOfPoints; }
+  /** @} */
+
+  /** The largest 2 theta in degrees, at most 180. @{ */
+  void setMaximumTwoTheta(Real twoTheta) { m_maximumTwoTheta = twoTheta; }
+  Real maximumTwoTheta() const { return m_maximumTwoTheta; }
+  /** @} */
+
+  /**
+   * Use the Cromer-Mann coefficients a1, b1, a2, b2, a3, b3, a4, b4 and c for
+   * the form factor of @a atomicNumber:
+   * f(s) = sum_i a_i exp(-b_i s^2) + c.
+   */
+  void setFormFactorCoefficients(unsigned char atomicNumber,
+                                 const Real coefficients[9]);
+
+  /**
+   * @return The atomic form factor of @a atomicNumber at
+   * @a s = sin(theta) / lambda, in electrons.
+   */
+  Real formFactor(unsigned char atomicNumber, Real s) const;
+
+  /**
+   * @return The diffraction peaks of the structure with atoms @a atomicNumbers
+   * at the fractional coordinates @a fractional in @a unitCell, sorted by
+   * increasing 2 theta.
+   */
+  std::vector<Reflection> reflections(
+    const UnitCell& unitCell, const Array<unsigned char>& atomicNumbers,
+    const Array<Vector3>& fractional) const;
+
+  /**
+   * @return The diffraction peaks of @a molecule, which must have a unit cell.
+   * If @a frame is not negative, the coordinate set @a frame is used instead
+   * of the current positions.
+   */
+  std::vector<Reflection> reflections(const Molecule& molecule,
+                                      int frame = -1) const;
+
+  /** @return The broadened pattern of the peaks @a reflections. */
+  Pattern pattern(const std::vector<Reflection>& reflections) const;
+
+  /** @return The broadened pattern of @a molecule, see reflections(). */
+  Pattern pattern(const Molecule& molecule, int frame = -1) const;
+
+  /**
+   * @return The patterns of each molecule in @a molecules, evaluated
+   * concurrently. Molecules without a unit cell give an empty pattern.
+   */
+  std::vector<Pattern> patterns(
+    const std::vector<const Molecule*>& molecules) const;
+
+  /**
+   * @return The pattern of every coordinate set of @a molecule, evaluated
+   * concurrently.
+   */
+  std::vector<Pattern> framePatterns(const Molecule& molecule) const;
+
+private:
+  std::vector<Reflection> reflections(const UnitCell& unitCell,
+                                      const Array<unsigned char>& atomicNumbers,
+                                      const Array<Vector3>& fractional,
+                                      bool parallel) const;
+  std::vector<Reflection> reflections(const Molecule& molecule, int frame,
+                                      bool parallel) const;
+
+  Real m_wavelength;
+  Real m_peakWidth;
+  size_t m_numberOfPoints;
+  Real m_maximumTwoTheta;
+  std::map<unsigned char, std::vector<Real>> m_coefficients;
+};
+
+} // End namespace Core
+} // End namespace Avogadro
+
+#endif // AVOGADRO_CORE_XRDCALCULATOR_H
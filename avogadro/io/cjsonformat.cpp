@@ -15,6 +15,7 @@
 
 #include <nlohmann/json.hpp>
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 
@@ -66,6 +67,41 @@ bool isNumericArray(json& j)
   return false;
 }
 
+// Add the bonds between the atom pairs in one step. A pair listed more than
+// once is only added the first time, as addBond() would have done.
+void addUniqueBonds(Molecule& m, const Array<std::pair<Index, Index>>& pairs,
+                    const Array<unsigned char>& orders)
+{
+  vector<Index> sorted(pairs.size());
+  for (Index i = 0; i < sorted.size(); ++i)
+    sorted[i] = i;
+  std::stable_sort(sorted.begin(), sorted.end(), [&pairs](Index a, Index b) {
+    return pairs[a] < pairs[b];
+  });
+  vector<bool> unique(pairs.size(), true);
+  bool duplicates = false;
+  for (Index i = 1; i < sorted.size(); ++i) {
+    if (pairs[sorted[i]] == pairs[sorted[i - 1]]) {
+      unique[sorted[i]] = false;
+      duplicates = true;
+    }
+  }
+  if (!duplicates) {
+    m.addBonds(pairs, orders);
+    return;
+  }
+
+  Array<std::pair<Index, Index>> uniquePairs;
+  Array<unsigned char> uniqueOrders;
+  for (Index i = 0; i < pairs.size(); ++i) {
+    if (unique[i]) {
+      uniquePairs.push_back(pairs[i]);
+      uniqueOrders.push_back(orders[i]);
+    }
+  }
+  m.addBonds(uniquePairs, uniqueOrders);
+}
+
 bool isBooleanArray(json& j)
 {
   if (j.is_array() && j.size() > 0) {
@@ -119,24 +155,27 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
   json atomicNumbers = atoms["elements"]["number"];
   // This represents our minimal spec for a molecule - atoms that have an
   // atomic number.
-  if (isNumericArray(atomicNumbers) && atomicNumbers.size() > 0) {
-    for (unsigned int i = 0; i < atomicNumbers.size(); ++i)
-      molecule.addAtom(atomicNumbers[i]);
-  } else {
+  if (!isNumericArray(atomicNumbers) || atomicNumbers.size() == 0) {
     appendError("Malformed array for in atoms.elements.number");
     return false;
   }
-  Index atomCount = molecule.atomCount();
+  Index atomCount = static_cast<Index>(atomicNumbers.size());
+  Array<unsigned char> elements;
+  elements.reserve(atomCount);
+  for (Index i = 0; i < atomCount; ++i)
+    elements.push_back(atomicNumbers[i]);
 
-  // 3d coordinates if available for our atoms
+  // 3d coordinates if available for our atoms, added with the atoms.
   json atomicCoords = atoms["coords"]["3d"];
+  Array<Vector3> positions;
   if (isNumericArray(atomicCoords) && atomicCoords.size() == 3 * atomCount) {
+    positions.reserve(atomCount);
     for (Index i = 0; i < atomCount; ++i) {
-      auto a = molecule.atom(i);
-      a.setPosition3d(Vector3(atomicCoords[3 * i], atomicCoords[3 * i + 1],
-                              atomicCoords[3 * i + 2]));
+      positions.push_back(Vector3(atomicCoords[3 * i], atomicCoords[3 * i + 1],
+                                  atomicCoords[3 * i + 2]));
     }
   }
+  molecule.addAtoms(elements, positions);
 
   // Check for coordinate sets, and read them in if found, e.g. trajectories.
   json coordSets = atoms["coords"]["3dSets"];
@@ -169,17 +208,23 @@ bool CjsonFormat::read(std::istream& file, Molecule& molecule)
   json bonds = jsonRoot["bonds"];
   if (bonds.is_object() && isNumericArray(bonds["connections"]["index"])) {
     json connections = bonds["connections"]["index"];
-    for (unsigned int i = 0; i < connections.size() / 2; ++i) {
-      molecule.addBond(static_cast<Index>(connections[2 * i]),
-                       static_cast<Index>(connections[2 * i + 1]), 1);
-    }
     json order = bonds["order"];
-    if (isNumericArray(order)) {
-      for (unsigned int i = 0; i < molecule.bondCount() && i < order.size();
-           ++i) {
-        molecule.bond(i).setOrder(static_cast<int>(order[i]));
-      }
+    if (!isNumericArray(order))
+      order = json::array();
+    Array<std::pair<Index, Index>> pairs;
+    Array<unsigned char> orders;
+    pairs.reserve(connections.size() / 2);
+    orders.reserve(connections.size() / 2);
+    for (unsigned int i = 0; i < connections.size() / 2; ++i) {
+      Index a = static_cast<Index>(connections[2 * i]);
+      Index b = static_cast<Index>(connections[2 * i + 1]);
+      if (a == b || a >= atomCount || b >= atomCount)
+        continue;
+      pairs.push_back(std::make_pair(std::min(a, b), std::max(a, b)));
+      orders.push_back(
+        i < order.size() ? static_cast<unsigned char>(order[i]) : 1);
     }
+    addUniqueBonds(molecule, pairs, orders);
   }
 
   json unitCell = jsonRoot["unitCell"];
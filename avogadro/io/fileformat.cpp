@@ -16,6 +16,7 @@
 
 #include "fileformat.h"
 
+#include <algorithm>
 #include <fstream>
 #include <locale>
 #include <sstream>
@@ -155,5 +156,31 @@ void FileFormat::appendError(const std::string& errorString, bool newLine)
     m_error += "\n";
 }
 
+size_t FileFormat::reserveCount(std::istream& stream, size_t count,
+                                size_t minimumSize)
+{
+  const size_t unknownSizeCount = 1 << 16;
+  std::streampos position = stream.tellg();
+  if (position == std::streampos(-1))
+    return std::min(count, unknownSizeCount);
+  stream.seekg(0, std::ios::end);
+  std::streampos end = stream.tellg();
+  // A failed seek sets failbit, which would turn the restore into a no-op.
+  stream.clear();
+  stream.seekg(position);
+  if (!stream || stream.tellg() != position) {
+    stream.clear();
+    return std::min(count, unknownSizeCount);
+  }
+  if (end == std::streampos(-1) || end < position)
+    return std::min(count, unknownSizeCount);
+
+  // The last record may lack its line ending.
+  size_t capacity = static_cast<size_t>(end - position) /
+                      std::max(minimumSize, static_cast<size_t>(1)) +
+                    1;
+  return std::min(count, capacity);
+}
+
 } // namespace Io
 } // namespace Avogadro
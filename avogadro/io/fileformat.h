@@ -245,6 +245,16 @@ protected:
    */
   void appendError(const std::string& errorString, bool newLine = true);
 
+  /**
+   * @brief The number of records to reserve storage for, when a file header
+   * announces @a count of them. Headers can be corrupt, so this is capped by
+   * what the rest of @a stream can hold, with each record taking at least
+   * @a minimumSize bytes. For streams of unknown size at most 2^16 records are
+   * reserved, and storage grows as they are read.
+   */
+  static size_t reserveCount(std::istream& stream, size_t count,
+                             size_t minimumSize);
+
 private:
   std::string m_error;
   std::string m_fileName;
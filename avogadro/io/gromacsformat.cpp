@@ -33,6 +33,7 @@
 
 namespace Avogadro {
 namespace Io {
+using Core::Array;
 
 using Core::Atom;
 using Core::Elements;
@@ -66,7 +67,7 @@ bool GromacsFormat::read(std::istream& in, Molecule& molecule)
 {
   string buffer;
   string value;
-  Residue* r;
+  Residue* r = nullptr;
   size_t currentResidueId = 0;
 
   // Title
@@ -84,13 +85,23 @@ bool GromacsFormat::read(std::istream& in, Molecule& molecule)
     return false;
   }
 
-  // read atom info:
+  // read atom info, the atoms are added to the molecule in one step at the end.
   typedef map<string, unsigned char> AtomTypeMap;
   AtomTypeMap atomTypes;
   unsigned char customElementCounter = CustomElementMin;
   Vector3 pos;
+  Index firstAtom = molecule.atomCount();
+  Array<unsigned char> atomicNumbers;
+  Array<Vector3> atomPositions;
+  // Atom lines have at least 20 columns before the coordinates.
+  size_t reserved = reserveCount(in, numAtoms, 24);
+  atomicNumbers.reserve(reserved);
+  atomPositions.reserve(reserved);
   while (numAtoms-- > 0) {
-    getline(in, buffer);
+    if (!getline(in, buffer)) {
+      appendError("Unexpected end of file while reading atoms.");
+      return false;
+    }
     // Figure out the distance between decimal points, implement support for
     // variable precision as specified:
     // "any number of decimal places, the format will then be n+5 positions with
@@ -148,27 +159,26 @@ bool GromacsFormat::read(std::istream& in, Molecule& molecule)
     }
 
     // Atom name:
-    value = trimmed(buffer.substr(10, 5));
-    Atom atom;
-    int atomicNum = r->getAtomicNumber(value);
+    string atomName = trimmed(buffer.substr(10, 5));
+    int atomicNum = r ? r->getAtomicNumber(atomName) : 0;
     if (atomicNum) {
-      atom = molecule.addAtom(atomicNum);
+      atomicNumbers.push_back(static_cast<unsigned char>(atomicNum));
     } else {
       unsigned char atomicNumFromSymbol =
-        Elements::atomicNumberFromSymbol(value);
+        Elements::atomicNumberFromSymbol(atomName);
       if (atomicNumFromSymbol != 255) {
-        atom = molecule.addAtom(atomicNumFromSymbol);
+        atomicNumbers.push_back(atomicNumFromSymbol);
       } else {
-        AtomTypeMap::const_iterator it = atomTypes.find(value);
+        AtomTypeMap::const_iterator it = atomTypes.find(atomName);
         if (it == atomTypes.end()) {
-          atomTypes.insert(std::make_pair(value, customElementCounter++));
-          it = atomTypes.find(value);
+          atomTypes.insert(std::make_pair(atomName, customElementCounter++));
+          it = atomTypes.find(atomName);
           if (customElementCounter > CustomElementMax) {
             appendError("Custom element type limit exceeded.");
             return false;
           }
         }
-        atom = molecule.addAtom(it->second);
+        atomicNumbers.push_back(it->second);
       }
     }
 
@@ -183,11 +193,14 @@ bool GromacsFormat::read(std::istream& in, Molecule& molecule)
         return false;
       }
     }
-    atom.setPosition3d(pos * static_cast<Real>(10.0)); // nm --> Angstrom
+    atomPositions.push_back(pos * static_cast<Real>(10.0)); // nm --> Angstrom
     if (r) {
-      r->addResidueAtom(value, atom);
+      // The atom is valid once the atoms are added below.
+      Atom atom(&molecule, firstAtom + atomicNumbers.size() - 1);
+      r->addResidueAtom(atomName, atom);
     }
   }
+  molecule.addAtoms(atomicNumbers, atomPositions);
 
   // Set the custom element map if needed:
   if (!atomTypes.empty()) {
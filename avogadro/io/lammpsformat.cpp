@@ -173,9 +173,16 @@ bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
       id_idx = i;
   }
 
-  // Parse atoms
+  // Parse atoms, they are added to the molecule in one step at the end.
+  Array<unsigned char> atomicNumbers;
+  Array<Vector3> atomPositions;
+  // The shortest atom line has a type and three coordinates.
+  size_t reserved = reserveCount(inStream, numAtoms, 8);
+  atomicNumbers.reserve(reserved);
+  atomPositions.reserve(reserved);
   for (size_t i = 0; i < numAtoms; ++i) {
-    getline(inStream, buffer);
+    if (!getline(inStream, buffer))
+      break;
     vector<string> tokens(split(buffer, ' '));
 
     if (tokens.size() < labels.size() - 2) {
@@ -208,9 +215,10 @@ bool LammpsTrajectoryFormat::read(std::istream& inStream, Core::Molecule& mol)
         return false;
       }
     }
-    Atom newAtom = mol.addAtom(it->second);
-    newAtom.setPosition3d(pos);
+    atomicNumbers.push_back(it->second);
+    atomPositions.push_back(pos);
   }
+  mol.addAtoms(atomicNumbers, atomPositions);
 
   // Set the custom element map if needed:
   if (!atomTypes.empty()) {
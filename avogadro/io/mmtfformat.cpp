@@ -84,6 +84,18 @@ bool MMTFFormat::read(std::istream& file, Molecule& molecule)
   Index modelChainCount =
     static_cast<Index>(structure.chainsPerModel[modelIndex]);
 
+  // The atoms and bonds are collected first and added in one step each.
+  Index firstAtom = molecule.atomCount();
+  Array<unsigned char> atomicNumbers;
+  Array<Vector3> atomPositions;
+  Array<signed char> formalCharges;
+  Array<std::pair<Index, Index>> bondPairs;
+  Array<unsigned char> bondOrders;
+  // Reserve by the decoded coordinates, numAtoms is an unchecked header field.
+  atomicNumbers.reserve(structure.xCoordList.size());
+  atomPositions.reserve(structure.xCoordList.size());
+  formalCharges.reserve(structure.xCoordList.size());
+
   for (Index j = 0; j < modelChainCount; j++) {
 
     Index chainGroupCount =
@@ -111,13 +123,14 @@ bool MMTFFormat::read(std::istream& file, Molecule& molecule)
 
       for (Index l = 0; l < groupSize; l++) {
 
-        auto atom = molecule.addAtom(
+        atomicNumbers.push_back(
           Elements::atomicNumberFromSymbol(group.elementList[l]));
         // Not supported by Avogadro?
         // const auto& altLocList = structure.altLocList;
 
-        atom.setFormalCharge(group.formalChargeList[l]);
-        atom.setPosition3d(
+        formalCharges.push_back(
+          static_cast<signed char>(group.formalChargeList[l]));
+        atomPositions.push_back(
           Vector3(static_cast<Real>(structure.xCoordList[atomIndex]),
                   static_cast<Real>(structure.yCoordList[atomIndex]),
                   static_cast<Real>(structure.zCoordList[atomIndex])));
@@ -125,6 +138,8 @@ bool MMTFFormat::read(std::istream& file, Molecule& molecule)
         // Stores if the compounds is a heteroatom
         // mmtf::is_hetatm(group.chemCompType.c_str());
         std::string atomName = group.atomNameList[l];
+        // The atom is valid once the atoms are added below.
+        Atom atom(&molecule, firstAtom + atomicNumbers.size() - 1);
         residue.addResidueAtom(atomName, atom);
         atomIndex++;
       }
@@ -137,7 +152,9 @@ bool MMTFFormat::read(std::istream& file, Molecule& molecule)
 
         char bo = static_cast<char>(group.bondOrderList[l]);
 
-        molecule.addBond(atomOffset + atom1, atomOffset + atom2, bo);
+        bondPairs.push_back(
+          std::make_pair(atomOffset + atom1, atomOffset + atom2));
+        bondOrders.push_back(static_cast<unsigned char>(bo));
       }
 
       // This is the origianl PDB Chain name
@@ -154,6 +171,9 @@ bool MMTFFormat::read(std::istream& file, Molecule& molecule)
   // Use this eventually for multi-model formats
   modelIndex++;
 
+  molecule.addAtoms(atomicNumbers, atomPositions);
+  molecule.setFormalCharges(formalCharges);
+
   // These are for inter-residue bonds
   for (size_t i = 0; i < structure.bondAtomList.size() / 2; i++) {
 
@@ -173,8 +193,24 @@ bool MMTFFormat::read(std::istream& file, Molecule& molecule)
 
     size_t atom_idx1 = atom1 - atomSkip; // atomSkip = 0 for us (1 model)
     size_t atom_idx2 = atom2 - atomSkip;
-    molecule.addBond(atom_idx1, atom_idx2, 1); // Always a single bond
+    bondPairs.push_back(std::make_pair(atom_idx1, atom_idx2));
+    bondOrders.push_back(1); // Always a single bond
+  }
+
+  // Drop the bonds to atoms of the other models, and self bonds.
+  Array<std::pair<Index, Index>> pairs;
+  Array<unsigned char> orders;
+  pairs.reserve(bondPairs.size());
+  orders.reserve(bondOrders.size());
+  for (Index i = 0; i < bondPairs.size(); ++i) {
+    const std::pair<Index, Index>& pair = bondPairs[i];
+    if (pair.first != pair.second && pair.first < molecule.atomCount() &&
+        pair.second < molecule.atomCount()) {
+      pairs.push_back(pair);
+      orders.push_back(bondOrders[i]);
+    }
   }
+  molecule.addBonds(pairs, orders);
 
   return true;
 }
@@ -6,6 +6,7 @@
 #include <avogadro/core/utilities.h>
 #include <avogadro/core/vector.h>
 
+#include <algorithm>
 #include <istream>
 #include <string>
 
@@ -35,16 +36,28 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
 {
   string buffer;
   std::vector<int> terList;
-  Residue* r;
+  Residue* r = nullptr;
   size_t currentResidueId = 0;
   bool ok(false);
   int coordSet = 0;
   Array<Vector3> positions;
 
+  // The atoms of the first model and the bonds are added to the molecule in
+  // one step each, once they have all been read.
+  Index firstAtom = mol.atomCount();
+  Array<unsigned char> atomicNumbers;
+  Array<Vector3> atomPositions;
+  Array<Real> occupancies;
+  Array<Real> bFactors;
+  bool hasOccupancies = false;
+  bool hasBFactors = false;
+  Array<std::pair<Index, Index>> bondPairs;
+
   while (getline(in, buffer)) { // Read Each line one by one
 
     if (startsWith(buffer, "ENDMDL")) {
       if (coordSet == 0) {
+        mol.addAtoms(atomicNumbers, atomPositions);
         mol.setCoordinate3d(mol.atomPositions3d(), coordSet++);
         positions.reserve(mol.atomCount());
       } else {
@@ -117,11 +130,21 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
         appendError("Invalid element");
 
       if (coordSet == 0) {
-        Atom newAtom = mol.addAtom(atomicNum);
-        newAtom.setPosition3d(pos);
+        atomicNumbers.push_back(atomicNum);
+        atomPositions.push_back(pos);
         if (r) {
+          // The atom is valid once the atoms are added to the molecule.
+          Atom newAtom(&mol, firstAtom + atomicNumbers.size() - 1);
           r->addResidueAtom(atomName, newAtom);
         }
+
+        // Occupancy and temperature factor, both optional.
+        Real occupancy = lexicalCast<Real>(buffer.substr(54, 6), ok);
+        occupancies.push_back(ok ? occupancy : Real(0));
+        hasOccupancies = hasOccupancies || ok;
+        Real bFactor = lexicalCast<Real>(buffer.substr(60, 6), ok);
+        bFactors.push_back(ok ? bFactor : Real(0));
+        hasBFactors = hasBFactors || ok;
       } else {
         positions.push_back(pos);
       }
@@ -169,13 +192,33 @@ bool PdbFormat::read(std::istream& in, Core::Molecule& mol)
             ; // semicolon is intentional
           b = b - terCount;
 
-          if (a < b) {
-            mol.Avogadro::Core::Molecule::addBond(a, b, 1);
-          }
+          if (a < b && a >= 0)
+            bondPairs.push_back(std::make_pair(a, b));
         }
       }
     }
   } // End while loop
+
+  if (coordSet == 0)
+    mol.addAtoms(atomicNumbers, atomPositions);
+  if (hasOccupancies)
+    mol.setAtomProperty("occupancy", occupancies);
+  if (hasBFactors)
+    mol.setAtomProperty("bFactor", bFactors);
+
+  // Bond orders are written as repeated CONECT records, drop the duplicates.
+  std::sort(bondPairs.begin(), bondPairs.end());
+  bondPairs.erase(std::unique(bondPairs.begin(), bondPairs.end()),
+                  bondPairs.end());
+  Index atomCount = mol.atomCount();
+  Array<std::pair<Index, Index>>::iterator last = std::remove_if(
+    bondPairs.begin(), bondPairs.end(),
+    [atomCount](const std::pair<Index, Index>& pair) {
+      return pair.second >= atomCount;
+    });
+  bondPairs.erase(last, bondPairs.end());
+  mol.addBonds(bondPairs, Array<unsigned char>(bondPairs.size(), 1));
+
   mol.perceiveBondsSimple();
   mol.perceiveBondsFromResidueData();
   return true;
@@ -80,9 +80,16 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
   if (!buffer.empty())
     mol.setData("name", trimmed(buffer));
 
-  // Parse atoms
+  // Parse atoms, they are added to the molecule in one step at the end.
+  Array<unsigned char> atomicNumbers;
+  Array<Vector3> atomPositions;
+  // The shortest atom line is "H 0 0 0" and a line ending.
+  size_t reserved = reserveCount(inStream, numAtoms, 8);
+  atomicNumbers.reserve(reserved);
+  atomPositions.reserve(reserved);
   for (size_t i = 0; i < numAtoms; ++i) {
-    getline(inStream, buffer);
+    if (!getline(inStream, buffer))
+      break;
     vector<string> tokens(split(buffer, ' '));
 
     if (tokens.size() < 4) {
@@ -99,19 +106,20 @@ bool XyzFormat::read(std::istream& inStream, Core::Molecule& mol)
     Vector3 pos(lexicalCast<double>(tokens[1]), lexicalCast<double>(tokens[2]),
                 lexicalCast<double>(tokens[3]));
 
-    Atom newAtom = mol.addAtom(atomicNum);
-    newAtom.setPosition3d(pos);
+    atomicNumbers.push_back(atomicNum);
+    atomPositions.push_back(pos);
   }
 
   // Check that all atoms were handled.
-  if (mol.atomCount() != numAtoms) {
+  if (atomicNumbers.size() != numAtoms) {
     std::ostringstream errorStream;
-    errorStream << "Error parsing atom at index " << mol.atomCount()
-                << " (line " << 3 + mol.atomCount() << ").\n"
+    errorStream << "Error parsing atom at index " << atomicNumbers.size()
+                << " (line " << 3 + atomicNumbers.size() << ").\n"
                 << buffer;
     appendError(errorStream.str());
     return false;
   }
+  mol.addAtoms(atomicNumbers, atomPositions);
 
   // Do we have an animation?
   size_t numAtoms2;
@@ -460,9 +460,10 @@ bool InterfaceScript::insertMolecule(QJsonObject& json,
 
   // insert the selected atoms
   QJsonArray selectedList;
-  for (Index i = 0; i < mol.atomCount(); ++i) {
-    if (mol.atomSelected(i))
-      selectedList.append(static_cast<qint64>(i));
+  const Core::Selection& selection = mol.atomSelection();
+  for (Index i = selection.first(); i < mol.atomCount();
+       i = selection.next(i)) {
+    selectedList.append(static_cast<qint64>(i));
   }
   json.insert("selectedatoms", selectedList);
 
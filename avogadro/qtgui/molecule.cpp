@@ -17,37 +17,106 @@
 #include "molecule.h"
 #include "rwmolecule.h"
 
+#include <algorithm>
+
 namespace Avogadro {
 namespace QtGui {
 
+namespace {
+// Map uniqueId to index in ids, and index back to uniqueId in indexIds. An
+// index of MaxIndex marks the unique id as unused.
+void mapUniqueId(Core::Array<Index>& ids, Core::Array<Index>& indexIds,
+                 Index uniqueId, Index index)
+{
+  if (uniqueId >= ids.size())
+    ids.resize(uniqueId + 1, MaxIndex);
+  ids[uniqueId] = index;
+  if (index == MaxIndex)
+    return;
+  if (index >= indexIds.size())
+    indexIds.resize(index + 1, MaxIndex);
+  indexIds[index] = uniqueId;
+}
+
+// The reverse entries of removed atoms and bonds are not cleared, so check
+// that the unique id still maps to the index.
+Index findUniqueId(const Core::Array<Index>& ids,
+                   const Core::Array<Index>& indexIds, Index index)
+{
+  if (index < indexIds.size()) {
+    Index uniqueId = indexIds[index];
+    if (uniqueId < ids.size() && ids[uniqueId] == index)
+      return uniqueId;
+  }
+  return MaxIndex;
+}
+
+// Give the first count indices the unique ids 0 to count - 1.
+void resetUniqueIds(Core::Array<Index>& ids, Core::Array<Index>& indexIds,
+                    Index count)
+{
+  ids.resize(count);
+  for (Index i = 0; i < count; ++i)
+    ids[i] = i;
+  indexIds = ids;
+}
+
+// Sort ranges and join the ones that overlap or touch.
+void coalesceRanges(Molecule::IndexRanges& ranges)
+{
+  if (ranges.empty())
+    return;
+  std::sort(ranges.begin(), ranges.end());
+  size_t last = 0;
+  for (size_t i = 1; i < ranges.size(); ++i) {
+    if (ranges[i].first <= ranges[last].second)
+      ranges[last].second = std::max(ranges[last].second, ranges[i].second);
+    else
+      ranges[++last] = ranges[i];
+  }
+  ranges.resize(last + 1);
+}
+
+// Queued connections to changedRanges() need the range type registered.
+void registerMetaTypes()
+{
+  static bool metaTypesRegistered = false;
+  if (!metaTypesRegistered) {
+    qRegisterMetaType<Molecule::IndexRanges>(
+      "Avogadro::QtGui::Molecule::IndexRanges");
+    metaTypesRegistered = true;
+  }
+}
+} // namespace
+
 Molecule::Molecule(QObject* parent_)
-  : QObject(parent_), m_undoMolecule(new RWMolecule(*this, this))
+  : QObject(parent_), m_undoMolecule(new RWMolecule(*this, this)),
+    m_changeDepth(0), m_pendingChanges(NoChange)
 {
+  registerMetaTypes();
   m_undoMolecule->setInteractive(true);
 }
 
 Molecule::Molecule(const Molecule& other)
   : QObject(), Core::Molecule(other),
-    m_undoMolecule(new RWMolecule(*this, this))
+    m_undoMolecule(new RWMolecule(*this, this)), m_changeDepth(0),
+    m_pendingChanges(NoChange)
 {
+  registerMetaTypes();
   m_undoMolecule->setInteractive(true);
   // Now assign the unique ids
-  for (Index i = 0; i < atomCount(); i++)
-    m_atomUniqueIds.push_back(i);
-
-  for (Index i = 0; i < bondCount(); i++)
-    m_bondUniqueIds.push_back(i);
+  resetUniqueIds(m_atomUniqueIds, m_atomIndexUniqueIds, atomCount());
+  resetUniqueIds(m_bondUniqueIds, m_bondIndexUniqueIds, bondCount());
 }
 
 Molecule::Molecule(const Core::Molecule& other)
-  : QObject(), Core::Molecule(other)
+  : QObject(), Core::Molecule(other), m_undoMolecule(nullptr),
+    m_changeDepth(0), m_pendingChanges(NoChange)
 {
+  registerMetaTypes();
   // Now assign the unique ids
-  for (Index i = 0; i < atomCount(); i++)
-    m_atomUniqueIds.push_back(i);
-
-  for (Index i = 0; i < bondCount(); i++)
-    m_bondUniqueIds.push_back(i);
+  resetUniqueIds(m_atomUniqueIds, m_atomIndexUniqueIds, atomCount());
+  resetUniqueIds(m_bondUniqueIds, m_bondIndexUniqueIds, bondCount());
 }
 
 Molecule& Molecule::operator=(const Molecule& other)
@@ -57,7 +126,9 @@ Molecule& Molecule::operator=(const Molecule& other)
 
   // Copy over the unique ids
   m_atomUniqueIds = other.m_atomUniqueIds;
+  m_atomIndexUniqueIds = other.m_atomIndexUniqueIds;
   m_bondUniqueIds = other.m_bondUniqueIds;
+  m_bondIndexUniqueIds = other.m_bondIndexUniqueIds;
 
   return *this;
 }
@@ -68,13 +139,8 @@ Molecule& Molecule::operator=(const Core::Molecule& other)
   Core::Molecule::operator=(other);
 
   // Reset the unique ids.
-  m_atomUniqueIds.clear();
-  for (Index i = 0; i < atomCount(); ++i)
-    m_atomUniqueIds.push_back(i);
-
-  m_bondUniqueIds.clear();
-  for (Index i = 0; i < bondCount(); ++i)
-    m_bondUniqueIds.push_back(i);
+  resetUniqueIds(m_atomUniqueIds, m_atomIndexUniqueIds, atomCount());
+  resetUniqueIds(m_bondUniqueIds, m_bondIndexUniqueIds, bondCount());
 
   return *this;
 }
@@ -83,9 +149,24 @@ Molecule::~Molecule()
 {
 }
 
+void Molecule::clear()
+{
+  Core::Molecule::clear();
+  m_atomUniqueIds.clear();
+  m_atomIndexUniqueIds.clear();
+  m_bondUniqueIds.clear();
+  m_bondIndexUniqueIds.clear();
+
+  // The undo history refers to atoms and bonds that no longer exist.
+  if (m_undoMolecule)
+    m_undoMolecule->undoStack().clear();
+  emitChanged(Atoms | Bonds | Removed);
+}
+
 Molecule::AtomType Molecule::addAtom(unsigned char number)
 {
-  m_atomUniqueIds.push_back(atomCount());
+  mapUniqueId(m_atomUniqueIds, m_atomIndexUniqueIds, m_atomUniqueIds.size(),
+              atomCount());
   AtomType a = Core::Molecule::addAtom(number);
   return a;
 }
@@ -97,11 +178,24 @@ Molecule::AtomType Molecule::addAtom(unsigned char number, Index uniqueId)
     return AtomType();
   }
 
-  m_atomUniqueIds[uniqueId] = atomCount();
+  mapUniqueId(m_atomUniqueIds, m_atomIndexUniqueIds, uniqueId, atomCount());
   AtomType a = Core::Molecule::addAtom(number);
   return a;
 }
 
+Index Molecule::addAtoms(const Core::Array<unsigned char>& atomicNumbers,
+                         const Core::Array<Vector3>& positions)
+{
+  Index first = atomCount();
+  m_atomUniqueIds.reserve(m_atomUniqueIds.size() + atomicNumbers.size());
+  m_atomIndexUniqueIds.reserve(first + atomicNumbers.size());
+  for (Index i = 0; i < atomicNumbers.size(); ++i) {
+    mapUniqueId(m_atomUniqueIds, m_atomIndexUniqueIds, m_atomUniqueIds.size(),
+                first + i);
+  }
+  return Core::Molecule::addAtoms(atomicNumbers, positions);
+}
+
 bool Molecule::removeAtom(Index index)
 {
   if (index >= atomCount())
@@ -142,14 +236,18 @@ bool Molecule::removeAtom(Index index)
 
     Index movedAtomUID = findAtomUniqueId(newSize);
     assert(movedAtomUID != MaxIndex);
-    m_atomUniqueIds[movedAtomUID] = index;
+    mapUniqueId(m_atomUniqueIds, m_atomIndexUniqueIds, movedAtomUID, index);
   }
   // Resize the arrays for the smaller molecule.
   if (m_positions2d.size() == m_atomicNumbers.size())
     m_positions2d.resize(newSize);
   if (m_positions3d.size() == m_atomicNumbers.size())
     m_positions3d.resize(newSize);
+  removePropertyRow(m_atomProperties, index);
+  m_selectedAtoms.swapRemove(index, newSize);
   m_atomicNumbers.resize(newSize);
+  if (m_atomIndexUniqueIds.size() > newSize)
+    m_atomIndexUniqueIds.resize(newSize);
 
   return true;
 }
@@ -184,20 +282,24 @@ Index Molecule::atomUniqueId(Index a) const
 Molecule::BondType Molecule::addBond(const AtomType& a, const AtomType& b,
                                      unsigned char order)
 {
-  m_bondUniqueIds.push_back(bondCount());
   assert(a.isValid() && a.molecule() == this);
   assert(b.isValid() && b.molecule() == this);
 
-  BondType bond_ = Core::Molecule::addBond(a.index(), b.index(), order);
-  return bond_;
+  return addBond(a.index(), b.index(), order);
 }
 
 Molecule::BondType Molecule::addBond(Avogadro::Index atomId1,
                                      Avogadro::Index atomId2,
                                      unsigned char order)
 {
-  m_bondUniqueIds.push_back(bondCount());
-  return Core::Molecule::addBond(atomId1, atomId2, order);
+  // Existing bonds are returned as they are and keep their unique ID.
+  Index count = bondCount();
+  BondType bond_ = Core::Molecule::addBond(atomId1, atomId2, order);
+  if (bondCount() != count) {
+    mapUniqueId(m_bondUniqueIds, m_bondIndexUniqueIds, m_bondUniqueIds.size(),
+                bond_.index());
+  }
+  return bond_;
 }
 
 Molecule::BondType Molecule::addBond(const AtomType& a, const AtomType& b,
@@ -208,10 +310,23 @@ Molecule::BondType Molecule::addBond(const AtomType& a, const AtomType& b,
     return BondType();
   }
 
-  m_bondUniqueIds[uniqueId] = bondCount();
+  mapUniqueId(m_bondUniqueIds, m_bondIndexUniqueIds, uniqueId, bondCount());
   return Core::Molecule::addBond(a, b, order);
 }
 
+Index Molecule::addBonds(const Core::Array<std::pair<Index, Index>>& pairs,
+                         const Core::Array<unsigned char>& orders)
+{
+  Index first = bondCount();
+  m_bondUniqueIds.reserve(m_bondUniqueIds.size() + pairs.size());
+  m_bondIndexUniqueIds.reserve(first + pairs.size());
+  for (Index i = 0; i < pairs.size(); ++i) {
+    mapUniqueId(m_bondUniqueIds, m_bondIndexUniqueIds, m_bondUniqueIds.size(),
+                first + i);
+  }
+  return Core::Molecule::addBonds(pairs, orders);
+}
+
 bool Molecule::removeBond(Index index)
 {
   if (index >= bondCount())
@@ -230,12 +345,16 @@ bool Molecule::removeBond(Index index)
 
     Index movedBondUID = findBondUniqueId(newSize);
     assert(movedBondUID != MaxIndex);
-    m_bondUniqueIds[movedBondUID] = index;
+    mapUniqueId(m_bondUniqueIds, m_bondIndexUniqueIds, movedBondUID, index);
   }
 
   // Resize the arrays for the smaller molecule.
   m_bondOrders.resize(newSize);
   m_bondPairs.resize(newSize);
+  removePropertyRow(m_bondProperties, index);
+  m_selectedBonds.swapRemove(index, newSize);
+  if (m_bondIndexUniqueIds.size() > newSize)
+    m_bondIndexUniqueIds.resize(newSize);
 
   return true;
 }
@@ -277,26 +396,86 @@ Index Molecule::bondUniqueId(Index b) const
   return findBondUniqueId(b);
 }
 
+void Molecule::beginChanges()
+{
+  ++m_changeDepth;
+}
+
+void Molecule::endChanges()
+{
+  if (m_changeDepth > 0 && --m_changeDepth == 0)
+    flushChanges();
+}
+
 void Molecule::emitChanged(unsigned int change)
 {
-  if (change != NoChange)
-    emit changed(change);
+  addChanges(change, 0, MaxIndex, 0, MaxIndex);
+}
+
+// The operation flags overlap the object type bits (Modified includes Bonds),
+// so the other type gets an empty range rather than all of its indices.
+void Molecule::emitAtomsChanged(unsigned int change, Index first, Index end)
+{
+  addChanges(change | Atoms, first, end, 0, 0);
+}
+
+void Molecule::emitBondsChanged(unsigned int change, Index first, Index end)
+{
+  addChanges(change | Bonds, 0, 0, first, end);
+}
+
+void Molecule::addChanges(unsigned int change, Index firstAtom, Index endAtom,
+                          Index firstBond, Index endBond)
+{
+  if (change == NoChange)
+    return;
+
+  m_pendingChanges |= change;
+  if ((change & Atoms) && firstAtom < endAtom)
+    m_changedAtoms.push_back(std::make_pair(firstAtom, endAtom));
+  if ((change & Bonds) && firstBond < endBond)
+    m_changedBonds.push_back(std::make_pair(firstBond, endBond));
+
+  if (!inChanges())
+    flushChanges();
+}
+
+void Molecule::flushChanges()
+{
+  // Take the pending changes first, listeners may make changes of their own.
+  unsigned int change = m_pendingChanges;
+  IndexRanges atoms;
+  IndexRanges bonds;
+  atoms.swap(m_changedAtoms);
+  bonds.swap(m_changedBonds);
+  m_pendingChanges = NoChange;
+  if (change == NoChange)
+    return;
+
+  coalesceRanges(atoms);
+  coalesceRanges(bonds);
+  emit changed(change);
+  emit changedRanges(change, atoms, bonds);
+}
+
+void Molecule::setAtomUniqueId(Index uniqueId, Index index)
+{
+  mapUniqueId(m_atomUniqueIds, m_atomIndexUniqueIds, uniqueId, index);
+}
+
+void Molecule::setBondUniqueId(Index uniqueId, Index index)
+{
+  mapUniqueId(m_bondUniqueIds, m_bondIndexUniqueIds, uniqueId, index);
 }
 
 Index Molecule::findAtomUniqueId(Index index) const
 {
-  for (Index i = 0; i < static_cast<Index>(m_atomUniqueIds.size()); ++i)
-    if (m_atomUniqueIds[i] == index)
-      return i;
-  return MaxIndex;
+  return findUniqueId(m_atomUniqueIds, m_atomIndexUniqueIds, index);
 }
 
 Index Molecule::findBondUniqueId(Index index) const
 {
-  for (Index i = 0; i < static_cast<Index>(m_bondUniqueIds.size()); ++i)
-    if (m_bondUniqueIds[i] == index)
-      return i;
-  return MaxIndex;
+  return findUniqueId(m_bondUniqueIds, m_bondIndexUniqueIds, index);
 }
 
 RWMolecule* Molecule::undoMolecule()
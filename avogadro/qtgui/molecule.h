@@ -25,8 +25,12 @@
 #include <avogadro/core/avogadrocore.h>
 #include <avogadro/core/molecule.h>
 
+#include <QtCore/QMetaType>
 #include <QtCore/QObject>
 
+#include <utility>
+#include <vector>
+
 namespace Avogadro {
 namespace QtGui {
 
@@ -57,6 +61,9 @@ public:
   /** Typedef for PersistentBond class. */
   typedef PersistentBond<Molecule> PersistentBondType;
 
+  /** Half open [first, end) ranges of atom or bond indices. */
+  typedef std::vector<std::pair<Index, Index>> IndexRanges;
+
   Molecule(QObject* parent_ = 0);
   ~Molecule() override;
   /** copy constructor */
@@ -71,6 +78,13 @@ public:
   /** Assignment operator to copy data from base instance */
   Molecule& operator=(const Core::Molecule& other);
 
+  /**
+   * Reset the molecule, and its unique IDs, keeping array capacity. The undo
+   * history of undoMolecule() is cleared too, as it refers to the removed atoms
+   * and bonds, and changed() is emitted with Atoms | Bonds | Removed.
+   */
+  void clear() override;
+
   /**
    * \enum MoleculeChange
    *Enumeration of change types that can be given.
@@ -103,6 +117,14 @@ public:
    */
   virtual AtomType addAtom(unsigned char atomicNumber, Index uniqueId);
 
+  /**
+   * Append atoms with @p atomicNumbers at @p positions in one step, see
+   * Core::Molecule::addAtoms.
+   * @return The index of the first new atom.
+   */
+  Index addAtoms(const Core::Array<unsigned char>& atomicNumbers,
+                 const Core::Array<Vector3>& positions) override;
+
   /**
    * @brief Remove the specified atom from the molecule.
    * @param index The index of the atom to be removed.
@@ -138,7 +160,8 @@ public:
   Index atomUniqueId(Index atom) const;
   /** @} */
 
-  Core::Array<Index>& atomUniqueIds() { return m_atomUniqueIds; }
+  /** The atom index for each unique ID, MaxIndex for removed atoms. */
+  const Core::Array<Index>& atomUniqueIds() const { return m_atomUniqueIds; }
 
   /**
    * @brief Add a bond between the specified atoms.
@@ -172,6 +195,14 @@ public:
   virtual BondType addBond(const AtomType& a, const AtomType& b,
                            unsigned char bondOrder, Index uniqueId);
 
+  /**
+   * Append bonds between the atom @p pairs in one step, see
+   * Core::Molecule::addBonds.
+   * @return The index of the first new bond.
+   */
+  Index addBonds(const Core::Array<std::pair<Index, Index>>& pairs,
+                 const Core::Array<unsigned char>& orders) override;
+
   /**
    * @brief Remove the specified bond.
    * @param index The index of the bond to be removed.
@@ -219,20 +250,71 @@ public:
   Index bondUniqueId(Index bond) const;
   /** @} */
 
-  Core::Array<Index>& bondUniqueIds() { return m_bondUniqueIds; }
+  /** The bond index for each unique ID, MaxIndex for removed bonds. */
+  const Core::Array<Index>& bondUniqueIds() const { return m_bondUniqueIds; }
 
+  /** The per atom and per bond property columns, for RWMolecule. @{ */
+  PropertyMap& atomProperties() { return m_atomProperties; }
+  PropertyMap& bondProperties() { return m_bondProperties; }
+  /** @} */
+
+  /**
+   * Map @p uniqueId to the atom or bond at @p index, growing the unique ID
+   * arrays as needed. An index of MaxIndex marks the unique ID as unused.
+   * @{
+   */
+  void setAtomUniqueId(Index uniqueId, Index index);
+  void setBondUniqueId(Index uniqueId, Index index);
+  /** @} */
+
+  /**
+   * @return The unique ID of the atom or bond at @p index in constant time,
+   * MaxIndex if there is none.
+   * @{
+   */
   Index findAtomUniqueId(Index index) const;
   Index findBondUniqueId(Index index) const;
+  /** @} */
 
   RWMolecule* undoMolecule();
 
+  /**
+   * @brief Begin a change transaction.
+   *
+   * Until the matching endChanges(), the emitChanged() calls are collected
+   * instead of emitted, so tools making many edits cause a single refresh.
+   * Transactions may be nested; only the outermost endChanges() emits.
+   */
+  void beginChanges();
+
+  /**
+   * @brief End a change transaction, emitting changed() and changedRanges()
+   * once for everything collected since beginChanges().
+   */
+  void endChanges();
+
+  /** @return True while a change transaction is open. */
+  bool inChanges() const { return m_changeDepth > 0; }
+
 public slots:
   /**
    * @brief Force the molecule to emit the changed() signal.
    * @param change See changed().
+   *
+   * Without an index range, every atom (or bond) is reported as changed when
+   * @p change includes Atoms (or Bonds).
    */
   void emitChanged(unsigned int change);
 
+  /**
+   * @brief Like emitChanged(), but only the atoms (or bonds) in [first, end)
+   * are reported as changed. Atoms (or Bonds) is added to @p change.
+   * @{
+   */
+  void emitAtomsChanged(unsigned int change, Index first, Index end);
+  void emitBondsChanged(unsigned int change, Index first, Index end);
+  /** @} */
+
 signals:
   /**
    * @brief Indicates that the molecule has changed.
@@ -244,13 +326,45 @@ signals:
    */
   void changed(unsigned int change);
 
+  /**
+   * @brief Emitted directly after changed(), with the atoms and bonds that were
+   * affected.
+   * @param change The same as for changed().
+   * @param atoms The changed atoms as sorted, non-overlapping ranges.
+   * @param bonds The changed bonds as sorted, non-overlapping ranges.
+   *
+   * The indices are those at the time of the signal. Ranges may extend past
+   * the current atom or bond count, e.g. a change to all atoms is reported as
+   * [0, MaxIndex). As removals move the last atom or bond into the removed
+   * one's place, listeners should treat changes including Removed as
+   * affecting everything.
+   */
+  void changedRanges(unsigned int change,
+                     const Avogadro::QtGui::Molecule::IndexRanges& atoms,
+                     const Avogadro::QtGui::Molecule::IndexRanges& bonds);
+
 private:
+  // Collect change, and the given ranges, until the transaction is emitted.
+  void addChanges(unsigned int change, Index firstAtom, Index endAtom,
+                  Index firstBond, Index endBond);
+  // Emit the collected changes and clear them.
+  void flushChanges();
+
   Core::Array<Index> m_atomUniqueIds;
   Core::Array<Index> m_bondUniqueIds;
+  // Reverse of the above, the unique ID for each index.
+  Core::Array<Index> m_atomIndexUniqueIds;
+  Core::Array<Index> m_bondIndexUniqueIds;
 
   friend class RWMolecule;
 
   RWMolecule* m_undoMolecule;
+
+  // The open change transaction, see beginChanges().
+  int m_changeDepth;
+  unsigned int m_pendingChanges;
+  IndexRanges m_changedAtoms;
+  IndexRanges m_changedBonds;
 };
 
 Q_DECLARE_OPERATORS_FOR_FLAGS(Molecule::MoleculeChanges)
@@ -258,4 +372,6 @@ Q_DECLARE_OPERATORS_FOR_FLAGS(Molecule::MoleculeChanges)
 } // end QtGui namespace
 } // end Avogadro namespace
 
+Q_DECLARE_METATYPE(Avogadro::QtGui::Molecule::IndexRanges)
+
 #endif // AVOGADRO_QTGUI_MOLECULE_H
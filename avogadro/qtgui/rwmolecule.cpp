@@ -48,8 +48,25 @@ public:
   UndoCommand(RWMolecule& m) : QUndoCommand(tr("Modify Molecule")), m_mol(m) {}
 
 protected:
-  Array<Index>& atomUniqueIds() { return m_mol.m_molecule.atomUniqueIds(); }
-  Array<Index>& bondUniqueIds() { return m_mol.m_molecule.bondUniqueIds(); }
+  const Array<Index>& atomUniqueIds() const
+  {
+    return m_mol.m_molecule.atomUniqueIds();
+  }
+  const Array<Index>& bondUniqueIds() const
+  {
+    return m_mol.m_molecule.bondUniqueIds();
+  }
+  void setAtomUniqueId(Index uid, Index atomId)
+  {
+    m_mol.m_molecule.setAtomUniqueId(uid, atomId);
+  }
+  void setBondUniqueId(Index uid, Index bondId)
+  {
+    m_mol.m_molecule.setBondUniqueId(uid, bondId);
+  }
+  // Sized to the current atom or bond count.
+  Core::Selection& atomSelection() { return m_mol.m_molecule.atomSelection(); }
+  Core::Selection& bondSelection() { return m_mol.m_molecule.bondSelection(); }
   Array<unsigned char>& atomicNumbers()
   {
     return m_mol.m_molecule.atomicNumbers();
@@ -70,6 +87,22 @@ protected:
   }
   Array<unsigned char>& bondOrders() { return m_mol.m_molecule.bondOrders(); }
   Array<Vector3>& forceVectors() { return m_mol.m_molecule.forceVectors(); }
+  Molecule::PropertyMap& atomProperties()
+  {
+    return m_mol.m_molecule.atomProperties();
+  }
+  Molecule::PropertyMap& bondProperties()
+  {
+    return m_mol.m_molecule.bondProperties();
+  }
+  static void resizeProperties(Molecule::PropertyMap& properties, Index size)
+  {
+    Molecule::resizeProperties(properties, size);
+  }
+  static void removePropertyRow(Molecule::PropertyMap& properties, Index index)
+  {
+    Molecule::removePropertyRow(properties, index);
+  }
   RWMolecule& m_mol;
 };
 
@@ -99,14 +132,166 @@ public:
   bool canMerge() const { return m_canMerge; }
   int id() const override { return m_canMerge ? Id : -1; }
 };
+
+// The change between two versions of an array, for the commands that replace
+// a whole array. Only the changed indices and their old and new values are
+// kept, so a step that touches a few atoms of a large system stays small.
+// When the size changes, or more than half of the values do, both versions
+// are kept whole instead; Array is copy-on-write, so these usually share their
+// data with the molecule.
+template <typename T>
+class ArrayChange
+{
+public:
+  ArrayChange(const Array<T>& oldValues, const Array<T>& newValues)
+    : m_whole(true)
+  {
+    if (oldValues.size() == newValues.size()) {
+      for (Index i = 0; i < newValues.size(); ++i) {
+        if (oldValues[i] != newValues[i])
+          m_indices.push_back(i);
+      }
+      if (m_indices.size() <= newValues.size() / 2) {
+        m_whole = false;
+        m_oldValues.reserve(m_indices.size());
+        m_newValues.reserve(m_indices.size());
+        for (Index i = 0; i < m_indices.size(); ++i) {
+          m_oldValues.push_back(oldValues[m_indices[i]]);
+          m_newValues.push_back(newValues[m_indices[i]]);
+        }
+        return;
+      }
+      m_indices.clear();
+    }
+    m_oldValues = oldValues;
+    m_newValues = newValues;
+  }
+
+  void redo(Array<T>& values) const { apply(values, m_newValues); }
+  void undo(Array<T>& values) const { apply(values, m_oldValues); }
+
+  // Fold in next, a change made directly after this one.
+  void merge(const ArrayChange& next)
+  {
+    if (next.m_whole) {
+      // Recover the whole array from before this change, if needed.
+      if (!m_whole) {
+        Array<T> oldValues = next.m_oldValues;
+        for (Index i = 0; i < m_indices.size(); ++i)
+          oldValues[m_indices[i]] = m_oldValues[i];
+        m_indices.clear();
+        m_oldValues = oldValues;
+        m_whole = true;
+      }
+      m_newValues = next.m_newValues;
+      return;
+    }
+    if (m_whole) {
+      next.redo(m_newValues);
+      return;
+    }
+
+    // Both are sparse: merge the sorted indices, keeping the oldest old value
+    // and the newest new value of each.
+    const Array<Index>& indices = m_indices;
+    const Array<T>& oldValues = m_oldValues;
+    const Array<Index>& nextIndices = next.m_indices;
+    Array<Index> mergedIndices;
+    Array<T> mergedOld;
+    Array<T> mergedNew;
+    mergedIndices.reserve(indices.size() + nextIndices.size());
+    mergedOld.reserve(indices.size() + nextIndices.size());
+    mergedNew.reserve(indices.size() + nextIndices.size());
+    Index i = 0;
+    Index j = 0;
+    while (i < indices.size() || j < nextIndices.size()) {
+      if (j == nextIndices.size() ||
+          (i < indices.size() && indices[i] < nextIndices[j])) {
+        mergedIndices.push_back(indices[i]);
+        mergedOld.push_back(oldValues[i]);
+        mergedNew.push_back(m_newValues[i]);
+        ++i;
+      } else if (i == indices.size() || nextIndices[j] < indices[i]) {
+        mergedIndices.push_back(nextIndices[j]);
+        mergedOld.push_back(next.m_oldValues[j]);
+        mergedNew.push_back(next.m_newValues[j]);
+        ++j;
+      } else {
+        mergedIndices.push_back(indices[i]);
+        mergedOld.push_back(oldValues[i]);
+        mergedNew.push_back(next.m_newValues[j]);
+        ++i;
+        ++j;
+      }
+    }
+    m_indices.swap(mergedIndices);
+    m_oldValues.swap(mergedOld);
+    m_newValues.swap(mergedNew);
+  }
+
+private:
+  void apply(Array<T>& values, const Array<T>& source) const
+  {
+    if (m_whole) {
+      values = source;
+      return;
+    }
+    for (Index i = 0; i < m_indices.size(); ++i)
+      values[m_indices[i]] = source[i];
+  }
+
+  bool m_whole;
+  Array<Index> m_indices;
+  Array<T> m_oldValues;
+  Array<T> m_newValues;
+};
+
+// The number of undo steps kept; a macro counts as one step.
+const int undoLimit = 500;
 } // namespace
 
-RWMolecule::RWMolecule(Molecule& mol, QObject* p) : QObject(p), m_molecule(mol)
-{}
+RWMolecule::RWMolecule(Molecule& mol, QObject* p)
+  : QObject(p), m_molecule(mol), m_interactive(false)
+{
+  // QUndoStack only accepts a limit while it is empty, so set it up front.
+  m_undoStack.setUndoLimit(undoLimit);
+}
 
 RWMolecule::~RWMolecule() {}
 
 namespace {
+// The property columns are kept in step with the atoms and bonds the same way
+// as the other arrays: removals move the last row into the removed one, see
+// Molecule::removePropertyRow().
+typedef Molecule::PropertyMap PropertyMap;
+typedef std::map<std::string, Real> PropertyRow;
+
+PropertyRow propertyRow(const PropertyMap& properties, Index index)
+{
+  PropertyRow row;
+  for (PropertyMap::const_iterator it = properties.begin(),
+                                   itEnd = properties.end();
+       it != itEnd; ++it) {
+    if (index < it->second.size())
+      row[it->first] = it->second[index];
+  }
+  return row;
+}
+
+// Undo removePropertyRow(), restoring the values in row at index.
+void insertPropertyRow(PropertyMap& properties, Index index,
+                       const PropertyRow& row)
+{
+  for (PropertyMap::iterator it = properties.begin(), itEnd = properties.end();
+       it != itEnd; ++it) {
+    Array<Real>& values = it->second;
+    PropertyRow::const_iterator value = row.find(it->first);
+    values.push_back(value != row.end() ? value->second : Real(0));
+    if (index < values.size() - 1)
+      std::swap(values[index], values.back());
+  }
+}
+
 class AddAtomCommand : public RWMolecule::UndoCommand
 {
   unsigned char m_atomicNumber;
@@ -127,9 +312,8 @@ public:
     atomicNumbers().push_back(m_atomicNumber);
     if (m_usingPositions)
       positions3d().push_back(Vector3::Zero());
-    if (m_uniqueId >= atomUniqueIds().size())
-      atomUniqueIds().resize(m_uniqueId + 1, MaxIndex);
-    atomUniqueIds()[m_uniqueId] = m_atomId;
+    resizeProperties(atomProperties(), atomicNumbers().size());
+    setAtomUniqueId(m_uniqueId, m_atomId);
   }
 
   void undo() override
@@ -138,7 +322,8 @@ public:
     atomicNumbers().pop_back();
     if (m_usingPositions)
       positions3d().resize(atomicNumbers().size(), Vector3::Zero());
-    atomUniqueIds()[m_uniqueId] = MaxIndex;
+    resizeProperties(atomProperties(), atomicNumbers().size());
+    setAtomUniqueId(m_uniqueId, MaxIndex);
   }
 };
 } // namespace
@@ -178,18 +363,23 @@ class RemoveAtomCommand : public RWMolecule::UndoCommand
   Index m_atomUid;
   unsigned char m_atomicNumber;
   Vector3 m_position3d;
+  PropertyRow m_properties;
+  bool m_selected;
 
 public:
   RemoveAtomCommand(RWMolecule& m, Index atomId, Index uid, unsigned char aN,
                     const Vector3& pos)
     : UndoCommand(m), m_atomId(atomId), m_atomUid(uid), m_atomicNumber(aN),
-      m_position3d(pos)
-  {}
+      m_position3d(pos), m_selected(m.atomSelected(atomId))
+  {
+    m_properties = propertyRow(atomProperties(), atomId);
+  }
 
   void redo() override
   {
     assert(m_atomUid < atomUniqueIds().size());
-    atomUniqueIds()[m_atomUid] = MaxIndex;
+    setAtomUniqueId(m_atomUid, MaxIndex);
+    atomSelection().swapRemove(m_atomId, m_mol.atomCount() - 1);
 
     // Move the last atom to the removed atom's position:
     Index movedId = m_mol.atomCount() - 1;
@@ -213,12 +403,13 @@ public:
       // Update the moved atom's uid
       Index movedUid = m_mol.atomUniqueId(movedId);
       assert(movedUid != MaxIndex);
-      atomUniqueIds()[movedUid] = m_atomId;
+      setAtomUniqueId(movedUid, m_atomId);
     }
 
     // Resize the arrays:
     if (positions3d().size() == atomicNumbers().size())
       positions3d().resize(movedId, Vector3::Zero());
+    removePropertyRow(atomProperties(), m_atomId);
     atomicNumbers().resize(movedId, 0);
   }
 
@@ -227,6 +418,7 @@ public:
     // Append removed atom's info to the end of the arrays:
     if (positions3d().size() == atomicNumbers().size())
       positions3d().push_back(m_position3d);
+    insertPropertyRow(atomProperties(), m_atomId, m_properties);
     atomicNumbers().push_back(m_atomicNumber);
 
     // Swap the moved and unremoved atom data if needed
@@ -252,11 +444,17 @@ public:
       // Update the moved atom's UID
       Index movedUid = m_mol.atomUniqueId(m_atomId);
       assert(movedUid != MaxIndex);
-      atomUniqueIds()[movedUid] = movedId;
+      setAtomUniqueId(movedUid, movedId);
     }
 
     // Update the removed atom's UID
-    atomUniqueIds()[m_atomUid] = m_atomId;
+    setAtomUniqueId(m_atomUid, m_atomId);
+
+    // Restore the selection, moving the moved atom's state back too.
+    Core::Selection& selection = atomSelection();
+    if (m_atomId != movedId)
+      selection.set(movedId, selection.test(m_atomId));
+    selection.set(m_atomId, m_selected);
   }
 };
 } // namespace
@@ -326,20 +524,18 @@ void RWMolecule::adjustHydrogens(const Core::Array<Index>& atomIds)
 namespace {
 class SetAtomicNumbersCommand : public RWMolecule::UndoCommand
 {
-  Core::Array<unsigned char> m_oldAtomicNumbers;
-  Core::Array<unsigned char> m_newAtomicNumbers;
+  ArrayChange<unsigned char> m_atomicNumbers;
 
 public:
   SetAtomicNumbersCommand(RWMolecule& m,
                           const Core::Array<unsigned char>& oldAtomicNumbers,
                           const Core::Array<unsigned char>& newAtomicNumbers)
-    : UndoCommand(m), m_oldAtomicNumbers(oldAtomicNumbers),
-      m_newAtomicNumbers(newAtomicNumbers)
+    : UndoCommand(m), m_atomicNumbers(oldAtomicNumbers, newAtomicNumbers)
   {}
 
-  void redo() override { atomicNumbers() = m_newAtomicNumbers; }
+  void redo() override { m_atomicNumbers.redo(atomicNumbers()); }
 
-  void undo() override { atomicNumbers() = m_oldAtomicNumbers; }
+  void undo() override { m_atomicNumbers.undo(atomicNumbers()); }
 };
 } // namespace
 
@@ -391,27 +587,26 @@ bool RWMolecule::setAtomicNumber(Index atomId, unsigned char num)
 namespace {
 class SetPositions3dCommand : public MergeUndoCommand<SetPositions3dMergeId>
 {
-  Core::Array<Vector3> m_oldPositions3d;
-  Core::Array<Vector3> m_newPositions3d;
+  ArrayChange<Vector3> m_positions3d;
 
 public:
   SetPositions3dCommand(RWMolecule& m,
                         const Core::Array<Vector3>& oldPositions3d,
                         const Core::Array<Vector3>& newPositions3d)
     : MergeUndoCommand<SetPositions3dMergeId>(m),
-      m_oldPositions3d(oldPositions3d), m_newPositions3d(newPositions3d)
+      m_positions3d(oldPositions3d, newPositions3d)
   {}
 
-  void redo() override { positions3d() = m_newPositions3d; }
+  void redo() override { m_positions3d.redo(positions3d()); }
 
-  void undo() override { positions3d() = m_oldPositions3d; }
+  void undo() override { m_positions3d.undo(positions3d()); }
 
   bool mergeWith(const QUndoCommand* other) override
   {
     const SetPositions3dCommand* o =
       dynamic_cast<const SetPositions3dCommand*>(other);
     if (o) {
-      m_newPositions3d = o->m_newPositions3d;
+      m_positions3d.merge(o->m_positions3d);
       return true;
     }
     return false;
@@ -648,9 +843,8 @@ public:
     assert(bondPairs().size() == m_bondId);
     bondOrders().push_back(m_bondOrder);
     bondPairs().push_back(m_bondPair);
-    if (m_uniqueId >= bondUniqueIds().size())
-      bondUniqueIds().resize(m_uniqueId + 1, MaxIndex);
-    bondUniqueIds()[m_uniqueId] = m_bondId;
+    resizeProperties(bondProperties(), bondPairs().size());
+    setBondUniqueId(m_uniqueId, m_bondId);
   }
 
   void undo() override
@@ -659,7 +853,8 @@ public:
     assert(bondPairs().size() == m_bondId + 1);
     bondOrders().pop_back();
     bondPairs().pop_back();
-    bondUniqueIds()[m_uniqueId] = MaxIndex;
+    resizeProperties(bondProperties(), bondPairs().size());
+    setBondUniqueId(m_uniqueId, MaxIndex);
   }
 };
 
@@ -704,19 +899,25 @@ class RemoveBondCommand : public RWMolecule::UndoCommand
   Index m_bondUid;
   std::pair<Index, Index> m_bondPair;
   unsigned char m_bondOrder;
+  PropertyRow m_properties;
+  bool m_selected;
 
 public:
   RemoveBondCommand(RWMolecule& m, Index bondId, Index bondUid,
                     const std::pair<Index, Index>& bondPair,
                     unsigned char bondOrder)
     : UndoCommand(m), m_bondId(bondId), m_bondUid(bondUid),
-      m_bondPair(bondPair), m_bondOrder(bondOrder)
-  {}
+      m_bondPair(bondPair), m_bondOrder(bondOrder),
+      m_selected(m.molecule().bondSelected(bondId))
+  {
+    m_properties = propertyRow(bondProperties(), bondId);
+  }
 
   void redo() override
   {
     // Clear removed bond's UID
-    bondUniqueIds()[m_bondUid] = MaxIndex;
+    setBondUniqueId(m_bondUid, MaxIndex);
+    bondSelection().swapRemove(m_bondId, m_mol.bondCount() - 1);
 
     // Move the last bond's data to the removed bond's index:
     Index movedId = m_mol.bondCount() - 1;
@@ -727,10 +928,11 @@ public:
       // Update moved bond's UID
       Index movedUid = m_mol.bondUniqueId(movedId);
       assert(movedUid != MaxIndex);
-      bondUniqueIds()[movedUid] = m_bondId;
+      setBondUniqueId(movedUid, m_bondId);
     }
     bondOrders().pop_back();
     bondPairs().pop_back();
+    removePropertyRow(bondProperties(), m_bondId);
   }
 
   void undo() override
@@ -738,6 +940,7 @@ public:
     // Push the removed bond's info to the end of the arrays:
     bondOrders().push_back(m_bondOrder);
     bondPairs().push_back(m_bondPair);
+    insertPropertyRow(bondProperties(), m_bondId, m_properties);
 
     // Swap with the bond that we moved in redo():
     Index movedId = m_mol.bondCount() - 1;
@@ -749,11 +952,17 @@ public:
       // Update moved bond's UID
       Index movedUid = m_mol.bondUniqueId(m_bondId);
       assert(movedUid != MaxIndex);
-      bondUniqueIds()[movedUid] = movedId;
+      setBondUniqueId(movedUid, movedId);
     }
 
     // Restore the removed bond's UID
-    bondUniqueIds()[m_bondUid] = m_bondId;
+    setBondUniqueId(m_bondUid, m_bondId);
+
+    // Restore the selection, moving the moved bond's state back too.
+    Core::Selection& selection = bondSelection();
+    if (m_bondId != movedId)
+      selection.set(movedId, selection.test(m_bondId));
+    selection.set(m_bondId, m_selected);
   }
 };
 } // namespace
@@ -788,19 +997,17 @@ void RWMolecule::clearBonds()
 namespace {
 class SetBondOrdersCommand : public RWMolecule::UndoCommand
 {
-  Array<unsigned char> m_oldBondOrders;
-  Array<unsigned char> m_newBondOrders;
+  ArrayChange<unsigned char> m_bondOrders;
 
 public:
   SetBondOrdersCommand(RWMolecule& m, const Array<unsigned char>& oldBondOrders,
                        const Array<unsigned char>& newBondOrders)
-    : UndoCommand(m), m_oldBondOrders(oldBondOrders),
-      m_newBondOrders(newBondOrders)
+    : UndoCommand(m), m_bondOrders(oldBondOrders, newBondOrders)
   {}
 
-  void redo() override { bondOrders() = m_newBondOrders; }
+  void redo() override { m_bondOrders.redo(bondOrders()); }
 
-  void undo() override { bondOrders() = m_oldBondOrders; }
+  void undo() override { m_bondOrders.undo(bondOrders()); }
 };
 } // namespace
 
@@ -865,19 +1072,18 @@ bool RWMolecule::setBondOrder(Index bondId, unsigned char order)
 namespace {
 class SetBondPairsCommand : public RWMolecule::UndoCommand
 {
-  Array<std::pair<Index, Index>> m_oldBondPairs;
-  Array<std::pair<Index, Index>> m_newBondPairs;
+  ArrayChange<std::pair<Index, Index>> m_bondPairs;
 
 public:
   SetBondPairsCommand(RWMolecule& m,
                       const Array<std::pair<Index, Index>>& oldBondPairs,
                       const Array<std::pair<Index, Index>>& newBondPairs)
-    : UndoCommand(m), m_oldBondPairs(oldBondPairs), m_newBondPairs(newBondPairs)
+    : UndoCommand(m), m_bondPairs(oldBondPairs, newBondPairs)
   {}
 
-  void redo() override { bondPairs() = m_newBondPairs; }
+  void redo() override { m_bondPairs.redo(bondPairs()); }
 
-  void undo() override { bondPairs() = m_oldBondPairs; }
+  void undo() override { m_bondPairs.undo(bondPairs()); }
 };
 } // namespace
 
@@ -1315,6 +1521,16 @@ bool RWMolecule::reduceCellToAsymmetricUnit(unsigned short hallNumber,
   return true;
 }
 
+void RWMolecule::beginChanges()
+{
+  m_molecule.beginChanges();
+}
+
+void RWMolecule::endChanges()
+{
+  m_molecule.endChanges();
+}
+
 void RWMolecule::emitChanged(unsigned int change)
 {
   m_molecule.emitChanged(change);
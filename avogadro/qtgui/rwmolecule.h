@@ -60,6 +60,9 @@ class RWBond;
  * named action using the QUndoStack's macro capability. Call
  * undoStack().beginMacro(tr("User Description Of Change")) to begin a macro,
  * and undoStack().endMacro() when finished.
+ *
+ * The undo stack keeps the 500 most recent commands, counting each macro as
+ * one; older commands are deleted as new ones are pushed.
  */
 class AVOGADROQTGUI_EXPORT RWMolecule : public QObject
 {
@@ -638,6 +641,15 @@ public:
     Index atomId, const Vector3& pos,
     const QString& undoText = QStringLiteral("Change Force Vectors"));
 
+  /**
+   * @brief Begin and end a change transaction on the molecule, see
+   * Molecule::beginChanges().
+   * @{
+   */
+  void beginChanges();
+  void endChanges();
+  /** @} */
+
 public slots:
   /**
    * @brief Force the molecule to emit the changed() signal.
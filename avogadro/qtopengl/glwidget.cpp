@@ -24,10 +24,13 @@
 #include <avogadro/qtgui/toolplugin.h>
 
 #include <avogadro/rendering/camera.h>
+#include <avogadro/rendering/glresourcecache.h>
 
+#include <QtCore/QHash>
 #include <QtCore/QTimer>
 #include <QtGui/QKeyEvent>
 #include <QtGui/QMouseEvent>
+#include <QtGui/QOpenGLContext>
 #include <QtGui/QWheelEvent>
 #include <QtWidgets/QAction>
 #include <QtWidgets/QApplication>
@@ -35,9 +38,26 @@
 namespace Avogadro {
 namespace QtOpenGL {
 
+namespace {
+// Widgets whose contexts share GL objects, such as the views of a
+// MultiViewWidget in one window, also share shader programs and buffers.
+struct SharedResourceCache
+{
+  SharedResourceCache() : cache(nullptr), users(0) {}
+  Rendering::GLResourceCache* cache;
+  int users;
+};
+
+QHash<QOpenGLContextShareGroup*, SharedResourceCache>& sharedResourceCaches()
+{
+  static QHash<QOpenGLContextShareGroup*, SharedResourceCache> caches;
+  return caches;
+}
+}
+
 GLWidget::GLWidget(QWidget* p)
   : QOpenGLWidget(p), m_activeTool(nullptr), m_defaultTool(nullptr),
-    m_renderTimer(nullptr)
+    m_renderTimer(nullptr), m_shareGroup(nullptr), m_sceneReleased(false)
 {
   setFocusPolicy(Qt::ClickFocus);
   connect(&m_scenePlugins,
@@ -49,6 +69,12 @@ GLWidget::GLWidget(QWidget* p)
 
 GLWidget::~GLWidget()
 {
+  // The context outlives us, it must not call back into a dead widget.
+  if (context())
+    disconnect(context(), 0, this, 0);
+  makeCurrent();
+  releaseResourceCache();
+  doneCurrent();
 }
 
 void GLWidget::setMolecule(QtGui::Molecule* mol)
@@ -230,6 +256,46 @@ void GLWidget::initializeGL()
   m_renderer.initialize();
   if (!m_renderer.isValid())
     emit rendererInvalid();
+
+  // The context is recreated when the widget moves to another window, the GL
+  // resources of the old one are released before it is destroyed.
+  connect(context(), SIGNAL(aboutToBeDestroyed()),
+          SLOT(contextAboutToBeDestroyed()), Qt::DirectConnection);
+
+  m_shareGroup = context()->shareGroup();
+  SharedResourceCache& shared = sharedResourceCaches()[m_shareGroup];
+  if (!shared.cache)
+    shared.cache = new Rendering::GLResourceCache;
+  ++shared.users;
+  m_renderer.setResourceCache(shared.cache);
+  if (m_sceneReleased) {
+    m_sceneReleased = false;
+    updateScene();
+  }
+}
+
+void GLWidget::contextAboutToBeDestroyed()
+{
+  makeCurrent();
+  m_sceneReleased = m_shareGroup != nullptr;
+  releaseResourceCache();
+  doneCurrent();
+}
+
+void GLWidget::releaseResourceCache()
+{
+  if (!m_shareGroup)
+    return;
+
+  // The drawables hold buffers from the cache, so they must go first.
+  m_renderer.scene().clear();
+  m_renderer.setResourceCache(nullptr);
+  SharedResourceCache& shared = sharedResourceCaches()[m_shareGroup];
+  if (--shared.users == 0) {
+    delete shared.cache;
+    sharedResourceCaches().remove(m_shareGroup);
+  }
+  m_shareGroup = nullptr;
 }
 
 void GLWidget::resizeGL(int width_, int height_)
@@ -240,6 +306,9 @@ void GLWidget::resizeGL(int width_, int height_)
 void GLWidget::paintGL()
 {
   m_renderer.render();
+  // Keep rendering until progressively refined drawables are complete.
+  if (m_renderer.isRefining())
+    update();
 }
 
 void GLWidget::mouseDoubleClickEvent(QMouseEvent* e)
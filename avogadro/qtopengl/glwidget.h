@@ -25,6 +25,7 @@
 #include <QtCore/QPointer>
 #include <QtWidgets/QOpenGLWidget>
 
+class QOpenGLContextShareGroup;
 class QTimer;
 
 namespace Avogadro {
@@ -176,6 +177,13 @@ protected slots:
    */
   void updateTimeout();
 
+private slots:
+  /**
+   * Release the scene and the GL resources of the context that is about to be
+   * destroyed, while it can still be made current.
+   */
+  void contextAboutToBeDestroyed();
+
 protected:
   /** This is where the GL context is initialized. */
   void initializeGL() override;
@@ -197,6 +205,12 @@ protected:
   /** @} */
 
 private:
+  /**
+   * Stop using the resource cache shared with the other widgets in our context
+   * share group, deleting it if this was the last widget using it.
+   */
+  void releaseResourceCache();
+
   QPointer<QtGui::Molecule> m_molecule;
   QList<QtGui::ToolPlugin*> m_tools;
   QtGui::ToolPlugin* m_activeTool;
@@ -205,6 +219,8 @@ private:
   QtGui::ScenePluginModel m_scenePlugins;
 
   QTimer* m_renderTimer;
+  QOpenGLContextShareGroup* m_shareGroup;
+  bool m_sceneReleased;
 };
 
 } // End QtOpenGL namespace
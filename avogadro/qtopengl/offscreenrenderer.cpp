@@ -0,0 +1,190 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "offscreenrenderer.h"
+
+#include "qttextrenderstrategy.h"
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/io/fileformatmanager.h>
+#include <avogadro/qtgui/sceneplugin.h>
+#include <avogadro/rendering/glresourcecache.h>
+#include <avogadro/rendering/groupnode.h>
+
+#include <QtCore/QDir>
+#include <QtCore/QFileInfo>
+#include <QtGui/QOffscreenSurface>
+#include <QtGui/QOpenGLContext>
+#include <QtGui/QOpenGLFramebufferObject>
+
+namespace Avogadro {
+namespace QtOpenGL {
+
+namespace {
+// Upper limit on the renders used to complete progressive drawables.
+const int maxRefiningRenders = 100;
+}
+
+OffscreenRenderer::OffscreenRenderer()
+  : m_valid(false), m_width(0), m_height(0), m_surface(nullptr),
+    m_context(nullptr), m_framebuffer(nullptr), m_resourceCache(nullptr)
+{
+}
+
+OffscreenRenderer::~OffscreenRenderer()
+{
+  // The scene, resource cache and framebuffer hold OpenGL resources, release
+  // them while the context is still current. They are deleted either way,
+  // without a current context their GL objects go away with the context.
+  bool current = makeCurrent();
+  m_renderer.scene().clear();
+  m_renderer.setResourceCache(nullptr);
+  delete m_resourceCache;
+  delete m_framebuffer;
+  if (current)
+    m_context->doneCurrent();
+  delete m_context;
+  delete m_surface;
+}
+
+bool OffscreenRenderer::initialize(int w, int h)
+{
+  if (m_context) {
+    m_error = "The offscreen renderer is already initialized.";
+    return false;
+  }
+
+  m_surface = new QOffscreenSurface;
+  m_surface->setFormat(QSurfaceFormat::defaultFormat());
+  m_surface->create();
+  if (!m_surface->isValid()) {
+    m_error = "Could not create an offscreen surface.";
+    return false;
+  }
+
+  m_context = new QOpenGLContext;
+  m_context->setFormat(m_surface->format());
+  if (!m_context->create()) {
+    m_error = "Could not create an OpenGL context.";
+    return false;
+  }
+  if (!makeCurrent()) {
+    m_error = "Could not make the OpenGL context current.";
+    return false;
+  }
+
+  m_renderer.initialize();
+  if (!m_renderer.isValid()) {
+    m_error = QString::fromStdString(m_renderer.error());
+    return false;
+  }
+  m_renderer.setTextRenderStrategy(new QtTextRenderStrategy);
+  // Our own cache, so that it is deleted while the context is current.
+  m_resourceCache = new Rendering::GLResourceCache;
+  m_renderer.setResourceCache(m_resourceCache);
+
+  return resize(w, h);
+}
+
+bool OffscreenRenderer::resize(int w, int h)
+{
+  if (!m_renderer.isValid() || !makeCurrent()) {
+    m_error = "The offscreen renderer is not initialized.";
+    return false;
+  }
+
+  // Nothing can be rendered until a new framebuffer is in place.
+  m_valid = false;
+  delete m_framebuffer;
+  QOpenGLFramebufferObjectFormat format;
+  format.setAttachment(QOpenGLFramebufferObject::CombinedDepthStencil);
+  format.setSamples(4);
+  m_framebuffer = new QOpenGLFramebufferObject(w, h, format);
+  if (!m_framebuffer->isValid()) {
+    delete m_framebuffer;
+    m_framebuffer = nullptr;
+    m_error = "Could not create a framebuffer object.";
+    return false;
+  }
+
+  m_width = w;
+  m_height = h;
+  m_renderer.resize(w, h);
+  m_valid = true;
+  return true;
+}
+
+QImage OffscreenRenderer::render(const Core::Molecule& molecule)
+{
+  if (!m_valid || !m_framebuffer || !makeCurrent())
+    return QImage();
+
+  m_framebuffer->bind();
+
+  // Build up the scene with the scene plugins, as GLWidget does.
+  Rendering::GroupNode& node = m_renderer.scene().rootNode();
+  node.clear();
+  Rendering::GroupNode* moleculeNode = new Rendering::GroupNode(&node);
+  foreach (QtGui::ScenePlugin* scenePlugin, m_scenePlugins) {
+    Rendering::GroupNode* engineNode = new Rendering::GroupNode(moleculeNode);
+    scenePlugin->process(molecule, *engineNode);
+  }
+  m_renderer.resetCamera();
+
+  // Drawables that refine themselves over several frames are completed, an
+  // image is only taken once.
+  m_renderer.render();
+  for (int i = 0; i < maxRefiningRenders && m_renderer.isRefining(); ++i)
+    m_renderer.render();
+
+  QImage image = m_framebuffer->toImage();
+  m_framebuffer->release();
+  return image;
+}
+
+bool OffscreenRenderer::render(const Core::Molecule& molecule,
+                               const QString& fileName)
+{
+  QImage image = render(molecule);
+  if (image.isNull()) {
+    m_error = "Could not render an image for " + fileName;
+    return false;
+  }
+  if (!image.save(fileName)) {
+    m_error = "Could not save the image " + fileName;
+    return false;
+  }
+  return true;
+}
+
+int OffscreenRenderer::renderFiles(const QStringList& fileNames,
+                                   const QString& outputDirectory)
+{
+  QDir dir(outputDirectory);
+  QStringList errors;
+  int written = 0;
+  foreach (const QString& fileName, fileNames) {
+    Core::Molecule molecule;
+    if (!Io::FileFormatManager::instance().readFile(molecule,
+                                                    fileName.toStdString())) {
+      errors << "Could not read " + fileName;
+      continue;
+    }
+    QString imageName =
+      dir.absoluteFilePath(QFileInfo(fileName).completeBaseName() + ".png");
+    if (render(molecule, imageName))
+      ++written;
+    else
+      errors << m_error;
+  }
+  m_error = errors.join("\n");
+  return written;
+}
+
+bool OffscreenRenderer::makeCurrent()
+{
+  return m_context && m_surface && m_context->makeCurrent(m_surface);
+}
+
+} // End namespace QtOpenGL
+} // End namespace Avogadro
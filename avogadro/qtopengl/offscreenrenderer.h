@@ -0,0 +1,154 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_QTOPENGL_OFFSCREENRENDERER_H
+#define AVOGADRO_QTOPENGL_OFFSCREENRENDERER_H
+
+#include "avogadroqtopenglexport.h"
+
+#include <avogadro/rendering/glrenderer.h>
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtGui/QImage>
+
+class QOffscreenSurface;
+class QOpenGLContext;
+class QOpenGLFramebufferObject;
+
+namespace Avogadro {
+
+namespace Core {
+class Molecule;
+}
+
+namespace QtGui {
+class ScenePlugin;
+}
+
+namespace Rendering {
+class GLResourceCache;
+}
+
+namespace QtOpenGL {
+
+/**
+ * @class OffscreenRenderer offscreenrenderer.h
+ * <avogadro/qtopengl/offscreenrenderer.h>
+ * @brief Render molecules to images without a window.
+ *
+ * The OffscreenRenderer creates an OpenGL context for a QOffscreenSurface and
+ * renders into a framebuffer object, so no window or widget is needed. A
+ * QGuiApplication must exist. On machines without a display use the
+ * "offscreen" or "minimalegl" Qt platform plugins (set QT_QPA_PLATFORM) with
+ * an EGL or Mesa (OSMesa/llvmpipe) OpenGL implementation.
+ *
+ * The context, framebuffer and renderer are created once and reused for every
+ * molecule, which makes the class suited to rendering many thumbnails:
+ * @code
+ * OffscreenRenderer renderer;
+ * renderer.setScenePlugins(plugins);
+ * if (renderer.initialize(256, 256))
+ *   renderer.renderFiles(fileNames, outputDirectory);
+ * @endcode
+ */
+
+class AVOGADROQTOPENGL_EXPORT OffscreenRenderer
+{
+public:
+  OffscreenRenderer();
+  ~OffscreenRenderer();
+
+  /**
+   * Create the OpenGL context and a framebuffer of the given size. This must
+   * be called before anything is rendered.
+   * @return True on success, see error() otherwise.
+   */
+  bool initialize(int width, int height);
+
+  /**
+   * @return True if the renderer was initialized successfully and the last
+   * resize() succeeded.
+   */
+  bool isValid() const { return m_valid; }
+
+  /** @return A description of the last error, empty if there was none. */
+  QString error() const { return m_error; }
+
+  /**
+   * Change the size of the rendered images. On failure nothing can be
+   * rendered until a later call succeeds.
+   * @return True on success, see error() otherwise.
+   */
+  bool resize(int width, int height);
+
+  /** The size of the rendered images. @{ */
+  int width() const { return m_width; }
+  int height() const { return m_height; }
+  /** @} */
+
+  /**
+   * The scene plugins used to build the scene for each molecule, in order.
+   * The plugins are not owned by the renderer.
+   * @{
+   */
+  void setScenePlugins(const QList<QtGui::ScenePlugin*>& plugins)
+  {
+    m_scenePlugins = plugins;
+  }
+  QList<QtGui::ScenePlugin*> scenePlugins() const { return m_scenePlugins; }
+  /** @} */
+
+  /**
+   * Get the renderer, to change the background color or projection for
+   * example. The camera is reset to fit each molecule that is rendered.
+   */
+  Rendering::GLRenderer& renderer() { return m_renderer; }
+
+  /**
+   * Render @a molecule with the scene plugins.
+   * @return The rendered image, or a null image on failure.
+   */
+  QImage render(const Core::Molecule& molecule);
+
+  /**
+   * Render @a molecule with the scene plugins and save the image to
+   * @a fileName, the image format is deduced from the file suffix.
+   * @return True on success.
+   */
+  bool render(const Core::Molecule& molecule, const QString& fileName);
+
+  /**
+   * Read each file in @a fileNames and render it to a PNG image in
+   * @a outputDirectory, named after the molecule file. Files that cannot be
+   * read or rendered are skipped, and error() lists them.
+   * @return The number of images written.
+   */
+  int renderFiles(const QStringList& fileNames,
+                  const QString& outputDirectory);
+
+private:
+  OffscreenRenderer(const OffscreenRenderer&);            // Not implemented.
+  OffscreenRenderer& operator=(const OffscreenRenderer&); // Not implemented.
+
+  bool makeCurrent();
+
+  bool m_valid;
+  QString m_error;
+  int m_width;
+  int m_height;
+
+  QOffscreenSurface* m_surface;
+  QOpenGLContext* m_context;
+  QOpenGLFramebufferObject* m_framebuffer;
+  Rendering::GLResourceCache* m_resourceCache;
+
+  Rendering::GLRenderer m_renderer;
+  QList<QtGui::ScenePlugin*> m_scenePlugins;
+};
+
+} // End namespace QtOpenGL
+} // End namespace Avogadro
+
+#endif // AVOGADRO_QTOPENGL_OFFSCREENRENDERER_H
@@ -75,12 +75,17 @@ void BallAndStick::process(const Molecule& molecule, Rendering::GroupNode& node)
     Vector3ub color = atom.color();
     float radius = static_cast<float>(Elements::radiusVDW(atomicNumber));
     spheres->addSphere(atom.position3d().cast<float>(), color, radius * 0.3f);
-    if (atom.selected()) {
-      color = Vector3ub(0, 0, 255);
-      radius *= 1.2;
-      selectedSpheres->addSphere(atom.position3d().cast<float>(), color,
-                                 radius * 0.3f);
-    }
+  }
+
+  const Core::Selection& selection = molecule.atomSelection();
+  for (Index i = selection.first(); i < molecule.atomCount();
+       i = selection.next(i)) {
+    unsigned char atomicNumber = molecule.atomicNumber(i);
+    if (atomicNumber == 1 && !m_showHydrogens)
+      continue;
+    float radius = static_cast<float>(Elements::radiusVDW(atomicNumber));
+    selectedSpheres->addSphere(molecule.atomPosition3d(i).cast<float>(),
+                               Vector3ub(0, 0, 255), radius * 1.2f * 0.3f);
   }
 
   float bondRadius = 0.1f;
@@ -163,10 +163,9 @@ void Bonding::clearBonds()
     m_molecule->clearBonds();
   else {
     std::vector<size_t> bondIndices;
-    for (Index i = 0; i < m_molecule->atomCount(); ++i) {
-      if (!m_molecule->atomSelected(i))
-        continue;
-
+    const Core::Selection& selection = m_molecule->atomSelection();
+    for (Index i = selection.first(); i < m_molecule->atomCount();
+         i = selection.next(i)) {
       // OK, the atom is selected, get the bonds to delete
       const NeighborListType bonds = m_molecule->bonds(i);
       for (NeighborListType::const_iterator it = bonds.begin();
@@ -132,9 +132,13 @@ void CopyPaste::clear()
   if (m_molecule->isSelectionEmpty())
     m_molecule->undoMolecule()->clearAtoms();
   else {
-    for (Index i = 0; i < m_molecule->atomCount(); ++i)
-      if (m_molecule->atomSelected(i))
-        m_molecule->undoMolecule()->removeAtom(i);
+    // Remove from the highest index down, removing an atom moves the last
+    // atom into its place.
+    std::vector<Index> selected = m_molecule->atomSelection().indices();
+    for (std::vector<Index>::const_reverse_iterator it = selected.rbegin();
+         it != selected.rend(); ++it) {
+      m_molecule->undoMolecule()->removeAtom(*it);
+    }
   }
   m_molecule->emitChanged(QtGui::Molecule::Atoms | QtGui::Molecule::Bonds |
                           QtGui::Molecule::Removed);
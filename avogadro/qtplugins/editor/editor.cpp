@@ -156,6 +156,8 @@ QUndoCommand* Editor::mouseReleaseEvent(QMouseEvent* e)
   switch (e->button()) {
     case Qt::LeftButton:
     case Qt::RightButton:
+      // reset() may adjust hydrogens, report that along with the rest.
+      m_molecule->beginChanges();
       reset();
       e->accept();
       m_molecule->endMergeMode();
@@ -164,6 +166,7 @@ QUndoCommand* Editor::mouseReleaseEvent(QMouseEvent* e)
       m_molecule->emitChanged(Molecule::Atoms | Molecule::Bonds |
                               Molecule::Added | Molecule::Removed |
                               Molecule::Modified);
+      m_molecule->endChanges();
       break;
     default:
       break;
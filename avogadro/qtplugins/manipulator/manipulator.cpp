@@ -138,10 +138,9 @@ QUndoCommand* Manipulator::mouseMoveEvent(QMouseEvent* e)
     // update all selected atoms
     Vector3f newPos = m_renderer->camera().unProject(windowPos);
     Vector3f delta = newPos - m_lastMouse3D;
-    for (Index i = 0; i < m_molecule->atomCount(); ++i) {
-      if (!m_molecule->atomSelected(i))
-        continue;
-
+    const Core::Selection& selection = mol->atomSelection();
+    for (Index i = selection.first(); i < m_molecule->atomCount();
+         i = selection.next(i)) {
       Vector3 currentPos = m_molecule->atomPosition3d(i);
       m_molecule->setAtomPosition3d(i, currentPos + delta.cast<double>());
     }
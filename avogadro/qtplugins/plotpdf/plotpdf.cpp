@@ -19,7 +19,7 @@
 #include <QMessageBox>
 #include <QString>
 
-#include <avogadro/core/crystaltools.h>
+#include <avogadro/core/trajectoryanalyzer.h>
 #include <avogadro/core/unitcell.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/vtk/vtkplot.h>
@@ -27,23 +27,19 @@
 #include "pdfoptionsdialog.h"
 #include "plotpdf.h"
 
-using Avogadro::Core::CrystalTools;
-using Avogadro::Core::UnitCell;
+using Avogadro::Core::TrajectoryAnalyzer;
 using Avogadro::QtGui::Molecule;
 
-using std::map;
-
 namespace Avogadro {
 namespace QtPlugins {
 
-using Core::Array;
-
 PlotPdf::PlotPdf(QObject* parent_)
   : Avogadro::QtGui::ExtensionPlugin(parent_)
   , m_actions(QList<QAction*>())
   , m_molecule(nullptr)
   , m_pdfOptionsDialog(new PdfOptionsDialog(qobject_cast<QWidget*>(parent())))
   , m_displayDialogAction(new QAction(this))
+  , m_displayCoordinationAction(new QAction(this))
 {
   m_displayDialogAction->setText(tr("Plot Pair Distribution Function..."));
   connect(m_displayDialogAction.data(), &QAction::triggered, this,
@@ -51,6 +47,12 @@ PlotPdf::PlotPdf(QObject* parent_)
   m_actions.push_back(m_displayDialogAction.data());
   m_displayDialogAction->setProperty("menu priority", 70);
 
+  m_displayCoordinationAction->setText(tr("Plot Coordination Number..."));
+  connect(m_displayCoordinationAction.data(), &QAction::triggered, this,
+          &PlotPdf::displayCoordinationDialog);
+  m_actions.push_back(m_displayCoordinationAction.data());
+  m_displayCoordinationAction->setProperty("menu priority", 69);
+
   updateActions();
 }
 
@@ -114,6 +116,16 @@ void PlotPdf::updateActions()
 }
 
 void PlotPdf::displayDialog()
+{
+  plotDistribution(false);
+}
+
+void PlotPdf::displayCoordinationDialog()
+{
+  plotDistribution(true);
+}
+
+void PlotPdf::plotDistribution(bool coordination)
 {
   // Do nothing if the user cancels
   if (m_pdfOptionsDialog->exec() != QDialog::Accepted)
@@ -122,12 +134,11 @@ void PlotPdf::displayDialog()
   // Otherwise, fetch the options and perform the run
   double maxRadius = m_pdfOptionsDialog->maxRadius();
   double step = m_pdfOptionsDialog->step();
-  // size_t numpoints = m_pdfOptionsDialog->numDataPoints();
-  // double max2theta = m_pdfOptionsDialog->max2Theta();
 
   PdfData results;
   QString err;
-  if (!generatePdfPattern(*m_molecule, results, err, maxRadius, step)) {
+  if (!generatePdfPattern(*m_molecule, results, err, maxRadius, step,
+                          coordination)) {
     QMessageBox::critical(qobject_cast<QWidget*>(parent()),
                           tr("Failed to generate PDF pattern"),
                           tr("Error message: ") + err);
@@ -143,72 +154,51 @@ void PlotPdf::displayDialog()
   }
   std::vector<std::vector<double>> data{ xData, yData };
 
-  std::vector<std::string> lineLabels{ "PdfData" };
+  std::vector<std::string> lineLabels{ coordination ? "CoordinationData"
+                                                    : "PdfData" };
 
   std::array<double, 4> color = { 255, 0, 0, 255 };
   std::vector<std::array<double, 4>> lineColors{ color };
 
   const char* xTitle = "r (Å)";
-  const char* yTitle = "g(r)";
-  const char* windowName = "Pair Distribution Function";
+  const char* yTitle = coordination ? "n(r)" : "g(r)";
+  const char* windowName =
+    coordination ? "Running Coordination Number" : "Pair Distribution Function";
 
   VTK::VtkPlot::generatePlot(data, lineLabels, lineColors, xTitle, yTitle,
                              windowName);
 }
 
-bool PlotPdf::generatePdfPattern(QtGui::Molecule& mol, PdfData& results,
-                                 QString& err, double maxRadius, double step)
+bool PlotPdf::generatePdfPattern(const QtGui::Molecule& mol, PdfData& results,
+                                 QString& err, double maxRadius, double step,
+                                 bool coordination)
 {
-  Array<Vector3> refAtomCoords = mol.atomPositions3d();
-
-  size_t i, j;
-
-  UnitCell* uc = mol.unitCell();
-  if (!uc) {
-    err = "No unit cell found.";
+  if (!mol.unitCell()) {
+    err = tr("No unit cell found.");
     return false;
   }
 
-  size_t a = static_cast<size_t>(maxRadius / uc->a()) + 1;
-  size_t b = static_cast<size_t>(maxRadius / uc->b()) + 1;
-  size_t c = static_cast<size_t>(maxRadius / uc->c()) + 1;
-
-  Vector3 disp = a * uc->aVector() + b * uc->bVector() + c * uc->cVector();
-  for (i = 0; i < refAtomCoords.size(); ++i) {
-    refAtomCoords[i] += disp;
+  if (maxRadius <= 0.0 || step <= 0.0) {
+    err = tr("Invalid radius or step.");
+    return false;
   }
 
-  Molecule newMolecule = mol;
-  CrystalTools::buildSupercell(newMolecule, 2 * a + 1, 2 * b + 1, 2 * c + 1);
-
-  Array<Vector3> newAtomCoords = newMolecule.atomPositions3d();
-
-  map<size_t, size_t> pdfCount;
-  double dist, rStep = step;
-  size_t k, binIdx;
-
-  for (i = 0; i < refAtomCoords.size(); ++i) {
-    for (j = 0; j < newAtomCoords.size(); ++j) {
-      dist = (refAtomCoords.at(i) - newAtomCoords.at(j)).norm();
-      binIdx = static_cast<size_t>(dist / rStep);
-      if (pdfCount.find(binIdx) == pdfCount.end()) {
-        pdfCount.insert(std::make_pair(binIdx, 1));
-      } else {
-        pdfCount[binIdx]++;
-      }
-    }
+  // All periodic images are included, and trajectories are averaged over
+  // their frames.
+  size_t binCount = static_cast<size_t>(maxRadius / step + 0.5);
+  TrajectoryAnalyzer analyzer(&mol);
+  TrajectoryAnalyzer::RadialDistribution rdf =
+    analyzer.radialDistribution(0, 0, binCount * step, binCount);
+  if (rdf.radii.empty()) {
+    err = tr("The structure has no pairs of atoms.");
+    return false;
   }
 
-  for (k = 0; k < static_cast<size_t>(maxRadius / rStep); k++) {
-    if (pdfCount.find(k) == pdfCount.end()) {
-      results.push_back(std::make_pair(k * rStep, 0.0));
-    } else {
-      results.push_back(std::make_pair(
-        k * rStep, pdfCount[k] * newMolecule.unitCell()->volume() /
-                     (4 * M_PI * pow(k * rStep, 2) * rStep *
-                      refAtomCoords.size() * newAtomCoords.size())));
-    }
-  }
+  const std::vector<Real>& values = coordination ? rdf.coordination
+                                                 : rdf.values;
+  results.clear();
+  for (size_t i = 0; i < rdf.radii.size(); ++i)
+    results.push_back(std::make_pair(rdf.radii[i], values[i]));
 
   return true;
 }
@@ -32,7 +32,8 @@ class PdfOptionsDialog;
 typedef std::vector<std::pair<double, double>> PdfData;
 
 /**
- * @brief Generate and plot a PDF curve
+ * @brief Generate and plot a PDF curve, or the running coordination number,
+ * averaged over all frames of a trajectory.
  */
 class PlotPdf : public Avogadro::QtGui::ExtensionPlugin
 {
@@ -56,21 +57,29 @@ private slots:
 
   void displayDialog();
 
+  void displayCoordinationDialog();
+
 private:
   // Generate Pdf curve from a crystal
   // Writes the results to @p results, which is a vector of pairs of doubles
   // (see definition above).
+  // If @p coordination is true, the running coordination number is written
+  // instead of g(r).
   // err will be set to an error string if the function fails.
   // radius is in Angstroms.
-  static bool generatePdfPattern(QtGui::Molecule& mol, PdfData& results,
+  static bool generatePdfPattern(const QtGui::Molecule& mol, PdfData& results,
                                  QString& err, double maxRadius = 10.0,
-                                 double step = 0.1);
+                                 double step = 0.1, bool coordination = false);
+
+  // Show the options dialog and plot either curve.
+  void plotDistribution(bool coordination);
 
   QList<QAction*> m_actions;
   QtGui::Molecule* m_molecule;
 
   QScopedPointer<PdfOptionsDialog> m_pdfOptionsDialog;
   QScopedPointer<QAction> m_displayDialogAction;
+  QScopedPointer<QAction> m_displayCoordinationAction;
 };
 
 inline QString PlotPdf::description() const
@@ -20,7 +20,8 @@
 #include <QProcess>
 #include <QString>
 
-#include <avogadro/core/array.h>
+#include <avogadro/core/rmsdcalculator.h>
+#include <avogadro/core/trajectoryanalyzer.h>
 #include <avogadro/io/fileformatmanager.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/vtk/vtkplot.h>
@@ -32,13 +33,12 @@ using Avogadro::QtGui::Molecule;
 namespace Avogadro {
 namespace QtPlugins {
 
-using Core::Array;
-
 PlotRmsd::PlotRmsd(QObject* parent_)
   : Avogadro::QtGui::ExtensionPlugin(parent_)
   , m_actions(QList<QAction*>())
   , m_molecule(nullptr)
   , m_displayDialogAction(new QAction(this))
+  , m_displayMsdAction(new QAction(this))
 {
   m_displayDialogAction->setText(tr("Plot RMSD curve..."));
   connect(m_displayDialogAction.get(), &QAction::triggered, this,
@@ -46,6 +46,12 @@ PlotRmsd::PlotRmsd(QObject* parent_)
   m_actions.push_back(m_displayDialogAction.get());
   m_displayDialogAction->setProperty("menu priority", 80);
 
+  m_displayMsdAction->setText(tr("Plot Mean Square Displacement..."));
+  connect(m_displayMsdAction.get(), &QAction::triggered, this,
+          &PlotRmsd::displayMsdDialog);
+  m_actions.push_back(m_displayMsdAction.get());
+  m_displayMsdAction->setProperty("menu priority", 79);
+
   updateActions();
 }
 
@@ -135,23 +141,39 @@ void PlotRmsd::displayDialog()
                              windowName);
 }
 
+void PlotRmsd::displayMsdDialog()
+{
+  // Periodic trajectories are unwrapped, and every frame is a time origin.
+  Core::TrajectoryAnalyzer analyzer(m_molecule);
+  std::vector<Real> msd = analyzer.meanSquareDisplacement();
+
+  std::vector<double> xData;
+  std::vector<double> yData(msd.begin(), msd.end());
+  for (size_t i = 0; i < msd.size(); ++i)
+    xData.push_back(static_cast<double>(i));
+  std::vector<std::vector<double>> data{ xData, yData };
+
+  std::vector<std::string> lineLabels{ "MsdData" };
+
+  std::array<double, 4> color = { 255, 0, 0, 255 };
+  std::vector<std::array<double, 4>> lineColors{ color };
+
+  const char* xTitle = "Lag (frames)";
+  const char* yTitle = "MSD (Å²)";
+  const char* windowName = "Mean Square Displacement";
+
+  VTK::VtkPlot::generatePlot(data, lineLabels, lineColors, xTitle, yTitle,
+                             windowName);
+}
+
 void PlotRmsd::generateRmsdPattern(RmsdData& results)
 {
-  m_molecule->setCoordinate3d(0);
-  Array<Vector3> ref = m_molecule->atomPositions3d();
-
-  for (size_t i = 0; i < m_molecule->coordinate3dCount(); ++i) {
-    m_molecule->setCoordinate3d(i);
-    Array<Vector3> positions = m_molecule->atomPositions3d();
-    double sum = 0;
-    for (size_t j = 0; j < positions.size(); ++j) {
-      sum += (positions[j][0] - ref[j][0]) * (positions[j][0] - ref[j][0]) +
-             (positions[j][1] - ref[j][1]) * (positions[j][1] - ref[j][1]) +
-             (positions[j][2] - ref[j][2]) * (positions[j][2] - ref[j][2]);
-    }
-    sum = sqrt(sum / m_molecule->coordinate3dCount());
-    results.push_back(std::make_pair(static_cast<double>(i), sum));
-  }
+  // Superimpose every frame onto the first one, the displayed coordinates are
+  // not changed.
+  Core::RmsdCalculator calculator(m_molecule);
+  std::vector<Real> rmsd = calculator.rmsdToFrame(0);
+  for (size_t i = 0; i < rmsd.size(); ++i)
+    results.push_back(std::make_pair(static_cast<double>(i), rmsd[i]));
 }
 
 } // namespace QtPlugins
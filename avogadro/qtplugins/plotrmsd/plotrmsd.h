@@ -32,7 +32,7 @@ namespace QtPlugins {
 typedef std::vector<std::pair<double, double>> RmsdData;
 
 /**
- * @brief Generate and plot an RMSD curve.
+ * @brief Generate and plot an RMSD or mean square displacement curve.
  */
 class PlotRmsd : public Avogadro::QtGui::ExtensionPlugin
 {
@@ -56,6 +56,8 @@ private slots:
 
   void displayDialog();
 
+  void displayMsdDialog();
+
 private:
   // Generate RMSD data from a coordinate set
   // Writes the results to @p results, which is a vector of pairs of doubles
@@ -66,11 +68,12 @@ private:
   QtGui::Molecule* m_molecule;
 
   std::unique_ptr<QAction> m_displayDialogAction;
+  std::unique_ptr<QAction> m_displayMsdAction;
 };
 
 inline QString PlotRmsd::description() const
 {
-  return tr("Generate and plot an RMSD curve.");
+  return tr("Generate and plot RMSD and mean square displacement curves.");
 }
 
 } // namespace QtPlugins
@@ -15,16 +15,12 @@
 ******************************************************************************/
 
 #include <QAction>
-#include <QByteArray>
-#include <QCoreApplication>
 #include <QDebug>
 #include <QDialog>
-#include <QFile>
 #include <QMessageBox>
-#include <QProcess>
 #include <QString>
 
-#include <avogadro/io/fileformatmanager.h>
+#include <avogadro/core/xrdcalculator.h>
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/vtk/vtkplot.h>
 
@@ -159,131 +155,27 @@ bool PlotXrd::generateXrdPattern(const QtGui::Molecule& mol, XrdData& results,
                                  double peakwidth, size_t numpoints,
                                  double max2theta)
 {
-  // Get the molecule as a cif file
-  std::string cifData;
-  if (!Io::FileFormatManager::instance().writeString(mol, cifData, "cif")) {
-    err = tr("Failed to convert molecule to CIF format.");
+  if (!mol.unitCell()) {
+    err = tr("The molecule has no unit cell.");
     qDebug() << "Error in" << __FUNCTION__ << ":" << err;
     return false;
   }
 
-  // Now, execute genXrdPattern with the given inputs
-  QStringList args;
-  args << "--read-from-stdin"
-       << "--wavelength=" + QString::number(wavelength)
-       << "--peakwidth=" + QString::number(peakwidth)
-       << "--numpoints=" + QString::number(numpoints)
-       << "--max2theta=" + QString::number(max2theta);
-
-  QByteArray output;
-  if (!executeGenXrdPattern(args, cifData.c_str(), output, err)) {
+  if (wavelength <= 0.0 || numpoints == 0 || max2theta <= 0.0) {
+    err = tr("Invalid XRD pattern options.");
     qDebug() << "Error in" << __FUNCTION__ << ":" << err;
     return false;
   }
 
-  // Store the results
-  results.clear();
-
-  // Find the section of data in the output
-  bool dataStarted = false;
-  QStringList lines =
-    QString(output).split(QRegExp("[\r\n]"), QString::SkipEmptyParts);
-  for (const auto& line : lines) {
-    if (!dataStarted && line.contains("#    2Theta/TOF    ICalc")) {
-      dataStarted = true;
-      continue;
-    }
-
-    if (dataStarted) {
-      QStringList rowData = line.split(" ", QString::SkipEmptyParts);
-      if (rowData.size() != 2) {
-        err = tr("Data read from genXrdPattern appears to be corrupt!");
-        qDebug() << "Error in" << __FUNCTION__ << err;
-        qDebug() << "Data is:";
-        for (const auto& lineTmp : lines)
-          qDebug() << lineTmp;
-        return false;
-      }
-      results.push_back(
-        std::make_pair(rowData[0].toDouble(), rowData[1].toDouble()));
-    }
-  }
-
-  return true;
-}
-
-bool PlotXrd::executeGenXrdPattern(const QStringList& args,
-                                   const QByteArray& input, QByteArray& output,
-                                   QString& err)
-{
-  QString program;
-  // If the GENXRDPATTERN_EXECUTABLE environment variable is set, then
-  // use that
-  QByteArray xrdExec = qgetenv("GENXRDPATTERN_EXECUTABLE");
-  if (!xrdExec.isEmpty()) {
-    program = xrdExec;
-  } else {
-// Otherwise, search in the current directory, and then ../bin
-#ifdef _WIN32
-    QString executable = "genXrdPattern.exe";
-#else
-    QString executable = "genXrdPattern";
-#endif
-    QString path = QCoreApplication::applicationDirPath();
-    if (QFile::exists(path + "/" + executable))
-      program = path + "/" + executable;
-    else if (QFile::exists(path + "/../bin/" + executable))
-      program = path + "/../bin/" + executable;
-    else {
-      err = tr("Error: could not find genXrdPattern executable!");
-      qDebug() << err;
-      return false;
-    }
-  }
-
-  QProcess p;
-  p.start(program, args);
-
-  if (!p.waitForStarted()) {
-    err = tr("Error: " + program.toLocal8Bit() + " failed to start");
-    qDebug() << err;
-    return false;
-  }
-
-  // Give it the input!
-  p.write(input.data());
-
-  // Close the write channel
-  p.closeWriteChannel();
-
-  if (!p.waitForFinished()) {
-    err = tr("Error: " + program.toLocal8Bit() + " failed to finish");
-    qDebug() << err;
-    output = p.readAll();
-    qDebug() << "Output is as follows:\n" << output;
-    return false;
-  }
-
-  int exitStatus = p.exitStatus();
-  output = p.readAll();
+  Core::XrdCalculator calculator;
+  calculator.setWavelength(wavelength);
+  calculator.setPeakWidth(peakwidth);
+  calculator.setNumberOfPoints(numpoints);
+  calculator.setMaximumTwoTheta(max2theta);
 
-  if (exitStatus == QProcess::CrashExit) {
-    err = tr("Error: " + program.toLocal8Bit() + " crashed!");
-    qDebug() << err;
-    qDebug() << "Output is as follows:\n" << output;
-    return false;
-  }
-
-  if (exitStatus != QProcess::NormalExit) {
-    err = tr("Error: " + program.toLocal8Bit() +
-             " finished abnormally with exit code " +
-             QString::number(exitStatus).toLocal8Bit());
-    qDebug() << err;
-    qDebug() << "Output is as follows:\n" << output;
-    return false;
-  }
-
-  // We did it!
+  results.clear();
+  Core::XrdCalculator::Pattern pattern = calculator.pattern(mol);
+  results.assign(pattern.begin(), pattern.end());
   return true;
 }
 
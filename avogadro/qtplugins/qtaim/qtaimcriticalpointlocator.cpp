@@ -26,11 +26,6 @@
 
 #include <QtConcurrent/QtConcurrentMap>
 
-#include <QDataStream>
-#include <QDir>
-#include <QFile>
-#include <QTemporaryFile>
-
 #include <QVariant>
 
 #include <QFuture>
@@ -48,16 +43,13 @@ namespace QtPlugins {
 
 QList<QVariant> QTAIMLocateNuclearCriticalPoint(QList<QVariant> input)
 {
-  const QString fileName = input.at(0).toString();
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(input.at(0));
+  const QTAIMWavefunction& wfn = eval.wavefunction();
   const qint64 nucleus = input.at(1).toInt();
   const QVector3D x0y0z0(input.at(2).toReal(), input.at(3).toReal(),
                          input.at(4).toReal());
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(fileName);
-
-  QTAIMWavefunctionEvaluator eval(wfn);
-
   QVector3D result;
 
   if (wfn.nuclearCharge(nucleus) < 4) {
@@ -101,23 +93,16 @@ QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
   QList<QVariant> value;
   value.clear();
 
-  const QString wfnFileName = input.at(0).toString();
-  const QString nuclearCriticalPointsFileName = input.at(1).toString();
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(input.at(0));
+  const QTAIMWavefunction& wfn = eval.wavefunction();
+  const QList<QVector3D> nuclearCriticalPoints =
+    input.at(1).value<QList<QVector3D>>();
   const qint64 nucleusA = input.at(2).toInt();
   const qint64 nucleusB = input.at(3).toInt();
   const QVector3D x0y0z0(input.at(4).toReal(), input.at(5).toReal(),
                          input.at(6).toReal());
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-
-  QList<QVector3D> nuclearCriticalPoints;
-  QFile nuclearCriticalPointsFile(nuclearCriticalPointsFileName);
-  nuclearCriticalPointsFile.open(QIODevice::ReadOnly);
-  QDataStream nuclearCriticalPointsFileIn(&nuclearCriticalPointsFile);
-  nuclearCriticalPointsFileIn >> nuclearCriticalPoints;
-  nuclearCriticalPointsFile.close();
-
   QList<QPair<QVector3D, qreal>> betaSpheres;
   for (qint64 i = 0; i < nuclearCriticalPoints.length(); ++i) {
     QPair<QVector3D, qreal> thisBetaSphere;
@@ -126,8 +111,6 @@ QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
     betaSpheres.append(thisBetaSphere);
   }
 
-  QTAIMWavefunctionEvaluator eval(wfn);
-
   QList<QVector3D> ncpList;
 
   QVector3D result;
@@ -284,7 +267,8 @@ QList<QVariant> QTAIMLocateBondCriticalPoint(QList<QVariant> input)
 QList<QVariant> QTAIMLocateElectronDensitySink(QList<QVariant> input)
 {
   qint64 counter = 0;
-  const QString fileName = input.at(counter).toString();
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(input.at(counter));
   counter++;
   //    const qint64 nucleus=input.at(counter).toInt(); counter++
   qreal x0 = input.at(counter).toReal();
@@ -296,11 +280,6 @@ QList<QVariant> QTAIMLocateElectronDensitySink(QList<QVariant> input)
 
   const QVector3D x0y0z0(x0, y0, z0);
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(fileName);
-
-  QTAIMWavefunctionEvaluator eval(wfn);
-
   bool correctSignature;
   QVector3D result;
 
@@ -348,7 +327,8 @@ QList<QVariant> QTAIMLocateElectronDensitySink(QList<QVariant> input)
 QList<QVariant> QTAIMLocateElectronDensitySource(QList<QVariant> input)
 {
   qint64 counter = 0;
-  const QString fileName = input.at(counter).toString();
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(input.at(counter));
   counter++;
   //    const qint64 nucleus=input.at(counter).toInt(); counter++
   qreal x0 = input.at(counter).toReal();
@@ -360,11 +340,6 @@ QList<QVariant> QTAIMLocateElectronDensitySource(QList<QVariant> input)
 
   const QVector3D x0y0z0(x0, y0, z0);
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(fileName);
-
-  QTAIMWavefunctionEvaluator eval(wfn);
-
   bool correctSignature;
   QVector3D result;
 
@@ -410,9 +385,8 @@ QList<QVariant> QTAIMLocateElectronDensitySource(QList<QVariant> input)
 }
 
 QTAIMCriticalPointLocator::QTAIMCriticalPointLocator(QTAIMWavefunction& wfn)
+  : m_wfn(&wfn), m_eval(wfn)
 {
-  m_wfn = &wfn;
-
   m_nuclearCriticalPoints.empty();
   m_bondCriticalPoints.empty();
   m_ringCriticalPoints.empty();
@@ -431,15 +405,13 @@ QTAIMCriticalPointLocator::QTAIMCriticalPointLocator(QTAIMWavefunction& wfn)
 void QTAIMCriticalPointLocator::locateNuclearCriticalPoints()
 {
 
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
   QList<QList<QVariant>> inputList;
 
   const qint64 numberOfNuclei = m_wfn->numberOfNuclei();
 
   for (qint64 n = 0; n < numberOfNuclei; ++n) {
     QList<QVariant> input;
-    input.append(tempFileName);
+    input.append(m_eval.toVariant());
     input.append(n);
     input.append(m_wfn->xNuclearCoordinate(n));
     input.append(m_wfn->yNuclearCoordinate(n));
@@ -448,8 +420,6 @@ void QTAIMCriticalPointLocator::locateNuclearCriticalPoints()
     inputList.append(input);
   }
 
-  m_wfn->saveToBinaryFile(tempFileName);
-
   QProgressDialog dialog;
   dialog.setWindowTitle("QTAIM");
   dialog.setLabelText(QString("Nuclear Critical Points Search"));
@@ -475,9 +445,6 @@ void QTAIMCriticalPointLocator::locateNuclearCriticalPoints()
     results = future.results();
   }
 
-  QFile file;
-  file.remove(tempFileName);
-
   for (qint64 n = 0; n < results.length(); ++n) {
 
     bool correctSignature = results.at(n).at(0).toBool();
@@ -506,15 +473,8 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
     return;
   }
 
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
-  QString nuclearCriticalPointsFileName =
-    QTAIMCriticalPointLocator::temporaryFileName();
-  QFile nuclearCriticalPointsFile(nuclearCriticalPointsFileName);
-  nuclearCriticalPointsFile.open(QIODevice::WriteOnly);
-  QDataStream nuclearCriticalPointsOut(&nuclearCriticalPointsFile);
-  nuclearCriticalPointsOut << m_nuclearCriticalPoints;
-  nuclearCriticalPointsFile.close();
+  const QVariant nuclearCriticalPoints =
+    QVariant::fromValue(m_nuclearCriticalPoints);
 
   QList<QList<QVariant>> inputList;
 
@@ -538,8 +498,8 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
           (m_wfn->zNuclearCoordinate(M) + m_wfn->zNuclearCoordinate(N)) / 2.0);
 
         QList<QVariant> input;
-        input.append(tempFileName);
-        input.append(nuclearCriticalPointsFileName);
+        input.append(m_eval.toVariant());
+        input.append(nuclearCriticalPoints);
         input.append(M);
         input.append(N);
         input.append(x0y0z0.x());
@@ -551,8 +511,6 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
     } // end N
   }   // end M
 
-  m_wfn->saveToBinaryFile(tempFileName);
-
   QProgressDialog dialog;
   dialog.setWindowTitle("QTAIM");
   dialog.setLabelText(QString("Bond Critical Points Search"));
@@ -579,10 +537,6 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
     results = future.results();
   }
 
-  QFile file;
-  file.remove(tempFileName);
-  file.remove(nuclearCriticalPointsFileName);
-
   for (qint64 i = 0; i < results.length(); ++i) {
     QList<QVariant> thisCriticalPoint = results.at(i);
 
@@ -623,8 +577,6 @@ void QTAIMCriticalPointLocator::locateBondCriticalPoints()
 void QTAIMCriticalPointLocator::locateElectronDensitySources()
 {
 
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
   QList<QList<QVariant>> inputList;
 
   qreal xmin, ymin, zmin;
@@ -685,22 +637,37 @@ void QTAIMCriticalPointLocator::locateElectronDensitySources()
 
   xstep = ystep = zstep = 0.5;
 
+  QList<Matrix<qreal, 3, 1>> gridPoints;
   for (qreal x = xmin; x < xmax + xstep; x = x + xstep) {
     for (qreal y = ymin; y < ymax + ystep; y = y + ystep) {
       for (qreal z = zmin; z < zmax + zstep; z = z + zstep) {
-        QList<QVariant> input;
-        input.append(tempFileName);
-        //          input.append( n );
-        input.append(x);
-        input.append(y);
-        input.append(z);
-
-        inputList.append(input);
+        Matrix<qreal, 3, 1> xyz;
+        xyz << x, y, z;
+        gridPoints.append(xyz);
       }
     }
   }
 
-  m_wfn->saveToBinaryFile(tempFileName);
+  // The density of the whole grid is evaluated in one batch, searches only
+  // start where it is at least 0.1.
+  Matrix<qreal, 3, Dynamic> grid(3, gridPoints.length());
+  for (qint64 n = 0; n < gridPoints.length(); ++n)
+    grid.col(n) = gridPoints.at(n);
+  const Matrix<qreal, Dynamic, 1> densities = m_eval.electronDensities(grid);
+
+  for (qint64 n = 0; n < gridPoints.length(); ++n) {
+    if (densities(n) < 1.e-1)
+      continue;
+
+    QList<QVariant> input;
+    input.append(m_eval.toVariant());
+    //          input.append( n );
+    input.append(grid(0, n));
+    input.append(grid(1, n));
+    input.append(grid(2, n));
+
+    inputList.append(input);
+  }
 
   QProgressDialog dialog;
   dialog.setWindowTitle("QTAIM");
@@ -727,9 +694,6 @@ void QTAIMCriticalPointLocator::locateElectronDensitySources()
     results = future.results();
   }
 
-  QFile file;
-  file.remove(tempFileName);
-
   for (qint64 n = 0; n < results.length(); ++n) {
 
     qint64 counter = 0;
@@ -776,8 +740,6 @@ void QTAIMCriticalPointLocator::locateElectronDensitySources()
 void QTAIMCriticalPointLocator::locateElectronDensitySinks()
 {
 
-  QString tempFileName = QTAIMCriticalPointLocator::temporaryFileName();
-
   QList<QList<QVariant>> inputList;
 
   qreal xmin, ymin, zmin;
@@ -838,22 +800,37 @@ void QTAIMCriticalPointLocator::locateElectronDensitySinks()
 
   xstep = ystep = zstep = 0.5;
 
+  QList<Matrix<qreal, 3, 1>> gridPoints;
   for (qreal x = xmin; x < xmax + xstep; x = x + xstep) {
     for (qreal y = ymin; y < ymax + ystep; y = y + ystep) {
       for (qreal z = zmin; z < zmax + zstep; z = z + zstep) {
-        QList<QVariant> input;
-        input.append(tempFileName);
-        //          input.append( n );
-        input.append(x);
-        input.append(y);
-        input.append(z);
-
-        inputList.append(input);
+        Matrix<qreal, 3, 1> xyz;
+        xyz << x, y, z;
+        gridPoints.append(xyz);
       }
     }
   }
 
-  m_wfn->saveToBinaryFile(tempFileName);
+  // The density of the whole grid is evaluated in one batch, searches only
+  // start where it is at least 0.1.
+  Matrix<qreal, 3, Dynamic> grid(3, gridPoints.length());
+  for (qint64 n = 0; n < gridPoints.length(); ++n)
+    grid.col(n) = gridPoints.at(n);
+  const Matrix<qreal, Dynamic, 1> densities = m_eval.electronDensities(grid);
+
+  for (qint64 n = 0; n < gridPoints.length(); ++n) {
+    if (densities(n) < 1.e-1)
+      continue;
+
+    QList<QVariant> input;
+    input.append(m_eval.toVariant());
+    //          input.append( n );
+    input.append(grid(0, n));
+    input.append(grid(1, n));
+    input.append(grid(2, n));
+
+    inputList.append(input);
+  }
 
   QProgressDialog dialog;
   dialog.setWindowTitle("QTAIM");
@@ -880,9 +857,6 @@ void QTAIMCriticalPointLocator::locateElectronDensitySinks()
     results = future.results();
   }
 
-  QFile file;
-  file.remove(tempFileName);
-
   for (qint64 n = 0; n < results.length(); ++n) {
 
     qint64 counter = 0;
@@ -926,22 +900,5 @@ void QTAIMCriticalPointLocator::locateElectronDensitySinks()
   //    qDebug() << "SINKS" << m_electronDensitySinks;
 }
 
-QString QTAIMCriticalPointLocator::temporaryFileName()
-{
-  QTemporaryFile temporaryFile;
-  temporaryFile.open();
-  QString tempFileName = temporaryFile.fileName();
-  temporaryFile.close();
-  temporaryFile.remove();
-
-  // wait for temporary file to be deleted
-  QDir dir;
-  do {
-    // Nothing
-  } while (dir.exists(tempFileName));
-
-  return tempFileName;
-}
-
 } // namespace QtPlugins
 } // namespace Avogadro
@@ -71,6 +71,7 @@ public:
 
 private:
   QTAIMWavefunction* m_wfn;
+  QTAIMWavefunctionEvaluator m_eval;
 
   QList<QVector3D> m_nuclearCriticalPoints;
   QList<QVector3D> m_bondCriticalPoints;
@@ -84,8 +85,6 @@ private:
 
   QList<QVector3D> m_electronDensitySources;
   QList<QVector3D> m_electronDensitySinks;
-
-  QString temporaryFileName();
 };
 
 } // namespace QtPlugins
@@ -1184,10 +1184,11 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
 {
   /*
      Order of variantList:
-     QString wfnFileName
+     QTAIMWavefunctionEvaluator evaluator
      qreal x0
      qreal y0
      qreal z0
+     qreal rho0
      qint64 nncp
      qint64 xncp1
      qint64 yncp1
@@ -1206,7 +1207,7 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
      ...
   */
   qint64 counter = 0;
-  QString wfnFileName = variantList.at(counter).toString();
+  const QVariant evaluator = variantList.at(counter);
   counter++;
   qreal x0 = variantList.at(counter).toDouble();
   counter++;
@@ -1214,6 +1215,8 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
   counter++;
   qreal z0 = variantList.at(counter).toDouble();
   counter++;
+  qreal rho0 = variantList.at(counter).toDouble();
+  counter++;
 
   qint64 nncp = variantList.at(counter).toLongLong();
   counter++;
@@ -1248,18 +1251,13 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
   }
   QSet<qint64> basinSet = basinList.toSet();
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-
-  QTAIMWavefunctionEvaluator eval(wfn);
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(evaluator);
 
   QList<QVariant> valueList;
 
-  double initialElectronDensity =
-    eval.electronDensity(Eigen::Vector3d(x0, y0, z0));
-
   // if less than some small value, then return zero for all integrands.
-  if (initialElectronDensity < 1.e-5) {
+  if (rho0 < 1.e-5) {
     for (qint64 m = 0; m < nmode; ++m) {
       qreal zero = 0.0;
       valueList.append(zero);
@@ -1312,7 +1310,7 @@ QList<QVariant> QTAIMEvaluateProperty(QList<QVariant> variantList)
       //      }
       for (qint64 m = 0; m < nmode; ++m) {
         if (modeList.at(m) == 0) {
-          valueList.append(eval.electronDensity(Eigen::Vector3d(x0, y0, z0)));
+          valueList.append(rho0);
         } else {
           qDebug() << "mode not defined";
           qreal zero = 0.0;
@@ -1338,7 +1336,7 @@ void property_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
   QVariantList paramVariantList = *paramVariantListPtr;
 
   qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
+  const QVariant evaluator = paramVariantList.at(counter);
   counter++;
 
   qint64 nncp = paramVariantList.at(counter).toLongLong();
@@ -1363,11 +1361,23 @@ void property_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
     counter++;
   }
 
+  // The densities of all points are evaluated in one batch. Only the points
+  // with a density above the cutoff of QTAIMEvaluateProperty need a gradient
+  // path, the others contribute zero.
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(evaluator);
+  const Matrix<qreal, 3, Dynamic> points =
+    Map<const Matrix<qreal, 3, Dynamic>>(xyz, 3, npts);
+  const Matrix<qreal, Dynamic, 1> densities = eval.electronDensities(points);
+
   // prepare input
 
   QList<QList<QVariant>> inputList;
+  QList<unsigned int> pointList;
 
   for (unsigned int i = 0; i < npts; ++i) {
+    if (densities(i) < 1.e-5)
+      continue;
 
     double x0 = xyz[i * 3 + 0];
     double y0 = xyz[i * 3 + 1];
@@ -1375,11 +1385,12 @@ void property_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
 
     QList<QVariant> variantList;
 
-    variantList.append(wfnFileName);
+    variantList.append(evaluator);
 
     variantList.append(x0);
     variantList.append(y0);
     variantList.append(z0);
+    variantList.append(densities(i));
 
     variantList.append(nncp);
     for (qint64 n = 0; n < nncp; ++n) {
@@ -1400,6 +1411,7 @@ void property_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
     }
 
     inputList.append(variantList);
+    pointList.append(i);
   }
 
   // calculate
@@ -1432,7 +1444,13 @@ void property_v(unsigned int /* ndim */, unsigned int npts, const double* xyz,
   // harvest results
   for (qint64 i = 0; i < npts; ++i) {
     for (qint64 m = 0; m < nmode; ++m) {
-      fval[m * nmode + i] = results.at(i).at(m).toDouble();
+      fval[m * nmode + i] = 0.0;
+    }
+  }
+  for (qint64 j = 0; j < results.length(); ++j) {
+    const qint64 i = pointList.at(j);
+    for (qint64 m = 0; m < nmode; ++m) {
+      fval[m * nmode + i] = results.at(j).at(m).toDouble();
     }
   }
 }
@@ -1444,10 +1462,11 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
 {
   /*
      Order of variantList:
-     QString wfnFileName
+     QTAIMWavefunctionEvaluator evaluator
      qreal r0
      qreal t0
      qreal p0
+     qreal rho0
      qint64 nncp
      qint64 xncp1
      qint64 yncp1
@@ -1466,7 +1485,7 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
      ...
   */
   qint64 counter = 0;
-  QString wfnFileName = variantList.at(counter).toString();
+  const QVariant evaluator = variantList.at(counter);
   counter++;
   qreal r0 = variantList.at(counter).toDouble();
   counter++;
@@ -1474,6 +1493,8 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
   counter++;
   qreal p0 = variantList.at(counter).toDouble();
   counter++;
+  qreal rho0 = variantList.at(counter).toDouble();
+  counter++;
 
   qint64 nncp = variantList.at(counter).toLongLong();
   counter++;
@@ -1521,18 +1542,13 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
   qreal y0 = x0y0z0(1);
   qreal z0 = x0y0z0(2);
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-
-  QTAIMWavefunctionEvaluator eval(wfn);
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(evaluator);
 
   QList<QVariant> valueList;
 
-  double initialElectronDensity =
-    eval.electronDensity(Eigen::Vector3d(x0, y0, z0));
-
   // if less than some small value, then return zero for all integrands.
-  if (initialElectronDensity < 1.e-5) {
+  if (rho0 < 1.e-5) {
     for (qint64 m = 0; m < nmode; ++m) {
       qreal zero = 0.0;
       valueList.append(zero);
@@ -1586,12 +1602,7 @@ QList<QVariant> QTAIMEvaluatePropertyRTP(QList<QVariant> variantList)
       //      }
       for (qint64 m = 0; m < nmode; ++m) {
         if (modeList.at(m) == 0) {
-          valueList.append(
-
-            r0 * r0 * sin(t0) *
-            eval.electronDensity(Eigen::Vector3d(x0, y0, z0))
-
-              );
+          valueList.append(r0 * r0 * sin(t0) * rho0);
         } else {
           qDebug() << "mode not defined";
           qreal zero = 0.0;
@@ -1618,7 +1629,7 @@ void property_v_rtp(unsigned int /* ndim */, unsigned int npts,
   QVariantList paramVariantList = *paramVariantListPtr;
 
   qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
+  const QVariant evaluator = paramVariantList.at(counter);
   counter++;
 
   qint64 nncp = paramVariantList.at(counter).toLongLong();
@@ -1643,11 +1654,30 @@ void property_v_rtp(unsigned int /* ndim */, unsigned int npts,
     counter++;
   }
 
+  // The densities of all points are evaluated in one batch. Only the points
+  // with a density above the cutoff of QTAIMEvaluatePropertyRTP need a
+  // gradient path, the others contribute zero.
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(evaluator);
+  Matrix<qreal, 3, 1> origin;
+  origin << ncpList.at(basinList.at(0)).x(), ncpList.at(basinList.at(0)).y(),
+    ncpList.at(basinList.at(0)).z();
+  Matrix<qreal, 3, Dynamic> points(3, npts);
+  for (unsigned int i = 0; i < npts; ++i) {
+    Matrix<qreal, 3, 1> rtp;
+    rtp << xyz[i * 3 + 0], xyz[i * 3 + 1], xyz[i * 3 + 2];
+    points.col(i) = QTAIMMathUtilities::sphericalToCartesian(rtp, origin);
+  }
+  const Matrix<qreal, Dynamic, 1> densities = eval.electronDensities(points);
+
   // prepare input
 
   QList<QList<QVariant>> inputList;
+  QList<unsigned int> pointList;
 
   for (unsigned int i = 0; i < npts; ++i) {
+    if (densities(i) < 1.e-5)
+      continue;
 
     double x0 = xyz[i * 3 + 0];
     double y0 = xyz[i * 3 + 1];
@@ -1655,11 +1685,12 @@ void property_v_rtp(unsigned int /* ndim */, unsigned int npts,
 
     QList<QVariant> variantList;
 
-    variantList.append(wfnFileName);
+    variantList.append(evaluator);
 
     variantList.append(x0);
     variantList.append(y0);
     variantList.append(z0);
+    variantList.append(densities(i));
 
     variantList.append(nncp);
     for (qint64 n = 0; n < nncp; ++n) {
@@ -1680,6 +1711,7 @@ void property_v_rtp(unsigned int /* ndim */, unsigned int npts,
     }
 
     inputList.append(variantList);
+    pointList.append(i);
   }
 
   // calculate
@@ -1712,26 +1744,29 @@ void property_v_rtp(unsigned int /* ndim */, unsigned int npts,
   // harvest results
   for (qint64 i = 0; i < npts; ++i) {
     for (qint64 m = 0; m < nmode; ++m) {
-      fval[m * nmode + i] = results.at(i).at(m).toDouble();
+      fval[m * nmode + i] = 0.0;
+    }
+  }
+  for (qint64 j = 0; j < results.length(); ++j) {
+    const qint64 i = pointList.at(j);
+    for (qint64 m = 0; m < nmode; ++m) {
+      fval[m * nmode + i] = results.at(j).at(m).toDouble();
     }
   }
 }
 
-void property_r(unsigned int ndim, const double* xyz, void* param,
-                unsigned int fdim, double* fval)
+void property_v_r(unsigned int /* ndim */, unsigned int npts,
+                  const double* xyz, void* param, unsigned int /* fdim */,
+                  double* fval)
 {
 
-  ndim = ndim;
-  fdim = fdim;
-
   QVariantList* paramVariantListPtr = (QVariantList*)param;
   QVariantList paramVariantList = *paramVariantListPtr;
 
   qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
+  const QVariant evaluator = paramVariantList.at(counter);
   counter++;
 
-  qreal r = xyz[0];
   qreal t = paramVariantList.at(counter).toDouble();
   counter++;
   qreal p = paramVariantList.at(counter).toDouble();
@@ -1750,7 +1785,6 @@ void property_r(unsigned int ndim, const double* xyz, void* param,
 
     ncpList.append(QVector3D(x, y, z));
   }
-  qint64 nmode = 1;
   qint64 mode = paramVariantList.at(counter).toLongLong();
   counter++;
   QList<qint64> basinList;
@@ -1759,30 +1793,28 @@ void property_r(unsigned int ndim, const double* xyz, void* param,
     counter++;
   }
 
-  Matrix<qreal, 3, 1> rtp;
-  rtp << r, t, p;
   Matrix<qreal, 3, 1> origin;
   origin << ncpList.at(basinList.at(0)).x(), ncpList.at(basinList.at(0)).y(),
     ncpList.at(basinList.at(0)).z();
 
-  Matrix<qreal, 3, 1> XYZ =
-    QTAIMMathUtilities::sphericalToCartesian(rtp, origin);
-
-  qreal x = XYZ(0);
-  qreal y = XYZ(1);
-  qreal z = XYZ(2);
+  // All radii of the ray are evaluated in one batch.
+  Matrix<qreal, 3, Dynamic> points(3, npts);
+  for (unsigned int i = 0; i < npts; ++i) {
+    Matrix<qreal, 3, 1> rtp;
+    rtp << xyz[i], t, p;
+    points.col(i) = QTAIMMathUtilities::sphericalToCartesian(rtp, origin);
+  }
 
-  // This routine reads the wavefunction file repeatedly.
-  // Let's hope that this time is dwarfed by the time
-  // taken to delineate the atomic basins in the calling routine.
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-  QTAIMWavefunctionEvaluator eval(wfn);
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(evaluator);
 
-  for (qint64 m = 0; m < nmode; ++m) {
-    if (mode == 0) {
-      fval[m] = r * r * eval.electronDensity(Eigen::Vector3d(x, y, z));
-    }
+  if (mode == 0) {
+    const Matrix<qreal, Dynamic, 1> densities = eval.electronDensities(points);
+    for (unsigned int i = 0; i < npts; ++i)
+      fval[i] = xyz[i] * xyz[i] * densities(i);
+  } else {
+    for (unsigned int i = 0; i < npts; ++i)
+      fval[i] = 0.0;
   }
 }
 
@@ -1791,7 +1823,7 @@ QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
 
   /*
      Order of variantList:
-     QString wfnFileName
+     QTAIMWavefunctionEvaluator evaluator
      qreal t
      qreal p
      qint64 nncp
@@ -1812,7 +1844,7 @@ QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
      ...
   */
   qint64 counter = 0;
-  QString wfnFileName = variantList.at(counter).toString();
+  const QVariant evaluator = variantList.at(counter);
   counter++;
   qreal t = variantList.at(counter).toDouble();
   counter++;
@@ -1852,9 +1884,8 @@ QList<QVariant> QTAIMEvaluatePropertyTP(QList<QVariant> variantList)
   }
   QSet<qint64> basinSet = basinList.toSet();
 
-  QTAIMWavefunction wfn;
-  wfn.loadFromBinaryFile(wfnFileName);
-  QTAIMWavefunctionEvaluator eval(wfn);
+  const QTAIMWavefunctionEvaluator& eval =
+    QTAIMWavefunctionEvaluator::fromVariant(evaluator);
 
   // Set up steepest ascent integrator and beta spheres
   QList<QPair<QVector3D, qreal>> betaSpheres;
@@ -2058,7 +2089,7 @@ endOfBisection:
   xmax[0] = rf;
 
   QVariantList paramVariantList;
-  paramVariantList.append(wfnFileName);
+  paramVariantList.append(evaluator);
   paramVariantList.append(t);
   paramVariantList.append(p);
   paramVariantList.append(
@@ -2072,8 +2103,8 @@ endOfBisection:
   paramVariantList.append(basinList.at(0)); // basin
 
   //  qDebug() << "Into R with rf=" << rf;
-  adapt_integrate(fdim, property_r, &paramVariantList, dim, xmin, xmax, maxEval,
-                  tol, 0, val, err);
+  adapt_integrate_v(fdim, property_v_r, &paramVariantList, dim, xmin, xmax,
+                    maxEval, tol, 0, val, err);
   //  qDebug() << "Out of R with val=" << val[0] << "err=" << err[0];
   qreal Rval = val[0];
 
@@ -2100,7 +2131,7 @@ void property_v_tp(unsigned int /* ndim */, unsigned int npts,
   QVariantList paramVariantList = *paramVariantListPtr;
 
   qint64 counter = 0;
-  QString wfnFileName = paramVariantList.at(counter).toString();
+  const QVariant evaluator = paramVariantList.at(counter);
   counter++;
 
   qint64 nncp = paramVariantList.at(counter).toLongLong();
@@ -2136,7 +2167,7 @@ void property_v_tp(unsigned int /* ndim */, unsigned int npts,
 
     QList<QVariant> variantList;
 
-    variantList.append(wfnFileName);
+    variantList.append(evaluator);
 
     variantList.append(t);
     variantList.append(p);
@@ -2202,13 +2233,8 @@ namespace Avogadro {
 namespace QtPlugins {
 
 QTAIMCubature::QTAIMCubature(QTAIMWavefunction& wfn)
+  : m_wfn(&wfn), m_eval(wfn)
 {
-
-  m_wfn = &wfn;
-
-  m_temporaryFileName = QTAIMCubature::temporaryFileName();
-  m_wfn->saveToBinaryFile(m_temporaryFileName);
-
   // Instantiate a Critical Point Locator
   QTAIMCriticalPointLocator cpl(wfn);
 
@@ -2263,7 +2289,7 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
         xmax[2] = 8. + m_ncpList.at(i).z();
 
         QVariantList paramVariantList;
-        paramVariantList.append(m_temporaryFileName);
+        paramVariantList.append(m_eval.toVariant());
 
         paramVariantList.append(
           m_ncpList.length()); // number of nuclear critical points
@@ -2289,7 +2315,7 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
         xmax[2] = 2.0 * pi;
 
         QVariantList paramVariantList;
-        paramVariantList.append(m_temporaryFileName);
+        paramVariantList.append(m_eval.toVariant());
 
         paramVariantList.append(
           m_ncpList.length()); // number of nuclear critical points
@@ -2324,7 +2350,7 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
       xmax[1] = 2.0 * pi;
 
       QVariantList paramVariantList;
-      paramVariantList.append(m_temporaryFileName);
+      paramVariantList.append(m_eval.toVariant());
 
       paramVariantList.append(
         m_ncpList.length()); // number of nuclear critical points
@@ -2361,9 +2387,6 @@ QList<QPair<qreal, qreal>> QTAIMCubature::integrate(qint64 mode,
 
 QTAIMCubature::~QTAIMCubature()
 {
-  if (QFile::exists(m_temporaryFileName)) {
-    QFile::remove(m_temporaryFileName);
-  }
 }
 
 void QTAIMCubature::setMode(qint64 mode)
@@ -2371,22 +2394,5 @@ void QTAIMCubature::setMode(qint64 mode)
   m_mode = mode;
 }
 
-QString QTAIMCubature::temporaryFileName()
-{
-  QTemporaryFile temporaryFile;
-  temporaryFile.open();
-  QString tempFileName = temporaryFile.fileName();
-  temporaryFile.close();
-  temporaryFile.remove();
-
-  // wait for temporary file to be deleted
-  QDir dir;
-  do {
-    // Nothing
-  } while (dir.exists(tempFileName));
-
-  return tempFileName;
-}
-
 } // end namespace QtPlugins
 } // end namespace Avogadro
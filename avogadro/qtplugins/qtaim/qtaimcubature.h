@@ -128,12 +128,10 @@ public:
 
 private:
   QTAIMWavefunction* m_wfn;
+  QTAIMWavefunctionEvaluator m_eval;
   qint64 m_mode;
   QList<qint64> m_basins;
 
-  QString m_temporaryFileName;
-  QString temporaryFileName();
-
   QList<QVector3D> m_ncpList;
 };
 
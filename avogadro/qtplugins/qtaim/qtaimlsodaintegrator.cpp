@@ -42,8 +42,8 @@ tam@wri.com
 namespace Avogadro {
 namespace QtPlugins {
 
-QTAIMLSODAIntegrator::QTAIMLSODAIntegrator(QTAIMWavefunctionEvaluator& eval,
-                                           const qint64 mode)
+QTAIMLSODAIntegrator::QTAIMLSODAIntegrator(
+  const QTAIMWavefunctionEvaluator& eval, const qint64 mode)
 {
   m_eval = &eval;
   m_mode = mode;
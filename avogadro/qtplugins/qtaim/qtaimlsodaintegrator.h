@@ -51,7 +51,7 @@ public:
     CMBPPlusThreeGradientInElectronDensityLaplacian = 8
   };
 
-  explicit QTAIMLSODAIntegrator(QTAIMWavefunctionEvaluator& eval,
+  explicit QTAIMLSODAIntegrator(const QTAIMWavefunctionEvaluator& eval,
                                 const qint64 mode);
 
   QVector3D integrate(QVector3D x0y0z0);
@@ -66,7 +66,7 @@ public:
   qint64 associatedSphere() const { return m_associatedSphere; }
 
 private:
-  QTAIMWavefunctionEvaluator* m_eval;
+  const QTAIMWavefunctionEvaluator* m_eval;
   qint64 m_mode;
 
   qint64 m_status;
@@ -23,7 +23,7 @@
 namespace Avogadro {
 namespace QtPlugins {
 
-QTAIMODEIntegrator::QTAIMODEIntegrator(QTAIMWavefunctionEvaluator& eval,
+QTAIMODEIntegrator::QTAIMODEIntegrator(const QTAIMWavefunctionEvaluator& eval,
                                        const qint64 mode)
 {
   m_eval = &eval;
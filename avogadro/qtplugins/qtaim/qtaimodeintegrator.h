@@ -48,7 +48,7 @@ public:
     CMBPPlusThreeGradientInElectronDensityLaplacian = 8
   };
 
-  explicit QTAIMODEIntegrator(QTAIMWavefunctionEvaluator& eval,
+  explicit QTAIMODEIntegrator(const QTAIMWavefunctionEvaluator& eval,
                               const qint64 mode);
 
   QVector3D integrate(QVector3D x0y0z0);
@@ -63,7 +63,7 @@ public:
   qint64 associatedSphere() const { return m_associatedSphere; }
 
 private:
-  QTAIMWavefunctionEvaluator* m_eval;
+  const QTAIMWavefunctionEvaluator* m_eval;
   qint64 m_mode;
 
   qint64 m_status;
@@ -14,6 +14,7 @@
 
 ******************************************************************************/
 
+#include <algorithm>
 #include <cmath>
 
 #include "qtaimwavefunctionevaluator.h"
@@ -21,7 +22,9 @@
 namespace Avogadro {
 namespace QtPlugins {
 
-QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(QTAIMWavefunction& wfn)
+QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(
+  const QTAIMWavefunction& wfn)
+  : m_wfn(&wfn)
 {
 
   m_nmo = wfn.numberOfMolecularOrbitals();
@@ -35,76 +38,141 @@ QTAIMWavefunctionEvaluator::QTAIMWavefunctionEvaluator(QTAIMWavefunction& wfn)
   m_nuczcoord =
     Map<const Matrix<qreal, Dynamic, 1>>(wfn.zNuclearCoordinates(), m_nnuc);
   m_nucz = Map<const Matrix<qint64, Dynamic, 1>>(wfn.nuclearCharges(), m_nnuc);
-  m_X0 = Map<const Matrix<qreal, Dynamic, 1>>(
+  const Map<const Matrix<qreal, Dynamic, 1>> X0(
     wfn.xGaussianPrimitiveCenterCoordinates(), m_nprim, 1);
-  m_Y0 = Map<const Matrix<qreal, Dynamic, 1>>(
+  const Map<const Matrix<qreal, Dynamic, 1>> Y0(
     wfn.yGaussianPrimitiveCenterCoordinates(), m_nprim, 1);
-  m_Z0 = Map<const Matrix<qreal, Dynamic, 1>>(
+  const Map<const Matrix<qreal, Dynamic, 1>> Z0(
     wfn.zGaussianPrimitiveCenterCoordinates(), m_nprim, 1);
-  m_xamom = Map<const Matrix<qint64, Dynamic, 1>>(
+  const Map<const Matrix<qint64, Dynamic, 1>> xamom(
     wfn.xGaussianPrimitiveAngularMomenta(), m_nprim, 1);
-  m_yamom = Map<const Matrix<qint64, Dynamic, 1>>(
+  const Map<const Matrix<qint64, Dynamic, 1>> yamom(
     wfn.yGaussianPrimitiveAngularMomenta(), m_nprim, 1);
-  m_zamom = Map<const Matrix<qint64, Dynamic, 1>>(
+  const Map<const Matrix<qint64, Dynamic, 1>> zamom(
     wfn.zGaussianPrimitiveAngularMomenta(), m_nprim, 1);
-  m_alpha = Map<const Matrix<qreal, Dynamic, 1>>(
+  const Map<const Matrix<qreal, Dynamic, 1>> alpha(
     wfn.gaussianPrimitiveExponentCoefficients(), m_nprim, 1);
   // TODO Implement screening for unoccupied molecular orbitals.
   m_occno = Map<const Matrix<qreal, Dynamic, 1>>(
     wfn.molecularOrbitalOccupationNumbers(), m_nmo, 1);
   m_orbe = Map<const Matrix<qreal, Dynamic, 1>>(
     wfn.molecularOrbitalEigenvalues(), m_nmo, 1);
-  m_coef = Map<const Matrix<qreal, Dynamic, Dynamic, RowMajor>>(
+  const Map<const Matrix<qreal, Dynamic, Dynamic, RowMajor>> coef(
     wfn.molecularOrbitalCoefficients(), m_nmo, m_nprim);
   m_totalEnergy = wfn.totalEnergy();
   m_virialRatio = wfn.virialRatio();
 
   m_cutoff = log(1.e-15);
 
-  m_cdg000.resize(m_nmo);
-  m_cdg100.resize(m_nmo);
-  m_cdg010.resize(m_nmo);
-  m_cdg001.resize(m_nmo);
-  m_cdg200.resize(m_nmo);
-  m_cdg110.resize(m_nmo);
-  m_cdg101.resize(m_nmo);
-  m_cdg020.resize(m_nmo);
-  m_cdg011.resize(m_nmo);
-  m_cdg002.resize(m_nmo);
-  m_cdg300.resize(m_nmo);
-  m_cdg120.resize(m_nmo);
-  m_cdg102.resize(m_nmo);
-  m_cdg210.resize(m_nmo);
-  m_cdg030.resize(m_nmo);
-  m_cdg012.resize(m_nmo);
-  m_cdg201.resize(m_nmo);
-  m_cdg021.resize(m_nmo);
-  m_cdg003.resize(m_nmo);
-  m_cdg111.resize(m_nmo);
-  m_cdg400.resize(m_nmo);
-  m_cdg220.resize(m_nmo);
-  m_cdg202.resize(m_nmo);
-  m_cdg310.resize(m_nmo);
-  m_cdg130.resize(m_nmo);
-  m_cdg112.resize(m_nmo);
-  m_cdg301.resize(m_nmo);
-  m_cdg121.resize(m_nmo);
-  m_cdg103.resize(m_nmo);
-  m_cdg040.resize(m_nmo);
-  m_cdg022.resize(m_nmo);
-  m_cdg211.resize(m_nmo);
-  m_cdg031.resize(m_nmo);
-  m_cdg013.resize(m_nmo);
-  m_cdg004.resize(m_nmo);
+  // Group the primitives by center, the most diffuse primitive of each center
+  // first, so that screenedPrimitives() can skip whole centers and stop at the
+  // first negligible exponent of the others.
+  std::vector<qint64> center(m_nprim);
+  std::vector<qint64> firstOfCenter;
+  for (qint64 p = 0; p < m_nprim; ++p) {
+    qint64 c = 0;
+    const qint64 ncenter = static_cast<qint64>(firstOfCenter.size());
+    while (c < ncenter && (X0(firstOfCenter[c]) != X0(p) ||
+                           Y0(firstOfCenter[c]) != Y0(p) ||
+                           Z0(firstOfCenter[c]) != Z0(p))) {
+      ++c;
+    }
+    if (c == ncenter)
+      firstOfCenter.push_back(p);
+    center[p] = c;
+  }
+  std::vector<qint64> order(m_nprim);
+  for (qint64 p = 0; p < m_nprim; ++p)
+    order[p] = p;
+  std::stable_sort(order.begin(), order.end(), [&](qint64 a, qint64 b) {
+    return center[a] < center[b] ||
+           (center[a] == center[b] && alpha(a) < alpha(b));
+  });
+
+  m_ncenter = static_cast<qint64>(firstOfCenter.size());
+  m_centerX0.resize(m_ncenter);
+  m_centerY0.resize(m_ncenter);
+  m_centerZ0.resize(m_ncenter);
+  m_centerPrimitives.setZero(m_ncenter + 1);
+  for (qint64 c = 0; c < m_ncenter; ++c) {
+    m_centerX0(c) = X0(firstOfCenter[c]);
+    m_centerY0(c) = Y0(firstOfCenter[c]);
+    m_centerZ0(c) = Z0(firstOfCenter[c]);
+  }
+
+  // The primitives are stored as separate arrays, and the coefficients
+  // column-major, so the contribution of one primitive to all orbitals is a
+  // contiguous, vectorizable update.
+  m_X0.resize(m_nprim);
+  m_Y0.resize(m_nprim);
+  m_Z0.resize(m_nprim);
+  m_xamom.resize(m_nprim);
+  m_yamom.resize(m_nprim);
+  m_zamom.resize(m_nprim);
+  m_alpha.resize(m_nprim);
+  m_coef.resize(m_nmo, m_nprim);
+  for (qint64 i = 0; i < m_nprim; ++i) {
+    const qint64 p = order[i];
+    m_X0(i) = X0(p);
+    m_Y0(i) = Y0(p);
+    m_Z0(i) = Z0(p);
+    m_xamom(i) = xamom(p);
+    m_yamom(i) = yamom(p);
+    m_zamom(i) = zamom(p);
+    m_alpha(i) = alpha(p);
+    m_coef.col(i) = coef.col(p);
+    ++m_centerPrimitives(center[p] + 1);
+  }
+  for (qint64 c = 0; c < m_ncenter; ++c)
+    m_centerPrimitives(c + 1) += m_centerPrimitives(c);
+}
+
+std::vector<qint64> QTAIMWavefunctionEvaluator::screenedPrimitives(
+  const Matrix<qreal, 3, 1>& xyz) const
+{
+  std::vector<qint64> primitives;
+  primitives.reserve(m_nprim);
+  for (qint64 c = 0; c < m_ncenter; ++c) {
+    const qreal xx0 = xyz(0) - m_centerX0(c);
+    const qreal yy0 = xyz(1) - m_centerY0(c);
+    const qreal zz0 = xyz(2) - m_centerZ0(c);
+    const qreal rr0 = xx0 * xx0 + yy0 * yy0 + zz0 * zz0;
+
+    // The exponents increase within each center.
+    for (qint64 p = m_centerPrimitives(c); p < m_centerPrimitives(c + 1);
+         ++p) {
+      if (-m_alpha(p) * rr0 <= m_cutoff)
+        break;
+      primitives.push_back(p);
+    }
+  }
+  return primitives;
+}
+
+QVariant QTAIMWavefunctionEvaluator::toVariant() const
+{
+  return QVariant::fromValue(this);
+}
+
+const QTAIMWavefunctionEvaluator& QTAIMWavefunctionEvaluator::fromVariant(
+  const QVariant& variant)
+{
+  const QTAIMWavefunctionEvaluator* evaluator =
+    variant.value<const QTAIMWavefunctionEvaluator*>();
+  Q_ASSERT_X(evaluator, "QTAIMWavefunctionEvaluator::fromVariant",
+             "The variant does not hold an evaluator");
+  return *evaluator;
 }
 
 qreal QTAIMWavefunctionEvaluator::molecularOrbital(
-  const qint64 mo, const Matrix<qreal, 3, 1> xyz)
+  const qint64 mo, const Matrix<qreal, 3, 1> xyz) const
 {
 
   qreal value = 0.0;
 
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -127,13 +195,16 @@ qreal QTAIMWavefunctionEvaluator::molecularOrbital(
   return value;
 }
 
-qreal QTAIMWavefunctionEvaluator::electronDensity(const Matrix<qreal, 3, 1> xyz)
+qreal QTAIMWavefunctionEvaluator::electronDensity(
+  const Matrix<qreal, 3, 1> xyz) const
 {
 
   qreal value;
 
-  m_cdg000.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -149,22 +220,20 @@ qreal QTAIMWavefunctionEvaluator::electronDensity(const Matrix<qreal, 3, 1> xyz)
 
       qreal dg000 = ax0 * ay0 * az0 * b0;
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-      }
+      cdg000 += dg000 * m_coef.col(p);
     }
   }
 
   value = 0.0;
   for (qint64 m = 0; m < m_nmo; ++m) {
-    value += m_occno(m) * ipow(m_cdg000(m), 2);
+    value += m_occno(m) * ipow(cdg000(m), 2);
   }
 
   return value;
 }
 
 const Matrix<qreal, 3, 1> QTAIMWavefunctionEvaluator::gradientOfElectronDensity(
-  Matrix<qreal, 3, 1> xyz)
+  Matrix<qreal, 3, 1> xyz) const
 {
 
   Matrix<qreal, 3, 1> value;
@@ -172,11 +241,13 @@ const Matrix<qreal, 3, 1> QTAIMWavefunctionEvaluator::gradientOfElectronDensity(
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg100.setZero();
-  m_cdg010.setZero();
-  m_cdg001.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg100(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg010(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg001(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -233,27 +304,25 @@ const Matrix<qreal, 3, 1> QTAIMWavefunctionEvaluator::gradientOfElectronDensity(
       qreal dg010 = ax0 * az0 * b0 * (ay1 + ay0 * by1);
       qreal dg001 = ax0 * ay0 * b0 * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg100 += dg100 * m_coef.col(p);
+      cdg010 += dg010 * m_coef.col(p);
+      cdg001 += dg001 * m_coef.col(p);
     }
   }
 
   value.setZero();
   for (qint64 m = 0; m < m_nmo; ++m) {
-    value(0) += m_occno(m) * m_cdg100(m) * m_cdg000(m);
-    value(1) += m_occno(m) * m_cdg010(m) * m_cdg000(m);
-    value(2) += m_occno(m) * m_cdg001(m) * m_cdg000(m);
+    value(0) += m_occno(m) * cdg100(m) * cdg000(m);
+    value(1) += m_occno(m) * cdg010(m) * cdg000(m);
+    value(2) += m_occno(m) * cdg001(m) * cdg000(m);
   }
 
   return value;
 }
 
 const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
-  const Matrix<qreal, 3, 1> xyz)
+  const Matrix<qreal, 3, 1> xyz) const
 {
 
   Matrix<qreal, 3, 3> value;
@@ -261,17 +330,19 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg100.setZero();
-  m_cdg010.setZero();
-  m_cdg001.setZero();
-  m_cdg200.setZero();
-  m_cdg020.setZero();
-  m_cdg002.setZero();
-  m_cdg110.setZero();
-  m_cdg101.setZero();
-  m_cdg011.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg100(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg010(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg001(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg200(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg020(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg002(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg110(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg101(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg011(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -367,35 +438,33 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
       qreal dg101 = ay0 * b0 * (ax1 + ax0 * bx1) * (az1 + az0 * bz1);
       qreal dg011 = ax0 * b0 * (ay1 + ay0 * by1) * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg100 += dg100 * m_coef.col(p);
+      cdg010 += dg010 * m_coef.col(p);
+      cdg001 += dg001 * m_coef.col(p);
+      cdg200 += dg200 * m_coef.col(p);
+      cdg020 += dg020 * m_coef.col(p);
+      cdg002 += dg002 * m_coef.col(p);
+      cdg110 += dg110 * m_coef.col(p);
+      cdg101 += dg101 * m_coef.col(p);
+      cdg011 += dg011 * m_coef.col(p);
     }
   }
 
   value.setZero();
   for (qint64 m = 0; m < m_nmo; ++m) {
     value(0, 0) +=
-      2 * m_occno(m) * (ipow(m_cdg100(m), 2) + m_cdg000(m) * m_cdg200(m));
+      2 * m_occno(m) * (ipow(cdg100(m), 2) + cdg000(m) * cdg200(m));
     value(1, 1) +=
-      2 * m_occno(m) * (ipow(m_cdg010(m), 2) + m_cdg000(m) * m_cdg020(m));
+      2 * m_occno(m) * (ipow(cdg010(m), 2) + cdg000(m) * cdg020(m));
     value(2, 2) +=
-      2 * m_occno(m) * (ipow(m_cdg001(m), 2) + m_cdg000(m) * m_cdg002(m));
+      2 * m_occno(m) * (ipow(cdg001(m), 2) + cdg000(m) * cdg002(m));
     value(0, 1) +=
-      2 * m_occno(m) * (m_cdg100(m) * m_cdg010(m) + m_cdg000(m) * m_cdg110(m));
+      2 * m_occno(m) * (cdg100(m) * cdg010(m) + cdg000(m) * cdg110(m));
     value(0, 2) +=
-      2 * m_occno(m) * (m_cdg100(m) * m_cdg001(m) + m_cdg000(m) * m_cdg101(m));
+      2 * m_occno(m) * (cdg100(m) * cdg001(m) + cdg000(m) * cdg101(m));
     value(1, 2) +=
-      2 * m_occno(m) * (m_cdg010(m) * m_cdg001(m) + m_cdg000(m) * m_cdg011(m));
+      2 * m_occno(m) * (cdg010(m) * cdg001(m) + cdg000(m) * cdg011(m));
   }
   value(1, 0) = value(0, 1);
   value(2, 0) = value(0, 2);
@@ -406,7 +475,7 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::hessianOfElectronDensity(
 
 const Matrix<qreal, 3, 4>
 QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
-  const Matrix<qreal, 3, 1> xyz)
+  const Matrix<qreal, 3, 1> xyz) const
 {
 
   Matrix<qreal, 3, 1> gValue;
@@ -416,17 +485,19 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg100.setZero();
-  m_cdg010.setZero();
-  m_cdg001.setZero();
-  m_cdg200.setZero();
-  m_cdg020.setZero();
-  m_cdg002.setZero();
-  m_cdg110.setZero();
-  m_cdg101.setZero();
-  m_cdg011.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg100(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg010(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg001(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg200(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg020(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg002(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg110(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg101(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg011(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -522,42 +593,40 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
       qreal dg101 = ay0 * b0 * (ax1 + ax0 * bx1) * (az1 + az0 * bz1);
       qreal dg011 = ax0 * b0 * (ay1 + ay0 * by1) * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg100 += dg100 * m_coef.col(p);
+      cdg010 += dg010 * m_coef.col(p);
+      cdg001 += dg001 * m_coef.col(p);
+      cdg200 += dg200 * m_coef.col(p);
+      cdg020 += dg020 * m_coef.col(p);
+      cdg002 += dg002 * m_coef.col(p);
+      cdg110 += dg110 * m_coef.col(p);
+      cdg101 += dg101 * m_coef.col(p);
+      cdg011 += dg011 * m_coef.col(p);
     }
   }
 
   gValue.setZero();
   for (qint64 m = 0; m < m_nmo; ++m) {
-    gValue(0) += m_occno(m) * m_cdg100(m) * m_cdg000(m);
-    gValue(1) += m_occno(m) * m_cdg010(m) * m_cdg000(m);
-    gValue(2) += m_occno(m) * m_cdg001(m) * m_cdg000(m);
+    gValue(0) += m_occno(m) * cdg100(m) * cdg000(m);
+    gValue(1) += m_occno(m) * cdg010(m) * cdg000(m);
+    gValue(2) += m_occno(m) * cdg001(m) * cdg000(m);
   }
 
   hValue.setZero();
   for (qint64 m = 0; m < m_nmo; ++m) {
     hValue(0, 0) +=
-      2 * m_occno(m) * (ipow(m_cdg100(m), 2) + m_cdg000(m) * m_cdg200(m));
+      2 * m_occno(m) * (ipow(cdg100(m), 2) + cdg000(m) * cdg200(m));
     hValue(1, 1) +=
-      2 * m_occno(m) * (ipow(m_cdg010(m), 2) + m_cdg000(m) * m_cdg020(m));
+      2 * m_occno(m) * (ipow(cdg010(m), 2) + cdg000(m) * cdg020(m));
     hValue(2, 2) +=
-      2 * m_occno(m) * (ipow(m_cdg001(m), 2) + m_cdg000(m) * m_cdg002(m));
+      2 * m_occno(m) * (ipow(cdg001(m), 2) + cdg000(m) * cdg002(m));
     hValue(0, 1) +=
-      2 * m_occno(m) * (m_cdg100(m) * m_cdg010(m) + m_cdg000(m) * m_cdg110(m));
+      2 * m_occno(m) * (cdg100(m) * cdg010(m) + cdg000(m) * cdg110(m));
     hValue(0, 2) +=
-      2 * m_occno(m) * (m_cdg100(m) * m_cdg001(m) + m_cdg000(m) * m_cdg101(m));
+      2 * m_occno(m) * (cdg100(m) * cdg001(m) + cdg000(m) * cdg101(m));
     hValue(1, 2) +=
-      2 * m_occno(m) * (m_cdg010(m) * m_cdg001(m) + m_cdg000(m) * m_cdg011(m));
+      2 * m_occno(m) * (cdg010(m) * cdg001(m) + cdg000(m) * cdg011(m));
   }
   hValue(1, 0) = hValue(0, 1);
   hValue(2, 0) = hValue(0, 2);
@@ -580,7 +649,7 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensity(
 }
 
 qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
-  const Matrix<qreal, 3, 1> xyz)
+  const Matrix<qreal, 3, 1> xyz) const
 {
 
   qreal value;
@@ -588,14 +657,16 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg100.setZero();
-  m_cdg010.setZero();
-  m_cdg001.setZero();
-  m_cdg200.setZero();
-  m_cdg020.setZero();
-  m_cdg002.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg100(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg010(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg001(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg200(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg020(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg002(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -688,24 +759,22 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
       qreal dg020 = ax0 * az0 * b0 * (ay2 + 2 * ay1 * by1 + ay0 * by2);
       qreal dg002 = ax0 * ay0 * b0 * (az2 + 2 * az1 * bz1 + az0 * bz2);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg100 += dg100 * m_coef.col(p);
+      cdg010 += dg010 * m_coef.col(p);
+      cdg001 += dg001 * m_coef.col(p);
+      cdg200 += dg200 * m_coef.col(p);
+      cdg020 += dg020 * m_coef.col(p);
+      cdg002 += dg002 * m_coef.col(p);
     }
   }
 
   value = 0.0;
   for (qint64 m = 0; m < m_nmo; ++m) {
     value +=
-      2 * m_occno(m) * (ipow(m_cdg100(m), 2) + m_cdg000(m) * m_cdg200(m)) +
-      2 * m_occno(m) * (ipow(m_cdg010(m), 2) + m_cdg000(m) * m_cdg020(m)) +
-      2 * m_occno(m) * (ipow(m_cdg001(m), 2) + m_cdg000(m) * m_cdg002(m));
+      2 * m_occno(m) * (ipow(cdg100(m), 2) + cdg000(m) * cdg200(m)) +
+      2 * m_occno(m) * (ipow(cdg010(m), 2) + cdg000(m) * cdg020(m)) +
+      2 * m_occno(m) * (ipow(cdg001(m), 2) + cdg000(m) * cdg002(m));
   }
 
   return value;
@@ -713,7 +782,7 @@ qreal QTAIMWavefunctionEvaluator::laplacianOfElectronDensity(
 
 const Matrix<qreal, 3, 1>
 QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
-  const Matrix<qreal, 3, 1> xyz)
+  const Matrix<qreal, 3, 1> xyz) const
 {
 
   Matrix<qreal, 3, 1> value;
@@ -721,27 +790,29 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg100.setZero();
-  m_cdg010.setZero();
-  m_cdg001.setZero();
-  m_cdg200.setZero();
-  m_cdg020.setZero();
-  m_cdg002.setZero();
-  m_cdg110.setZero();
-  m_cdg101.setZero();
-  m_cdg011.setZero();
-  m_cdg300.setZero();
-  m_cdg120.setZero();
-  m_cdg102.setZero();
-  m_cdg210.setZero();
-  m_cdg030.setZero();
-  m_cdg012.setZero();
-  m_cdg201.setZero();
-  m_cdg021.setZero();
-  m_cdg003.setZero();
-  // m_cdg111.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg100(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg010(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg001(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg200(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg020(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg002(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg110(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg101(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg011(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg300(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg120(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg102(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg210(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg030(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg012(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg201(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg021(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg003(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  // cdg111.setZero();
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -892,28 +963,26 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
         ax0 * b0 * (ay1 + ay0 * by1) * (az2 + 2 * az1 * bz1 + az0 * bz2);
       // qreal dg111 = b0*(ax1+ax0*bx1)*(ay1+ay0*by1)*(az1+az0*bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-        m_cdg300(m) += m_coef(m, p) * dg300;
-        m_cdg030(m) += m_coef(m, p) * dg030;
-        m_cdg003(m) += m_coef(m, p) * dg003;
-        m_cdg210(m) += m_coef(m, p) * dg210;
-        m_cdg201(m) += m_coef(m, p) * dg201;
-        m_cdg120(m) += m_coef(m, p) * dg120;
-        m_cdg021(m) += m_coef(m, p) * dg021;
-        m_cdg102(m) += m_coef(m, p) * dg102;
-        m_cdg012(m) += m_coef(m, p) * dg012;
-        // m_cdg111(m) += m_coef(m,p) * dg111;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg100 += dg100 * m_coef.col(p);
+      cdg010 += dg010 * m_coef.col(p);
+      cdg001 += dg001 * m_coef.col(p);
+      cdg200 += dg200 * m_coef.col(p);
+      cdg020 += dg020 * m_coef.col(p);
+      cdg002 += dg002 * m_coef.col(p);
+      cdg110 += dg110 * m_coef.col(p);
+      cdg101 += dg101 * m_coef.col(p);
+      cdg011 += dg011 * m_coef.col(p);
+      cdg300 += dg300 * m_coef.col(p);
+      cdg030 += dg030 * m_coef.col(p);
+      cdg003 += dg003 * m_coef.col(p);
+      cdg210 += dg210 * m_coef.col(p);
+      cdg201 += dg201 * m_coef.col(p);
+      cdg120 += dg120 * m_coef.col(p);
+      cdg021 += dg021 * m_coef.col(p);
+      cdg102 += dg102 * m_coef.col(p);
+      cdg012 += dg012 * m_coef.col(p);
+      // cdg111 += dg111 * m_coef.col(p);
     }
   }
 
@@ -928,32 +997,32 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
   qreal deriv012 = zero;
   // qreal deriv111=zero;
   for (qint64 m = 0; m < m_nmo; ++m) {
-    deriv300 += (m_occno(m) * (6 * m_cdg100(m) * m_cdg200(m) +
-                               2 * m_cdg000(m) * m_cdg300(m)));
-    deriv030 += (m_occno(m) * (6 * m_cdg010(m) * m_cdg020(m) +
-                               2 * m_cdg000(m) * m_cdg030(m)));
-    deriv003 += (m_occno(m) * (6 * m_cdg001(m) * m_cdg002(m) +
-                               2 * m_cdg000(m) * m_cdg003(m)));
+    deriv300 += (m_occno(m) * (6 * cdg100(m) * cdg200(m) +
+                               2 * cdg000(m) * cdg300(m)));
+    deriv030 += (m_occno(m) * (6 * cdg010(m) * cdg020(m) +
+                               2 * cdg000(m) * cdg030(m)));
+    deriv003 += (m_occno(m) * (6 * cdg001(m) * cdg002(m) +
+                               2 * cdg000(m) * cdg003(m)));
     deriv210 += (m_occno(m) *
-                 (2 * (2 * m_cdg100(m) * m_cdg110(m) +
-                       m_cdg010(m) * m_cdg200(m) + m_cdg000(m) * m_cdg210(m))));
+                 (2 * (2 * cdg100(m) * cdg110(m) +
+                       cdg010(m) * cdg200(m) + cdg000(m) * cdg210(m))));
     deriv201 += (m_occno(m) *
-                 (2 * (2 * m_cdg100(m) * m_cdg101(m) +
-                       m_cdg001(m) * m_cdg200(m) + m_cdg000(m) * m_cdg201(m))));
-    deriv120 += (m_occno(m) * (2 * (m_cdg020(m) * m_cdg100(m) +
-                                    2 * m_cdg010(m) * m_cdg110(m) +
-                                    m_cdg000(m) * m_cdg120(m))));
+                 (2 * (2 * cdg100(m) * cdg101(m) +
+                       cdg001(m) * cdg200(m) + cdg000(m) * cdg201(m))));
+    deriv120 += (m_occno(m) * (2 * (cdg020(m) * cdg100(m) +
+                                    2 * cdg010(m) * cdg110(m) +
+                                    cdg000(m) * cdg120(m))));
     deriv021 += (m_occno(m) *
-                 (2 * (2 * m_cdg010(m) * m_cdg011(m) +
-                       m_cdg001(m) * m_cdg020(m) + m_cdg000(m) * m_cdg021(m))));
-    deriv102 += (m_occno(m) * (2 * (m_cdg002(m) * m_cdg100(m) +
-                                    2 * m_cdg001(m) * m_cdg101(m) +
-                                    m_cdg000(m) * m_cdg102(m))));
-    deriv012 += (m_occno(m) * (2 * (m_cdg002(m) * m_cdg010(m) +
-                                    2 * m_cdg001(m) * m_cdg011(m) +
-                                    m_cdg000(m) * m_cdg012(m))));
+                 (2 * (2 * cdg010(m) * cdg011(m) +
+                       cdg001(m) * cdg020(m) + cdg000(m) * cdg021(m))));
+    deriv102 += (m_occno(m) * (2 * (cdg002(m) * cdg100(m) +
+                                    2 * cdg001(m) * cdg101(m) +
+                                    cdg000(m) * cdg102(m))));
+    deriv012 += (m_occno(m) * (2 * (cdg002(m) * cdg010(m) +
+                                    2 * cdg001(m) * cdg011(m) +
+                                    cdg000(m) * cdg012(m))));
     // deriv111+=(m_occno(m)*(
-    // 2*(m_cdg011(m)*m_cdg100(m)+m_cdg010(m)*m_cdg101(m)+m_cdg001(m)*m_cdg110(m)+m_cdg000(m)*m_cdg111(m))
+    // 2*(cdg011(m)*cdg100(m)+cdg010(m)*cdg101(m)+cdg001(m)*cdg110(m)+cdg000(m)*cdg111(m))
     // ));
   }
 
@@ -966,7 +1035,7 @@ QTAIMWavefunctionEvaluator::gradientOfElectronDensityLaplacian(
 
 const Matrix<qreal, 3, 3>
 QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
-  const Matrix<qreal, 3, 1> xyz)
+  const Matrix<qreal, 3, 1> xyz) const
 {
 
   Matrix<qreal, 3, 3> value;
@@ -974,43 +1043,45 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg100.setZero();
-  m_cdg010.setZero();
-  m_cdg001.setZero();
-  m_cdg200.setZero();
-  m_cdg020.setZero();
-  m_cdg002.setZero();
-  m_cdg110.setZero();
-  m_cdg101.setZero();
-  m_cdg011.setZero();
-  m_cdg300.setZero();
-  m_cdg120.setZero();
-  m_cdg102.setZero();
-  m_cdg210.setZero();
-  m_cdg030.setZero();
-  m_cdg012.setZero();
-  m_cdg201.setZero();
-  m_cdg021.setZero();
-  m_cdg003.setZero();
-  m_cdg111.setZero();
-  m_cdg400.setZero();
-  m_cdg040.setZero();
-  m_cdg004.setZero();
-  m_cdg310.setZero();
-  m_cdg301.setZero();
-  m_cdg130.setZero();
-  m_cdg031.setZero();
-  m_cdg103.setZero();
-  m_cdg013.setZero();
-  m_cdg220.setZero();
-  m_cdg202.setZero();
-  m_cdg022.setZero();
-  m_cdg211.setZero();
-  m_cdg121.setZero();
-  m_cdg112.setZero();
-
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg100(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg010(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg001(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg200(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg020(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg002(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg110(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg101(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg011(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg300(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg120(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg102(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg210(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg030(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg012(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg201(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg021(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg003(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg111(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg400(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg040(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg004(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg310(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg301(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg130(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg031(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg103(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg013(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg220(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg202(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg022(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg211(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg121(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg112(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -1237,43 +1308,41 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
       qreal dg112 = b0 * (ax1 + ax0 * bx1) * (ay1 + ay0 * by1) *
                     (az2 + 2 * az1 * bz1 + az0 * bz2);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-        m_cdg300(m) += m_coef(m, p) * dg300;
-        m_cdg030(m) += m_coef(m, p) * dg030;
-        m_cdg003(m) += m_coef(m, p) * dg003;
-        m_cdg210(m) += m_coef(m, p) * dg210;
-        m_cdg201(m) += m_coef(m, p) * dg201;
-        m_cdg120(m) += m_coef(m, p) * dg120;
-        m_cdg021(m) += m_coef(m, p) * dg021;
-        m_cdg102(m) += m_coef(m, p) * dg102;
-        m_cdg012(m) += m_coef(m, p) * dg012;
-        m_cdg111(m) += m_coef(m, p) * dg111;
-        m_cdg400(m) += m_coef(m, p) * dg400;
-        m_cdg040(m) += m_coef(m, p) * dg040;
-        m_cdg004(m) += m_coef(m, p) * dg004;
-        m_cdg310(m) += m_coef(m, p) * dg310;
-        m_cdg301(m) += m_coef(m, p) * dg301;
-        m_cdg130(m) += m_coef(m, p) * dg130;
-        m_cdg031(m) += m_coef(m, p) * dg031;
-        m_cdg103(m) += m_coef(m, p) * dg103;
-        m_cdg013(m) += m_coef(m, p) * dg013;
-        m_cdg220(m) += m_coef(m, p) * dg220;
-        m_cdg202(m) += m_coef(m, p) * dg202;
-        m_cdg022(m) += m_coef(m, p) * dg022;
-        m_cdg211(m) += m_coef(m, p) * dg211;
-        m_cdg121(m) += m_coef(m, p) * dg121;
-        m_cdg112(m) += m_coef(m, p) * dg112;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg100 += dg100 * m_coef.col(p);
+      cdg010 += dg010 * m_coef.col(p);
+      cdg001 += dg001 * m_coef.col(p);
+      cdg200 += dg200 * m_coef.col(p);
+      cdg020 += dg020 * m_coef.col(p);
+      cdg002 += dg002 * m_coef.col(p);
+      cdg110 += dg110 * m_coef.col(p);
+      cdg101 += dg101 * m_coef.col(p);
+      cdg011 += dg011 * m_coef.col(p);
+      cdg300 += dg300 * m_coef.col(p);
+      cdg030 += dg030 * m_coef.col(p);
+      cdg003 += dg003 * m_coef.col(p);
+      cdg210 += dg210 * m_coef.col(p);
+      cdg201 += dg201 * m_coef.col(p);
+      cdg120 += dg120 * m_coef.col(p);
+      cdg021 += dg021 * m_coef.col(p);
+      cdg102 += dg102 * m_coef.col(p);
+      cdg012 += dg012 * m_coef.col(p);
+      cdg111 += dg111 * m_coef.col(p);
+      cdg400 += dg400 * m_coef.col(p);
+      cdg040 += dg040 * m_coef.col(p);
+      cdg004 += dg004 * m_coef.col(p);
+      cdg310 += dg310 * m_coef.col(p);
+      cdg301 += dg301 * m_coef.col(p);
+      cdg130 += dg130 * m_coef.col(p);
+      cdg031 += dg031 * m_coef.col(p);
+      cdg103 += dg103 * m_coef.col(p);
+      cdg013 += dg013 * m_coef.col(p);
+      cdg220 += dg220 * m_coef.col(p);
+      cdg202 += dg202 * m_coef.col(p);
+      cdg022 += dg022 * m_coef.col(p);
+      cdg211 += dg211 * m_coef.col(p);
+      cdg121 += dg121 * m_coef.col(p);
+      cdg112 += dg112 * m_coef.col(p);
     }
   }
 
@@ -1294,68 +1363,68 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
   qreal deriv112 = zero;
   for (qint64 m = 0; m < m_nmo; ++m) {
     deriv400 +=
-      (m_occno(m) * (6 * ipow(m_cdg200(m), 2) + 8 * m_cdg100(m) * m_cdg300(m) +
-                     2 * m_cdg000(m) * m_cdg400(m)));
+      (m_occno(m) * (6 * ipow(cdg200(m), 2) + 8 * cdg100(m) * cdg300(m) +
+                     2 * cdg000(m) * cdg400(m)));
     deriv040 +=
-      (m_occno(m) * (6 * ipow(m_cdg020(m), 2) + 8 * m_cdg010(m) * m_cdg030(m) +
-                     2 * m_cdg000(m) * m_cdg040(m)));
+      (m_occno(m) * (6 * ipow(cdg020(m), 2) + 8 * cdg010(m) * cdg030(m) +
+                     2 * cdg000(m) * cdg040(m)));
     deriv004 +=
-      (m_occno(m) * (6 * ipow(m_cdg002(m), 2) + 8 * m_cdg001(m) * m_cdg003(m) +
-                     2 * m_cdg000(m) * m_cdg004(m)));
+      (m_occno(m) * (6 * ipow(cdg002(m), 2) + 8 * cdg001(m) * cdg003(m) +
+                     2 * cdg000(m) * cdg004(m)));
     deriv310 +=
       (m_occno(m) *
-       (2 * (3 * m_cdg110(m) * m_cdg200(m) + 3 * m_cdg100(m) * m_cdg210(m) +
-             m_cdg010(m) * m_cdg300(m) + m_cdg000(m) * m_cdg310(m))));
+       (2 * (3 * cdg110(m) * cdg200(m) + 3 * cdg100(m) * cdg210(m) +
+             cdg010(m) * cdg300(m) + cdg000(m) * cdg310(m))));
     deriv301 +=
       (m_occno(m) *
-       (2 * (3 * m_cdg101(m) * m_cdg200(m) + 3 * m_cdg100(m) * m_cdg201(m) +
-             m_cdg001(m) * m_cdg300(m) + m_cdg000(m) * m_cdg301(m))));
+       (2 * (3 * cdg101(m) * cdg200(m) + 3 * cdg100(m) * cdg201(m) +
+             cdg001(m) * cdg300(m) + cdg000(m) * cdg301(m))));
     deriv130 +=
       (m_occno(m) *
-       (2 * (m_cdg030(m) * m_cdg100(m) + 3 * m_cdg020(m) * m_cdg110(m) +
-             3 * m_cdg010(m) * m_cdg120(m) + m_cdg000(m) * m_cdg130(m))));
+       (2 * (cdg030(m) * cdg100(m) + 3 * cdg020(m) * cdg110(m) +
+             3 * cdg010(m) * cdg120(m) + cdg000(m) * cdg130(m))));
     deriv031 +=
       (m_occno(m) *
-       (2 * (3 * m_cdg011(m) * m_cdg020(m) + 3 * m_cdg010(m) * m_cdg021(m) +
-             m_cdg001(m) * m_cdg030(m) + m_cdg000(m) * m_cdg031(m))));
+       (2 * (3 * cdg011(m) * cdg020(m) + 3 * cdg010(m) * cdg021(m) +
+             cdg001(m) * cdg030(m) + cdg000(m) * cdg031(m))));
     deriv103 +=
       (m_occno(m) *
-       (2 * (m_cdg003(m) * m_cdg100(m) + 3 * m_cdg002(m) * m_cdg101(m) +
-             3 * m_cdg001(m) * m_cdg102(m) + m_cdg000(m) * m_cdg103(m))));
+       (2 * (cdg003(m) * cdg100(m) + 3 * cdg002(m) * cdg101(m) +
+             3 * cdg001(m) * cdg102(m) + cdg000(m) * cdg103(m))));
     deriv013 +=
       (m_occno(m) *
-       (2 * (m_cdg003(m) * m_cdg010(m) + 3 * m_cdg002(m) * m_cdg011(m) +
-             3 * m_cdg001(m) * m_cdg012(m) + m_cdg000(m) * m_cdg013(m))));
+       (2 * (cdg003(m) * cdg010(m) + 3 * cdg002(m) * cdg011(m) +
+             3 * cdg001(m) * cdg012(m) + cdg000(m) * cdg013(m))));
     deriv220 +=
       (m_occno(m) *
-       (2 * (2 * ipow(m_cdg110(m), 2) + 2 * m_cdg100(m) * m_cdg120(m) +
-             m_cdg020(m) * m_cdg200(m) + 2 * m_cdg010(m) * m_cdg210(m) +
-             m_cdg000(m) * m_cdg220(m))));
+       (2 * (2 * ipow(cdg110(m), 2) + 2 * cdg100(m) * cdg120(m) +
+             cdg020(m) * cdg200(m) + 2 * cdg010(m) * cdg210(m) +
+             cdg000(m) * cdg220(m))));
     deriv202 +=
       (m_occno(m) *
-       (2 * (2 * ipow(m_cdg101(m), 2) + 2 * m_cdg100(m) * m_cdg102(m) +
-             m_cdg002(m) * m_cdg200(m) + 2 * m_cdg001(m) * m_cdg201(m) +
-             m_cdg000(m) * m_cdg202(m))));
+       (2 * (2 * ipow(cdg101(m), 2) + 2 * cdg100(m) * cdg102(m) +
+             cdg002(m) * cdg200(m) + 2 * cdg001(m) * cdg201(m) +
+             cdg000(m) * cdg202(m))));
     deriv022 +=
       (m_occno(m) *
-       (2 * (2 * ipow(m_cdg011(m), 2) + 2 * m_cdg010(m) * m_cdg012(m) +
-             m_cdg002(m) * m_cdg020(m) + 2 * m_cdg001(m) * m_cdg021(m) +
-             m_cdg000(m) * m_cdg022(m))));
+       (2 * (2 * ipow(cdg011(m), 2) + 2 * cdg010(m) * cdg012(m) +
+             cdg002(m) * cdg020(m) + 2 * cdg001(m) * cdg021(m) +
+             cdg000(m) * cdg022(m))));
     deriv211 +=
       (m_occno(m) *
-       (2 * (2 * m_cdg101(m) * m_cdg110(m) + 2 * m_cdg100(m) * m_cdg111(m) +
-             m_cdg011(m) * m_cdg200(m) + m_cdg010(m) * m_cdg201(m) +
-             m_cdg001(m) * m_cdg210(m) + m_cdg000(m) * m_cdg211(m))));
+       (2 * (2 * cdg101(m) * cdg110(m) + 2 * cdg100(m) * cdg111(m) +
+             cdg011(m) * cdg200(m) + cdg010(m) * cdg201(m) +
+             cdg001(m) * cdg210(m) + cdg000(m) * cdg211(m))));
     deriv121 +=
       (m_occno(m) *
-       (2 * (m_cdg021(m) * m_cdg100(m) + m_cdg020(m) * m_cdg101(m) +
-             2 * m_cdg011(m) * m_cdg110(m) + 2 * m_cdg010(m) * m_cdg111(m) +
-             m_cdg001(m) * m_cdg120(m) + m_cdg000(m) * m_cdg121(m))));
+       (2 * (cdg021(m) * cdg100(m) + cdg020(m) * cdg101(m) +
+             2 * cdg011(m) * cdg110(m) + 2 * cdg010(m) * cdg111(m) +
+             cdg001(m) * cdg120(m) + cdg000(m) * cdg121(m))));
     deriv112 +=
       (m_occno(m) *
-       (2 * (m_cdg012(m) * m_cdg100(m) + 2 * m_cdg011(m) * m_cdg101(m) +
-             m_cdg010(m) * m_cdg102(m) + m_cdg002(m) * m_cdg110(m) +
-             2 * m_cdg001(m) * m_cdg111(m) + m_cdg000(m) * m_cdg112(m))));
+       (2 * (cdg012(m) * cdg100(m) + 2 * cdg011(m) * cdg101(m) +
+             cdg010(m) * cdg102(m) + cdg002(m) * cdg110(m) +
+             2 * cdg001(m) * cdg111(m) + cdg000(m) * cdg112(m))));
   }
 
   value(0, 0) = deriv400 + deriv220 + deriv202;
@@ -1373,7 +1442,7 @@ QTAIMWavefunctionEvaluator::hessianOfElectronDensityLaplacian(
 
 const Matrix<qreal, 3, 4>
 QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
-  const Matrix<qreal, 3, 1> xyz)
+  const Matrix<qreal, 3, 1> xyz) const
 {
 
   Matrix<qreal, 3, 1> gValue;
@@ -1383,43 +1452,45 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg100.setZero();
-  m_cdg010.setZero();
-  m_cdg001.setZero();
-  m_cdg200.setZero();
-  m_cdg020.setZero();
-  m_cdg002.setZero();
-  m_cdg110.setZero();
-  m_cdg101.setZero();
-  m_cdg011.setZero();
-  m_cdg300.setZero();
-  m_cdg120.setZero();
-  m_cdg102.setZero();
-  m_cdg210.setZero();
-  m_cdg030.setZero();
-  m_cdg012.setZero();
-  m_cdg201.setZero();
-  m_cdg021.setZero();
-  m_cdg003.setZero();
-  m_cdg111.setZero();
-  m_cdg400.setZero();
-  m_cdg040.setZero();
-  m_cdg004.setZero();
-  m_cdg310.setZero();
-  m_cdg301.setZero();
-  m_cdg130.setZero();
-  m_cdg031.setZero();
-  m_cdg103.setZero();
-  m_cdg013.setZero();
-  m_cdg220.setZero();
-  m_cdg202.setZero();
-  m_cdg022.setZero();
-  m_cdg211.setZero();
-  m_cdg121.setZero();
-  m_cdg112.setZero();
-
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg100(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg010(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg001(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg200(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg020(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg002(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg110(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg101(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg011(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg300(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg120(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg102(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg210(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg030(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg012(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg201(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg021(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg003(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg111(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg400(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg040(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg004(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg310(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg301(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg130(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg031(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg103(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg013(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg220(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg202(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg022(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg211(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg121(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg112(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -1646,43 +1717,41 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
       qreal dg112 = b0 * (ax1 + ax0 * bx1) * (ay1 + ay0 * by1) *
                     (az2 + 2 * az1 * bz1 + az0 * bz2);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-        m_cdg300(m) += m_coef(m, p) * dg300;
-        m_cdg030(m) += m_coef(m, p) * dg030;
-        m_cdg003(m) += m_coef(m, p) * dg003;
-        m_cdg210(m) += m_coef(m, p) * dg210;
-        m_cdg201(m) += m_coef(m, p) * dg201;
-        m_cdg120(m) += m_coef(m, p) * dg120;
-        m_cdg021(m) += m_coef(m, p) * dg021;
-        m_cdg102(m) += m_coef(m, p) * dg102;
-        m_cdg012(m) += m_coef(m, p) * dg012;
-        m_cdg111(m) += m_coef(m, p) * dg111;
-        m_cdg400(m) += m_coef(m, p) * dg400;
-        m_cdg040(m) += m_coef(m, p) * dg040;
-        m_cdg004(m) += m_coef(m, p) * dg004;
-        m_cdg310(m) += m_coef(m, p) * dg310;
-        m_cdg301(m) += m_coef(m, p) * dg301;
-        m_cdg130(m) += m_coef(m, p) * dg130;
-        m_cdg031(m) += m_coef(m, p) * dg031;
-        m_cdg103(m) += m_coef(m, p) * dg103;
-        m_cdg013(m) += m_coef(m, p) * dg013;
-        m_cdg220(m) += m_coef(m, p) * dg220;
-        m_cdg202(m) += m_coef(m, p) * dg202;
-        m_cdg022(m) += m_coef(m, p) * dg022;
-        m_cdg211(m) += m_coef(m, p) * dg211;
-        m_cdg121(m) += m_coef(m, p) * dg121;
-        m_cdg112(m) += m_coef(m, p) * dg112;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg100 += dg100 * m_coef.col(p);
+      cdg010 += dg010 * m_coef.col(p);
+      cdg001 += dg001 * m_coef.col(p);
+      cdg200 += dg200 * m_coef.col(p);
+      cdg020 += dg020 * m_coef.col(p);
+      cdg002 += dg002 * m_coef.col(p);
+      cdg110 += dg110 * m_coef.col(p);
+      cdg101 += dg101 * m_coef.col(p);
+      cdg011 += dg011 * m_coef.col(p);
+      cdg300 += dg300 * m_coef.col(p);
+      cdg030 += dg030 * m_coef.col(p);
+      cdg003 += dg003 * m_coef.col(p);
+      cdg210 += dg210 * m_coef.col(p);
+      cdg201 += dg201 * m_coef.col(p);
+      cdg120 += dg120 * m_coef.col(p);
+      cdg021 += dg021 * m_coef.col(p);
+      cdg102 += dg102 * m_coef.col(p);
+      cdg012 += dg012 * m_coef.col(p);
+      cdg111 += dg111 * m_coef.col(p);
+      cdg400 += dg400 * m_coef.col(p);
+      cdg040 += dg040 * m_coef.col(p);
+      cdg004 += dg004 * m_coef.col(p);
+      cdg310 += dg310 * m_coef.col(p);
+      cdg301 += dg301 * m_coef.col(p);
+      cdg130 += dg130 * m_coef.col(p);
+      cdg031 += dg031 * m_coef.col(p);
+      cdg103 += dg103 * m_coef.col(p);
+      cdg013 += dg013 * m_coef.col(p);
+      cdg220 += dg220 * m_coef.col(p);
+      cdg202 += dg202 * m_coef.col(p);
+      cdg022 += dg022 * m_coef.col(p);
+      cdg211 += dg211 * m_coef.col(p);
+      cdg121 += dg121 * m_coef.col(p);
+      cdg112 += dg112 * m_coef.col(p);
     }
   }
 
@@ -1711,96 +1780,96 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
   qreal deriv121 = zero;
   qreal deriv112 = zero;
   for (qint64 m = 0; m < m_nmo; ++m) {
-    deriv300 += (m_occno(m) * (6 * m_cdg100(m) * m_cdg200(m) +
-                               2 * m_cdg000(m) * m_cdg300(m)));
-    deriv030 += (m_occno(m) * (6 * m_cdg010(m) * m_cdg020(m) +
-                               2 * m_cdg000(m) * m_cdg030(m)));
-    deriv003 += (m_occno(m) * (6 * m_cdg001(m) * m_cdg002(m) +
-                               2 * m_cdg000(m) * m_cdg003(m)));
+    deriv300 += (m_occno(m) * (6 * cdg100(m) * cdg200(m) +
+                               2 * cdg000(m) * cdg300(m)));
+    deriv030 += (m_occno(m) * (6 * cdg010(m) * cdg020(m) +
+                               2 * cdg000(m) * cdg030(m)));
+    deriv003 += (m_occno(m) * (6 * cdg001(m) * cdg002(m) +
+                               2 * cdg000(m) * cdg003(m)));
     deriv210 += (m_occno(m) *
-                 (2 * (2 * m_cdg100(m) * m_cdg110(m) +
-                       m_cdg010(m) * m_cdg200(m) + m_cdg000(m) * m_cdg210(m))));
+                 (2 * (2 * cdg100(m) * cdg110(m) +
+                       cdg010(m) * cdg200(m) + cdg000(m) * cdg210(m))));
     deriv201 += (m_occno(m) *
-                 (2 * (2 * m_cdg100(m) * m_cdg101(m) +
-                       m_cdg001(m) * m_cdg200(m) + m_cdg000(m) * m_cdg201(m))));
-    deriv120 += (m_occno(m) * (2 * (m_cdg020(m) * m_cdg100(m) +
-                                    2 * m_cdg010(m) * m_cdg110(m) +
-                                    m_cdg000(m) * m_cdg120(m))));
+                 (2 * (2 * cdg100(m) * cdg101(m) +
+                       cdg001(m) * cdg200(m) + cdg000(m) * cdg201(m))));
+    deriv120 += (m_occno(m) * (2 * (cdg020(m) * cdg100(m) +
+                                    2 * cdg010(m) * cdg110(m) +
+                                    cdg000(m) * cdg120(m))));
     deriv021 += (m_occno(m) *
-                 (2 * (2 * m_cdg010(m) * m_cdg011(m) +
-                       m_cdg001(m) * m_cdg020(m) + m_cdg000(m) * m_cdg021(m))));
-    deriv102 += (m_occno(m) * (2 * (m_cdg002(m) * m_cdg100(m) +
-                                    2 * m_cdg001(m) * m_cdg101(m) +
-                                    m_cdg000(m) * m_cdg102(m))));
-    deriv012 += (m_occno(m) * (2 * (m_cdg002(m) * m_cdg010(m) +
-                                    2 * m_cdg001(m) * m_cdg011(m) +
-                                    m_cdg000(m) * m_cdg012(m))));
+                 (2 * (2 * cdg010(m) * cdg011(m) +
+                       cdg001(m) * cdg020(m) + cdg000(m) * cdg021(m))));
+    deriv102 += (m_occno(m) * (2 * (cdg002(m) * cdg100(m) +
+                                    2 * cdg001(m) * cdg101(m) +
+                                    cdg000(m) * cdg102(m))));
+    deriv012 += (m_occno(m) * (2 * (cdg002(m) * cdg010(m) +
+                                    2 * cdg001(m) * cdg011(m) +
+                                    cdg000(m) * cdg012(m))));
     // deriv111+=(m_occno(m)*(
-    // 2*(m_cdg011(m)*m_cdg100(m)+m_cdg010(m)*m_cdg101(m)+m_cdg001(m)*m_cdg110(m)+m_cdg000(m)*m_cdg111(m))
+    // 2*(cdg011(m)*cdg100(m)+cdg010(m)*cdg101(m)+cdg001(m)*cdg110(m)+cdg000(m)*cdg111(m))
     // ));
     deriv400 +=
-      (m_occno(m) * (6 * ipow(m_cdg200(m), 2) + 8 * m_cdg100(m) * m_cdg300(m) +
-                     2 * m_cdg000(m) * m_cdg400(m)));
+      (m_occno(m) * (6 * ipow(cdg200(m), 2) + 8 * cdg100(m) * cdg300(m) +
+                     2 * cdg000(m) * cdg400(m)));
     deriv040 +=
-      (m_occno(m) * (6 * ipow(m_cdg020(m), 2) + 8 * m_cdg010(m) * m_cdg030(m) +
-                     2 * m_cdg000(m) * m_cdg040(m)));
+      (m_occno(m) * (6 * ipow(cdg020(m), 2) + 8 * cdg010(m) * cdg030(m) +
+                     2 * cdg000(m) * cdg040(m)));
     deriv004 +=
-      (m_occno(m) * (6 * ipow(m_cdg002(m), 2) + 8 * m_cdg001(m) * m_cdg003(m) +
-                     2 * m_cdg000(m) * m_cdg004(m)));
+      (m_occno(m) * (6 * ipow(cdg002(m), 2) + 8 * cdg001(m) * cdg003(m) +
+                     2 * cdg000(m) * cdg004(m)));
     deriv310 +=
       (m_occno(m) *
-       (2 * (3 * m_cdg110(m) * m_cdg200(m) + 3 * m_cdg100(m) * m_cdg210(m) +
-             m_cdg010(m) * m_cdg300(m) + m_cdg000(m) * m_cdg310(m))));
+       (2 * (3 * cdg110(m) * cdg200(m) + 3 * cdg100(m) * cdg210(m) +
+             cdg010(m) * cdg300(m) + cdg000(m) * cdg310(m))));
     deriv301 +=
       (m_occno(m) *
-       (2 * (3 * m_cdg101(m) * m_cdg200(m) + 3 * m_cdg100(m) * m_cdg201(m) +
-             m_cdg001(m) * m_cdg300(m) + m_cdg000(m) * m_cdg301(m))));
+       (2 * (3 * cdg101(m) * cdg200(m) + 3 * cdg100(m) * cdg201(m) +
+             cdg001(m) * cdg300(m) + cdg000(m) * cdg301(m))));
     deriv130 +=
       (m_occno(m) *
-       (2 * (m_cdg030(m) * m_cdg100(m) + 3 * m_cdg020(m) * m_cdg110(m) +
-             3 * m_cdg010(m) * m_cdg120(m) + m_cdg000(m) * m_cdg130(m))));
+       (2 * (cdg030(m) * cdg100(m) + 3 * cdg020(m) * cdg110(m) +
+             3 * cdg010(m) * cdg120(m) + cdg000(m) * cdg130(m))));
     deriv031 +=
       (m_occno(m) *
-       (2 * (3 * m_cdg011(m) * m_cdg020(m) + 3 * m_cdg010(m) * m_cdg021(m) +
-             m_cdg001(m) * m_cdg030(m) + m_cdg000(m) * m_cdg031(m))));
+       (2 * (3 * cdg011(m) * cdg020(m) + 3 * cdg010(m) * cdg021(m) +
+             cdg001(m) * cdg030(m) + cdg000(m) * cdg031(m))));
     deriv103 +=
       (m_occno(m) *
-       (2 * (m_cdg003(m) * m_cdg100(m) + 3 * m_cdg002(m) * m_cdg101(m) +
-             3 * m_cdg001(m) * m_cdg102(m) + m_cdg000(m) * m_cdg103(m))));
+       (2 * (cdg003(m) * cdg100(m) + 3 * cdg002(m) * cdg101(m) +
+             3 * cdg001(m) * cdg102(m) + cdg000(m) * cdg103(m))));
     deriv013 +=
       (m_occno(m) *
-       (2 * (m_cdg003(m) * m_cdg010(m) + 3 * m_cdg002(m) * m_cdg011(m) +
-             3 * m_cdg001(m) * m_cdg012(m) + m_cdg000(m) * m_cdg013(m))));
+       (2 * (cdg003(m) * cdg010(m) + 3 * cdg002(m) * cdg011(m) +
+             3 * cdg001(m) * cdg012(m) + cdg000(m) * cdg013(m))));
     deriv220 +=
       (m_occno(m) *
-       (2 * (2 * ipow(m_cdg110(m), 2) + 2 * m_cdg100(m) * m_cdg120(m) +
-             m_cdg020(m) * m_cdg200(m) + 2 * m_cdg010(m) * m_cdg210(m) +
-             m_cdg000(m) * m_cdg220(m))));
+       (2 * (2 * ipow(cdg110(m), 2) + 2 * cdg100(m) * cdg120(m) +
+             cdg020(m) * cdg200(m) + 2 * cdg010(m) * cdg210(m) +
+             cdg000(m) * cdg220(m))));
     deriv202 +=
       (m_occno(m) *
-       (2 * (2 * ipow(m_cdg101(m), 2) + 2 * m_cdg100(m) * m_cdg102(m) +
-             m_cdg002(m) * m_cdg200(m) + 2 * m_cdg001(m) * m_cdg201(m) +
-             m_cdg000(m) * m_cdg202(m))));
+       (2 * (2 * ipow(cdg101(m), 2) + 2 * cdg100(m) * cdg102(m) +
+             cdg002(m) * cdg200(m) + 2 * cdg001(m) * cdg201(m) +
+             cdg000(m) * cdg202(m))));
     deriv022 +=
       (m_occno(m) *
-       (2 * (2 * ipow(m_cdg011(m), 2) + 2 * m_cdg010(m) * m_cdg012(m) +
-             m_cdg002(m) * m_cdg020(m) + 2 * m_cdg001(m) * m_cdg021(m) +
-             m_cdg000(m) * m_cdg022(m))));
+       (2 * (2 * ipow(cdg011(m), 2) + 2 * cdg010(m) * cdg012(m) +
+             cdg002(m) * cdg020(m) + 2 * cdg001(m) * cdg021(m) +
+             cdg000(m) * cdg022(m))));
     deriv211 +=
       (m_occno(m) *
-       (2 * (2 * m_cdg101(m) * m_cdg110(m) + 2 * m_cdg100(m) * m_cdg111(m) +
-             m_cdg011(m) * m_cdg200(m) + m_cdg010(m) * m_cdg201(m) +
-             m_cdg001(m) * m_cdg210(m) + m_cdg000(m) * m_cdg211(m))));
+       (2 * (2 * cdg101(m) * cdg110(m) + 2 * cdg100(m) * cdg111(m) +
+             cdg011(m) * cdg200(m) + cdg010(m) * cdg201(m) +
+             cdg001(m) * cdg210(m) + cdg000(m) * cdg211(m))));
     deriv121 +=
       (m_occno(m) *
-       (2 * (m_cdg021(m) * m_cdg100(m) + m_cdg020(m) * m_cdg101(m) +
-             2 * m_cdg011(m) * m_cdg110(m) + 2 * m_cdg010(m) * m_cdg111(m) +
-             m_cdg001(m) * m_cdg120(m) + m_cdg000(m) * m_cdg121(m))));
+       (2 * (cdg021(m) * cdg100(m) + cdg020(m) * cdg101(m) +
+             2 * cdg011(m) * cdg110(m) + 2 * cdg010(m) * cdg111(m) +
+             cdg001(m) * cdg120(m) + cdg000(m) * cdg121(m))));
     deriv112 +=
       (m_occno(m) *
-       (2 * (m_cdg012(m) * m_cdg100(m) + 2 * m_cdg011(m) * m_cdg101(m) +
-             m_cdg010(m) * m_cdg102(m) + m_cdg002(m) * m_cdg110(m) +
-             2 * m_cdg001(m) * m_cdg111(m) + m_cdg000(m) * m_cdg112(m))));
+       (2 * (cdg012(m) * cdg100(m) + 2 * cdg011(m) * cdg101(m) +
+             cdg010(m) * cdg102(m) + cdg002(m) * cdg110(m) +
+             2 * cdg001(m) * cdg111(m) + cdg000(m) * cdg112(m))));
   }
 
   gValue(0) = deriv300 + deriv120 + deriv102;
@@ -1833,7 +1902,8 @@ QTAIMWavefunctionEvaluator::gradientAndHessianOfElectronDensityLaplacian(
   return value;
 }
 
-qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityG(Matrix<qreal, 3, 1> xyz)
+qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityG(
+  Matrix<qreal, 3, 1> xyz) const
 {
 
   qreal value;
@@ -1841,11 +1911,13 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityG(Matrix<qreal, 3, 1> xyz)
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg100.setZero();
-  m_cdg010.setZero();
-  m_cdg001.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg100(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg010(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg001(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -1902,27 +1974,25 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityG(Matrix<qreal, 3, 1> xyz)
       qreal dg010 = ax0 * az0 * b0 * (ay1 + ay0 * by1);
       qreal dg001 = ax0 * ay0 * b0 * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg100 += dg100 * m_coef.col(p);
+      cdg010 += dg010 * m_coef.col(p);
+      cdg001 += dg001 * m_coef.col(p);
     }
   }
 
   value = zero;
   for (qint64 m = 0; m < m_nmo; ++m) {
     value +=
-      (0.5) * (m_occno(m) * (ipow(m_cdg100(m), 2) + ipow(m_cdg010(m), 2) +
-                             ipow(m_cdg001(m), 2)));
+      (0.5) * (m_occno(m) * (ipow(cdg100(m), 2) + ipow(cdg010(m), 2) +
+                             ipow(cdg001(m), 2)));
   }
 
   return value;
 }
 
 qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
-  const Matrix<qreal, 3, 1> xyz)
+  const Matrix<qreal, 3, 1> xyz) const
 {
 
   qreal value;
@@ -1930,11 +2000,13 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg200.setZero();
-  m_cdg020.setZero();
-  m_cdg002.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg200(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg020(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg002(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -2024,12 +2096,10 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
       qreal dg020 = ax0 * az0 * b0 * (ay2 + 2 * ay1 * by1 + ay0 * by2);
       qreal dg002 = ax0 * ay0 * b0 * (az2 + 2 * az1 * bz1 + az0 * bz2);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg200 += dg200 * m_coef.col(p);
+      cdg020 += dg020 * m_coef.col(p);
+      cdg002 += dg002 * m_coef.col(p);
     }
   }
 
@@ -2037,14 +2107,14 @@ qreal QTAIMWavefunctionEvaluator::kineticEnergyDensityK(
   for (qint64 m = 0; m < m_nmo; ++m) {
     value +=
       (0.25) * (m_occno(m) *
-                (2 * m_cdg000(m) * (m_cdg200(m) + m_cdg020(m) + m_cdg002(m))));
+                (2 * cdg000(m) * (cdg200(m) + cdg020(m) + cdg002(m))));
   }
 
   return value;
 }
 
 const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
-  const Matrix<qreal, 3, 1> xyz)
+  const Matrix<qreal, 3, 1> xyz) const
 {
 
   Matrix<qreal, 3, 3> value;
@@ -2052,17 +2122,19 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
   const qreal zero = 0.0;
   const qreal one = 1.0;
 
-  m_cdg000.setZero();
-  m_cdg100.setZero();
-  m_cdg010.setZero();
-  m_cdg001.setZero();
-  m_cdg200.setZero();
-  m_cdg020.setZero();
-  m_cdg002.setZero();
-  m_cdg110.setZero();
-  m_cdg101.setZero();
-  m_cdg011.setZero();
-  for (qint64 p = 0; p < m_nprim; ++p) {
+  Matrix<qreal, Dynamic, 1> cdg000(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg100(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg010(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg001(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg200(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg020(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg002(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg110(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg101(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  Matrix<qreal, Dynamic, 1> cdg011(Matrix<qreal, Dynamic, 1>::Zero(m_nmo));
+  const std::vector<qint64> primitives = screenedPrimitives(xyz);
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const qint64 p = primitives[i];
     qreal xx0 = xyz(0) - m_X0(p);
     qreal yy0 = xyz(1) - m_Y0(p);
     qreal zz0 = xyz(2) - m_Z0(p);
@@ -2158,35 +2230,33 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
       qreal dg101 = ay0 * b0 * (ax1 + ax0 * bx1) * (az1 + az0 * bz1);
       qreal dg011 = ax0 * b0 * (ay1 + ay0 * by1) * (az1 + az0 * bz1);
 
-      for (qint64 m = 0; m < m_nmo; ++m) {
-        m_cdg000(m) += m_coef(m, p) * dg000;
-        m_cdg100(m) += m_coef(m, p) * dg100;
-        m_cdg010(m) += m_coef(m, p) * dg010;
-        m_cdg001(m) += m_coef(m, p) * dg001;
-        m_cdg200(m) += m_coef(m, p) * dg200;
-        m_cdg020(m) += m_coef(m, p) * dg020;
-        m_cdg002(m) += m_coef(m, p) * dg002;
-        m_cdg110(m) += m_coef(m, p) * dg110;
-        m_cdg101(m) += m_coef(m, p) * dg101;
-        m_cdg011(m) += m_coef(m, p) * dg011;
-      }
+      cdg000 += dg000 * m_coef.col(p);
+      cdg100 += dg100 * m_coef.col(p);
+      cdg010 += dg010 * m_coef.col(p);
+      cdg001 += dg001 * m_coef.col(p);
+      cdg200 += dg200 * m_coef.col(p);
+      cdg020 += dg020 * m_coef.col(p);
+      cdg002 += dg002 * m_coef.col(p);
+      cdg110 += dg110 * m_coef.col(p);
+      cdg101 += dg101 * m_coef.col(p);
+      cdg011 += dg011 * m_coef.col(p);
     }
   }
 
   value.setZero();
   for (qint64 m = 0; m < m_nmo; ++m) {
     value(0, 0) +=
-      (m_occno(m) * (2 * m_cdg000(m) * m_cdg200(m) - 2 * ipow(m_cdg100(m), 2)));
-    value(0, 1) += (m_occno(m) * (2 * m_cdg000(m) * m_cdg110(m) -
-                                  2 * m_cdg100(m) * m_cdg010(m)));
-    value(0, 2) += (m_occno(m) * (2 * m_cdg000(m) * m_cdg101(m) -
-                                  2 * m_cdg100(m) * m_cdg001(m)));
+      (m_occno(m) * (2 * cdg000(m) * cdg200(m) - 2 * ipow(cdg100(m), 2)));
+    value(0, 1) += (m_occno(m) * (2 * cdg000(m) * cdg110(m) -
+                                  2 * cdg100(m) * cdg010(m)));
+    value(0, 2) += (m_occno(m) * (2 * cdg000(m) * cdg101(m) -
+                                  2 * cdg100(m) * cdg001(m)));
     value(1, 1) +=
-      (m_occno(m) * (2 * m_cdg000(m) * m_cdg020(m) - 2 * ipow(m_cdg010(m), 2)));
-    value(1, 2) += (m_occno(m) * (2 * m_cdg000(m) * m_cdg011(m) -
-                                  2 * m_cdg010(m) * m_cdg001(m)));
+      (m_occno(m) * (2 * cdg000(m) * cdg020(m) - 2 * ipow(cdg010(m), 2)));
+    value(1, 2) += (m_occno(m) * (2 * cdg000(m) * cdg011(m) -
+                                  2 * cdg010(m) * cdg001(m)));
     value(2, 2) +=
-      (m_occno(m) * (2 * m_cdg000(m) * m_cdg002(m) - 2 * ipow(m_cdg001(m), 2)));
+      (m_occno(m) * (2 * cdg000(m) * cdg002(m) - 2 * ipow(cdg001(m), 2)));
   }
   value(1, 0) = value(0, 1);
   value(2, 0) = value(0, 2);
@@ -2195,5 +2265,138 @@ const Matrix<qreal, 3, 3> QTAIMWavefunctionEvaluator::quantumStressTensor(
   return 0.25 * value;
 }
 
+void QTAIMWavefunctionEvaluator::contractedPrimitives(
+  const Matrix<qreal, 3, Dynamic>& xyz, qint64 first, qint64 npts, int order,
+  std::vector<Matrix<qreal, Dynamic, Dynamic>>& cdg) const
+{
+  const int count = order < 1 ? 1 : (order < 2 ? 4 : 7);
+
+  // Only the primitives that matter at one of the points take part in the
+  // contraction, each gets a row of dg.
+  std::vector<std::vector<qint64>> screened(npts);
+  std::vector<qint64> row(m_nprim, -1);
+  std::vector<qint64> active;
+  for (qint64 n = 0; n < npts; ++n) {
+    screened[n] = screenedPrimitives(xyz.col(first + n));
+    for (size_t i = 0; i < screened[n].size(); ++i) {
+      const qint64 p = screened[n][i];
+      if (row[p] < 0) {
+        row[p] = static_cast<qint64>(active.size());
+        active.push_back(p);
+      }
+    }
+  }
+
+  std::vector<Matrix<qreal, Dynamic, Dynamic>> dg(
+    count, Matrix<qreal, Dynamic, Dynamic>::Zero(active.size(), npts));
+  for (qint64 n = 0; n < npts; ++n) {
+    const Matrix<qreal, 3, 1> point = xyz.col(first + n);
+    const std::vector<qint64>& primitives = screened[n];
+    for (size_t i = 0; i < primitives.size(); ++i) {
+      const qint64 p = primitives[i];
+      const qint64 r = row[p];
+      const qreal xx0 = point(0) - m_X0(p);
+      const qreal yy0 = point(1) - m_Y0(p);
+      const qreal zz0 = point(2) - m_Z0(p);
+
+      const qreal b0 =
+        exp(-m_alpha(p) * (xx0 * xx0 + yy0 * yy0 + zz0 * zz0));
+      const qreal ax0 = ipow(xx0, m_xamom(p));
+      const qreal ay0 = ipow(yy0, m_yamom(p));
+      const qreal az0 = ipow(zz0, m_zamom(p));
+      dg[0](r, n) = ax0 * ay0 * az0 * b0;
+      if (order < 1)
+        continue;
+
+      const qreal ax1 = angularDerivative(xx0, m_xamom(p), 1);
+      const qreal ay1 = angularDerivative(yy0, m_yamom(p), 1);
+      const qreal az1 = angularDerivative(zz0, m_zamom(p), 1);
+      const qreal bx1 = -2 * m_alpha(p) * xx0;
+      const qreal by1 = -2 * m_alpha(p) * yy0;
+      const qreal bz1 = -2 * m_alpha(p) * zz0;
+      dg[1](r, n) = ay0 * az0 * b0 * (ax1 + ax0 * bx1);
+      dg[2](r, n) = ax0 * az0 * b0 * (ay1 + ay0 * by1);
+      dg[3](r, n) = ax0 * ay0 * b0 * (az1 + az0 * bz1);
+      if (order < 2)
+        continue;
+
+      const qreal ax2 = angularDerivative(xx0, m_xamom(p), 2);
+      const qreal ay2 = angularDerivative(yy0, m_yamom(p), 2);
+      const qreal az2 = angularDerivative(zz0, m_zamom(p), 2);
+      const qreal bx2 = -2 * m_alpha(p) + 4 * (ipow(m_alpha(p), 2) * xx0 * xx0);
+      const qreal by2 = -2 * m_alpha(p) + 4 * (ipow(m_alpha(p), 2) * yy0 * yy0);
+      const qreal bz2 = -2 * m_alpha(p) + 4 * (ipow(m_alpha(p), 2) * zz0 * zz0);
+      dg[4](r, n) = ay0 * az0 * b0 * (ax2 + 2 * ax1 * bx1 + ax0 * bx2);
+      dg[5](r, n) = ax0 * az0 * b0 * (ay2 + 2 * ay1 * by1 + ay0 * by2);
+      dg[6](r, n) = ax0 * ay0 * b0 * (az2 + 2 * az1 * bz1 + az0 * bz2);
+    }
+  }
+
+  Matrix<qreal, Dynamic, Dynamic> coef(m_nmo, active.size());
+  for (size_t r = 0; r < active.size(); ++r)
+    coef.col(r) = m_coef.col(active[r]);
+  cdg.resize(count);
+  for (int k = 0; k < count; ++k)
+    cdg[k].noalias() = coef * dg[k];
+}
+
+const Matrix<qreal, Dynamic, 1> QTAIMWavefunctionEvaluator::electronDensities(
+  const Matrix<qreal, 3, Dynamic>& xyz) const
+{
+  Matrix<qreal, Dynamic, 1> value(xyz.cols());
+  std::vector<Matrix<qreal, Dynamic, Dynamic>> cdg;
+  for (qint64 first = 0; first < xyz.cols(); first += m_blockSize) {
+    const qint64 npts = std::min<qint64>(m_blockSize, xyz.cols() - first);
+    contractedPrimitives(xyz, first, npts, 0, cdg);
+    value.segment(first, npts) =
+      (cdg[0].array().square().colwise() * m_occno.array())
+        .colwise()
+        .sum()
+        .transpose();
+  }
+
+  return value;
+}
+
+const Matrix<qreal, 3, Dynamic>
+QTAIMWavefunctionEvaluator::gradientsOfElectronDensity(
+  const Matrix<qreal, 3, Dynamic>& xyz) const
+{
+  Matrix<qreal, 3, Dynamic> value(3, xyz.cols());
+  std::vector<Matrix<qreal, Dynamic, Dynamic>> cdg;
+  for (qint64 first = 0; first < xyz.cols(); first += m_blockSize) {
+    const qint64 npts = std::min<qint64>(m_blockSize, xyz.cols() - first);
+    contractedPrimitives(xyz, first, npts, 1, cdg);
+    const Array<qreal, Dynamic, Dynamic> weighted =
+      cdg[0].array().colwise() * m_occno.array();
+    for (int k = 0; k < 3; ++k) {
+      value.block(k, first, 1, npts) =
+        (weighted * cdg[k + 1].array()).colwise().sum();
+    }
+  }
+
+  return value;
+}
+
+const Matrix<qreal, Dynamic, 1>
+QTAIMWavefunctionEvaluator::laplaciansOfElectronDensity(
+  const Matrix<qreal, 3, Dynamic>& xyz) const
+{
+  Matrix<qreal, Dynamic, 1> value(xyz.cols());
+  std::vector<Matrix<qreal, Dynamic, Dynamic>> cdg;
+  for (qint64 first = 0; first < xyz.cols(); first += m_blockSize) {
+    const qint64 npts = std::min<qint64>(m_blockSize, xyz.cols() - first);
+    contractedPrimitives(xyz, first, npts, 2, cdg);
+    Array<qreal, Dynamic, Dynamic> sum =
+      Array<qreal, Dynamic, Dynamic>::Zero(m_nmo, npts);
+    for (int k = 1; k < 4; ++k)
+      sum += cdg[k].array().square() + cdg[0].array() * cdg[k + 3].array();
+    value.segment(first, npts) =
+      2 * (sum.colwise() * m_occno.array()).colwise().sum().transpose();
+  }
+
+  return value;
+}
+
 } // namespace QtPlugins
 } // namespace Avogadro
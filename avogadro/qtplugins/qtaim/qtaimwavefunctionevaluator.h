@@ -21,6 +21,10 @@
 
 #include <Eigen/Core>
 
+#include <QVariant>
+
+#include <vector>
+
 using namespace Eigen;
 
 namespace Avogadro {
@@ -28,37 +32,61 @@ namespace QtPlugins {
 
 class QTAIMWavefunction;
 
+// The evaluator copies what it needs from the wavefunction and keeps no
+// scratch state, so one instance can be shared by any number of threads.
+// The wavefunction must outlive the evaluator.
 class QTAIMWavefunctionEvaluator
 {
 public:
   EIGEN_MAKE_ALIGNED_OPERATOR_NEW
 
-  explicit QTAIMWavefunctionEvaluator(QTAIMWavefunction& wfn);
+  explicit QTAIMWavefunctionEvaluator(const QTAIMWavefunction& wfn);
+
+  const QTAIMWavefunction& wavefunction() const { return *m_wfn; }
 
-  qreal molecularOrbital(const qint64 mo, const Matrix<qreal, 3, 1> xyz);
-  qreal electronDensity(const Matrix<qreal, 3, 1> xyz);
+  // QtConcurrent tasks receive the shared evaluator as the first element of
+  // their QVariant list. The pointer is stored with its own metatype, so a
+  // variant holding anything else is caught rather than reinterpreted.
+  QVariant toVariant() const;
+  static const QTAIMWavefunctionEvaluator& fromVariant(const QVariant& variant);
+
+  qreal molecularOrbital(const qint64 mo, const Matrix<qreal, 3, 1> xyz) const;
+  qreal electronDensity(const Matrix<qreal, 3, 1> xyz) const;
   const Matrix<qreal, 3, 1> gradientOfElectronDensity(
-    const Matrix<qreal, 3, 1> xyz);
+    const Matrix<qreal, 3, 1> xyz) const;
   const Matrix<qreal, 3, 3> hessianOfElectronDensity(
-    const Matrix<qreal, 3, 1> xyz);
+    const Matrix<qreal, 3, 1> xyz) const;
   const Matrix<qreal, 3, 4> gradientAndHessianOfElectronDensity(
-    const Matrix<qreal, 3, 1> xyz);
-  qreal laplacianOfElectronDensity(const Matrix<qreal, 3, 1> xyz);
-  qreal electronDensityLaplacian(const Matrix<qreal, 3, 1> xyz)
+    const Matrix<qreal, 3, 1> xyz) const;
+  qreal laplacianOfElectronDensity(const Matrix<qreal, 3, 1> xyz) const;
+  qreal electronDensityLaplacian(const Matrix<qreal, 3, 1> xyz) const
   {
     return laplacianOfElectronDensity(xyz);
   }
   const Matrix<qreal, 3, 1> gradientOfElectronDensityLaplacian(
-    const Matrix<qreal, 3, 1> xyz);
+    const Matrix<qreal, 3, 1> xyz) const;
   const Matrix<qreal, 3, 3> hessianOfElectronDensityLaplacian(
-    const Matrix<qreal, 3, 1> xyz);
+    const Matrix<qreal, 3, 1> xyz) const;
   const Matrix<qreal, 3, 4> gradientAndHessianOfElectronDensityLaplacian(
-    const Matrix<qreal, 3, 1> xyz);
-  qreal kineticEnergyDensityG(const Matrix<qreal, 3, 1> xyz);
-  qreal kineticEnergyDensityK(const Matrix<qreal, 3, 1> xyz);
-  const Matrix<qreal, 3, 3> quantumStressTensor(const Matrix<qreal, 3, 1> xyz);
+    const Matrix<qreal, 3, 1> xyz) const;
+  qreal kineticEnergyDensityG(const Matrix<qreal, 3, 1> xyz) const;
+  qreal kineticEnergyDensityK(const Matrix<qreal, 3, 1> xyz) const;
+  const Matrix<qreal, 3, 3> quantumStressTensor(
+    const Matrix<qreal, 3, 1> xyz) const;
+
+  // The same properties at each column of xyz. The primitives are evaluated
+  // once per point and contracted with the orbital coefficients in a single
+  // matrix product, which is much faster than one call per point.
+  const Matrix<qreal, Dynamic, 1> electronDensities(
+    const Matrix<qreal, 3, Dynamic>& xyz) const;
+  const Matrix<qreal, 3, Dynamic> gradientsOfElectronDensity(
+    const Matrix<qreal, 3, Dynamic>& xyz) const;
+  const Matrix<qreal, Dynamic, 1> laplaciansOfElectronDensity(
+    const Matrix<qreal, 3, Dynamic>& xyz) const;
 
 private:
+  const QTAIMWavefunction* m_wfn;
+
   qint64 m_nmo;
   qint64 m_nprim;
   qint64 m_nnuc;
@@ -77,52 +105,65 @@ private:
   Matrix<qreal, Dynamic, 1> m_alpha;
   Matrix<qreal, Dynamic, 1> m_occno;
   Matrix<qreal, Dynamic, 1> m_orbe;
-  Matrix<qreal, Dynamic, Dynamic, RowMajor> m_coef;
+  Matrix<qreal, Dynamic, Dynamic> m_coef;
   qreal m_totalEnergy;
   qreal m_virialRatio;
 
   qreal m_cutoff;
 
-  Matrix<qreal, Dynamic, 1> m_cdg000;
-  Matrix<qreal, Dynamic, 1> m_cdg100;
-  Matrix<qreal, Dynamic, 1> m_cdg010;
-  Matrix<qreal, Dynamic, 1> m_cdg001;
-  Matrix<qreal, Dynamic, 1> m_cdg200;
-  Matrix<qreal, Dynamic, 1> m_cdg110;
-  Matrix<qreal, Dynamic, 1> m_cdg101;
-  Matrix<qreal, Dynamic, 1> m_cdg020;
-  Matrix<qreal, Dynamic, 1> m_cdg011;
-  Matrix<qreal, Dynamic, 1> m_cdg002;
-  Matrix<qreal, Dynamic, 1> m_cdg300;
-  Matrix<qreal, Dynamic, 1> m_cdg120;
-  Matrix<qreal, Dynamic, 1> m_cdg102;
-  Matrix<qreal, Dynamic, 1> m_cdg210;
-  Matrix<qreal, Dynamic, 1> m_cdg030;
-  Matrix<qreal, Dynamic, 1> m_cdg012;
-  Matrix<qreal, Dynamic, 1> m_cdg201;
-  Matrix<qreal, Dynamic, 1> m_cdg021;
-  Matrix<qreal, Dynamic, 1> m_cdg003;
-  Matrix<qreal, Dynamic, 1> m_cdg111;
-  Matrix<qreal, Dynamic, 1> m_cdg400;
-  Matrix<qreal, Dynamic, 1> m_cdg220;
-  Matrix<qreal, Dynamic, 1> m_cdg202;
-  Matrix<qreal, Dynamic, 1> m_cdg310;
-  Matrix<qreal, Dynamic, 1> m_cdg130;
-  Matrix<qreal, Dynamic, 1> m_cdg112;
-  Matrix<qreal, Dynamic, 1> m_cdg301;
-  Matrix<qreal, Dynamic, 1> m_cdg121;
-  Matrix<qreal, Dynamic, 1> m_cdg103;
-  Matrix<qreal, Dynamic, 1> m_cdg040;
-  Matrix<qreal, Dynamic, 1> m_cdg022;
-  Matrix<qreal, Dynamic, 1> m_cdg211;
-  Matrix<qreal, Dynamic, 1> m_cdg031;
-  Matrix<qreal, Dynamic, 1> m_cdg013;
-  Matrix<qreal, Dynamic, 1> m_cdg004;
-
-  static inline qreal ipow(qreal a, qint64 n) { return (qreal)pow(a, (int)n); }
+  // The primitives of center c are m_centerPrimitives(c) up to, but not
+  // including, m_centerPrimitives(c + 1).
+  qint64 m_ncenter;
+  Matrix<qreal, Dynamic, 1> m_centerX0;
+  Matrix<qreal, Dynamic, 1> m_centerY0;
+  Matrix<qreal, Dynamic, 1> m_centerZ0;
+  Matrix<qint64, Dynamic, 1> m_centerPrimitives;
+
+  // The primitives that are not negligible at xyz.
+  std::vector<qint64> screenedPrimitives(const Matrix<qreal, 3, 1>& xyz) const;
+
+  // The orbitals (rows) at npts points from column first of xyz (columns)
+  // in cdg[0], and with order 1 or 2 also their x, y and z derivatives in
+  // cdg[1] to cdg[3], and with order 2 their second x, y and z derivatives
+  // in cdg[4] to cdg[6].
+  void contractedPrimitives(
+    const Matrix<qreal, 3, Dynamic>& xyz, qint64 first, qint64 npts,
+    int order, std::vector<Matrix<qreal, Dynamic, Dynamic>>& cdg) const;
+
+  // The batches are split into blocks of points whose primitives stay in
+  // cache.
+  static const qint64 m_blockSize = 32;
+
+  // Angular momenta are small, a few multiplications are much cheaper than
+  // pow().
+  static inline qreal ipow(qreal a, qint64 n)
+  {
+    if (n < 0)
+      return (qreal)pow(a, (int)n);
+    qreal value = 1.0;
+    for (qint64 i = 0; i < n; ++i)
+      value *= a;
+    return value;
+  }
+
+  // The kth derivative of a^n without the exponential, with the convention
+  // of the single point routines for n == k.
+  static inline qreal angularDerivative(qreal a, qint64 n, qint64 k)
+  {
+    if (n < k)
+      return 0.0;
+    if (n == k)
+      return 1.0;
+    qint64 factor = 1;
+    for (qint64 i = 0; i < k; ++i)
+      factor *= n - i;
+    return factor * ipow(a, n - k);
+  }
 };
 
 } // namespace QtPlugins
 } // namespace Avogadro
 
+Q_DECLARE_METATYPE(const Avogadro::QtPlugins::QTAIMWavefunctionEvaluator*)
+
 #endif // QTAIMWAVEFUNCTIONEVALUATOR_H
@@ -0,0 +1,133 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "../qtaimwavefunction.h"
+#include "../qtaimwavefunctionevaluator.h"
+
+#include <QElapsedTimer>
+#include <QString>
+
+#include <iostream>
+#include <vector>
+
+using Avogadro::QtPlugins::QTAIMWavefunction;
+using Avogadro::QtPlugins::QTAIMWavefunctionEvaluator;
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef Matrix<qreal, 3, 1> Point;
+
+// A grid of points within 2 bohr of the nuclei, the region the critical point
+// searches and the basin integration spend most of their time in.
+std::vector<Point> samplePoints(const QTAIMWavefunction& wfn, int perAxis)
+{
+  Point lower(wfn.xNuclearCoordinate(0), wfn.yNuclearCoordinate(0),
+              wfn.zNuclearCoordinate(0));
+  Point upper(lower);
+  for (qint64 n = 1; n < wfn.numberOfNuclei(); ++n) {
+    Point nucleus(wfn.xNuclearCoordinate(n), wfn.yNuclearCoordinate(n),
+                  wfn.zNuclearCoordinate(n));
+    lower = lower.cwiseMin(nucleus);
+    upper = upper.cwiseMax(nucleus);
+  }
+  lower.array() -= 2.0;
+  upper.array() += 2.0;
+
+  std::vector<Point> points;
+  const Point step = (upper - lower) / (perAxis - 1);
+  for (int i = 0; i < perAxis; ++i) {
+    for (int j = 0; j < perAxis; ++j) {
+      for (int k = 0; k < perAxis; ++k)
+        points.push_back(lower + Point(i, j, k).cwiseProduct(step));
+    }
+  }
+  return points;
+}
+
+// Print the mean time per point of evaluate, repeated until a second passes.
+template <typename Evaluate>
+void report(const char* name, const std::vector<Point>& points,
+            const Evaluate& evaluate)
+{
+  QElapsedTimer timer;
+  timer.start();
+  qint64 count = 0;
+  qreal sum = 0.0;
+  do {
+    for (size_t i = 0; i < points.size(); ++i)
+      sum += evaluate(points[i]);
+    count += points.size();
+  } while (timer.elapsed() < 1000);
+  cout << name << ": " << 1.e6 * timer.elapsed() / (1000.0 * count)
+       << " us per point (checksum " << sum / count << ")" << endl;
+}
+
+// The same for evaluate on all points in one batch.
+template <typename Evaluate>
+void reportBatch(const char* name, const std::vector<Point>& points,
+                 const Evaluate& evaluate)
+{
+  Matrix<qreal, 3, Dynamic> batch(3, points.size());
+  for (size_t i = 0; i < points.size(); ++i)
+    batch.col(i) = points[i];
+
+  QElapsedTimer timer;
+  timer.start();
+  qint64 count = 0;
+  qreal sum = 0.0;
+  do {
+    sum += evaluate(batch);
+    count += points.size();
+  } while (timer.elapsed() < 1000);
+  cout << name << ": " << 1.e6 * timer.elapsed() / (1000.0 * count)
+       << " us per point (checksum " << sum / count << ")" << endl;
+}
+} // End anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  const QString fileName =
+    argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString(QTAIM_TEST_WFN);
+  QTAIMWavefunction wfn;
+  if (!wfn.initializeWithWFNFile(fileName)) {
+    cout << "Could not read " << fileName.toStdString() << endl;
+    return 1;
+  }
+  cout << fileName.toStdString() << ": " << wfn.numberOfNuclei()
+       << " nuclei, " << wfn.numberOfGaussianPrimitives() << " primitives, "
+       << wfn.numberOfMolecularOrbitals() << " orbitals" << endl;
+
+  const QTAIMWavefunctionEvaluator eval(wfn);
+  const std::vector<Point> points = samplePoints(wfn, 20);
+
+  report("electronDensity", points,
+         [&](const Point& xyz) { return eval.electronDensity(xyz); });
+  report("gradientOfElectronDensity", points, [&](const Point& xyz) {
+    return eval.gradientOfElectronDensity(xyz).sum();
+  });
+  report("gradientAndHessianOfElectronDensity", points,
+         [&](const Point& xyz) {
+           return eval.gradientAndHessianOfElectronDensity(xyz).sum();
+         });
+  report("laplacianOfElectronDensity", points, [&](const Point& xyz) {
+    return eval.laplacianOfElectronDensity(xyz);
+  });
+  report("gradientAndHessianOfElectronDensityLaplacian", points,
+         [&](const Point& xyz) {
+           return eval.gradientAndHessianOfElectronDensityLaplacian(xyz).sum();
+         });
+
+  typedef Matrix<qreal, 3, Dynamic> Points;
+  reportBatch("electronDensities", points, [&](const Points& xyz) {
+    return eval.electronDensities(xyz).sum();
+  });
+  reportBatch("gradientsOfElectronDensity", points, [&](const Points& xyz) {
+    return eval.gradientsOfElectronDensity(xyz).sum();
+  });
+  reportBatch("laplaciansOfElectronDensity", points, [&](const Points& xyz) {
+    return eval.laplaciansOfElectronDensity(xyz).sum();
+  });
+  return 0;
+}
@@ -0,0 +1,106 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "../qtaimwavefunction.h"
+#include "../qtaimwavefunctionevaluator.h"
+
+#include <QString>
+#include <QVariant>
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+using Avogadro::QtPlugins::QTAIMWavefunction;
+using Avogadro::QtPlugins::QTAIMWavefunctionEvaluator;
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef Matrix<qreal, 3, 1> Point;
+typedef Matrix<qreal, 3, Dynamic> Points;
+
+// Points on a line through the first two nuclei and past both ends, so that
+// they sample the nuclear cusps, the bond and the tail of the density. There
+// are more points than one batch block, so the blocks are checked too.
+Points samplePoints(const QTAIMWavefunction& wfn, int count)
+{
+  const Point a(wfn.xNuclearCoordinate(0), wfn.yNuclearCoordinate(0),
+                wfn.zNuclearCoordinate(0));
+  const Point b(wfn.xNuclearCoordinate(1), wfn.yNuclearCoordinate(1),
+                wfn.zNuclearCoordinate(1));
+  const Point offset(0.1, -0.2, 0.3);
+  Points points(3, count);
+  for (int i = 0; i < count; ++i) {
+    const qreal t = -1.0 + 3.0 * i / (count - 1);
+    points.col(i) = a + t * (b - a) + offset;
+  }
+  return points;
+}
+
+// Compare with a tolerance relative to the largest single point value, the
+// batch sums the same terms in a different order.
+bool compare(const char* name, const Matrix<qreal, Dynamic, Dynamic>& single,
+             const Matrix<qreal, Dynamic, Dynamic>& batch)
+{
+  const qreal scale = std::max<qreal>(single.cwiseAbs().maxCoeff(), 1.0);
+  const qreal error = (single - batch).cwiseAbs().maxCoeff();
+  if (error > 1.e-10 * scale) {
+    cout << name << ": the batch differs from single points by " << error
+         << endl;
+    return false;
+  }
+  return true;
+}
+} // End anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  const QString fileName =
+    argc > 1 ? QString::fromLocal8Bit(argv[1]) : QString(QTAIM_TEST_WFN);
+  QTAIMWavefunction wfn;
+  if (!wfn.initializeWithWFNFile(fileName)) {
+    cout << "Could not read " << fileName.toStdString() << endl;
+    return 1;
+  }
+  if (wfn.numberOfNuclei() < 2) {
+    cout << "Expected at least two nuclei" << endl;
+    return 1;
+  }
+
+  const QTAIMWavefunctionEvaluator eval(wfn);
+  bool ok = true;
+
+  // The shared evaluator travels to the QtConcurrent tasks in a QVariant.
+  const QVariant variant = eval.toVariant();
+  if (&QTAIMWavefunctionEvaluator::fromVariant(variant) != &eval ||
+      variant.value<void*>() != nullptr) {
+    cout << "The evaluator does not round trip through a QVariant" << endl;
+    ok = false;
+  }
+
+  const Points points = samplePoints(wfn, 101);
+  Matrix<qreal, Dynamic, 1> densities(points.cols());
+  Points gradients(3, points.cols());
+  Matrix<qreal, Dynamic, 1> laplacians(points.cols());
+  for (qint64 i = 0; i < points.cols(); ++i) {
+    const Point xyz = points.col(i);
+    densities(i) = eval.electronDensity(xyz);
+    gradients.col(i) = eval.gradientOfElectronDensity(xyz);
+    laplacians(i) = eval.laplacianOfElectronDensity(xyz);
+  }
+
+  ok = compare("electronDensities", densities,
+               eval.electronDensities(points)) && ok;
+  ok = compare("gradientsOfElectronDensity", gradients,
+               eval.gradientsOfElectronDensity(points)) && ok;
+  ok = compare("laplaciansOfElectronDensity", laplacians,
+               eval.laplaciansOfElectronDensity(points)) && ok;
+  if (densities.minCoeff() <= 0.0) {
+    cout << "The density should be positive at every point" << endl;
+    ok = false;
+  }
+
+  return ok ? 0 : 1;
+}
@@ -77,30 +77,27 @@ void Select::setMolecule(QtGui::Molecule* mol)
 void Select::selectAll()
 {
   if (m_molecule) {
-    for (Index i = 0; i < m_molecule->atomCount(); ++i)
-      m_molecule->atom(i).setSelected(true);
+    m_molecule->atomSelection().setAll(true);
 
-    m_molecule->emitChanged(Molecule::Atoms);
+    m_molecule->emitAtomsChanged(Molecule::Atoms, 0, m_molecule->atomCount());
   }
 }
 
 void Select::selectNone()
 {
   if (m_molecule) {
-    for (Index i = 0; i < m_molecule->atomCount(); ++i)
-      m_molecule->atom(i).setSelected(false);
+    m_molecule->atomSelection().setAll(false);
 
-    m_molecule->emitChanged(Molecule::Atoms);
+    m_molecule->emitAtomsChanged(Molecule::Atoms, 0, m_molecule->atomCount());
   }
 }
 
 void Select::invertSelection()
 {
   if (m_molecule) {
-    for (Index i = 0; i < m_molecule->atomCount(); ++i)
-      m_molecule->atom(i).setSelected(!m_molecule->atomSelected(i));
+    m_molecule->atomSelection().flipAll();
 
-    m_molecule->emitChanged(Molecule::Atoms);
+    m_molecule->emitAtomsChanged(Molecule::Atoms, 0, m_molecule->atomCount());
   }
 }
 
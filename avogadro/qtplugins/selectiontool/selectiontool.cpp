@@ -218,18 +218,17 @@ void SelectionTool::draw(Rendering::GroupNode& node)
 
 void SelectionTool::applyColor(Vector3ub color)
 {
-  for (Index i = 0; i < m_molecule->atomCount(); ++i) {
-    auto a = m_molecule->atom(i);
-    if (a.selected())
-      a.setColor(color);
+  const Core::Selection& selection = m_molecule->atomSelection();
+  for (Index i = selection.first(); i < m_molecule->atomCount();
+       i = selection.next(i)) {
+    m_molecule->atom(i).setColor(color);
   }
   m_molecule->emitChanged(Molecule::Atoms);
 }
 
 void SelectionTool::clearAtoms()
 {
-  for (Index i = 0; i < m_molecule->atomCount(); ++i)
-    m_molecule->atom(i).setSelected(false);
+  m_molecule->atomSelection().setAll(false);
 }
 
 bool SelectionTool::addAtom(const Rendering::Identifier& atom)
@@ -16,9 +16,9 @@
 
 #include "gaussiansetconcurrent.h"
 
-#include <avogadro/core/gaussianset.h>
 #include <avogadro/core/gaussiansettools.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/moleculesnapshot.h>
 #include <avogadro/core/mutex.h>
 
 #include <avogadro/core/cube.h>
@@ -30,9 +30,9 @@ namespace QtPlugins {
 
 using Core::BasisSet;
 using Core::Cube;
-using Core::GaussianSet;
 using Core::GaussianSetTools;
 using Core::Molecule;
+using Core::MoleculeSnapshot;
 
 template <typename Derived>
 class BasisSetConcurrent
@@ -52,7 +52,8 @@ struct GaussianShell
 };
 
 GaussianSetConcurrent::GaussianSetConcurrent(QObject* p)
-  : QObject(p), m_gaussianShells(nullptr), m_set(nullptr), m_tools(nullptr)
+  : QObject(p), m_gaussianShells(nullptr), m_molecule(nullptr),
+    m_tools(nullptr)
 {
   // Watch for the future
   connect(&m_watcher, SIGNAL(finished()), this, SLOT(calculationComplete()));
@@ -61,39 +62,34 @@ GaussianSetConcurrent::GaussianSetConcurrent(QObject* p)
 GaussianSetConcurrent::~GaussianSetConcurrent()
 {
   delete m_gaussianShells;
+  delete m_tools;
 }
 
 void GaussianSetConcurrent::setMolecule(Core::Molecule* mol)
 {
   if (!mol)
     return;
-  m_set = dynamic_cast<GaussianSet*>(mol->basisSet());
-  if (m_tools)
-    delete m_tools;
-  m_tools = new GaussianSetTools(mol);
+  m_molecule = mol;
 }
 
 bool GaussianSetConcurrent::calculateMolecularOrbital(Core::Cube* cube,
                                                       unsigned int state,
                                                       bool beta)
 {
-  // We can do some initial set up of the tools here to set electron type.
-  if (!beta)
-    m_tools->setElectronType(BasisSet::Alpha);
-  else
-    m_tools->setElectronType(BasisSet::Beta);
-
-  return setUpCalculation(cube, state, GaussianSetConcurrent::processOrbital);
+  return setUpCalculation(cube, state, beta ? BasisSet::Beta : BasisSet::Alpha,
+                          GaussianSetConcurrent::processOrbital);
 }
 
 bool GaussianSetConcurrent::calculateElectronDensity(Core::Cube* cube)
 {
-  return setUpCalculation(cube, 0, GaussianSetConcurrent::processDensity);
+  return setUpCalculation(cube, 0, BasisSet::Paired,
+                          GaussianSetConcurrent::processDensity);
 }
 
 bool GaussianSetConcurrent::calculateSpinDensity(Core::Cube* cube)
 {
-  return setUpCalculation(cube, 0, GaussianSetConcurrent::processSpinDensity);
+  return setUpCalculation(cube, 0, BasisSet::Paired,
+                          GaussianSetConcurrent::processSpinDensity);
 }
 
 void GaussianSetConcurrent::calculationComplete()
@@ -106,12 +102,22 @@ void GaussianSetConcurrent::calculationComplete()
 
 bool GaussianSetConcurrent::setUpCalculation(Core::Cube* cube,
                                              unsigned int state,
+                                             BasisSet::ElectronType type,
                                              void (*func)(GaussianShell&))
 {
-  if (!m_set || !m_tools)
+  if (!m_molecule)
     return false;
 
-  m_set->initCalculation();
+  // The workers only read the snapshot and write to the cube, the molecule
+  // can change while they run.
+  GaussianSetTools* tools = new GaussianSetTools(MoleculeSnapshot(*m_molecule));
+  if (!tools->isValid()) {
+    delete tools;
+    return false;
+  }
+  tools->setElectronType(type);
+  delete m_tools;
+  m_tools = tools;
 
   // Set up the points we want to calculate the density at.
   m_gaussianShells =
@@ -17,6 +17,8 @@
 #ifndef GAUSSIANSETCONCURRENT_H
 #define GAUSSIANSETCONCURRENT_H
 
+#include <avogadro/core/basisset.h>
+
 #include <QtCore/QFuture>
 #include <QtCore/QFutureWatcher>
 #include <QtCore/QObject>
@@ -26,7 +28,6 @@ namespace Avogadro {
 namespace Core {
 class Cube;
 class Molecule;
-class GaussianSet;
 class GaussianSetTools;
 }
 
@@ -37,6 +38,8 @@ struct GaussianShell;
 /**
  * @brief The GaussianSetConcurrent class uses GaussianSetTools to calculate
  * values of electronic structure properties from quantum output read in.
+ * Each calculation works on a snapshot of the molecule taken when it starts,
+ * so the molecule can be edited while it runs.
  * @author Marcus D. Hanwell
  */
 
@@ -75,10 +78,11 @@ private:
   Core::Cube* m_cube;
   QVector<GaussianShell>* m_gaussianShells;
 
-  Core::GaussianSet* m_set;
+  Core::Molecule* m_molecule;
   Core::GaussianSetTools* m_tools;
 
   bool setUpCalculation(Core::Cube* cube, unsigned int state,
+                        Core::BasisSet::ElectronType type,
                         void (*func)(GaussianShell&));
 
   static void processOrbital(GaussianShell& shell);
@@ -48,6 +48,12 @@ void VanDerWaalsAO::process(const Core::Molecule& molecule,
   AmbientOcclusionSphereGeometry* spheres = new AmbientOcclusionSphereGeometry;
   spheres->identifier().molecule = &molecule;
   spheres->identifier().type = Rendering::AtomType;
+  // Reuse the ambient occlusion baked for the previous geometry, and bake the
+  // changed spheres over several frames to keep interaction smooth. The baked
+  // textures are kept with the other GL resources of the view's context, so
+  // they are freed while that context is current.
+  spheres->setCacheKey(this);
+  spheres->setProgressiveBaking(true);
   geometry->addDrawable(spheres);
 
   for (size_t i = 0; i < molecule.atomCount(); ++i) {
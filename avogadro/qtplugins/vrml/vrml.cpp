@@ -21,7 +21,7 @@
 #include <avogadro/rendering/scene.h>
 #include <avogadro/rendering/vrmlvisitor.h>
 
-#include <QtCore/QTextStream>
+#include <QtCore/QFile>
 #include <QtGui/QClipboard>
 #include <QtGui/QIcon>
 #include <QtGui/QKeySequence>
@@ -30,6 +30,7 @@
 #include <QtWidgets/QFileDialog>
 #include <QtWidgets/QMessageBox>
 
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -81,15 +82,22 @@ void VRML::render()
   QString filename = QFileDialog::getSaveFileName(
     qobject_cast<QWidget*>(parent()), tr("Save File"), QDir::homePath(),
     tr("VRML (*.wrl);;Text file (*.txt)"));
-  QFile file(filename);
-  if (!file.open(QIODevice::WriteOnly))
+  if (filename.isEmpty())
+    return;
+
+  // Stream the scene straight to the file through a large buffer rather than
+  // building it in memory first.
+  std::vector<char> buffer(1 << 20);
+  std::ofstream file;
+  file.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+  file.open(QFile::encodeName(filename).constData());
+  if (!file.is_open())
     return;
 
-  QTextStream fileStream(&file);
   Rendering::VRMLVisitor visitor(*m_camera);
-  visitor.begin();
+  visitor.begin(file);
   m_scene->rootNode().accept(visitor);
-  fileStream << visitor.end().c_str();
+  visitor.end();
 
   file.close();
 }
@@ -18,6 +18,7 @@
 #include "ambientocclusionspheregeometry.h"
 
 #include "camera.h"
+#include "glresourcecache.h"
 #include "scene.h"
 
 #include "bufferobject.h"
@@ -524,11 +525,19 @@ const float ao_points[] = {
   -0.26286555606f,
   -0.951056516295f,
 };
+
+// The directions are ordered as successive subdivisions of an icosahedron, so
+// the first frame of progressive baking already covers the whole sphere.
+const int ao_points_per_frame = 18;
 }
 
 #include "avogadrogl.h"
 
+#include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
 using std::cout;
 using std::endl;
@@ -567,16 +576,55 @@ public:
     // delete framebuffers
     glDeleteFramebuffers(1, &m_depthFBO);
     glDeleteFramebuffers(1, &m_aoFBO);
-    // delete depth texture
+    // delete textures
     glDeleteTextures(1, &m_depthTexture);
-    // note: ao texture not deleted since it contains the computed data...
+    glDeleteTextures(1, &m_aoTexture);
   }
 
   GLint textureSize() const { return m_textureSize; }
 
   GLuint aoTexture() const { return m_aoTexture; }
 
-  void accumulateAO(const Vector3f& center, float radius)
+  void clearAO()
+  {
+    // save OpenGL state
+    m_openglState.save();
+
+    // the alpha channel counts the baked directions, so clear it too
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_aoFBO);
+    glClear(GL_COLOR_BUFFER_BIT);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // load OpenGL state
+    m_openglState.load();
+  }
+
+  // clear the (x, y, width, height) pixel rectangles of the AO texture
+  void clearAO(const std::vector<Eigen::Vector4i>& rects)
+  {
+    // save OpenGL state
+    m_openglState.save();
+
+    glViewport(0, 0, m_textureSize, m_textureSize);
+    glClearColor(0.0, 0.0, 0.0, 0.0);
+    glBindFramebuffer(GL_FRAMEBUFFER, m_aoFBO);
+    glEnable(GL_SCISSOR_TEST);
+    for (std::vector<Eigen::Vector4i>::const_iterator it = rects.begin();
+         it != rects.end(); ++it) {
+      glScissor((*it)[0], (*it)[1], (*it)[2], (*it)[3]);
+      glClear(GL_COLOR_BUFFER_BIT);
+    }
+    glDisable(GL_SCISSOR_TEST);
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+    // load OpenGL state
+    m_openglState.load();
+  }
+
+  // accumulate AO for the directions in [firstDirection, lastDirection)
+  void accumulateAO(const Vector3f& center, float radius, int firstDirection,
+                    int lastDirection)
   {
     // save OpenGL state
     m_openglState.save();
@@ -602,12 +650,9 @@ public:
                                  radius);
     Eigen::Matrix4f projection(camera.projection().matrix());
 
-    // clear draw buffer once, AO wil be accumulated using blending
-    glBindFramebuffer(GL_FRAMEBUFFER, m_aoFBO);
-    glClear(GL_COLOR_BUFFER_BIT);
-    glBindFramebuffer(GL_FRAMEBUFFER, 0);
-
-    for (int i = 0; i < num_ao_points; ++i) {
+    // the AO texture is cleared by clearAO(), AO is accumulated using
+    // blending so baking can be spread over several calls
+    for (int i = firstDirection; i < lastDirection; ++i) {
       // random light direction
       Vector3f dir(ao_points[i * 3], ao_points[i * 3 + 1],
                    ao_points[i * 3 + 2]);
@@ -809,6 +854,8 @@ private:
   {
     void save()
     {
+      // bound framebuffer, which is not 0 when rendering offscreen
+      glGetIntegerv(GL_FRAMEBUFFER_BINDING, &framebuffer);
       // bound texture
       glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
       // viewport
@@ -829,6 +876,8 @@ private:
 
     void load()
     {
+      // bound framebuffer
+      glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(framebuffer));
       // bound texture
       glBindTexture(GL_TEXTURE_2D, boundTexture);
       // viewport
@@ -848,6 +897,8 @@ private:
       glBlendFunc(blendSrc, blendDst);
     }
 
+    // bound framebuffer
+    GLint framebuffer;
     // bound texture
     GLint boundTexture;
     // viewport
@@ -880,24 +931,39 @@ private:
 class SphereAmbientOcclusionRenderer : public AmbientOcclusionRenderer
 {
 public:
-  SphereAmbientOcclusionRenderer(BufferObject& vbo, BufferObject& ibo,
-                                 int numSpheres, int numVertices,
-                                 int numIndices)
-    : m_vbo(vbo)
-    , m_ibo(ibo)
-    , m_numSpheres(numSpheres)
-    , m_numVertices(numVertices)
-    , m_numIndices(numIndices)
+  SphereAmbientOcclusionRenderer()
+    : m_vbo(nullptr)
+    , m_ibo(nullptr)
+    , m_aoIbo(nullptr)
+    , m_numSpheres(0)
+    , m_numVertices(0)
+    , m_numIndices(0)
+    , m_numAOIndices(0)
   {
     initialize();
   }
 
+  // All spheres in ibo cast shadows, but only the spheres in aoIbo have their
+  // AO accumulated.
+  void setBuffers(BufferObject* vbo, BufferObject* ibo, BufferObject* aoIbo,
+                  int numSpheres, int numVertices, int numIndices,
+                  int numAOIndices)
+  {
+    m_vbo = vbo;
+    m_ibo = ibo;
+    m_aoIbo = aoIbo;
+    m_numSpheres = numSpheres;
+    m_numVertices = numVertices;
+    m_numIndices = numIndices;
+    m_numAOIndices = numAOIndices;
+  }
+
   void renderDepth(const Eigen::Matrix4f& modelView,
                    const Eigen::Matrix4f& projection) override
   {
     // bind buffer objects
-    m_vbo.bind();
-    m_ibo.bind();
+    m_vbo->bind();
+    m_ibo->bind();
 
     m_depthProgram.bind();
 
@@ -932,8 +998,8 @@ public:
                         static_cast<GLsizei>(m_numIndices), GL_UNSIGNED_INT,
                         reinterpret_cast<const GLvoid*>(NULL));
 
-    m_vbo.release();
-    m_ibo.release();
+    m_vbo->release();
+    m_ibo->release();
 
     m_depthProgram.disableAttributeArray("a_pos");
     m_depthProgram.disableAttributeArray("a_corner");
@@ -946,8 +1012,8 @@ public:
                 float numDirections) override
   {
     // bind buffer objects
-    m_vbo.bind();
-    m_ibo.bind();
+    m_vbo->bind();
+    m_aoIbo->bind();
 
     m_aoProgram.bind();
 
@@ -1003,11 +1069,11 @@ public:
 
     // draw
     glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(m_numVertices),
-                        static_cast<GLsizei>(m_numIndices), GL_UNSIGNED_INT,
+                        static_cast<GLsizei>(m_numAOIndices), GL_UNSIGNED_INT,
                         reinterpret_cast<const GLvoid*>(NULL));
 
-    m_vbo.release();
-    m_ibo.release();
+    m_vbo->release();
+    m_aoIbo->release();
 
     m_aoProgram.disableAttributeArray("a_pos");
     m_aoProgram.disableAttributeArray("a_corner");
@@ -1072,18 +1138,236 @@ private:
   Shader m_aoFragmentShader;
   ShaderProgram m_aoProgram;
 
-  BufferObject& m_vbo;
-  BufferObject& m_ibo;
+  BufferObject* m_vbo;
+  BufferObject* m_ibo;
+  BufferObject* m_aoIbo;
   int m_numSpheres;
   int m_numVertices;
   int m_numIndices;
+  int m_numAOIndices;
 };
 
+class AmbientOcclusionCache::Private
+{
+public:
+  Private()
+    : baker(nullptr)
+    , renderer(nullptr)
+    , aoTextureSize(1024)
+    , pendingChanged(false)
+    , nextDirection(num_ao_points)
+    , aoIndexCount(0)
+    , center(Vector3f::Zero())
+    , radius(0.0f)
+  {}
+
+  ~Private()
+  {
+    if (baker) {
+      baker->destroy();
+      delete baker;
+    }
+    if (renderer) {
+      renderer->destroy();
+      delete renderer;
+    }
+  }
+
+  // Compare the new spheres to the baked ones and mark those to bake again.
+  void invalidate(const Core::Array<SphereColor>& newSpheres);
+
+  // Bake the pending spheres, one frame's worth of directions if progressive.
+  void bake(BufferObject& vbo, BufferObject& ibo, int numVertices,
+            int numIndices, bool progressive);
+
+  bool isBaking() const { return !pending.empty(); }
+
+  AmbientOcclusionBaker* baker;
+  SphereAmbientOcclusionRenderer* renderer;
+  BufferObject aoIbo;
+  int aoTextureSize;
+
+  // The spheres the AO texture is baked for, and those that still need baking.
+  Core::Array<SphereColor> spheres;
+  std::vector<unsigned int> pending;
+  bool pendingChanged;
+  int nextDirection;
+  int aoIndexCount;
+
+  Vector3f center;
+  float radius;
+};
+
+void AmbientOcclusionCache::Private::invalidate(
+  const Core::Array<SphereColor>& newSpheres)
+{
+  const size_t n = newSpheres.size();
+  std::vector<bool> affected(n, false);
+  bool bakeAll = n != spheres.size();
+
+  if (!bakeAll) {
+    // Find the spheres that moved or changed size.
+    std::vector<size_t> changed;
+    float maxRadius = 0.0f;
+    for (size_t i = 0; i < n; ++i) {
+      const SphereColor& a = spheres[i];
+      const SphereColor& b = newSpheres[i];
+      maxRadius = std::max(maxRadius, b.radius);
+      if (a.center != b.center || a.radius != b.radius)
+        changed.push_back(i);
+    }
+    if (changed.empty())
+      return;
+
+    // Past this point it is cheaper to bake everything.
+    const float cutoff = 4.0f * maxRadius;
+    bakeAll = changed.size() > n / 2 || cutoff <= 0.0f;
+
+    if (!bakeAll) {
+      // Spheres close to the old or new position of a changed sphere may have
+      // gained or lost an occluder. Bin the spheres on a grid to find them.
+      typedef long long CellKey;
+      const float invCutoff = 1.0f / cutoff;
+      auto cellKey = [](int x, int y, int z) {
+        return (static_cast<CellKey>(x & 0x1FFFFF) << 42) |
+               (static_cast<CellKey>(y & 0x1FFFFF) << 21) |
+               static_cast<CellKey>(z & 0x1FFFFF);
+      };
+      std::unordered_map<CellKey, std::vector<unsigned int>> grid;
+      for (size_t i = 0; i < n; ++i) {
+        const Vector3f cell =
+          (newSpheres[i].center * invCutoff).array().floor();
+        grid[cellKey(static_cast<int>(cell.x()), static_cast<int>(cell.y()),
+                     static_cast<int>(cell.z()))]
+          .push_back(static_cast<unsigned int>(i));
+      }
+
+      const float cutoffSquared = cutoff * cutoff;
+      for (size_t i : changed) {
+        const Vector3f positions[2] = { spheres[i].center,
+                                        newSpheres[i].center };
+        for (const Vector3f& pos : positions) {
+          const Vector3f cell = (pos * invCutoff).array().floor();
+          const int cx = static_cast<int>(cell.x());
+          const int cy = static_cast<int>(cell.y());
+          const int cz = static_cast<int>(cell.z());
+          for (int x = cx - 1; x <= cx + 1; ++x) {
+            for (int y = cy - 1; y <= cy + 1; ++y) {
+              for (int z = cz - 1; z <= cz + 1; ++z) {
+                auto it = grid.find(cellKey(x, y, z));
+                if (it == grid.end())
+                  continue;
+                for (unsigned int j : it->second) {
+                  if ((newSpheres[j].center - pos).squaredNorm() <
+                      cutoffSquared) {
+                    affected[j] = true;
+                  }
+                }
+              }
+            }
+          }
+        }
+      }
+
+      // Spheres that were still being baked need to be restarted too.
+      for (unsigned int i : pending)
+        affected[i] = true;
+    }
+  }
+
+  spheres = newSpheres;
+  pending.clear();
+  for (size_t i = 0; i < n; ++i) {
+    if (bakeAll || affected[i])
+      pending.push_back(static_cast<unsigned int>(i));
+  }
+  pendingChanged = true;
+  nextDirection = 0;
+}
+
+void AmbientOcclusionCache::Private::bake(BufferObject& vbo, BufferObject& ibo,
+                                          int numVertices, int numIndices,
+                                          bool progressive)
+{
+  if (pending.empty())
+    return;
+
+  if (!baker) {
+    renderer = new SphereAmbientOcclusionRenderer;
+    baker = new AmbientOcclusionBaker(renderer, aoTextureSize);
+  }
+
+  const int nSpheres = static_cast<int>(spheres.size());
+  if (pendingChanged) {
+    // Clear the tiles of the pending spheres, and make an index buffer that
+    // only contains them.
+    if (pending.size() == spheres.size()) {
+      baker->clearAO();
+    } else {
+      const int tilesPerRow =
+        static_cast<int>(std::ceil(std::sqrt(static_cast<float>(nSpheres))));
+      const float tileSize = static_cast<float>(aoTextureSize) /
+                             static_cast<float>(tilesPerRow);
+      std::vector<Eigen::Vector4i> rects;
+      rects.reserve(pending.size());
+      for (unsigned int i : pending) {
+        const int tileX = static_cast<int>(i) % tilesPerRow;
+        const int tileY = static_cast<int>(i) / tilesPerRow;
+        const int x0 = static_cast<int>(std::floor(tileSize * tileX + 0.5f));
+        const int y0 = static_cast<int>(std::floor(tileSize * tileY + 0.5f));
+        const int x1 =
+          static_cast<int>(std::floor(tileSize * (tileX + 1) + 0.5f));
+        const int y1 =
+          static_cast<int>(std::floor(tileSize * (tileY + 1) + 0.5f));
+        rects.push_back(Eigen::Vector4i(x0, y0, x1 - x0, y1 - y0));
+      }
+      baker->clearAO(rects);
+    }
+
+    std::vector<unsigned int> aoIndices;
+    aoIndices.reserve(pending.size() * 6);
+    for (unsigned int i : pending) {
+      unsigned int index = 4 * i;
+      aoIndices.push_back(index + 0);
+      aoIndices.push_back(index + 1);
+      aoIndices.push_back(index + 2);
+      aoIndices.push_back(index + 3);
+      aoIndices.push_back(index + 2);
+      aoIndices.push_back(index + 1);
+    }
+    if (!aoIbo.upload(aoIndices, BufferObject::ElementArrayBuffer))
+      cout << aoIbo.error() << endl;
+    aoIndexCount = static_cast<int>(aoIndices.size());
+    pendingChanged = false;
+  }
+
+  renderer->setBuffers(&vbo, &ibo, &aoIbo, nSpheres, numVertices, numIndices,
+                       aoIndexCount);
+  const int lastDirection =
+    progressive ? std::min(nextDirection + ao_points_per_frame, num_ao_points)
+                : num_ao_points;
+  baker->accumulateAO(center, radius + 2.0f, nextDirection, lastDirection);
+  nextDirection = lastDirection;
+  if (nextDirection == num_ao_points)
+    pending.clear();
+}
+
+AmbientOcclusionCache::AmbientOcclusionCache()
+  : d(new Private)
+{}
+
+AmbientOcclusionCache::~AmbientOcclusionCache()
+{
+  delete d;
+}
+
 class AmbientOcclusionSphereGeometry::Private
 {
 public:
   Private()
-    : aoTextureSize(1024)
+    : cache(&ownCache)
+    , cacheKey(nullptr)
+    , progressive(false)
   {}
 
   BufferObject vbo;
@@ -1097,8 +1381,11 @@ public:
   size_t numberOfIndices;
 
   Eigen::Matrix4f translate;
-  int aoTextureSize;
-  int aoTexture;
+
+  AmbientOcclusionCache ownCache;
+  AmbientOcclusionCache* cache;
+  const void* cacheKey;
+  bool progressive;
 };
 
 AmbientOcclusionSphereGeometry::AmbientOcclusionSphereGeometry()
@@ -1130,8 +1417,22 @@ void AmbientOcclusionSphereGeometry::update()
   if (m_indices.empty() || m_spheres.empty())
     return;
 
+  // A keyed cache lives in the resource cache of the context we render with.
+  bool cacheChanged = false;
+  if (d->cacheKey) {
+    GLResourceCache* resources = GLResourceCache::current();
+    AmbientOcclusionCache* cache = static_cast<AmbientOcclusionCache*>(
+      resources->resource(d->cacheKey, "AmbientOcclusionCache"));
+    if (!cache) {
+      cache = new AmbientOcclusionCache;
+      resources->setResource(d->cacheKey, "AmbientOcclusionCache", cache);
+    }
+    cacheChanged = cache != d->cache;
+    d->cache = cache;
+  }
+
   // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
+  if (!d->vbo.ready() || m_dirty || cacheChanged) {
     std::vector<unsigned int> sphereIndices;
     std::vector<ColorTextureVertex> sphereVertices;
     sphereIndices.reserve(m_indices.size() * 4);
@@ -1208,19 +1509,19 @@ void AmbientOcclusionSphereGeometry::update()
     d->numberOfVertices = sphereVertices.size();
     d->numberOfIndices = sphereIndices.size();
 
-    SphereAmbientOcclusionRenderer aoSphereRenderer(
-      d->vbo, d->ibo, static_cast<int>(m_spheres.size()),
-      static_cast<int>(d->numberOfVertices),
-      static_cast<int>(d->numberOfIndices));
-    AmbientOcclusionBaker baker(&aoSphereRenderer, d->aoTextureSize);
-    baker.accumulateAO(center, radius + 2.0f);
-    d->aoTexture = baker.aoTexture();
-    baker.destroy();
-    aoSphereRenderer.destroy();
+    // Only the spheres that changed since the last bake, and their
+    // neighbors, need their ambient occlusion baked again.
+    AmbientOcclusionCache::Private* cache = d->cache->d;
+    cache->center = center;
+    cache->radius = radius;
+    cache->invalidate(m_spheres);
 
     m_dirty = false;
   }
 
+  d->cache->d->bake(d->vbo, d->ibo, static_cast<int>(d->numberOfVertices),
+                    static_cast<int>(d->numberOfIndices), d->progressive);
+
   // Build and link the shader if it has not been used yet.
   if (d->vertexShader.type() == Shader::Unknown) {
     d->vertexShader.setType(Shader::Vertex);
@@ -1246,8 +1547,9 @@ void AmbientOcclusionSphereGeometry::render(const Camera& camera)
   // Prepare the VBOs, IBOs and shader program if necessary.
   update();
 
+  const AmbientOcclusionCache::Private* cache = d->cache->d;
   glActiveTexture(GL_TEXTURE0);
-  glBindTexture(GL_TEXTURE_2D, d->aoTexture);
+  glBindTexture(GL_TEXTURE_2D, cache->baker ? cache->baker->aoTexture() : 0);
 
   if (!d->program.bind())
     cout << d->program.error() << endl;
@@ -1302,12 +1604,16 @@ void AmbientOcclusionSphereGeometry::render(const Camera& camera)
   if (!d->program.setUniformValue("u_tex", 0)) {
     cout << d->program.error() << endl;
   }
+  if (!d->program.setUniformValue("u_numDirections",
+                                  static_cast<float>(num_ao_points))) {
+    cout << d->program.error() << endl;
+  }
 
   // To avoid texture interpolation from neighboring tiles, texture coords are
   // scaled such that half a texel is removed from all sides of a tile.
 
   // width of a singl texel in texture coordinates [0, 1]
-  float texel = 1.0f / static_cast<float>(d->aoTextureSize);
+  float texel = 1.0f / static_cast<float>(cache->aoTextureSize);
   // with of a single tile in texture coordinates [0, 1]
   float tile = 1.f / std::ceil(std::sqrt(static_cast<float>(m_spheres.size())));
 
@@ -1375,6 +1681,35 @@ std::multimap<float, Identifier> AmbientOcclusionSphereGeometry::hits(
   return result;
 }
 
+void AmbientOcclusionSphereGeometry::setCache(AmbientOcclusionCache* cache)
+{
+  d->cache = cache ? cache : &d->ownCache;
+  d->cacheKey = nullptr;
+  m_dirty = true;
+}
+
+void AmbientOcclusionSphereGeometry::setCacheKey(const void* key)
+{
+  d->cache = &d->ownCache;
+  d->cacheKey = key;
+  m_dirty = true;
+}
+
+void AmbientOcclusionSphereGeometry::setProgressiveBaking(bool progressive)
+{
+  d->progressive = progressive;
+}
+
+bool AmbientOcclusionSphereGeometry::progressiveBaking() const
+{
+  return d->progressive;
+}
+
+bool AmbientOcclusionSphereGeometry::isBaking() const
+{
+  return d->cache->d->isBaking();
+}
+
 void AmbientOcclusionSphereGeometry::addSphere(const Vector3f& position,
                                                const Vector3ub& color,
                                                float radius)
@@ -19,6 +19,7 @@
 #define AVOGADRO_RENDERING_AMBIENTOCCLUSIONSPHEREGEOMETRY_H
 
 #include "drawable.h"
+#include "glresourcecache.h"
 
 #include <avogadro/core/array.h>
 #include <avogadro/core/vector.h>
@@ -27,6 +28,36 @@
 namespace Avogadro {
 namespace Rendering {
 
+/**
+ * @class AmbientOcclusionCache ambientocclusionspheregeometry.h
+ * <avogadro/rendering/ambientocclusionspheregeometry.h>
+ * @brief The AmbientOcclusionCache class keeps the baked ambient occlusion of
+ * spheres between AmbientOcclusionSphereGeometry objects.
+ *
+ * Scene plugins create new geometry every time the molecule changes. When the
+ * same cache is passed to each new geometry only the spheres that moved, and
+ * the spheres close to them, are baked again. A cache holds OpenGL resources
+ * and must only be used with one OpenGL context, it is best kept in the
+ * GLResourceCache of that context, see
+ * AmbientOcclusionSphereGeometry::setCacheKey().
+ */
+class AVOGADRORENDERING_EXPORT AmbientOcclusionCache
+  : public GLResourceCache::Resource
+{
+public:
+  AmbientOcclusionCache();
+  ~AmbientOcclusionCache() override;
+
+private:
+  AmbientOcclusionCache(const AmbientOcclusionCache&); // Not implemented.
+  AmbientOcclusionCache& operator=(
+    const AmbientOcclusionCache&); // Not implemented.
+
+  friend class AmbientOcclusionSphereGeometry;
+  class Private;
+  Private* d;
+};
+
 /**
  * @class AmbientOcclusionSphereGeometry ambientocclusionspheregeometry.h
  * <avogadro/rendering/ambientocclusionspheregeometry.h>
@@ -80,6 +111,38 @@ public:
     const Vector3f& rayOrigin, const Vector3f& rayEnd,
     const Vector3f& rayDirection) const override;
 
+  /**
+   * Keep the baked ambient occlusion in @a cache, so it can be reused by the
+   * next geometry created for the same view. The cache is not owned by the
+   * geometry and must outlive it, nullptr reverts to a private cache.
+   */
+  void setCache(AmbientOcclusionCache* cache);
+
+  /**
+   * Keep the baked ambient occlusion in a cache stored under @a key in the
+   * GLResourceCache the geometry is rendered with. Unlike setCache() the cache
+   * is deleted with the other OpenGL resources of the context, so the key only
+   * needs to identify the view, a scene plugin can pass itself for example.
+   * nullptr reverts to a private cache.
+   */
+  void setCacheKey(const void* key);
+
+  /**
+   * Spread the baking of ambient occlusion over several renders, refining the
+   * result each frame rather than stalling until all directions are baked.
+   * Defaults to false.
+   * @{
+   */
+  void setProgressiveBaking(bool progressive);
+  bool progressiveBaking() const;
+  /** @} */
+
+  /**
+   * @return True while some spheres still need their ambient occlusion baked,
+   * further renders are needed to complete it.
+   */
+  bool isBaking() const;
+
   /**
    * Add a sphere to the geometry object.
    */
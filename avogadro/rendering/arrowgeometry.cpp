@@ -19,8 +19,8 @@
 #include "avogadrogl.h"
 #include "bufferobject.h"
 #include "camera.h"
+#include "glresourcecache.h"
 #include "scene.h"
-#include "shader.h"
 #include "shaderprogram.h"
 #include "visitor.h"
 
@@ -48,10 +48,9 @@ namespace Rendering {
 class ArrowGeometry::Private
 {
 public:
-  Private() {}
+  Private() : program(nullptr) {}
 
-  Shader vertexShader;
-  ShaderProgram program;
+  ShaderProgram* program;
 };
 
 ArrowGeometry::ArrowGeometry() : m_dirty(false), d(new Private) {}
@@ -76,16 +75,8 @@ void ArrowGeometry::update()
   if (m_vertices.empty())
     return;
 
-  // Build and link the shader if it has not been used yet.
-  if (d->vertexShader.type() == Shader::Unknown) {
-    d->vertexShader.setType(Shader::Vertex);
-    d->vertexShader.setSource(arrow_vs);
-    if (!d->vertexShader.compile())
-      cout << d->vertexShader.error() << endl;
-    d->program.attachShader(d->vertexShader);
-    if (!d->program.link())
-      cout << d->program.error() << endl;
-  }
+  // The shader program is shared by all drawables of this kind.
+  d->program = GLResourceCache::current()->program("arrow", arrow_vs, nullptr);
 }
 
 void ArrowGeometry::render(const Camera& camera)
@@ -96,15 +87,16 @@ void ArrowGeometry::render(const Camera& camera)
   // Prepare the shader program if necessary.
   update();
 
-  if (!d->program.bind())
-    cout << d->program.error() << endl;
+  if (!d->program->bind())
+    cout << d->program->error() << endl;
 
   // Set up our uniforms (model-view and projection matrices right now).
-  if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
-    cout << d->program.error() << endl;
+  if (!d->program->setUniformValue("modelView", camera.modelView().matrix())) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.setUniformValue("projection", camera.projection().matrix())) {
-    cout << d->program.error() << endl;
+  if (!d->program->setUniformValue("projection",
+                                   camera.projection().matrix())) {
+    cout << d->program->error() << endl;
   }
 
   // Render the arrows using the shader.
@@ -117,7 +109,7 @@ void ArrowGeometry::render(const Camera& camera)
     drawCone(v3, m_vertices[startIndex].second, 0.05, 1.0);
   }
 
-  d->program.release();
+  d->program->release();
 }
 
 void ArrowGeometry::clear()
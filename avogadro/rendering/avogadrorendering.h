@@ -36,9 +36,11 @@ enum RenderPass
    */
   OpaquePass,
   /**
-   * Translucent geometry is being drawn. Depth testing is disabled, and alpha
-   * blending is enabled using the equivalent of the OpenGL call
+   * Translucent geometry is being drawn. Depth testing is enabled, but depth
+   * writes are disabled, and alpha blending is enabled using the equivalent of
+   * the OpenGL call
    * @code glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) @endcode
+   * Drawables are expected to render their primitives back to front.
    */
   TranslucentPass,
   /**
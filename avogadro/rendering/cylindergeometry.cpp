@@ -21,8 +21,8 @@
 #include "visitor.h"
 
 #include "bufferobject.h"
+#include "glresourcecache.h"
 
-#include "shader.h"
 #include "shaderprogram.h"
 
 namespace {
@@ -45,17 +45,12 @@ namespace Rendering {
 class CylinderGeometry::Private
 {
 public:
-  Private() {}
+  Private() : program(nullptr) {}
 
-  BufferObject vbo;
-  BufferObject ibo;
+  // Shared with other drawables showing the same cylinders.
+  GLResourceCache::BufferHandle buffers;
 
-  Shader vertexShader;
-  Shader fragmentShader;
-  ShaderProgram program;
-
-  size_t numberOfVertices;
-  size_t numberOfIndices;
+  ShaderProgram* program;
 };
 
 CylinderGeometry::CylinderGeometry() : m_dirty(false), d(new Private)
@@ -83,93 +78,96 @@ void CylinderGeometry::update()
   if (m_indices.empty() || m_cylinders.empty())
     return;
 
-  // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
-    // Set some defaults for our cylinders.
-    const unsigned int resolution = 12; // points per circle
-    const float resolutionRadians =
-      2.0f * static_cast<float>(M_PI) / static_cast<float>(resolution);
-    std::vector<Vector3f> radials;
-    radials.reserve(resolution);
-
-    std::vector<unsigned int> cylinderIndices;
-    std::vector<ColorNormalVertex> cylinderVertices;
-    // cylinderIndices.reserve(m_indices.size() * 4);
-    // cylinderVertices.reserve(m_cylinders.size() * 4);
-
-    std::vector<size_t>::const_iterator itIndex = m_indices.begin();
-    std::vector<CylinderColor>::const_iterator itCylinder = m_cylinders.begin();
-
-    for (unsigned int i = 0;
-         itIndex != m_indices.end() && itCylinder != m_cylinders.end();
-         ++i, ++itIndex, ++itCylinder) {
-
-      const Vector3f& position1 = itCylinder->end1;
-      const Vector3f& position2 = itCylinder->end2;
-      const Vector3f direction = (position2 - position1).normalized();
-      float radius = itCylinder->radius;
-
-      // Generate the radial vectors
-      Vector3f radial = direction.unitOrthogonal() * radius;
-      Eigen::AngleAxisf transform(resolutionRadians, direction);
-      radials.clear();
-      for (unsigned int j = 0; j < resolution; ++j) {
-        radials.push_back(radial);
-        radial = transform * radial;
+  // Check if the VBOs are ready, if not get them ready. Drawables showing the
+  // same cylinders share their buffers, so another view may have built them.
+  GLResourceCache* cache = GLResourceCache::current();
+  if (d->buffers.cache() != cache || m_dirty) {
+    uint64_t hash = GLResourceCache::hashValue(m_cylinders.size(), 0);
+    for (size_t i = 0; i < m_cylinders.size() && i < m_indices.size(); ++i) {
+      const CylinderColor& cylinder = m_cylinders[i];
+      hash = GLResourceCache::hashValue(cylinder.end1, hash);
+      hash = GLResourceCache::hashValue(cylinder.end2, hash);
+      hash = GLResourceCache::hashValue(cylinder.radius, hash);
+      hash = GLResourceCache::hashValue(cylinder.color, hash);
+      hash = GLResourceCache::hashValue(cylinder.color2, hash);
+      hash = GLResourceCache::hashValue(m_indices[i], hash);
+    }
+    if (d->buffers.acquire(cache, m_identifier.molecule, "cylinders", hash)) {
+      // Set some defaults for our cylinders.
+      const unsigned int resolution = 12; // points per circle
+      const float resolutionRadians =
+        2.0f * static_cast<float>(M_PI) / static_cast<float>(resolution);
+      std::vector<Vector3f> radials;
+      radials.reserve(resolution);
+
+      std::vector<unsigned int> cylinderIndices;
+      std::vector<ColorNormalVertex> cylinderVertices;
+      // cylinderIndices.reserve(m_indices.size() * 4);
+      // cylinderVertices.reserve(m_cylinders.size() * 4);
+
+      std::vector<size_t>::const_iterator itIndex = m_indices.begin();
+      std::vector<CylinderColor>::const_iterator itCylinder =
+        m_cylinders.begin();
+
+      for (unsigned int i = 0;
+           itIndex != m_indices.end() && itCylinder != m_cylinders.end();
+           ++i, ++itIndex, ++itCylinder) {
+
+        const Vector3f& position1 = itCylinder->end1;
+        const Vector3f& position2 = itCylinder->end2;
+        const Vector3f direction = (position2 - position1).normalized();
+        float radius = itCylinder->radius;
+
+        // Generate the radial vectors
+        Vector3f radial = direction.unitOrthogonal() * radius;
+        Eigen::AngleAxisf transform(resolutionRadians, direction);
+        radials.clear();
+        for (unsigned int j = 0; j < resolution; ++j) {
+          radials.push_back(radial);
+          radial = transform * radial;
+        }
+
+        // Cylinder
+        ColorNormalVertex vert(itCylinder->color, -direction, position1);
+        ColorNormalVertex vert2(itCylinder->color2, -direction, position1);
+        const unsigned int tubeStart =
+          static_cast<unsigned int>(cylinderVertices.size());
+        for (std::vector<Vector3f>::const_iterator it = radials.begin(),
+                                                   itEnd = radials.end();
+             it != itEnd; ++it) {
+          vert.normal = *it;
+          vert.vertex = position1 + *it;
+          cylinderVertices.push_back(vert);
+          vert2.normal = vert.normal;
+          vert2.vertex = position2 + *it;
+          cylinderVertices.push_back(vert2);
+        }
+        // Now to stitch it together.
+        for (unsigned int j = 0; j < resolution; ++j) {
+          unsigned int r1 = j + j;
+          unsigned int r2 = (j != 0 ? r1 : resolution + resolution) - 2;
+          cylinderIndices.push_back(tubeStart + r1);
+          cylinderIndices.push_back(tubeStart + r1 + 1);
+          cylinderIndices.push_back(tubeStart + r2);
+
+          cylinderIndices.push_back(tubeStart + r2);
+          cylinderIndices.push_back(tubeStart + r1 + 1);
+          cylinderIndices.push_back(tubeStart + r2 + 1);
+        }
       }
 
-      // Cylinder
-      ColorNormalVertex vert(itCylinder->color, -direction, position1);
-      ColorNormalVertex vert2(itCylinder->color2, -direction, position1);
-      const unsigned int tubeStart =
-        static_cast<unsigned int>(cylinderVertices.size());
-      for (std::vector<Vector3f>::const_iterator it = radials.begin(),
-                                                 itEnd = radials.end();
-           it != itEnd; ++it) {
-        vert.normal = *it;
-        vert.vertex = position1 + *it;
-        cylinderVertices.push_back(vert);
-        vert2.normal = vert.normal;
-        vert2.vertex = position2 + *it;
-        cylinderVertices.push_back(vert2);
-      }
-      // Now to stitch it together.
-      for (unsigned int j = 0; j < resolution; ++j) {
-        unsigned int r1 = j + j;
-        unsigned int r2 = (j != 0 ? r1 : resolution + resolution) - 2;
-        cylinderIndices.push_back(tubeStart + r1);
-        cylinderIndices.push_back(tubeStart + r1 + 1);
-        cylinderIndices.push_back(tubeStart + r2);
-
-        cylinderIndices.push_back(tubeStart + r2);
-        cylinderIndices.push_back(tubeStart + r1 + 1);
-        cylinderIndices.push_back(tubeStart + r2 + 1);
-      }
+      d->buffers->vbo.upload(cylinderVertices, BufferObject::ArrayBuffer);
+      d->buffers->ibo.upload(cylinderIndices, BufferObject::ElementArrayBuffer);
+      d->buffers->numberOfVertices = cylinderVertices.size();
+      d->buffers->numberOfIndices = cylinderIndices.size();
     }
 
-    d->vbo.upload(cylinderVertices, BufferObject::ArrayBuffer);
-    d->ibo.upload(cylinderIndices, BufferObject::ElementArrayBuffer);
-    d->numberOfVertices = cylinderVertices.size();
-    d->numberOfIndices = cylinderIndices.size();
-
     m_dirty = false;
   }
 
-  // Build and link the shader if it has not been used yet.
-  if (d->vertexShader.type() == Shader::Unknown) {
-    d->vertexShader.setType(Shader::Vertex);
-    d->vertexShader.setSource(cylinders_vs);
-    d->fragmentShader.setType(Shader::Fragment);
-    d->fragmentShader.setSource(cylinders_fs);
-    if (!d->vertexShader.compile())
-      cout << d->vertexShader.error() << endl;
-    if (!d->fragmentShader.compile())
-      cout << d->fragmentShader.error() << endl;
-    d->program.attachShader(d->vertexShader);
-    d->program.attachShader(d->fragmentShader);
-    if (!d->program.link())
-      cout << d->program.error() << endl;
-  }
+  // The shader program is shared by all drawables of this kind.
+  d->program = GLResourceCache::current()->program("cylinders", cylinders_vs,
+                                                   cylinders_fs);
 }
 
 void CylinderGeometry::render(const Camera& camera)
@@ -180,59 +178,61 @@ void CylinderGeometry::render(const Camera& camera)
   // Prepare the VBOs, IBOs and shader program if necessary.
   update();
 
-  if (!d->program.bind())
-    cout << d->program.error() << endl;
+  if (!d->program->bind())
+    cout << d->program->error() << endl;
 
-  d->vbo.bind();
-  d->ibo.bind();
+  d->buffers->vbo.bind();
+  d->buffers->ibo.bind();
 
   // Set up our attribute arrays.
-  if (!d->program.enableAttributeArray("vertex"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("vertex", ColorNormalVertex::vertexOffset(),
-                                    sizeof(ColorNormalVertex), FloatType, 3,
-                                    ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
+  if (!d->program->enableAttributeArray("vertex"))
+    cout << d->program->error() << endl;
+  if (!d->program->useAttributeArray(
+        "vertex", ColorNormalVertex::vertexOffset(), sizeof(ColorNormalVertex),
+        FloatType, 3, ShaderProgram::NoNormalize)) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.enableAttributeArray("color"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("color", ColorNormalVertex::colorOffset(),
-                                    sizeof(ColorNormalVertex), UCharType, 3,
-                                    ShaderProgram::Normalize)) {
-    cout << d->program.error() << endl;
+  if (!d->program->enableAttributeArray("color"))
+    cout << d->program->error() << endl;
+  if (!d->program->useAttributeArray("color", ColorNormalVertex::colorOffset(),
+                                     sizeof(ColorNormalVertex), UCharType, 3,
+                                     ShaderProgram::Normalize)) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.enableAttributeArray("normal"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("normal", ColorNormalVertex::normalOffset(),
-                                    sizeof(ColorNormalVertex), FloatType, 3,
-                                    ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
+  if (!d->program->enableAttributeArray("normal"))
+    cout << d->program->error() << endl;
+  if (!d->program->useAttributeArray(
+        "normal", ColorNormalVertex::normalOffset(), sizeof(ColorNormalVertex),
+        FloatType, 3, ShaderProgram::NoNormalize)) {
+    cout << d->program->error() << endl;
   }
 
   // Set up our uniforms (model-view and projection matrices right now).
-  if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
-    cout << d->program.error() << endl;
+  if (!d->program->setUniformValue("modelView", camera.modelView().matrix())) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.setUniformValue("projection", camera.projection().matrix())) {
-    cout << d->program.error() << endl;
+  if (!d->program->setUniformValue("projection",
+                                   camera.projection().matrix())) {
+    cout << d->program->error() << endl;
   }
   Matrix3f normalMatrix = camera.modelView().linear().inverse().transpose();
-  if (!d->program.setUniformValue("normalMatrix", normalMatrix))
-    std::cout << d->program.error() << std::endl;
+  if (!d->program->setUniformValue("normalMatrix", normalMatrix))
+    std::cout << d->program->error() << std::endl;
 
   // Render the loaded spheres using the shader and bound VBO.
-  glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices),
-                      static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
-                      reinterpret_cast<const GLvoid*>(0));
+  glDrawRangeElements(GL_TRIANGLES, 0,
+                      static_cast<GLuint>(d->buffers->numberOfVertices),
+                      static_cast<GLsizei>(d->buffers->numberOfIndices),
+                      GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(0));
 
-  d->vbo.release();
-  d->ibo.release();
+  d->buffers->vbo.release();
+  d->buffers->ibo.release();
 
-  d->program.disableAttributeArray("vector");
-  d->program.disableAttributeArray("color");
-  d->program.disableAttributeArray("normal");
+  d->program->disableAttributeArray("vector");
+  d->program->disableAttributeArray("color");
+  d->program->disableAttributeArray("normal");
 
-  d->program.release();
+  d->program->release();
 }
 
 std::multimap<float, Identifier> CylinderGeometry::hits(
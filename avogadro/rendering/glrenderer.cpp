@@ -18,8 +18,10 @@
 
 #include "avogadrogl.h"
 
+#include "ambientocclusionspheregeometry.h"
 #include "geometrynode.h"
 #include "glrendervisitor.h"
+#include "glresourcecache.h"
 #include "shader.h"
 #include "shaderprogram.h"
 #include "textlabel2d.h"
@@ -37,14 +39,19 @@ namespace Rendering {
 using Core::Array;
 
 GLRenderer::GLRenderer()
-  : m_valid(false), m_textRenderStrategy(nullptr), m_center(Vector3f::Zero()),
+  : m_valid(false), m_refining(false), m_textRenderStrategy(nullptr),
+    m_resourceCache(new GLResourceCache), m_center(Vector3f::Zero()),
     m_radius(20.0)
 {
+  m_ownResourceCache = m_resourceCache;
   m_overlayCamera.setIdentity();
 }
 
 GLRenderer::~GLRenderer()
 {
+  // The drawables release their buffers to the cache when they are deleted.
+  m_scene.clear();
+  delete m_ownResourceCache;
   delete m_textRenderStrategy;
 }
 
@@ -79,6 +86,8 @@ void GLRenderer::render()
   if (!m_valid)
     return;
 
+  GLResourceCache* previousCache = GLResourceCache::setCurrent(m_resourceCache);
+
   Vector4ub c = m_scene.backgroundColor();
   glClearColor(c[0] / 255.0f, c[1] / 255.0f, c[2] / 255.0f, c[3] / 255.0f);
   glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -91,11 +100,15 @@ void GLRenderer::render()
   glDisable(GL_BLEND);
   m_scene.rootNode().accept(visitor);
 
-  // Setup for transparent geometry
+  // Setup for transparent geometry, the drawables sort themselves back to
+  // front and the depth buffer is left untouched so that translucent
+  // surfaces do not hide each other.
   visitor.setRenderPass(TranslucentPass);
   glEnable(GL_BLEND);
   glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+  glDepthMask(GL_FALSE);
   m_scene.rootNode().accept(visitor);
+  glDepthMask(GL_TRUE);
 
   // Setup for 3d overlay rendering
   visitor.setRenderPass(Overlay3DPass);
@@ -107,6 +120,33 @@ void GLRenderer::render()
   visitor.setCamera(m_overlayCamera);
   glDisable(GL_DEPTH_TEST);
   m_scene.rootNode().accept(visitor);
+
+  // Check whether any drawables need more renders to finish refining.
+  class RefiningVisitor : public Visitor
+  {
+  public:
+    RefiningVisitor() : refining(false) {}
+    void visit(Node&) override { return; }
+    void visit(GroupNode&) override { return; }
+    void visit(GeometryNode&) override { return; }
+    void visit(Drawable&) override { return; }
+    void visit(SphereGeometry&) override { return; }
+    void visit(AmbientOcclusionSphereGeometry& g) override
+    {
+      refining = refining || g.isBaking();
+    }
+    void visit(CylinderGeometry&) override { return; }
+    void visit(MeshGeometry&) override { return; }
+    void visit(TextLabel2D&) override { return; }
+    void visit(TextLabel3D&) override { return; }
+    void visit(LineStripGeometry&) override { return; }
+    bool refining;
+  } refiningVisitor;
+
+  m_scene.rootNode().accept(refiningVisitor);
+  m_refining = refiningVisitor.refining;
+
+  GLResourceCache::setCurrent(previousCache);
 }
 
 void GLRenderer::resetCamera()
@@ -152,6 +192,11 @@ void GLRenderer::setTextRenderStrategy(TextRenderStrategy* tren)
   }
 }
 
+void GLRenderer::setResourceCache(GLResourceCache* cache)
+{
+  m_resourceCache = cache ? cache : m_ownResourceCache;
+}
+
 void GLRenderer::applyProjection()
 {
   float distance = m_camera.distance(m_center);
@@ -35,6 +35,7 @@
 namespace Avogadro {
 namespace Rendering {
 class GeometryNode;
+class GLResourceCache;
 class TextRenderStrategy;
 
 /**
@@ -58,6 +59,13 @@ public:
   /** Take care of rendering the scene, requires that the context is current. */
   void render();
 
+  /**
+   * @return True if drawables in the last render() were not finished refining
+   * themselves, such as ambient occlusion that is baked progressively. The
+   * scene should be rendered again to complete them.
+   */
+  bool isRefining() const { return m_refining; }
+
   /** Reset the view to fit the entire scene. */
   void resetCamera();
 
@@ -107,6 +115,18 @@ public:
   void setTextRenderStrategy(TextRenderStrategy* tren);
   /** @} */
 
+  /**
+   * Get/set the cache of shader programs and geometry buffers used by this
+   * renderer. By default every renderer has its own cache. Renderers whose GL
+   * contexts share objects can use the same cache so that programs are only
+   * compiled once and identical geometry is only uploaded once. The renderer
+   * does not take ownership of @a cache, which must outlive the renderer.
+   * Passing nullptr restores the renderer's own cache. @{
+   */
+  GLResourceCache* resourceCache() const { return m_resourceCache; }
+  void setResourceCache(GLResourceCache* cache);
+  /** @} */
+
 private:
   /**
    * Apply the projection matrix.
@@ -133,11 +153,14 @@ private:
                                const Frustrum& frustrum) const;
 
   bool m_valid;
+  bool m_refining;
   std::string m_error;
   Camera m_camera;
   Camera m_overlayCamera;
   Scene m_scene;
   TextRenderStrategy* m_textRenderStrategy;
+  GLResourceCache* m_resourceCache;
+  GLResourceCache* m_ownResourceCache;
 
   Vector3f m_center;
   float m_radius;
@@ -0,0 +1,190 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include "glresourcecache.h"
+
+#include "shader.h"
+#include "shaderprogram.h"
+
+#include <iostream>
+#include <map>
+#include <tuple>
+#include <utility>
+
+namespace Avogadro {
+namespace Rendering {
+
+using std::cout;
+using std::endl;
+
+namespace {
+GLResourceCache* currentCache = nullptr;
+}
+
+class GLResourceCache::Private
+{
+public:
+  struct Program
+  {
+    Shader vertexShader;
+    Shader fragmentShader;
+    ShaderProgram program;
+  };
+
+  typedef std::tuple<const void*, std::string, uint64_t> BufferKey;
+  typedef std::pair<const void*, std::string> ResourceKey;
+
+  struct BufferEntry
+  {
+    BufferEntry() : useCount(0) {}
+    GeometryBuffers buffers;
+    size_t useCount;
+  };
+
+  ~Private()
+  {
+    for (auto& resource : resources)
+      delete resource.second;
+    for (auto& program : programs)
+      delete program.second;
+    for (auto& entry : buffers)
+      delete entry.second;
+  }
+
+  std::map<std::string, Program*> programs;
+  std::map<BufferKey, BufferEntry*> buffers;
+  std::map<const GeometryBuffers*, BufferKey> bufferKeys;
+  std::map<ResourceKey, Resource*> resources;
+};
+
+GLResourceCache::GLResourceCache() : d(new Private)
+{
+}
+
+GLResourceCache::~GLResourceCache()
+{
+  if (currentCache == this)
+    currentCache = nullptr;
+  delete d;
+}
+
+GLResourceCache* GLResourceCache::current()
+{
+  if (currentCache)
+    return currentCache;
+  // Deliberately leaked, there is no GL context left to clean up at exit.
+  static GLResourceCache* defaultCache = new GLResourceCache;
+  return defaultCache;
+}
+
+GLResourceCache* GLResourceCache::setCurrent(GLResourceCache* cache)
+{
+  GLResourceCache* previous = currentCache;
+  currentCache = cache;
+  return previous;
+}
+
+ShaderProgram* GLResourceCache::program(const std::string& name,
+                                        const char* vertexSource,
+                                        const char* fragmentSource)
+{
+  auto it = d->programs.find(name);
+  if (it != d->programs.end())
+    return &it->second->program;
+
+  Private::Program* entry = new Private::Program;
+  d->programs[name] = entry;
+  entry->vertexShader.setType(Shader::Vertex);
+  entry->vertexShader.setSource(vertexSource);
+  if (!entry->vertexShader.compile())
+    cout << entry->vertexShader.error() << endl;
+  entry->program.attachShader(entry->vertexShader);
+  if (fragmentSource) {
+    entry->fragmentShader.setType(Shader::Fragment);
+    entry->fragmentShader.setSource(fragmentSource);
+    if (!entry->fragmentShader.compile())
+      cout << entry->fragmentShader.error() << endl;
+    entry->program.attachShader(entry->fragmentShader);
+  }
+  if (!entry->program.link())
+    cout << entry->program.error() << endl;
+  return &entry->program;
+}
+
+GLResourceCache::GeometryBuffers* GLResourceCache::acquireBuffers(
+  const void* molecule, const std::string& kind, uint64_t hash, bool& created)
+{
+  Private::BufferKey key(molecule, kind, hash);
+  Private::BufferEntry*& entry = d->buffers[key];
+  created = (entry == nullptr);
+  if (created) {
+    entry = new Private::BufferEntry;
+    d->bufferKeys[&entry->buffers] = key;
+  }
+  ++entry->useCount;
+  return &entry->buffers;
+}
+
+void GLResourceCache::releaseBuffers(GeometryBuffers* buffers)
+{
+  auto keyIt = d->bufferKeys.find(buffers);
+  if (keyIt == d->bufferKeys.end())
+    return;
+  auto it = d->buffers.find(keyIt->second);
+  if (--it->second->useCount == 0) {
+    delete it->second;
+    d->buffers.erase(it);
+    d->bufferKeys.erase(keyIt);
+  }
+}
+
+GLResourceCache::Resource* GLResourceCache::resource(
+  const void* owner, const std::string& kind) const
+{
+  auto it = d->resources.find(Private::ResourceKey(owner, kind));
+  return it != d->resources.end() ? it->second : nullptr;
+}
+
+void GLResourceCache::setResource(const void* owner, const std::string& kind,
+                                  Resource* resource)
+{
+  Private::ResourceKey key(owner, kind);
+  auto it = d->resources.find(key);
+  if (it != d->resources.end()) {
+    if (it->second == resource)
+      return;
+    delete it->second;
+    d->resources.erase(it);
+  }
+  if (resource)
+    d->resources[key] = resource;
+}
+
+size_t GLResourceCache::programCount() const
+{
+  return d->programs.size();
+}
+
+size_t GLResourceCache::bufferCount() const
+{
+  return d->buffers.size();
+}
+
+size_t GLResourceCache::resourceCount() const
+{
+  return d->resources.size();
+}
+
+uint64_t GLResourceCache::hash(const void* data, size_t size, uint64_t seed)
+{
+  uint64_t result = seed ? seed : 14695981039346656037ull;
+  const unsigned char* bytes = static_cast<const unsigned char*>(data);
+  for (size_t i = 0; i < size; ++i) {
+    result ^= bytes[i];
+    result *= 1099511628211ull;
+  }
+  return result;
+}
+
+} // End namespace Rendering
+} // End namespace Avogadro
@@ -0,0 +1,204 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_RENDERING_GLRESOURCECACHE_H
+#define AVOGADRO_RENDERING_GLRESOURCECACHE_H
+
+#include "avogadrorenderingexport.h"
+
+#include "bufferobject.h"
+
+#include <cstdint>
+#include <string>
+
+namespace Avogadro {
+namespace Rendering {
+
+class ShaderProgram;
+
+/**
+ * @class GLResourceCache glresourcecache.h
+ * <avogadro/rendering/glresourcecache.h>
+ * @brief Shader programs and geometry buffers shared between renderers.
+ *
+ * OpenGL objects can be used by every context in a share group, so views that
+ * share a context only need to compile each shader program and upload each
+ * geometry once. GLRenderer makes its cache current while it renders, and the
+ * drawables look up their programs and buffers in GLResourceCache::current().
+ *
+ * Shader programs are keyed by name and kept until the cache is destroyed, as
+ * are other objects holding OpenGL resources that are stored with
+ * setResource().
+ * Geometry buffers are keyed by the molecule the drawable belongs to, the kind
+ * of drawable and a hash of the data they were built from, so that drawables
+ * showing the same geometry in different views use the same buffers. They
+ * are reference counted and deleted when the last drawable releases them.
+ *
+ * All methods require the GL context to be current.
+ */
+
+class AVOGADRORENDERING_EXPORT GLResourceCache
+{
+public:
+  /** The vertex and index buffers shared by drawables with equal geometry. */
+  struct GeometryBuffers
+  {
+    GeometryBuffers()
+      : vbo(BufferObject::ArrayBuffer), ibo(BufferObject::ElementArrayBuffer),
+        numberOfVertices(0), numberOfIndices(0)
+    {
+    }
+
+    BufferObject vbo;
+    BufferObject ibo;
+    size_t numberOfVertices;
+    size_t numberOfIndices;
+  };
+
+  /**
+   * Holds one use of shared GeometryBuffers, releasing it when the handle is
+   * destroyed or other buffers are acquired.
+   */
+  class BufferHandle
+  {
+  public:
+    BufferHandle() : m_cache(nullptr), m_buffers(nullptr) {}
+    ~BufferHandle() { release(); }
+
+    /**
+     * Acquire the buffers from @a cache, see GLResourceCache::acquireBuffers.
+     * @return True if the buffers were created and must be filled.
+     */
+    bool acquire(GLResourceCache* cache, const void* molecule,
+                 const std::string& kind, uint64_t hash)
+    {
+      bool created = false;
+      GeometryBuffers* buffers =
+        cache->acquireBuffers(molecule, kind, hash, created);
+      release();
+      m_cache = cache;
+      m_buffers = buffers;
+      return created;
+    }
+
+    /** Release the buffers held by this handle, if any. */
+    void release()
+    {
+      if (m_buffers)
+        m_cache->releaseBuffers(m_buffers);
+      m_cache = nullptr;
+      m_buffers = nullptr;
+    }
+
+    /** The cache the buffers were acquired from, or nullptr. */
+    GLResourceCache* cache() const { return m_cache; }
+
+    GeometryBuffers* operator->() const { return m_buffers; }
+
+  private:
+    // Not implemented.
+    BufferHandle(const BufferHandle&);
+    BufferHandle& operator=(const BufferHandle&);
+
+    GLResourceCache* m_cache;
+    GeometryBuffers* m_buffers;
+  };
+
+  /**
+   * Base class for objects holding OpenGL resources that are kept in the
+   * cache, so that they are deleted with the other resources of the context.
+   */
+  class Resource
+  {
+  public:
+    virtual ~Resource() {}
+  };
+
+  GLResourceCache();
+  ~GLResourceCache();
+
+  /**
+   * The cache used by drawables that are rendered now. If no cache has been
+   * made current a process wide default cache is returned, so this is never
+   * null.
+   */
+  static GLResourceCache* current();
+
+  /**
+   * Make @a cache the current cache, nullptr restores the default cache.
+   * @return The previously current cache.
+   */
+  static GLResourceCache* setCurrent(GLResourceCache* cache);
+
+  /**
+   * Get the shader program called @a name, compiling and linking it from the
+   * supplied sources the first time it is requested. @a fragmentSource may be
+   * null for vertex only programs. The cache owns the returned program.
+   */
+  ShaderProgram* program(const std::string& name, const char* vertexSource,
+                         const char* fragmentSource);
+
+  /**
+   * Acquire the geometry buffers for the drawable @a kind of @a molecule built
+   * from data with the hash @a hash. If no drawable holds those buffers yet,
+   * they are created empty and @a created is set to true, the caller must then
+   * upload the geometry. Each call must be balanced by releaseBuffers().
+   */
+  GeometryBuffers* acquireBuffers(const void* molecule, const std::string& kind,
+                                  uint64_t hash, bool& created);
+
+  /**
+   * Release buffers obtained from acquireBuffers(), they are deleted when no
+   * drawable uses them any more.
+   */
+  void releaseBuffers(GeometryBuffers* buffers);
+
+  /**
+   * Get the resource of the given @a kind stored for @a owner, or nullptr if
+   * there is none.
+   */
+  Resource* resource(const void* owner, const std::string& kind) const;
+
+  /**
+   * Store @a resource as the resource of the given @a kind for @a owner,
+   * deleting any resource stored there before, nullptr only removes it. The
+   * cache takes ownership and deletes the resource when it is destroyed.
+   */
+  void setResource(const void* owner, const std::string& kind,
+                   Resource* resource);
+
+  /**
+   * The number of shader programs, geometry buffers and stored resources in
+   * the cache. @{
+   */
+  size_t programCount() const;
+  size_t bufferCount() const;
+  size_t resourceCount() const;
+  /** @} */
+
+  /**
+   * Add @a size bytes at @a data to the 64-bit FNV-1a hash @a seed, pass 0 as
+   * the seed to start a new hash.
+   */
+  static uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+
+  /** Add a value to the hash @a seed, the value must not contain padding. */
+  template <typename T>
+  static uint64_t hashValue(const T& value, uint64_t seed)
+  {
+    return hash(&value, sizeof(T), seed);
+  }
+
+private:
+  // Not implemented.
+  GLResourceCache(const GLResourceCache&);
+  GLResourceCache& operator=(const GLResourceCache&);
+
+  class Private;
+  Private* d;
+};
+
+} // End namespace Rendering
+} // End namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_GLRESOURCECACHE_H
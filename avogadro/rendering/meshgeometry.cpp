@@ -19,21 +19,28 @@
 #include "avogadrogl.h"
 #include "bufferobject.h"
 #include "camera.h"
+#include "glresourcecache.h"
 #include "scene.h"
-#include "shader.h"
 #include "shaderprogram.h"
 #include "visitor.h"
 
 #include <avogadro/core/matrix.h>
 #include <avogadro/core/vector.h>
 
+#include <algorithm>
 #include <iostream>
 #include <iterator>
 #include <limits>
+#include <numeric>
+#include <vector>
 
 namespace {
 #include "mesh_fs.h"
 #include "mesh_vs.h"
+
+// Number of triangles that are kept together when depth sorting translucent
+// meshes. Larger chunks make sorting cheaper at the cost of accuracy.
+const size_t trianglesPerChunk = 64;
 }
 
 using Avogadro::Vector3f;
@@ -52,17 +59,20 @@ const unsigned int MeshGeometry::InvalidIndex =
 class MeshGeometry::Private
 {
 public:
-  Private() {}
+  Private() : program(nullptr) {}
 
-  BufferObject vbo;
-  BufferObject ibo;
+  // Shared with other drawables showing the same mesh.
+  GLResourceCache::BufferHandle buffers;
 
-  Shader vertexShader;
-  Shader fragmentShader;
-  ShaderProgram program;
+  ShaderProgram* program;
 
-  size_t numberOfVertices;
-  size_t numberOfIndices;
+  // Used to depth sort translucent geometry, the sorted indices are kept in a
+  // buffer of our own as the order depends on the view.
+  BufferObject sortedIbo;
+  std::vector<Vector3f> chunkCenters;
+  std::vector<unsigned int> chunkOrder;
+  std::vector<float> chunkDepths;
+  Core::Array<unsigned int> sortedIndices;
 };
 
 MeshGeometry::MeshGeometry()
@@ -93,30 +103,43 @@ void MeshGeometry::update()
   if (m_vertices.empty() || m_indices.empty())
     return;
 
-  // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
-    d->vbo.upload(m_vertices, BufferObject::ArrayBuffer);
-    d->ibo.upload(m_indices, BufferObject::ElementArrayBuffer);
-    d->numberOfVertices = m_vertices.size();
-    d->numberOfIndices = m_indices.size();
+  // Check if the VBOs are ready, if not get them ready. Drawables showing the
+  // same mesh share their buffers, so another view may have uploaded them.
+  GLResourceCache* cache = GLResourceCache::current();
+  if (d->buffers.cache() != cache || m_dirty) {
+    const Core::Array<PackedVertex>& vertices = m_vertices;
+    const Core::Array<unsigned int>& indices = m_indices;
+    uint64_t hash = GLResourceCache::hash(
+      &vertices[0], vertices.size() * sizeof(PackedVertex), 0);
+    hash = GLResourceCache::hash(&indices[0],
+                                 indices.size() * sizeof(unsigned int), hash);
+    if (d->buffers.acquire(cache, m_identifier.molecule, "mesh", hash)) {
+      d->buffers->vbo.upload(vertices, BufferObject::ArrayBuffer);
+      d->buffers->ibo.upload(indices, BufferObject::ElementArrayBuffer);
+      d->buffers->numberOfVertices = vertices.size();
+      d->buffers->numberOfIndices = indices.size();
+    }
+
+    // Cache the center of each chunk of triangles for depth sorting.
+    const size_t indicesPerChunk = 3 * trianglesPerChunk;
+    const size_t chunkCount =
+      (indices.size() + indicesPerChunk - 1) / indicesPerChunk;
+    d->chunkCenters.resize(chunkCount);
+    for (size_t i = 0; i < chunkCount; ++i) {
+      const size_t begin = i * indicesPerChunk;
+      const size_t end = std::min(begin + indicesPerChunk, indices.size());
+      Vector3f center(Vector3f::Zero());
+      for (size_t j = begin; j < end; ++j)
+        center += vertices[indices[j]].vertex;
+      d->chunkCenters[i] = center / static_cast<float>(end - begin);
+    }
+    d->chunkOrder.clear();
+
     m_dirty = false;
   }
 
-  // Build and link the shader if it has not been used yet.
-  if (d->vertexShader.type() == Shader::Unknown) {
-    d->vertexShader.setType(Shader::Vertex);
-    d->vertexShader.setSource(mesh_vs);
-    d->fragmentShader.setType(Shader::Fragment);
-    d->fragmentShader.setSource(mesh_fs);
-    if (!d->vertexShader.compile())
-      cout << d->vertexShader.error() << endl;
-    if (!d->fragmentShader.compile())
-      cout << d->fragmentShader.error() << endl;
-    d->program.attachShader(d->vertexShader);
-    d->program.attachShader(d->fragmentShader);
-    if (!d->program.link())
-      cout << d->program.error() << endl;
-  }
+  // The shader program is shared by all drawables of this kind.
+  d->program = GLResourceCache::current()->program("mesh", mesh_vs, mesh_fs);
 }
 
 void MeshGeometry::render(const Camera& camera)
@@ -127,60 +150,111 @@ void MeshGeometry::render(const Camera& camera)
   // Prepare the VBOs, IBOs and shader program if necessary.
   update();
 
-  if (!d->program.bind())
-    cout << d->program.error() << endl;
+  if (m_renderPass == TranslucentPass)
+    sortChunks(camera);
+
+  if (!d->program->bind())
+    cout << d->program->error() << endl;
 
-  d->vbo.bind();
-  d->ibo.bind();
+  d->buffers->vbo.bind();
+  if (m_renderPass == TranslucentPass && !d->chunkOrder.empty())
+    d->sortedIbo.bind();
+  else
+    d->buffers->ibo.bind();
 
   // Set up our attribute arrays.
-  if (!d->program.enableAttributeArray("vertex"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("vertex", PackedVertex::vertexOffset(),
-                                    sizeof(PackedVertex), FloatType, 3,
-                                    ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
+  if (!d->program->enableAttributeArray("vertex"))
+    cout << d->program->error() << endl;
+  if (!d->program->useAttributeArray("vertex", PackedVertex::vertexOffset(),
+                                     sizeof(PackedVertex), FloatType, 3,
+                                     ShaderProgram::NoNormalize)) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.enableAttributeArray("color"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("color", PackedVertex::colorOffset(),
-                                    sizeof(PackedVertex), UCharType, 4,
-                                    ShaderProgram::Normalize)) {
-    cout << d->program.error() << endl;
+  if (!d->program->enableAttributeArray("color"))
+    cout << d->program->error() << endl;
+  if (!d->program->useAttributeArray("color", PackedVertex::colorOffset(),
+                                     sizeof(PackedVertex), UCharType, 4,
+                                     ShaderProgram::Normalize)) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.enableAttributeArray("normal"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("normal", PackedVertex::normalOffset(),
-                                    sizeof(PackedVertex), FloatType, 3,
-                                    ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
+  if (!d->program->enableAttributeArray("normal"))
+    cout << d->program->error() << endl;
+  if (!d->program->useAttributeArray("normal", PackedVertex::normalOffset(),
+                                     sizeof(PackedVertex), FloatType, 3,
+                                     ShaderProgram::NoNormalize)) {
+    cout << d->program->error() << endl;
   }
 
   // Set up our uniforms (model-view and projection matrices right now).
-  if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
-    cout << d->program.error() << endl;
+  if (!d->program->setUniformValue("modelView", camera.modelView().matrix())) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.setUniformValue("projection", camera.projection().matrix())) {
-    cout << d->program.error() << endl;
+  if (!d->program->setUniformValue("projection",
+                                   camera.projection().matrix())) {
+    cout << d->program->error() << endl;
   }
   Matrix3f normalMatrix = camera.modelView().linear().inverse().transpose();
-  if (!d->program.setUniformValue("normalMatrix", normalMatrix))
-    std::cout << d->program.error() << std::endl;
+  if (!d->program->setUniformValue("normalMatrix", normalMatrix))
+    std::cout << d->program->error() << std::endl;
 
   // Render the loaded spheres using the shader and bound VBO.
   glDrawRangeElements(GL_TRIANGLES, 0,
-                      static_cast<GLuint>(d->numberOfVertices - 1),
-                      static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
-                      reinterpret_cast<const GLvoid*>(0));
+                      static_cast<GLuint>(d->buffers->numberOfVertices - 1),
+                      static_cast<GLsizei>(d->buffers->numberOfIndices),
+                      GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(0));
 
-  d->vbo.release();
-  d->ibo.release();
+  d->buffers->vbo.release();
+  d->buffers->ibo.release();
 
-  d->program.disableAttributeArray("vector");
-  d->program.disableAttributeArray("color");
-  d->program.disableAttributeArray("normal");
+  d->program->disableAttributeArray("vector");
+  d->program->disableAttributeArray("color");
+  d->program->disableAttributeArray("normal");
 
-  d->program.release();
+  d->program->release();
+}
+
+void MeshGeometry::sortChunks(const Camera& camera)
+{
+  const size_t chunkCount = d->chunkCenters.size();
+  if (chunkCount < 2)
+    return;
+
+  // Only the view direction matters for the order, the translation part of the
+  // model view matrix adds the same offset to every depth.
+  const Vector3f viewRow = camera.modelView().linear().row(2);
+  d->chunkDepths.resize(chunkCount);
+  for (size_t i = 0; i < chunkCount; ++i)
+    d->chunkDepths[i] = viewRow.dot(d->chunkCenters[i]);
+
+  // Start from the previous order, which is usually nearly sorted.
+  std::vector<unsigned int> order(d->chunkOrder);
+  if (order.size() != chunkCount) {
+    order.resize(chunkCount);
+    std::iota(order.begin(), order.end(), 0);
+  }
+  const std::vector<float>& depths = d->chunkDepths;
+  std::stable_sort(order.begin(), order.end(),
+                   [&depths](unsigned int a, unsigned int b) {
+                     return depths[a] < depths[b];
+                   });
+  if (order == d->chunkOrder)
+    return;
+  d->chunkOrder.swap(order);
+
+  // Farthest chunks (most negative eye space z) come first.
+  const Core::Array<unsigned int>& indices = m_indices;
+  const size_t indicesPerChunk = 3 * trianglesPerChunk;
+  d->sortedIndices.resize(indices.size());
+  auto out = d->sortedIndices.begin();
+  for (unsigned int chunk : d->chunkOrder) {
+    const size_t begin = chunk * indicesPerChunk;
+    const size_t end = std::min(begin + indicesPerChunk, indices.size());
+    out = std::copy(indices.begin() + begin, indices.begin() + end, out);
+  }
+  if (!d->sortedIbo.upload(d->sortedIndices,
+                           BufferObject::ElementArrayBuffer)) {
+    cout << d->sortedIbo.error() << endl;
+  }
 }
 
 unsigned int MeshGeometry::addVertices(const Core::Array<Vector3f>& v,
@@ -71,6 +71,10 @@ public:
   /**
    * @brief Render the mesh geometry.
    * @param camera The current camera to be used for rendering.
+   *
+   * When the mesh is rendered in the TranslucentPass the triangles are drawn
+   * back to front. The triangles are sorted in fixed size chunks rather than
+   * individually, so the cost of sorting stays bounded for large meshes.
    */
   void render(const Camera& camera) override;
 
@@ -155,6 +159,12 @@ private:
    */
   void update();
 
+  /**
+   * @brief Sort the triangle chunks back to front for the supplied camera,
+   * uploading a new index buffer if the order changed.
+   */
+  void sortChunks(const Camera& camera);
+
   Core::Array<PackedVertex> m_vertices;
   Core::Array<unsigned int> m_indices;
   Vector3ub m_color;
@@ -0,0 +1,71 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#ifndef AVOGADRO_RENDERING_PARALLELFORMAT_H
+#define AVOGADRO_RENDERING_PARALLELFORMAT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Avogadro {
+namespace Rendering {
+
+/**
+ * Format @a count items to @a out, splitting the work into chunks of
+ * @a chunkSize items that are formatted concurrently on worker threads.
+ *
+ * @a format is called as format(std::ostream& str, size_t begin, size_t end)
+ * and must write items [begin, end) to str. It is called from several threads
+ * at once, so it must only read shared state. The chunks are written to
+ * @a out in order, so the output is identical to a single-threaded loop. At
+ * most one chunk per thread is held in memory at any time.
+ */
+template <typename Formatter>
+void formatParallel(std::ostream& out, size_t count, const Formatter& format,
+                    size_t chunkSize = 4096)
+{
+  if (count == 0)
+    return;
+  chunkSize = std::max(chunkSize, static_cast<size_t>(1));
+  size_t chunks = (count + chunkSize - 1) / chunkSize;
+  size_t threads = std::min(
+    chunks, std::max(static_cast<size_t>(std::thread::hardware_concurrency()),
+                     static_cast<size_t>(1)));
+  if (threads == 1) {
+    format(out, 0, count);
+    return;
+  }
+
+  std::vector<std::string> buffers(threads);
+  std::vector<std::thread> workers;
+  workers.reserve(threads);
+  for (size_t first = 0; first < chunks; first += threads) {
+    size_t batch = std::min(threads, chunks - first);
+    for (size_t t = 0; t < batch; ++t) {
+      workers.emplace_back([&, first, t]() {
+        size_t begin = (first + t) * chunkSize;
+        size_t end = std::min(begin + chunkSize, count);
+        std::ostringstream str;
+        format(str, begin, end);
+        buffers[t] = str.str();
+      });
+    }
+    for (size_t t = 0; t < batch; ++t)
+      workers[t].join();
+    workers.clear();
+    for (size_t t = 0; t < batch; ++t) {
+      out << buffers[t];
+      buffers[t].clear();
+    }
+  }
+}
+
+} // End namespace Rendering
+} // End namespace Avogadro
+
+#endif // AVOGADRO_RENDERING_PARALLELFORMAT_H
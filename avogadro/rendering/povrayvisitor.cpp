@@ -20,10 +20,13 @@
 #include "cylindergeometry.h"
 #include "linestripgeometry.h"
 #include "meshgeometry.h"
+#include "parallelformat.h"
 #include "spheregeometry.h"
 
 #include <iostream>
+#include <map>
 #include <ostream>
+#include <vector>
 
 namespace Avogadro {
 namespace Rendering {
@@ -34,6 +37,7 @@ using std::endl;
 using std::ostringstream;
 using std::ostream;
 using std::ofstream;
+using std::vector;
 
 namespace {
 ostream& operator<<(ostream& os, const Vector3f& v)
@@ -48,11 +52,31 @@ ostream& operator<<(ostream& os, const Vector3ub& color)
      << color[2] / 255.0f;
   return os;
 }
+
+// Group the indices of the primitives by color, in order of first appearance.
+template <typename Container>
+vector<vector<size_t>> groupByColor(const Container& primitives)
+{
+  std::map<unsigned int, size_t> groupIndex;
+  vector<vector<size_t>> groups;
+  for (size_t i = 0; i < primitives.size(); ++i) {
+    const Vector3ub& c = primitives[i].color;
+    unsigned int key = (c[0] << 16) | (c[1] << 8) | c[2];
+    auto it = groupIndex.find(key);
+    if (it == groupIndex.end()) {
+      it = groupIndex.insert(std::make_pair(key, groups.size())).first;
+      groups.push_back(vector<size_t>());
+    }
+    groups[it->second].push_back(i);
+  }
+  return groups;
+}
 }
 
 POVRayVisitor::POVRayVisitor(const Camera& c)
   : m_camera(c), m_backgroundColor(255, 255, 255),
-    m_ambientColor(100, 100, 100), m_aspectRatio(800.0f / 600.0f)
+    m_ambientColor(100, 100, 100), m_aspectRatio(800.0f / 600.0f),
+    m_stream(&m_buffer), m_useUnions(true)
 {
 }
 
@@ -62,6 +86,14 @@ POVRayVisitor::~POVRayVisitor()
 
 void POVRayVisitor::begin()
 {
+  m_buffer.str(string());
+  begin(m_buffer);
+}
+
+void POVRayVisitor::begin(ostream& stream)
+{
+  m_stream = &stream;
+
   // Initialise our POV-Ray scene
   // The POV-Ray camera basically has the same matrix elements - we just need to
   // translate
@@ -81,43 +113,48 @@ void POVRayVisitor::begin()
     huge * (m_camera.modelView().linear().adjoint() * Vector3f(0, 1, 0));
 
   // Output the POV-Ray initialisation code
-  ostringstream str;
-  str << "global_settings {\n"
-      << "\tambient_light rgb <" << m_ambientColor << ">\n"
-      << "\tmax_trace_level 15\n}\n\n"
-      << "background { color rgb <" << m_backgroundColor << "> }\n\n"
-      << "camera {\n"
-      << "\tperspective\n"
-      << "\tlocation <" << cameraT.x() << ", " << cameraT.y() << ", "
-      << cameraT.z() << ">\n"
-      << "\tangle 70\n"
-      << "\tup <" << cameraY.x() << ", " << cameraY.y() << ", " << cameraY.z()
-      << ">\n"
-      << "\tright <" << cameraX.x() << ", " << cameraX.y() << ", "
-      << cameraX.z() << "> * " << m_aspectRatio << '\n'
-      << "\tdirection <" << cameraZ.x() << ", " << cameraZ.y() << ", "
-      << cameraZ.z() << "> }\n\n"
-
-      << "light_source {\n"
-      << "\t<" << light0pos[0] << ", " << light0pos[1] << ", " << light0pos[2]
-      << ">\n"
-      << "\tcolor rgb <1.0, 1.0, 1.0>\n"
-      << "\tfade_distance " << 2 * huge << '\n'
-      << "\tfade_power 0\n"
-      << "\tparallel\n"
-      << "\tpoint_at <" << -light0pos[0] << ", " << -light0pos[1] << ", "
-      << -light0pos[2] << ">\n"
-      << "}\n\n"
-
-      << "#default {\n\tfinish {ambient .8 diffuse 1 specular 1 roughness .005 "
-         "metallic 0.5}\n}\n\n";
-
-  m_sceneData = str.str();
+  *m_stream
+    << "global_settings {\n"
+    << "\tambient_light rgb <" << m_ambientColor << ">\n"
+    << "\tmax_trace_level 15\n}\n\n"
+    << "background { color rgb <" << m_backgroundColor << "> }\n\n"
+    << "camera {\n"
+    << "\tperspective\n"
+    << "\tlocation <" << cameraT.x() << ", " << cameraT.y() << ", "
+    << cameraT.z() << ">\n"
+    << "\tangle 70\n"
+    << "\tup <" << cameraY.x() << ", " << cameraY.y() << ", " << cameraY.z()
+    << ">\n"
+    << "\tright <" << cameraX.x() << ", " << cameraX.y() << ", " << cameraX.z()
+    << "> * " << m_aspectRatio << '\n'
+    << "\tdirection <" << cameraZ.x() << ", " << cameraZ.y() << ", "
+    << cameraZ.z() << "> }\n\n"
+
+    << "light_source {\n"
+    << "\t<" << light0pos[0] << ", " << light0pos[1] << ", " << light0pos[2]
+    << ">\n"
+    << "\tcolor rgb <1.0, 1.0, 1.0>\n"
+    << "\tfade_distance " << 2 * huge << '\n'
+    << "\tfade_power 0\n"
+    << "\tparallel\n"
+    << "\tpoint_at <" << -light0pos[0] << ", " << -light0pos[1] << ", "
+    << -light0pos[2] << ">\n"
+    << "}\n\n"
+
+    << "#default {\n\tfinish {ambient .8 diffuse 1 specular 1 roughness .005 "
+       "metallic 0.5}\n}\n\n";
 }
 
 string POVRayVisitor::end()
 {
-  return m_sceneData;
+  if (m_stream != &m_buffer) {
+    m_stream->flush();
+    m_stream = &m_buffer;
+    return string();
+  }
+  string sceneData = m_buffer.str();
+  m_buffer.str(string());
+  return sceneData;
 }
 
 void POVRayVisitor::visit(Drawable& geometry)
@@ -127,13 +164,35 @@ void POVRayVisitor::visit(Drawable& geometry)
 
 void POVRayVisitor::visit(SphereGeometry& geometry)
 {
-  ostringstream str;
-  for (size_t i = 0; i < geometry.spheres().size(); ++i) {
-    Rendering::SphereColor s = geometry.spheres()[i];
-    str << "sphere {\n\t<" << s.center << ">, " << s.radius
-        << "\n\tpigment { rgbt <" << s.color << ", 0.0> }\n}\n";
+  const Core::Array<SphereColor>& spheres = geometry.spheres();
+  if (!m_useUnions) {
+    formatParallel(*m_stream, spheres.size(),
+                   [&spheres](ostream& str, size_t begin, size_t end) {
+                     for (size_t i = begin; i < end; ++i) {
+                       const SphereColor& s = spheres[i];
+                       str << "sphere {\n\t<" << s.center << ">, " << s.radius
+                           << "\n\tpigment { rgbt <" << s.color
+                           << ", 0.0> }\n}\n";
+                     }
+                   });
+    return;
+  }
+
+  vector<vector<size_t>> groups = groupByColor(spheres);
+  for (size_t g = 0; g < groups.size(); ++g) {
+    const vector<size_t>& group = groups[g];
+    *m_stream << "union {\n";
+    formatParallel(*m_stream, group.size(),
+                   [&spheres, &group](ostream& str, size_t begin, size_t end) {
+                     for (size_t i = begin; i < end; ++i) {
+                       const SphereColor& s = spheres[group[i]];
+                       str << "\tsphere { <" << s.center << ">, " << s.radius
+                           << " }\n";
+                     }
+                   });
+    *m_stream << "\tpigment { rgbt <" << spheres[group.front()].color
+              << ", 0.0> }\n}\n";
   }
-  m_sceneData += str.str();
 }
 
 void POVRayVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
@@ -143,52 +202,93 @@ void POVRayVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
 
 void POVRayVisitor::visit(CylinderGeometry& geometry)
 {
-  ostringstream str;
-  for (size_t i = 0; i < geometry.cylinders().size(); ++i) {
-    Rendering::CylinderColor c = geometry.cylinders()[i];
-    str << "cylinder {\n"
-        << "\t<" << c.end1 << ">,\n"
-        << "\t<" << c.end2 << ">, " << c.radius << "\n\tpigment { rgbt <"
-        << c.color << ", 0.0> }\n}\n";
+  const vector<CylinderColor>& cylinders = geometry.cylinders();
+  if (!m_useUnions) {
+    formatParallel(*m_stream, cylinders.size(),
+                   [&cylinders](ostream& str, size_t begin, size_t end) {
+                     for (size_t i = begin; i < end; ++i) {
+                       const CylinderColor& c = cylinders[i];
+                       str << "cylinder {\n"
+                           << "\t<" << c.end1 << ">,\n"
+                           << "\t<" << c.end2 << ">, " << c.radius
+                           << "\n\tpigment { rgbt <" << c.color
+                           << ", 0.0> }\n}\n";
+                     }
+                   });
+    return;
+  }
+
+  vector<vector<size_t>> groups = groupByColor(cylinders);
+  for (size_t g = 0; g < groups.size(); ++g) {
+    const vector<size_t>& group = groups[g];
+    *m_stream << "union {\n";
+    formatParallel(
+      *m_stream, group.size(),
+      [&cylinders, &group](ostream& str, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+          const CylinderColor& c = cylinders[group[i]];
+          str << "\tcylinder { <" << c.end1 << ">, <" << c.end2 << ">, "
+              << c.radius << " }\n";
+        }
+      });
+    *m_stream << "\tpigment { rgbt <" << cylinders[group.front()].color
+              << ", 0.0> }\n}\n";
   }
-  m_sceneData += str.str();
 }
 
 void POVRayVisitor::visit(MeshGeometry& geometry)
 {
-  ostringstream str;
-  str << "mesh2 {\n";
-  Core::Array<Rendering::MeshGeometry::PackedVertex> v = geometry.vertices();
-  Core::Array<unsigned int> tris = geometry.triangles();
-  str << "vertex_vectors{" << v.size() << ",\n";
-  for (size_t i = 0; i < v.size(); ++i) {
-    str << "<" << v[i].vertex << ">,";
-    if (i != 0 && i % 3)
-      str << "\n";
-  }
-  str << "\n}\n";
-  str << "normal_vectors{" << v.size() << ",\n";
+  const Core::Array<MeshGeometry::PackedVertex> v = geometry.vertices();
+  const Core::Array<unsigned int> tris = geometry.triangles();
+  size_t numFaces = tris.size() / 3;
+  if (v.empty() || numFaces == 0)
+    return;
+
+  // Write one texture per distinct vertex color rather than one per vertex.
+  std::map<unsigned int, size_t> textureIndex;
+  vector<Vector4ub> textures;
+  vector<size_t> vertexTexture(v.size());
   for (size_t i = 0; i < v.size(); ++i) {
-    str << "<" << v[i].normal << ">,";
-    if (i != 0 && i % 3)
-      str << "\n";
+    const Vector4ub& c = v[i].color;
+    unsigned int key = (c[0] << 24) | (c[1] << 16) | (c[2] << 8) | c[3];
+    auto it = textureIndex.find(key);
+    if (it == textureIndex.end()) {
+      it = textureIndex.insert(std::make_pair(key, textures.size())).first;
+      textures.push_back(c);
+    }
+    vertexTexture[i] = it->second;
   }
-  str << "\n}\n";
-  str << "texture_list{" << v.size() << ",\n";
-  for (size_t i = 0; i < v.size(); ++i)
-    str << "texture{pigment{rgb<" << v[i].normal << ">}\n";
-  str << "\n}\n";
-  str << "face_indices{" << tris.size() / 3 << ",\n";
-  for (size_t i = 0; i < tris.size(); i += 3) {
-    str << "<" << tris[i] << "," << tris[i + 1] << "," << tris[i + 2] << ">";
-    if (i != tris.size() - 3)
-      str << ", ";
-    if (i != 0 && ((i + 1) / 3) % 3 == 0)
-      str << '\n';
+
+  ostream& out = *m_stream;
+  out << "mesh2 {\n\tvertex_vectors { " << v.size() << ",\n";
+  formatParallel(out, v.size(), [&v](ostream& str, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+      str << "\t\t<" << v[i].vertex << ">" << (i + 1 < v.size() ? ",\n" : "\n");
+  });
+  out << "\t}\n\tnormal_vectors { " << v.size() << ",\n";
+  formatParallel(out, v.size(), [&v](ostream& str, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+      str << "\t\t<" << v[i].normal << ">" << (i + 1 < v.size() ? ",\n" : "\n");
+  });
+  out << "\t}\n\ttexture_list { " << textures.size() << ",\n";
+  for (size_t i = 0; i < textures.size(); ++i) {
+    const Vector4ub& c = textures[i];
+    out << "\t\ttexture { pigment { rgbt <" << Vector3ub(c[0], c[1], c[2])
+        << ", " << 1.0f - c[3] / 255.0f << "> } }\n";
   }
-  str << "\n}\n";
-  str << "\tpigment { rgbt <1.0, 0.0, 0.0, 1.0> }\n"
-      << "}\n\n";
+  out << "\t}\n\tface_indices { " << numFaces << ",\n";
+  formatParallel(out, numFaces, [&tris, &vertexTexture, numFaces](
+                                  ostream& str, size_t begin, size_t end) {
+    for (size_t f = begin; f < end; ++f) {
+      unsigned int a = tris[3 * f];
+      unsigned int b = tris[3 * f + 1];
+      unsigned int c = tris[3 * f + 2];
+      str << "\t\t<" << a << ", " << b << ", " << c << ">, "
+          << vertexTexture[a] << ", " << vertexTexture[b] << ", "
+          << vertexTexture[c] << (f + 1 < numFaces ? ",\n" : "\n");
+    }
+  });
+  out << "\t}\n}\n\n";
 }
 
 void POVRayVisitor::visit(LineStripGeometry& geometry)
@@ -21,6 +21,9 @@
 
 #include "avogadrorendering.h"
 #include "camera.h"
+
+#include <ostream>
+#include <sstream>
 #include <string>
 
 namespace Avogadro {
@@ -40,7 +43,23 @@ public:
   POVRayVisitor(const Camera& camera);
   ~POVRayVisitor() override;
 
+  /**
+   * Start a new scene that is buffered in memory and returned by end().
+   */
   void begin();
+
+  /**
+   * Start a new scene that is written directly to @a stream as the scene is
+   * visited. The stream should be buffered, e.g. an std::ofstream, and must
+   * stay valid until end() is called.
+   */
+  void begin(std::ostream& stream);
+
+  /**
+   * Finish the scene. If the scene was started with begin() the complete
+   * scene is returned, otherwise the stream is flushed and an empty string is
+   * returned.
+   */
   std::string end();
 
   /**
@@ -65,12 +84,23 @@ public:
   void setAmbientColor(const Vector3ub& c) { m_ambientColor = c; }
   void setAspectRatio(float ratio) { m_aspectRatio = ratio; }
 
+  /**
+   * If true (the default), spheres and cylinders with the same color are
+   * written as one union block sharing a single pigment, which keeps the file
+   * smaller and faster for POV-Ray to parse. If false, every primitive gets
+   * its own pigment.
+   */
+  void setUseUnions(bool useUnions) { m_useUnions = useUnions; }
+  bool useUnions() const { return m_useUnions; }
+
 private:
   Camera m_camera;
   Vector3ub m_backgroundColor;
   Vector3ub m_ambientColor;
   float m_aspectRatio;
-  std::string m_sceneData;
+  std::ostringstream m_buffer;
+  std::ostream* m_stream;
+  bool m_useUnions;
 };
 
 } // End namespace Rendering
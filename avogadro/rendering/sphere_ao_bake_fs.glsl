@@ -31,6 +31,9 @@ uniform sampler2D u_depthTex;
 // intensity = 1 / (number of light directions)
 uniform float u_intensity;
 
+// the alpha channel counts the baked light directions, one step per direction
+const float directionWeight = 1.0 / 255.0;
+
 /**
  * Inverse gnomonic projection over octahedron unfloded into a square. This
  * inverse  projection goes from texture coordinates to the surface of the unit
@@ -73,10 +76,10 @@ void main()
   // since we are using flat impostors in the depth texture, cos_alpha needs to be positive
   if (cos_alpha > 0.0 && texture2D(u_depthTex, pos.xy).r > pos.z) {
     // the texel is visible from the light source
-    gl_FragColor = vec4(vec3(1.0, 1.0, 1.0) * cos_alpha * u_intensity, 1.0);
+    gl_FragColor = vec4(vec3(1.0, 1.0, 1.0) * cos_alpha * u_intensity, directionWeight);
   } else {
     // texel not visible
-    gl_FragColor = vec4(0.0, 0.0, 0.0, 0.0);
+    gl_FragColor = vec4(0.0, 0.0, 0.0, directionWeight);
   }
 
 }
@@ -20,6 +20,8 @@ uniform mat4 u_projection;
 // the texture sampler
 uniform sampler2D u_tex;
 uniform float u_texScale;
+// the total number of light directions used to bake the AO
+uniform float u_numDirections;
 
 #ifdef CONTOUR_LINES
 const float contourWidth = 0.3;
@@ -107,7 +109,12 @@ void main()
 
   // final color
   vec3 color = ambient + diffuse + specular;
-  gl_FragColor = 1.2 * vec4(color, 1.0) * texture2D(u_tex, uv); // AO + Phong reflection [+ contours]
+  // the alpha channel holds the number of directions baked so far, scale
+  // partially baked tiles to the brightness of a complete bake
+  vec4 ao = texture2D(u_tex, uv);
+  float bakedDirections = max(1.0, floor(ao.a * 255.0 + 0.5));
+  ao.rgb *= u_numDirections / bakedDirections;
+  gl_FragColor = vec4(1.2 * color * ao.rgb, 1.0); // AO + Phong reflection [+ contours]
   //gl_FragColor = vec4(color, 1.0); // Phong reflection [+ contours]
   //gl_FragColor = 1.2 * texture2D(u_tex, uv); // AO [+ contours]
   //gl_FragColor = vec4(1.0, 1.0, 1.0, 1.0); // contours + white atoms
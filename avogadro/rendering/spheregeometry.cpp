@@ -20,8 +20,8 @@
 #include "scene.h"
 
 #include "bufferobject.h"
+#include "glresourcecache.h"
 
-#include "shader.h"
 #include "shaderprogram.h"
 
 #include "visitor.h"
@@ -33,7 +33,9 @@ namespace {
 
 #include "avogadrogl.h"
 
+#include <algorithm>
 #include <iostream>
+#include <numeric>
 
 using std::cout;
 using std::endl;
@@ -46,17 +48,19 @@ using Core::Array;
 class SphereGeometry::Private
 {
 public:
-  Private() {}
+  Private() : program(nullptr) {}
 
-  BufferObject vbo;
-  BufferObject ibo;
+  // Shared with other drawables showing the same spheres.
+  GLResourceCache::BufferHandle buffers;
 
-  Shader vertexShader;
-  Shader fragmentShader;
-  ShaderProgram program;
+  ShaderProgram* program;
 
-  size_t numberOfVertices;
-  size_t numberOfIndices;
+  // Used to depth sort translucent spheres, the sorted indices are kept in a
+  // buffer of our own as the order depends on the view.
+  BufferObject sortedIbo;
+  std::vector<unsigned int> sphereOrder;
+  std::vector<float> sphereDepths;
+  std::vector<unsigned int> sortedIndices;
 };
 
 SphereGeometry::SphereGeometry() : m_dirty(false), d(new Private)
@@ -84,70 +88,74 @@ void SphereGeometry::update()
   if (m_indices.empty() || m_spheres.empty())
     return;
 
-  // Check if the VBOs are ready, if not get them ready.
-  if (!d->vbo.ready() || m_dirty) {
-    std::vector<unsigned int> sphereIndices;
-    std::vector<ColorTextureVertex> sphereVertices;
-    sphereIndices.reserve(m_indices.size() * 4);
-    sphereVertices.reserve(m_spheres.size() * 4);
-
-    std::vector<size_t>::const_iterator itIndex = m_indices.begin();
-    std::vector<SphereColor>::const_iterator itSphere = m_spheres.begin();
-
-    for (unsigned int i = 0;
-         itIndex != m_indices.end() && itSphere != m_spheres.end();
-         ++i, ++itIndex, ++itSphere) {
-      // Use our packed data structure...
-      float r = itSphere->radius;
-      unsigned int index = 4 * static_cast<unsigned int>(*itIndex);
-      ColorTextureVertex vert(itSphere->center, itSphere->color,
-                              Vector2f(-r, -r));
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(-r, r);
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(r, -r);
-      sphereVertices.push_back(vert);
-      vert.textureCoord = Vector2f(r, r);
-      sphereVertices.push_back(vert);
-
-      // 6 indexed vertices to draw a quad...
-      sphereIndices.push_back(index + 0);
-      sphereIndices.push_back(index + 1);
-      sphereIndices.push_back(index + 2);
-      sphereIndices.push_back(index + 3);
-      sphereIndices.push_back(index + 2);
-      sphereIndices.push_back(index + 1);
-
-      // m_spheres.push_back(Sphere(position, r, id, color));
+  // Check if the VBOs are ready, if not get them ready. Drawables showing the
+  // same spheres share their buffers, so another view may have built them.
+  GLResourceCache* cache = GLResourceCache::current();
+  if (d->buffers.cache() != cache || m_dirty) {
+    const Array<SphereColor>& spheres = m_spheres;
+    uint64_t hash = GLResourceCache::hashValue(spheres.size(), 0);
+    for (size_t i = 0; i < spheres.size() && i < m_indices.size(); ++i) {
+      const SphereColor& sphere = spheres[i];
+      hash = GLResourceCache::hashValue(sphere.center, hash);
+      hash = GLResourceCache::hashValue(sphere.radius, hash);
+      hash = GLResourceCache::hashValue(sphere.color, hash);
+      hash = GLResourceCache::hashValue(m_indices[i], hash);
     }
+    if (d->buffers.acquire(cache, m_identifier.molecule, "spheres", hash)) {
+      std::vector<unsigned int> sphereIndices;
+      std::vector<ColorTextureVertex> sphereVertices;
+      sphereIndices.reserve(m_indices.size() * 4);
+      sphereVertices.reserve(m_spheres.size() * 4);
+
+      std::vector<size_t>::const_iterator itIndex = m_indices.begin();
+      std::vector<SphereColor>::const_iterator itSphere = m_spheres.begin();
+
+      for (unsigned int i = 0;
+           itIndex != m_indices.end() && itSphere != m_spheres.end();
+           ++i, ++itIndex, ++itSphere) {
+        // Use our packed data structure...
+        float r = itSphere->radius;
+        unsigned int index = 4 * static_cast<unsigned int>(*itIndex);
+        ColorTextureVertex vert(itSphere->center, itSphere->color,
+                                Vector2f(-r, -r));
+        sphereVertices.push_back(vert);
+        vert.textureCoord = Vector2f(-r, r);
+        sphereVertices.push_back(vert);
+        vert.textureCoord = Vector2f(r, -r);
+        sphereVertices.push_back(vert);
+        vert.textureCoord = Vector2f(r, r);
+        sphereVertices.push_back(vert);
+
+        // 6 indexed vertices to draw a quad...
+        sphereIndices.push_back(index + 0);
+        sphereIndices.push_back(index + 1);
+        sphereIndices.push_back(index + 2);
+        sphereIndices.push_back(index + 3);
+        sphereIndices.push_back(index + 2);
+        sphereIndices.push_back(index + 1);
+
+        // m_spheres.push_back(Sphere(position, r, id, color));
+      }
 
-    if (!d->vbo.upload(sphereVertices, BufferObject::ArrayBuffer))
-      cout << d->vbo.error() << endl;
+      if (!d->buffers->vbo.upload(sphereVertices, BufferObject::ArrayBuffer))
+        cout << d->buffers->vbo.error() << endl;
 
-    if (!d->ibo.upload(sphereIndices, BufferObject::ElementArrayBuffer))
-      cout << d->ibo.error() << endl;
+      if (!d->buffers->ibo.upload(sphereIndices,
+                                  BufferObject::ElementArrayBuffer)) {
+        cout << d->buffers->ibo.error() << endl;
+      }
 
-    d->numberOfVertices = sphereVertices.size();
-    d->numberOfIndices = sphereIndices.size();
+      d->buffers->numberOfVertices = sphereVertices.size();
+      d->buffers->numberOfIndices = sphereIndices.size();
+    }
+    d->sphereOrder.clear();
 
     m_dirty = false;
   }
 
-  // Build and link the shader if it has not been used yet.
-  if (d->vertexShader.type() == Shader::Unknown) {
-    d->vertexShader.setType(Shader::Vertex);
-    d->vertexShader.setSource(spheres_vs);
-    d->fragmentShader.setType(Shader::Fragment);
-    d->fragmentShader.setSource(spheres_fs);
-    if (!d->vertexShader.compile())
-      cout << d->vertexShader.error() << endl;
-    if (!d->fragmentShader.compile())
-      cout << d->fragmentShader.error() << endl;
-    d->program.attachShader(d->vertexShader);
-    d->program.attachShader(d->fragmentShader);
-    if (!d->program.link())
-      cout << d->program.error() << endl;
-  }
+  // The shader program is shared by all drawables of this kind.
+  d->program =
+    GLResourceCache::current()->program("spheres", spheres_vs, spheres_fs);
 }
 
 void SphereGeometry::render(const Camera& camera)
@@ -158,59 +166,115 @@ void SphereGeometry::render(const Camera& camera)
   // Prepare the VBOs, IBOs and shader program if necessary.
   update();
 
-  if (!d->program.bind())
-    cout << d->program.error() << endl;
+  if (m_renderPass == TranslucentPass)
+    sortSpheres(camera);
 
-  d->vbo.bind();
-  d->ibo.bind();
+  if (!d->program->bind())
+    cout << d->program->error() << endl;
+
+  d->buffers->vbo.bind();
+  if (m_renderPass == TranslucentPass && !d->sphereOrder.empty())
+    d->sortedIbo.bind();
+  else
+    d->buffers->ibo.bind();
 
   // Set up our attribute arrays.
-  if (!d->program.enableAttributeArray("vertex"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray(
+  if (!d->program->enableAttributeArray("vertex"))
+    cout << d->program->error() << endl;
+  if (!d->program->useAttributeArray(
         "vertex", ColorTextureVertex::vertexOffset(),
         sizeof(ColorTextureVertex), FloatType, 3, ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
+    cout << d->program->error() << endl;
   }
-  if (!d->program.enableAttributeArray("color"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray("color", ColorTextureVertex::colorOffset(),
-                                    sizeof(ColorTextureVertex), UCharType, 3,
-                                    ShaderProgram::Normalize)) {
-    cout << d->program.error() << endl;
+  if (!d->program->enableAttributeArray("color"))
+    cout << d->program->error() << endl;
+  if (!d->program->useAttributeArray("color", ColorTextureVertex::colorOffset(),
+                                     sizeof(ColorTextureVertex), UCharType, 3,
+                                     ShaderProgram::Normalize)) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.enableAttributeArray("texCoordinate"))
-    cout << d->program.error() << endl;
-  if (!d->program.useAttributeArray(
+  if (!d->program->enableAttributeArray("texCoordinate"))
+    cout << d->program->error() << endl;
+  if (!d->program->useAttributeArray(
         "texCoordinate", ColorTextureVertex::textureCoordOffset(),
         sizeof(ColorTextureVertex), FloatType, 2, ShaderProgram::NoNormalize)) {
-    cout << d->program.error() << endl;
+    cout << d->program->error() << endl;
   }
 
   // Set up our uniforms (model-view and projection matrices right now).
-  if (!d->program.setUniformValue("modelView", camera.modelView().matrix())) {
-    cout << d->program.error() << endl;
+  if (!d->program->setUniformValue("modelView", camera.modelView().matrix())) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.setUniformValue("projection", camera.projection().matrix())) {
-    cout << d->program.error() << endl;
+  if (!d->program->setUniformValue("projection",
+                                   camera.projection().matrix())) {
+    cout << d->program->error() << endl;
   }
-  if (!d->program.setUniformValue("opacity", m_opacity)) {
-    cout << d->program.error() << endl;
+  if (!d->program->setUniformValue("opacity", m_opacity)) {
+    cout << d->program->error() << endl;
   }
 
   // Render the loaded spheres using the shader and bound VBO.
-  glDrawRangeElements(GL_TRIANGLES, 0, static_cast<GLuint>(d->numberOfVertices),
-                      static_cast<GLsizei>(d->numberOfIndices), GL_UNSIGNED_INT,
-                      reinterpret_cast<const GLvoid*>(NULL));
+  glDrawRangeElements(GL_TRIANGLES, 0,
+                      static_cast<GLuint>(d->buffers->numberOfVertices),
+                      static_cast<GLsizei>(d->buffers->numberOfIndices),
+                      GL_UNSIGNED_INT, reinterpret_cast<const GLvoid*>(NULL));
+
+  d->buffers->vbo.release();
+  d->buffers->ibo.release();
+
+  d->program->disableAttributeArray("vector");
+  d->program->disableAttributeArray("color");
+  d->program->disableAttributeArray("texCoordinates");
 
-  d->vbo.release();
-  d->ibo.release();
+  d->program->release();
+}
 
-  d->program.disableAttributeArray("vector");
-  d->program.disableAttributeArray("color");
-  d->program.disableAttributeArray("texCoordinates");
+void SphereGeometry::sortSpheres(const Camera& camera)
+{
+  const Array<SphereColor>& spheres = m_spheres;
+  const size_t sphereCount = std::min(spheres.size(), m_indices.size());
+  if (sphereCount < 2)
+    return;
 
-  d->program.release();
+  // Only the view direction matters for the order, the translation part of the
+  // model view matrix adds the same offset to every depth.
+  const Vector3f viewRow = camera.modelView().linear().row(2);
+  d->sphereDepths.resize(sphereCount);
+  for (size_t i = 0; i < sphereCount; ++i)
+    d->sphereDepths[i] = viewRow.dot(spheres[i].center);
+
+  // Start from the previous order, which is usually nearly sorted.
+  std::vector<unsigned int> order(d->sphereOrder);
+  if (order.size() != sphereCount) {
+    order.resize(sphereCount);
+    std::iota(order.begin(), order.end(), 0);
+  }
+  const std::vector<float>& depths = d->sphereDepths;
+  std::stable_sort(order.begin(), order.end(),
+                   [&depths](unsigned int a, unsigned int b) {
+                     return depths[a] < depths[b];
+                   });
+  if (order == d->sphereOrder)
+    return;
+  d->sphereOrder.swap(order);
+
+  // Farthest spheres (most negative eye space z) come first, each sphere is a
+  // quad of four vertices drawn as two triangles.
+  d->sortedIndices.clear();
+  d->sortedIndices.reserve(6 * sphereCount);
+  for (unsigned int sphere : d->sphereOrder) {
+    unsigned int index = 4 * sphere;
+    d->sortedIndices.push_back(index + 0);
+    d->sortedIndices.push_back(index + 1);
+    d->sortedIndices.push_back(index + 2);
+    d->sortedIndices.push_back(index + 3);
+    d->sortedIndices.push_back(index + 2);
+    d->sortedIndices.push_back(index + 1);
+  }
+  if (!d->sortedIbo.upload(d->sortedIndices,
+                           BufferObject::ElementArrayBuffer)) {
+    cout << d->sortedIbo.error() << endl;
+  }
 }
 
 std::multimap<float, Identifier> SphereGeometry::hits(
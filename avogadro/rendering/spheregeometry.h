@@ -72,6 +72,8 @@ public:
   /**
    * @brief Render the sphere geometry.
    * @param camera The current camera to be used for rendering.
+   *
+   * Spheres rendered in the TranslucentPass are drawn back to front.
    */
   void render(const Camera& camera) override;
 
@@ -124,6 +126,12 @@ public:
   size_t size() const { return m_spheres.size(); }
 
 private:
+  /**
+   * @brief Sort the spheres back to front for the supplied camera, uploading a
+   * new index buffer if the order changed.
+   */
+  void sortSpheres(const Camera& camera);
+
   Core::Array<SphereColor> m_spheres;
   Core::Array<size_t> m_indices;
 
@@ -19,7 +19,7 @@
 #include "avogadrogl.h"
 #include "bufferobject.h"
 #include "camera.h"
-#include "shader.h"
+#include "glresourcecache.h"
 #include "shaderprogram.h"
 #include "textrenderstrategy.h"
 #include "texture2d.h"
@@ -60,7 +60,6 @@ public:
   BufferObject vbo;
 
   // Sentinals:
-  bool shadersInvalid;
   bool textureInvalid;
   bool vboInvalid;
 
@@ -69,11 +68,6 @@ public:
   float radius;
   Texture2D texture;
 
-  // Shaders
-  Shader vertexShader;
-  Shader fragmentShader;
-  ShaderProgram shaderProgram;
-
   RenderImpl();
   ~RenderImpl() {}
 
@@ -84,12 +78,11 @@ public:
                   TextProperties::VAlign vAlign);
 
   void render(const Camera& cam);
-  void compileShaders();
   void uploadVbo();
 };
 
 TextLabelBase::RenderImpl::RenderImpl()
-  : vertices(4), shadersInvalid(true), textureInvalid(true), vboInvalid(true),
+  : vertices(4), textureInvalid(true), vboInvalid(true),
     radius(0.0)
 {
   texture.setMinFilter(Texture2D::Nearest);
@@ -172,9 +165,9 @@ void TextLabelBase::RenderImpl::render(const Camera& cam)
     return;
   }
 
-  // Prepare GL
-  if (shadersInvalid)
-    compileShaders();
+  // Prepare GL, the shader program is shared by all labels.
+  ShaderProgram& shaderProgram = *GLResourceCache::current()->program(
+    "textlabelbase", textlabelbase_vs, textlabelbase_fs);
   if (vboInvalid)
     uploadVbo();
 
@@ -223,32 +216,6 @@ void TextLabelBase::RenderImpl::render(const Camera& cam)
   vbo.release();
 }
 
-void TextLabelBase::RenderImpl::compileShaders()
-{
-  vertexShader.setType(Shader::Vertex);
-  vertexShader.setSource(textlabelbase_vs);
-  if (!vertexShader.compile()) {
-    std::cerr << vertexShader.error() << std::endl;
-    return;
-  }
-
-  fragmentShader.setType(Shader::Fragment);
-  fragmentShader.setSource(textlabelbase_fs);
-  if (!fragmentShader.compile()) {
-    std::cerr << fragmentShader.error() << std::endl;
-    return;
-  }
-
-  shaderProgram.attachShader(vertexShader);
-  shaderProgram.attachShader(fragmentShader);
-  if (!shaderProgram.link()) {
-    std::cerr << shaderProgram.error() << std::endl;
-    return;
-  }
-
-  shadersInvalid = false;
-}
-
 void TextLabelBase::RenderImpl::uploadVbo()
 {
   if (!vbo.upload(vertices, BufferObject::ArrayBuffer))
@@ -361,7 +328,6 @@ float TextLabelBase::getRadiusInternal() const
 
 void TextLabelBase::markDirty()
 {
-  m_render->shadersInvalid = true;
   m_render->textureInvalid = true;
   m_render->vboInvalid = true;
 }
@@ -20,10 +20,12 @@
 #include "cylindergeometry.h"
 #include "linestripgeometry.h"
 #include "meshgeometry.h"
+#include "parallelformat.h"
 #include "spheregeometry.h"
 
 #include <iostream>
 #include <ostream>
+#include <vector>
 
 namespace Avogadro {
 namespace Rendering {
@@ -34,6 +36,7 @@ using std::endl;
 using std::ostringstream;
 using std::ostream;
 using std::ofstream;
+using std::vector;
 
 namespace {
 ostream& operator<<(ostream& os, const Vector3f& v)
@@ -48,18 +51,12 @@ ostream& operator<<(ostream& os, const Vector3ub& color)
      << color[2] / 255.0f;
   return os;
 }
-
-ostream& operator<<(ostream& os, const Vector4ub& color)
-{
-  os << color[0] / 255.0f << " " << color[1] / 255.0f << " "
-     << color[2] / 255.0f << color[3] / 255.0f;
-  return os;
-}
 }
 
 VRMLVisitor::VRMLVisitor(const Camera& c)
   : m_camera(c), m_backgroundColor(255, 255, 255),
-    m_ambientColor(100, 100, 100), m_aspectRatio(800.0f / 600.0f)
+    m_ambientColor(100, 100, 100), m_aspectRatio(800.0f / 600.0f),
+    m_stream(&m_buffer)
 {
 }
 
@@ -69,37 +66,37 @@ VRMLVisitor::~VRMLVisitor()
 
 void VRMLVisitor::begin()
 {
+  m_buffer.str(string());
+  begin(m_buffer);
+}
+
+void VRMLVisitor::begin(ostream& stream)
+{
+  m_stream = &stream;
 
   // Initialise the VRML scene
   Vector3f cameraT = -(m_camera.modelView().linear().adjoint() *
                        m_camera.modelView().translation());
-  Vector3f cameraX =
-    m_camera.modelView().linear().row(0).transpose().normalized();
-  Vector3f cameraY =
-    m_camera.modelView().linear().row(1).transpose().normalized();
-  Vector3f cameraZ =
-    -m_camera.modelView().linear().row(2).transpose().normalized();
-
-  double huge = 100;
 
-  Vector3f light0pos =
-    huge * (m_camera.modelView().linear().adjoint() * Vector3f(0, 1, 0));
-
-  // Output the POV-Ray initialisation code
+  // Output the VRML initialisation code
   // orientation should be set
   // http://cgvr.informatik.uni-bremen.de/teaching/vr_literatur/Calculating%20VRML%20Viewpoints.html
-  ostringstream str;
-  str << "#VRML V2.0 utf8\n"
-      << "DEF DefaultView Viewpoint {\n"
-      << "position " << cameraT << " \n"
-      << "fieldOfView 0.785398\n}\n";
-
-  m_sceneData = str.str();
+  *m_stream << "#VRML V2.0 utf8\n"
+            << "DEF DefaultView Viewpoint {\n"
+            << "position " << cameraT << " \n"
+            << "fieldOfView 0.785398\n}\n";
 }
 
 string VRMLVisitor::end()
 {
-  return m_sceneData;
+  if (m_stream != &m_buffer) {
+    m_stream->flush();
+    m_stream = &m_buffer;
+    return string();
+  }
+  string sceneData = m_buffer.str();
+  m_buffer.str(string());
+  return sceneData;
 }
 
 void VRMLVisitor::visit(Drawable& geometry)
@@ -109,19 +106,23 @@ void VRMLVisitor::visit(Drawable& geometry)
 
 void VRMLVisitor::visit(SphereGeometry& geometry)
 {
-  ostringstream str;
-  for (size_t i = 0; i < geometry.spheres().size(); ++i) {
-    Rendering::SphereColor s = geometry.spheres()[i];
-
-    str << "Transform {\n"
-        << "\ttranslation\t" << s.center[0] << "\t" << s.center[1] << "\t"
-        << s.center[2] << "\n\tchildren Shape {\n"
-        << "\t\tgeometry Sphere {\n\t\t\tradius\t" << s.radius << "\n\t\t}\n"
-        << "\t\tappearance Appearance {\n"
-        << "\t\t\tmaterial Material {\n"
-        << "\t\t\t\tdiffuseColor\t" << s.color << "\n\t\t\t}\n\t\t}\n\t}\n}\n";
-  }
-  m_sceneData += str.str();
+  const Core::Array<SphereColor>& spheres = geometry.spheres();
+  formatParallel(
+    *m_stream, spheres.size(),
+    [&spheres](ostream& str, size_t begin, size_t end) {
+      for (size_t i = begin; i < end; ++i) {
+        const SphereColor& s = spheres[i];
+        str << "Transform {\n"
+            << "\ttranslation\t" << s.center[0] << "\t" << s.center[1] << "\t"
+            << s.center[2] << "\n\tchildren Shape {\n"
+            << "\t\tgeometry Sphere {\n\t\t\tradius\t" << s.radius
+            << "\n\t\t}\n"
+            << "\t\tappearance Appearance {\n"
+            << "\t\t\tmaterial Material {\n"
+            << "\t\t\t\tdiffuseColor\t" << s.color
+            << "\n\t\t\t}\n\t\t}\n\t}\n}\n";
+      }
+    });
 }
 
 void VRMLVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
@@ -131,99 +132,109 @@ void VRMLVisitor::visit(AmbientOcclusionSphereGeometry& geometry)
 
 void VRMLVisitor::visit(CylinderGeometry& geometry)
 {
-  ostringstream str;
-  for (size_t i = 0; i < geometry.cylinders().size(); ++i) {
-    Rendering::CylinderColor c = geometry.cylinders()[i];
-
-    // double scale = 1.0;
-    double x1, x2, y1, y2, z1, z2;
-    x1 = c.end1[0];
-    x2 = c.end2[0];
-    y1 = c.end1[1];
-    y2 = c.end2[1];
-    z1 = c.end1[2];
-    z2 = c.end2[2];
-
-    double dx = x2 - x1;
-    double dy = y2 - y1;
-    double dz = z2 - z1;
-
-    double length = sqrt(dx * dx + dy * dy + dz * dz);
-    double tx = dx / 2 + x1;
-    double ty = dy / 2 + y1;
-    double tz = dz / 2 + z1;
-
-    dx = dx / length;
-    dy = dy / length;
-    dz = dz / length;
-
-    double ax, ay, az, angle;
-
-    if (dy > 0.999) {
-      ax = 1.0;
-      ay = 0.0;
-      az = 0.0;
-      angle = 0.0;
-    } else if (dy < -0.999) {
-      ax = 1.0;
-      ay = 0.0;
-      az = 0.0;
-      angle = 3.14159265359;
-    } else {
-      ax = dz;
-      ay = 0.0;
-      az = dx * -1.0;
-      angle = acos(dy);
+  const vector<CylinderColor>& cylinders = geometry.cylinders();
+  formatParallel(*m_stream, cylinders.size(), [&cylinders](ostream& str,
+                                                           size_t begin,
+                                                           size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const CylinderColor& c = cylinders[i];
+
+      // double scale = 1.0;
+      double x1, x2, y1, y2, z1, z2;
+      x1 = c.end1[0];
+      x2 = c.end2[0];
+      y1 = c.end1[1];
+      y2 = c.end2[1];
+      z1 = c.end1[2];
+      z2 = c.end2[2];
+
+      double dx = x2 - x1;
+      double dy = y2 - y1;
+      double dz = z2 - z1;
+
+      double length = sqrt(dx * dx + dy * dy + dz * dz);
+      double tx = dx / 2 + x1;
+      double ty = dy / 2 + y1;
+      double tz = dz / 2 + z1;
+
+      dx = dx / length;
+      dy = dy / length;
+      dz = dz / length;
+
+      double ax, ay, az, angle;
+
+      if (dy > 0.999) {
+        ax = 1.0;
+        ay = 0.0;
+        az = 0.0;
+        angle = 0.0;
+      } else if (dy < -0.999) {
+        ax = 1.0;
+        ay = 0.0;
+        az = 0.0;
+        angle = 3.14159265359;
+      } else {
+        ax = dz;
+        ay = 0.0;
+        az = dx * -1.0;
+        angle = acos(dy);
+      }
+      length = length / 2.0;
+
+      str << "Transform {\n"
+          << "\ttranslation\t" << tx << "\t" << ty << "\t" << tz
+          << "\n\tscale "
+          << " 1 " << length << " 1"
+          << "\n\trotation " << ax << " " << ay << " " << az << " " << angle
+          << "\n\tchildren Shape {\n"
+          << "\t\tgeometry Cylinder {\n\t\t\tradius\t" << c.radius
+          << "\n\t\t}\n"
+          << "\t\tappearance Appearance {\n"
+          << "\t\t\tmaterial Material {\n"
+          << "\t\t\t\tdiffuseColor\t" << c.color
+          << "\n\t\t\t}\n\t\t}\n\t}\n}\n";
     }
-    length = length / 2.0;
-
-    str << "Transform {\n"
-        << "\ttranslation\t" << tx << "\t" << ty << "\t" << tz << "\n\tscale "
-        << " 1 " << length << " 1"
-        << "\n\trotation " << ax << " " << ay << " " << az << " " << angle
-        << "\n\tchildren Shape {\n"
-        << "\t\tgeometry Cylinder {\n\t\t\tradius\t" << c.radius << "\n\t\t}\n"
-        << "\t\tappearance Appearance {\n"
-        << "\t\t\tmaterial Material {\n"
-        << "\t\t\t\tdiffuseColor\t" << c.color << "\n\t\t\t}\n\t\t}\n\t}\n}\n";
-  }
-  m_sceneData += str.str();
+  });
 }
 
 void VRMLVisitor::visit(MeshGeometry& geometry)
 {
-  Core::Array<Rendering::MeshGeometry::PackedVertex> v = geometry.vertices();
+  const Core::Array<MeshGeometry::PackedVertex> v = geometry.vertices();
+  const Core::Array<unsigned int> tris = geometry.triangles();
+  size_t numFaces = tris.size() / 3;
 
   // If there are no triangles then don't bother doing anything
-  if (v.size() == 0)
+  if (v.empty() || numFaces == 0)
     return;
 
-  ostringstream str, verts, iverts, colors;
-
-  // save the points, coordinates, and colors to separate strings
-  for (unsigned int i = 0; i < v.size(); ++i) {
-    if (i == v.size() - 1) {
-      verts << v[i].vertex;
-      colors << v[i].color;
-      break;
-    }
-    verts << v[i].vertex << ",\n";
-    colors << v[i].color << ", ";
-  }
-  // Now to write out the indices
-  for (unsigned int i = 0; i < v.size(); i += 3) {
-    iverts << i << ", " << i + 1 << ", " << i + 2 << ", -1,\n";
-  }
-
   // Now to write out the full mesh - could be pretty big...
-  str << "Shape {\n"
+  ostream& out = *m_stream;
+  out << "Shape {\n"
       << "\tgeometry IndexedFaceSet {\n"
       << "\t\tcoord Coordinate {\n"
-      << "\t\t\tpoint [" << verts.str() << "\t\t\t]\n\t\t}\n"
-      << "\t\tcoordIndex[" << iverts.str() << "\t\t\t]\n"
-      << "color Color {\n color [" << colors.str() << "]\n}\n}\n}";
-
-  m_sceneData += str.str();
+      << "\t\t\tpoint [";
+  formatParallel(out, v.size(), [&v](ostream& str, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i)
+      str << v[i].vertex << (i + 1 < v.size() ? ",\n" : "");
+  });
+  out << "\t\t\t]\n\t\t}\n"
+      << "\t\tcoordIndex[";
+  formatParallel(out, numFaces,
+                 [&tris](ostream& str, size_t begin, size_t end) {
+                   for (size_t f = begin; f < end; ++f) {
+                     str << tris[3 * f] << ", " << tris[3 * f + 1] << ", "
+                         << tris[3 * f + 2] << ", -1,\n";
+                   }
+                 });
+  out << "\t\t\t]\n"
+      << "color Color {\n color [";
+  formatParallel(out, v.size(), [&v](ostream& str, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+      const Vector4ub& c = v[i].color;
+      str << Vector3ub(c[0], c[1], c[2]) << (i + 1 < v.size() ? ", " : "");
+    }
+  });
+  out << "]\n}\n}\n}";
 }
 
 void VRMLVisitor::visit(LineStripGeometry& geometry)
@@ -21,6 +21,9 @@
 
 #include "avogadrorendering.h"
 #include "camera.h"
+
+#include <ostream>
+#include <sstream>
 #include <string>
 
 namespace Avogadro {
@@ -40,7 +43,23 @@ public:
   VRMLVisitor(const Camera& camera);
   ~VRMLVisitor() override;
 
+  /**
+   * Start a new scene that is buffered in memory and returned by end().
+   */
   void begin();
+
+  /**
+   * Start a new scene that is written directly to @a stream as the scene is
+   * visited. The stream should be buffered, e.g. an std::ofstream, and must
+   * stay valid until end() is called.
+   */
+  void begin(std::ostream& stream);
+
+  /**
+   * Finish the scene. If the scene was started with begin() the complete
+   * scene is returned, otherwise the stream is flushed and an empty string is
+   * returned.
+   */
   std::string end();
 
   /**
@@ -70,7 +89,8 @@ private:
   Vector3ub m_backgroundColor;
   Vector3ub m_ambientColor;
   float m_aspectRatio;
-  std::string m_sceneData;
+  std::ostringstream m_buffer;
+  std::ostream* m_stream;
 };
 
 } // End namespace Rendering
@@ -1,14 +1,79 @@
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
+#include <pybind11/stl.h>
 
 #include <avogadro/core/cube.h>
 #include <avogadro/core/gaussiansettools.h>
 #include <avogadro/core/molecule.h>
+#include <avogadro/core/trajectoryanalyzer.h>
+
+#include <utility>
+#include <vector>
 
 namespace py = pybind11;
 
 using namespace Avogadro;
 using namespace Avogadro::Core;
 
+namespace {
+static_assert(sizeof(Vector3) == 3 * sizeof(Real),
+              "Positions must be packed to be viewed as an (n, 3) array");
+static_assert(sizeof(std::pair<Index, Index>) == 2 * sizeof(Index),
+              "Bond pairs must be packed to be viewed as an (n, 2) array");
+
+// The NumPy views below hold a copy of the molecule's Array in a capsule.
+// Array is copy-on-write, so the copy shares the molecule's storage instead of
+// duplicating it, and keeps that storage alive for as long as the view exists.
+// The molecule detaches from shared storage before its next change, so a view
+// is a snapshot: editing, growing or clearing the molecule afterwards neither
+// changes nor invalidates it. The snapshots are read only, as a write would
+// reach every molecule sharing the storage; the setters and the writable
+// views below change the molecule.
+template <typename T, typename V>
+py::array_t<T> snapshotView(const Array<V>& values, size_t columns)
+{
+  Array<V>* copy = new Array<V>(values);
+  py::capsule owner(copy, [](void* p) { delete static_cast<Array<V>*>(p); });
+  std::vector<size_t> shape(1, copy->size());
+  if (columns > 1)
+    shape.push_back(columns);
+  const T* data =
+    copy->empty() ? nullptr : reinterpret_cast<const T*>(copy->constData());
+  py::array_t<T> view(shape, data, owner);
+  view.attr("setflags")(py::arg("write") = false);
+  return view;
+}
+
+// The writable views point straight into the storage of an object owned by
+// Python, which becomes their base and is kept alive by them. Writes change
+// that object, and anything that reallocates the storage leaves the view
+// dangling, so they are only valid until the object is next resized. The
+// non-const accessors detach the copy-on-write Array first, so writes do not
+// reach the snapshots or other molecules sharing the storage.
+py::array_t<Real> positionsView(Array<Vector3>& positions, py::handle base)
+{
+  std::vector<size_t> shape = { positions.size(), 3 };
+  Real* data =
+    positions.empty() ? nullptr : reinterpret_cast<Real*>(positions.data());
+  return py::array_t<Real>(shape, data, base);
+}
+
+typedef py::array_t<Real, py::array::c_style | py::array::forcecast>
+  RealArray;
+typedef py::array_t<unsigned char, py::array::c_style | py::array::forcecast>
+  ByteArray;
+
+Array<Vector3> toPositions(const RealArray& values, Index count)
+{
+  if (values.ndim() != 2 || static_cast<Index>(values.shape(0)) != count ||
+      values.shape(1) != 3) {
+    throw py::value_error("Expected an (n, 3) array with one row per atom");
+  }
+  const Vector3* begin = reinterpret_cast<const Vector3*>(values.data());
+  return Array<Vector3>(begin, begin + count);
+}
+} // namespace
+
 PYBIND11_MODULE(core, m)
 {
   m.doc() = "AvogadroCore Python binding";
@@ -32,8 +97,26 @@ PYBIND11_MODULE(core, m)
     .def("atom2", &Bond::atom2, "The second atom");
 
   bool (Cube::*setLimits0)(const Molecule&, double, double) = &Cube::setLimits;
-  py::class_<Cube>(m, "Cube").def(
-    "set_limits", setLimits0, "Set the limits based on the molecule geometry");
+  py::class_<Cube>(m, "Cube")
+    .def("set_limits", setLimits0,
+         "Set the limits based on the molecule geometry")
+    .def("values",
+         [](py::object self) {
+           Cube& cube = self.cast<Cube&>();
+           std::vector<double>& values = *cube.data();
+           Vector3i dims = cube.dimensions();
+           std::vector<size_t> shape(1, values.size());
+           if (static_cast<size_t>(dims.prod()) == values.size()) {
+             shape = { static_cast<size_t>(dims.x()),
+                       static_cast<size_t>(dims.y()),
+                       static_cast<size_t>(dims.z()) };
+           }
+           double* data = values.empty() ? nullptr : values.data();
+           return py::array_t<double>(shape, data, self);
+         },
+         "A writable (x, y, z) view of the cube values, without a copy. The "
+         "view keeps the cube alive, but changing the cube limits or "
+         "dimensions resizes the values and invalidates it");
 
   Index (Molecule::*atomCount0)() const = &Molecule::atomCount;
   Index (Molecule::*atomCount1)(unsigned char) const = &Molecule::atomCount;
@@ -52,14 +135,117 @@ PYBIND11_MODULE(core, m)
     .def("add_bond", addBond2, "Add a new bond", py::arg("a1"), py::arg("a2"),
          py::arg("order") = 1)
     .def("bond_count", &Molecule::bondCount, "The number of bonds")
-    .def("add_cube", &Molecule::addCube, py::return_value_policy::reference,
-         "Add a new cube")
+    .def("clear", &Molecule::clear,
+         "Reset to an empty molecule, keeping allocated storage for reuse")
+    .def("atomic_numbers",
+         [](const Molecule& mol) {
+           return snapshotView<unsigned char>(mol.atomicNumbers(), 1);
+         },
+         "A read only snapshot of the atomic numbers, without a copy")
+    .def("set_atomic_numbers",
+         [](Molecule& mol, const ByteArray& numbers) {
+           if (numbers.ndim() != 1 ||
+               static_cast<Index>(numbers.size()) != mol.atomCount()) {
+             throw py::value_error("Expected one atomic number per atom");
+           }
+           mol.setAtomicNumbers(Array<unsigned char>(
+             numbers.data(), numbers.data() + numbers.size()));
+         },
+         "Set the atomic numbers, one per atom")
+    .def("atom_positions",
+         [](py::object self, bool writable) -> py::array_t<Real> {
+           Molecule& mol = self.cast<Molecule&>();
+           if (writable)
+             return positionsView(mol.atomPositions3d(), self);
+           return snapshotView<Real>(
+             static_cast<const Molecule&>(mol).atomPositions3d(), 3);
+         },
+         "An (n, 3) view of the atom positions, without a copy. It has no "
+         "rows if the molecule has no 3D positions. By default it is a read "
+         "only snapshot. A writable view edits the molecule in place, and is "
+         "invalidated when atoms are added or removed or the molecule is "
+         "cleared",
+         py::arg("writable") = false)
+    .def("set_atom_positions",
+         [](Molecule& mol, const RealArray& positions) {
+           mol.setAtomPositions3d(toPositions(positions, mol.atomCount()));
+         },
+         "Set the atom positions from an (n, 3) array")
+    .def("bond_pairs",
+         [](const Molecule& mol) {
+           return snapshotView<Index>(mol.bondPairs(), 2);
+         },
+         "A read only (n, 2) snapshot of the bonded atom indices, without a "
+         "copy")
+    .def("coordinate_set_count", &Molecule::coordinate3dCount,
+         "The number of coordinate sets (conformers or trajectory frames)")
+    .def("coordinate_set",
+         [](py::object self, int index,
+            bool writable) -> py::array_t<Real> {
+           Molecule& mol = self.cast<Molecule&>();
+           if (index < 0 || index >= mol.coordinate3dCount())
+             throw py::index_error("No coordinate set at this index");
+           if (writable)
+             return positionsView(*mol.coordinate3dArray(index), self);
+           return snapshotView<Real>(mol.coordinate3d(index), 3);
+         },
+         "An (n, 3) view of a coordinate set, without a copy. By default it "
+         "is a read only snapshot. A writable view edits the coordinate set "
+         "in place, and is invalidated when the set is replaced or resized",
+         py::arg("index"), py::arg("writable") = false)
+    .def("set_coordinate_set",
+         [](Molecule& mol, int index, const RealArray& positions) {
+           if (index < 0)
+             throw py::index_error("No coordinate set at this index");
+           mol.setCoordinate3d(toPositions(positions, mol.atomCount()), index);
+         },
+         "Set a coordinate set from an (n, 3) array, adding it if needed")
+    .def("add_cube", &Molecule::addCube,
+         py::return_value_policy::reference_internal, "Add a new cube")
     .def("cube_count", &Molecule::cubeCount, "The number of cubes")
     .def("has_custom_elements", &Molecule::hasCustomElements,
          "Returns true if the molecule contains any custom elements")
     .def("formula", &Molecule::formula, "The chemical formula of the molecule",
          py::arg("delimiter") = "", py::arg("show_counts_over") = 1)
-    .def("mass", &Molecule::mass, "The mass of the molecule");
+    .def("mass", &Molecule::mass, "The mass of the molecule")
+    .def("has_atom_property", &Molecule::hasAtomProperty,
+         "Returns true if the named per atom property is set")
+    .def("atom_property",
+         [](const Molecule& mol, const std::string& name) {
+           const Array<Real>& values = mol.atomProperty(name);
+           return std::vector<Real>(values.begin(), values.end());
+         },
+         "The values of the named per atom property")
+    .def("set_atom_property",
+         [](Molecule& mol, const std::string& name,
+            const std::vector<Real>& values) {
+           return mol.setAtomProperty(
+             name, Array<Real>(values.begin(), values.end()));
+         },
+         "Set the values of the named per atom property, one per atom")
+    .def("remove_atom_property", &Molecule::removeAtomProperty,
+         "Remove the named per atom property")
+    .def("atom_property_names", &Molecule::atomPropertyNames,
+         "The names of the per atom properties")
+    .def("has_bond_property", &Molecule::hasBondProperty,
+         "Returns true if the named per bond property is set")
+    .def("bond_property",
+         [](const Molecule& mol, const std::string& name) {
+           const Array<Real>& values = mol.bondProperty(name);
+           return std::vector<Real>(values.begin(), values.end());
+         },
+         "The values of the named per bond property")
+    .def("set_bond_property",
+         [](Molecule& mol, const std::string& name,
+            const std::vector<Real>& values) {
+           return mol.setBondProperty(
+             name, Array<Real>(values.begin(), values.end()));
+         },
+         "Set the values of the named per bond property, one per bond")
+    .def("remove_bond_property", &Molecule::removeBondProperty,
+         "Remove the named per bond property")
+    .def("bond_property_names", &Molecule::bondPropertyNames,
+         "The names of the per bond properties");
 
   bool (GaussianSetTools::*calculateMolecularOrbital0)(Cube&, int) const =
     &GaussianSetTools::calculateMolecularOrbital;
@@ -75,4 +261,31 @@ PYBIND11_MODULE(core, m)
          "Calculate the electron density and set values in the cube")
     .def("calculate_spin_density", calculateSpinDensity0,
          "Calculate the spin density and set values in the cube");
+
+  using RadialDistribution = TrajectoryAnalyzer::RadialDistribution;
+  py::class_<RadialDistribution>(m, "RadialDistribution")
+    .def_readonly("radii", &RadialDistribution::radii,
+                  "The center of each bin in Angstrom")
+    .def_readonly("values", &RadialDistribution::values,
+                  "The pair distribution g(r) of each bin")
+    .def_readonly("coordination", &RadialDistribution::coordination,
+                  "The running coordination number at the end of each bin");
+
+  py::class_<TrajectoryAnalyzer>(m, "TrajectoryAnalyzer")
+    .def(py::init<const Molecule*>(), py::keep_alive<1, 2>())
+    .def("frame_count", &TrajectoryAnalyzer::frameCount,
+         "The number of frames in the molecule")
+    .def("radial_distribution", &TrajectoryAnalyzer::radialDistribution,
+         "The radial distribution of the neighbor atoms around the center "
+         "atoms, averaged over all frames (0 selects every element)",
+         py::arg("center") = 0, py::arg("neighbor") = 0,
+         py::arg("max_radius") = 10.0, py::arg("bin_count") = 200)
+    .def("coordination_histogram", &TrajectoryAnalyzer::coordinationHistogram,
+         "The fraction of the center atoms with n neighbor atoms within the "
+         "cutoff, at index n",
+         py::arg("center"), py::arg("neighbor"), py::arg("cutoff"))
+    .def("mean_square_displacement",
+         &TrajectoryAnalyzer::meanSquareDisplacement,
+         "The mean square displacement for each lag in frames",
+         py::arg("element") = 0);
 }
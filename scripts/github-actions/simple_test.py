@@ -1,4 +1,6 @@
 import avogadro
+import numpy as np
+import pytest
 
 ethane_xyz = '''8
 Ethane
@@ -25,5 +27,81 @@ def test_simple():
     assert mol.mass() == 30.06904
 
 
+def test_array_views():
+    mol = avogadro.core.Molecule()
+    manager = avogadro.io.FileFormatManager()
+    assert manager.read_string(mol, ethane_xyz, 'xyz')
+
+    numbers = mol.atomic_numbers()
+    positions = mol.atom_positions()
+    assert numbers.shape == (8,)
+    assert list(numbers[:2]) == [1, 6]
+    assert positions.shape == (8, 3)
+    assert mol.bond_pairs().shape == (mol.bond_count(), 2)
+    assert not numbers.flags.writeable
+    assert not positions.flags.writeable
+
+    # Changes go through the setters and leave earlier views untouched.
+    original = positions.copy()
+    mol.set_atom_positions(positions + 1.0)
+    mol.set_atomic_numbers(np.full(8, 6))
+    assert np.array_equal(mol.atom_positions(), original + 1.0)
+    assert list(mol.atomic_numbers()) == [6] * 8
+    assert np.array_equal(positions, original)
+    assert numbers[0] == 1
+    with pytest.raises(ValueError):
+        mol.set_atom_positions(np.zeros((2, 3)))
+
+    count = mol.coordinate_set_count()
+    mol.set_coordinate_set(count, original)
+    assert mol.coordinate_set_count() == count + 1
+    assert np.array_equal(mol.coordinate_set(count), original)
+    with pytest.raises(IndexError):
+        mol.coordinate_set(count + 1)
+
+    # Views stay valid after the molecule grows or is cleared.
+    mol.add_atom(8)
+    mol.clear()
+    assert mol.atom_count() == 0
+    assert mol.atom_positions().shape == (0, 3)
+    assert np.array_equal(positions, original)
+    assert numbers[1] == 6
+
+
+def test_writable_views():
+    mol = avogadro.core.Molecule()
+    manager = avogadro.io.FileFormatManager()
+    assert manager.read_string(mol, ethane_xyz, 'xyz')
+
+    # Writable views edit the molecule in place, earlier snapshots keep the
+    # values they were taken with.
+    snapshot = mol.atom_positions()
+    original = snapshot.copy()
+    positions = mol.atom_positions(writable=True)
+    assert positions.flags.writeable
+    assert positions.base is mol
+    positions[0] = [1.0, 2.0, 3.0]
+    assert list(mol.atom_positions()[0]) == [1.0, 2.0, 3.0]
+    assert np.array_equal(snapshot, original)
+
+    mol.set_coordinate_set(0, original)
+    frame = mol.coordinate_set(0, writable=True)
+    assert frame.shape == (8, 3)
+    frame[1, 2] = 5.0
+    assert mol.coordinate_set(0)[1, 2] == 5.0
+    with pytest.raises(IndexError):
+        mol.coordinate_set(1, writable=True)
+
+    cube = mol.add_cube()
+    assert cube.set_limits(mol, 0.5, 2.0)
+    values = cube.values()
+    assert values.ndim == 3
+    assert values.base is cube
+    values[0, 0, 0] = 7.0
+    assert cube.values()[0, 0, 0] == 7.0
+
+
 if __name__ == '__main__':
     test_simple()
+    test_array_views()
+    test_writable_views()
@@ -63,5 +63,6 @@ setup(
         'Operating System :: MacOS'
         ],
     packages=['avogadro'],
+    install_requires=['numpy'],
     cmake_args=cmake_args,
 )
@@ -18,6 +18,10 @@
 
 #include <avogadro/core/array.h>
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 using Avogadro::Core::Array;
 
 TEST(ArrayTest, setSize)
@@ -89,6 +93,70 @@ TEST(ArrayTest, implicitDetach)
   EXPECT_EQ(array2.at(2), 42);
 }
 
+TEST(ArrayTest, assignmentShares)
+{
+  Array<int> array(5, 3);
+  Array<int> array2;
+  array2 = array;
+  EXPECT_EQ(array.constData(), array2.constData());
+
+  array2[0] = 1;
+  EXPECT_NE(array.constData(), array2.constData());
+  EXPECT_EQ(array.at(0), 3);
+  EXPECT_EQ(array2.at(0), 1);
+
+  array2 = array2;
+  EXPECT_EQ(array2.at(0), 1);
+  array = array2;
+  EXPECT_EQ(array.at(0), 1);
+}
+
+TEST(ArrayTest, threadedCopies)
+{
+  // Each worker takes copies of the shared array, reads them and modifies
+  // some of them, while the main thread keeps modifying its own copy.
+  const int size = 1000;
+  Array<int> original;
+  for (int i = 0; i < size; ++i)
+    original.push_back(i);
+  const Array<int> shared(original);
+
+  std::atomic<int> errors(0);
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.push_back(std::thread([&, t]() {
+      for (int iteration = 0; iteration < 2000; ++iteration) {
+        Array<int> copy(shared);
+        Array<int> assigned;
+        assigned = copy;
+        if (copy.constData() != shared.constData() ||
+            assigned[size - 1] != size - 1) {
+          ++errors;
+        }
+        if (iteration % 3 == t % 3) {
+          copy[0] = -1;
+          if (copy.at(0) != -1 || shared.at(0) != 0)
+            ++errors;
+        }
+      }
+    }));
+  }
+  for (int iteration = 0; iteration < 2000; ++iteration) {
+    Array<int> copy(shared);
+    copy.push_back(iteration);
+    original = copy;
+    original[1] = -1;
+  }
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+
+  EXPECT_EQ(errors.load(), 0);
+  for (int i = 0; i < size; ++i)
+    EXPECT_EQ(shared[i], i);
+  EXPECT_EQ(original.size(), static_cast<size_t>(size + 1));
+  EXPECT_EQ(original[1], -1);
+}
+
 TEST(ArrayTest, operators)
 {
   Array<int> a1;
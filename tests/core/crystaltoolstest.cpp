@@ -0,0 +1,132 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/crystaltools.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/unitcell.h>
+
+using Avogadro::Index;
+using Avogadro::Matrix3;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::CrystalTools;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::UnitCell;
+
+namespace {
+
+// A periodic chain along a: three atoms 1 Angstrom apart, the last one bonded
+// to the first atom of the next cell.
+void setupChain(Molecule& molecule)
+{
+  Matrix3 cellMatrix(Matrix3::Identity());
+  cellMatrix(0, 0) = 3.0;
+  cellMatrix(1, 1) = 5.0;
+  cellMatrix(2, 2) = 5.0;
+  UnitCell* cell = new UnitCell(cellMatrix);
+  molecule.setUnitCell(cell);
+
+  molecule.addAtom(6).setPosition3d(Vector3(0.5, 2.5, 2.5));
+  molecule.addAtom(7).setPosition3d(Vector3(1.5, 2.5, 2.5));
+  molecule.addAtom(8).setPosition3d(Vector3(2.5, 2.5, 2.5));
+  molecule.addBond(0, 1, 1);
+  molecule.addBond(1, 2, 2);
+  molecule.addBond(2, 0, 1);
+}
+}
+
+TEST(CrystalToolsTest, buildSupercell)
+{
+  Molecule molecule;
+  setupChain(molecule);
+  molecule.formalCharges() = Array<signed char>(3, 0);
+  molecule.formalCharges()[1] = 1;
+
+  EXPECT_TRUE(CrystalTools::buildSupercell(molecule, 3, 2, 1));
+  const UnitCell& cell = *molecule.unitCell();
+  EXPECT_NEAR(cell.a(), 9.0, 1e-10);
+  EXPECT_NEAR(cell.b(), 10.0, 1e-10);
+
+  ASSERT_EQ(molecule.atomCount(), static_cast<Index>(18));
+  ASSERT_EQ(molecule.atomPositions3d().size(), static_cast<size_t>(18));
+  ASSERT_EQ(molecule.formalCharges().size(), static_cast<size_t>(18));
+  // The subcells are ordered a, then b, then c, with c varying fastest.
+  for (Index image = 0; image < 6; ++image) {
+    Vector3 offset((image / 2) * 3.0, (image % 2) * 5.0, 0.0);
+    for (Index i = 0; i < 3; ++i) {
+      Index atom = image * 3 + i;
+      EXPECT_EQ(molecule.atomicNumber(atom), 6 + i);
+      EXPECT_EQ(molecule.formalCharge(atom), i == 1 ? 1 : 0);
+      EXPECT_TRUE(molecule.atomPosition3d(atom).isApprox(
+        molecule.atomPosition3d(i) + offset));
+    }
+  }
+
+  // Every atom is in the ring, and no bond is stretched across the supercell.
+  ASSERT_EQ(molecule.bondCount(), static_cast<Index>(18));
+  std::vector<int> degree(molecule.atomCount(), 0);
+  for (Index bond = 0; bond < molecule.bondCount(); ++bond) {
+    std::pair<Index, Index> pair = molecule.bondPair(bond);
+    ++degree[pair.first];
+    ++degree[pair.second];
+    Real distance = cell.distance(molecule.atomPosition3d(pair.first),
+                                  molecule.atomPosition3d(pair.second));
+    EXPECT_NEAR(distance, 1.0, 1e-10);
+  }
+  for (size_t i = 0; i < degree.size(); ++i)
+    EXPECT_EQ(degree[i], 2);
+  // The boundary bond of the first cell wraps around to the last subcell.
+  EXPECT_EQ(molecule.bondPair(2), std::make_pair(Index(0), Index(14)));
+  EXPECT_EQ(molecule.bondOrder(4), 2);
+}
+
+TEST(CrystalToolsTest, buildSupercellProperties)
+{
+  Molecule molecule;
+  setupChain(molecule);
+  Array<Real> occupancy(3, 1.0);
+  occupancy[2] = 0.5;
+  molecule.setAtomProperty("occupancy", occupancy);
+  Array<Real> strain(3, 0.0);
+  strain[1] = 0.25;
+  molecule.setBondProperty("strain", strain);
+
+  EXPECT_TRUE(CrystalTools::buildSupercell(molecule, 2, 2, 1));
+  ASSERT_EQ(molecule.atomProperty("occupancy").size(), static_cast<size_t>(12));
+  for (Index atom = 0; atom < molecule.atomCount(); ++atom) {
+    EXPECT_EQ(molecule.atomProperty(atom, "occupancy"), occupancy[atom % 3])
+      << " for atom " << atom;
+  }
+  ASSERT_EQ(molecule.bondProperty("strain").size(), static_cast<size_t>(12));
+  for (Index bond = 0; bond < molecule.bondCount(); ++bond) {
+    // The bond orders mark which bond of the chain each one is a copy of.
+    EXPECT_EQ(molecule.bondProperty(bond, "strain"),
+              molecule.bondOrder(bond) == 2 ? 0.25 : 0.0)
+      << " for bond " << bond;
+    EXPECT_EQ(molecule.bondProperty(bond, "strain"), strain[bond % 3]);
+  }
+}
+
+TEST(CrystalToolsTest, buildSupercellErrors)
+{
+  Molecule molecule;
+  EXPECT_FALSE(CrystalTools::buildSupercell(molecule, 2, 2, 2));
+  setupChain(molecule);
+  EXPECT_FALSE(CrystalTools::buildSupercell(molecule, 2, 0, 2));
+  EXPECT_TRUE(CrystalTools::buildSupercell(molecule, 1, 1, 1));
+  EXPECT_EQ(molecule.atomCount(), static_cast<Index>(3));
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(3));
+}
+
+TEST(CrystalToolsTest, largeSupercell)
+{
+  Molecule molecule;
+  setupChain(molecule);
+  EXPECT_TRUE(CrystalTools::buildSupercell(molecule, 100, 60, 60));
+  EXPECT_EQ(molecule.atomCount(), static_cast<Index>(1080000));
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(1080000));
+}
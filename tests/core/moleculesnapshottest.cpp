@@ -0,0 +1,217 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/cube.h>
+#include <avogadro/core/gaussianset.h>
+#include <avogadro/core/gaussiansettools.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/moleculesnapshot.h>
+#include <avogadro/core/slaterset.h>
+#include <avogadro/core/unitcell.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::MatrixX;
+using Avogadro::Vector3;
+using Avogadro::Vector3i;
+using Avogadro::Core::Array;
+using Avogadro::Core::Cube;
+using Avogadro::Core::GaussianSet;
+using Avogadro::Core::GaussianSetTools;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::MoleculeSnapshot;
+using Avogadro::Core::SlaterSet;
+using Avogadro::Core::UnitCell;
+
+namespace {
+
+void setupChain(Molecule& molecule, int size)
+{
+  for (int i = 0; i < size; ++i) {
+    molecule.addAtom(6).setPosition3d(Vector3(1.5 * i, 0.0, 0.0));
+    if (i > 0)
+      molecule.addBond(i - 1, i, 1);
+  }
+}
+}
+
+TEST(MoleculeSnapshotTest, sharesData)
+{
+  Molecule molecule;
+  setupChain(molecule, 10);
+  MoleculeSnapshot snapshot(molecule);
+  EXPECT_EQ(snapshot.atomCount(), static_cast<size_t>(10));
+  EXPECT_EQ(snapshot.bondCount(), static_cast<size_t>(9));
+  EXPECT_EQ(snapshot.atomPositions3d().constData(),
+            molecule.atomPositions3d().constData());
+  EXPECT_EQ(snapshot.bondPairs().constData(),
+            molecule.bondPairs().constData());
+
+  MoleculeSnapshot copy(snapshot);
+  EXPECT_EQ(copy.atomicNumbers().constData(),
+            snapshot.atomicNumbers().constData());
+
+  MoleculeSnapshot empty;
+  EXPECT_EQ(empty.atomCount(), static_cast<size_t>(0));
+  EXPECT_EQ(empty.basisSet(), nullptr);
+  EXPECT_EQ(empty.unitCell(), nullptr);
+  EXPECT_EQ(empty.cube(0), nullptr);
+}
+
+TEST(MoleculeSnapshotTest, unchangedByEdits)
+{
+  Molecule molecule;
+  setupChain(molecule, 10);
+  molecule.setCoordinate3d(molecule.atomPositions3d(), 0);
+  molecule.setUnitCell(new UnitCell(10.0, 10.0, 10.0, 1.5, 1.5, 1.5));
+  molecule.setAtomProperty(4, "charge", 0.5);
+  MoleculeSnapshot snapshot(molecule);
+
+  molecule.atom(3).setPosition3d(Vector3(0.0, 5.0, 0.0));
+  molecule.atom(4).setAtomicNumber(8);
+  molecule.setAtomProperty(4, "charge", -0.5);
+  molecule.addAtom(1);
+  molecule.removeBond(static_cast<Index>(0));
+  molecule.setCoordinate3d(Array<Vector3>(11, Vector3(1.0, 1.0, 1.0)), 0);
+  molecule.unitCell()->setCellParameters(5.0, 5.0, 5.0, 1.5, 1.5, 1.5);
+
+  EXPECT_EQ(snapshot.atomCount(), static_cast<size_t>(10));
+  EXPECT_EQ(snapshot.bondCount(), static_cast<size_t>(9));
+  EXPECT_EQ(snapshot.atomPositions3d()[3], Vector3(4.5, 0.0, 0.0));
+  EXPECT_EQ(snapshot.atomicNumbers()[4], 6);
+  EXPECT_EQ(snapshot.atomProperty("charge")[4], 0.5);
+  EXPECT_TRUE(snapshot.bondProperty("charge").empty());
+  ASSERT_EQ(snapshot.coordinate3dCount(), 1);
+  EXPECT_EQ(snapshot.coordinate3d(0)[3], Vector3(4.5, 0.0, 0.0));
+  EXPECT_TRUE(snapshot.coordinate3d(1).empty());
+  ASSERT_NE(snapshot.unitCell(), nullptr);
+  EXPECT_NEAR(snapshot.unitCell()->a(), 10.0, 1e-12);
+  EXPECT_EQ(molecule.atomPositions3d()[3], Vector3(0.0, 5.0, 0.0));
+}
+
+TEST(MoleculeSnapshotTest, basisSetAndCubes)
+{
+  Molecule molecule;
+  setupChain(molecule, 2);
+  SlaterSet* basis = new SlaterSet;
+  basis->setElectronCount(12);
+  molecule.setBasisSet(basis);
+  Cube* cube = molecule.addCube();
+  cube->setLimits(Vector3(0.0, 0.0, 0.0), Vector3i(2, 2, 2), 1.0);
+  cube->setValue(0, 1.0);
+
+  MoleculeSnapshot snapshot(molecule);
+  const Molecule& constMolecule = molecule;
+  EXPECT_EQ(snapshot.cube(0), constMolecule.cube(0));
+  EXPECT_EQ(constMolecule.cubes().front(), constMolecule.cube(0));
+
+  // The basis set is a copy that is not linked to the live molecule, later
+  // snapshots share it until the basis set may have changed.
+  ASSERT_NE(snapshot.basisSet(), nullptr);
+  EXPECT_NE(snapshot.basisSet(), constMolecule.basisSet());
+  EXPECT_EQ(snapshot.basisSet()->molecule(), nullptr);
+  EXPECT_EQ(snapshot.basisSet()->electronCount(), 12u);
+  EXPECT_EQ(MoleculeSnapshot(molecule).basisSet(), snapshot.basisSet());
+
+  // Non-const access copies the shared cubes first, the next snapshot copies
+  // the basis set again.
+  molecule.cube(0)->setValue(0, 2.0);
+  molecule.basisSet()->setElectronCount(14);
+  MoleculeSnapshot later(molecule);
+  EXPECT_NE(snapshot.cube(0), constMolecule.cube(0));
+  EXPECT_NE(later.basisSet(), snapshot.basisSet());
+  EXPECT_EQ(snapshot.cube(0)->value(0, 0, 0), 1.0);
+  EXPECT_EQ(molecule.cube(0)->value(0, 0, 0), 2.0);
+  EXPECT_EQ(snapshot.basisSet()->electronCount(), 12u);
+  EXPECT_EQ(later.basisSet()->electronCount(), 14u);
+  EXPECT_EQ(molecule.basisSet()->electronCount(), 14u);
+
+  // The snapshot keeps its cubes when the molecule drops them.
+  molecule.clearCubes();
+  molecule.setBasisSet(nullptr);
+  EXPECT_EQ(snapshot.cubeCount(), static_cast<size_t>(1));
+  EXPECT_EQ(snapshot.cube(0)->data()->size(), static_cast<size_t>(8));
+  EXPECT_EQ(snapshot.basisSet()->electronCount(), 12u);
+
+  // Without a snapshot the molecule hands out its own objects.
+  Cube* owned = molecule.addCube();
+  EXPECT_EQ(molecule.cube(0), owned);
+  EXPECT_EQ(molecule.cubes().size(), static_cast<size_t>(1));
+}
+
+TEST(MoleculeSnapshotTest, gaussianSetTools)
+{
+  // Two hydrogen atoms with one s function each.
+  Molecule molecule;
+  molecule.addAtom(1).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  molecule.addAtom(1).setPosition3d(Vector3(0.74, 0.0, 0.0));
+  GaussianSet* basis = new GaussianSet;
+  for (unsigned int i = 0; i < 2; ++i) {
+    unsigned int shell = basis->addBasis(i, GaussianSet::S);
+    basis->addGto(shell, 0.4, 0.8);
+    basis->addGto(shell, 0.6, 0.2);
+  }
+  basis->setMolecularOrbitals({ 0.55, 0.55, 1.2, -1.2 });
+  MatrixX density(2, 2);
+  density << 0.6, 0.6, 0.6, 0.6;
+  basis->setDensityMatrix(density);
+  molecule.setBasisSet(basis);
+
+  GaussianSetTools liveTools(&molecule);
+  GaussianSetTools snapshotTools((MoleculeSnapshot(molecule)));
+  ASSERT_TRUE(snapshotTools.isValid());
+  const Vector3 point(0.3, 0.2, 0.1);
+  const double rho = liveTools.calculateElectronDensity(point);
+  EXPECT_GT(rho, 0.0);
+  EXPECT_DOUBLE_EQ(snapshotTools.calculateElectronDensity(point), rho);
+  EXPECT_DOUBLE_EQ(snapshotTools.calculateMolecularOrbital(point, 1),
+                   liveTools.calculateMolecularOrbital(point, 1));
+
+  // The snapshot tools keep the geometry they were made from.
+  molecule.atom(1).setPosition3d(Vector3(2.0, 0.0, 0.0));
+  EXPECT_DOUBLE_EQ(snapshotTools.calculateElectronDensity(point), rho);
+  EXPECT_NE(liveTools.calculateElectronDensity(point), rho);
+
+  EXPECT_FALSE(GaussianSetTools(MoleculeSnapshot()).isValid());
+}
+
+TEST(MoleculeSnapshotTest, threadedReads)
+{
+  // Workers read snapshots while the molecule keeps changing.
+  Molecule molecule;
+  setupChain(molecule, 200);
+  std::vector<MoleculeSnapshot> snapshots;
+  for (int s = 0; s < 4; ++s) {
+    snapshots.push_back(MoleculeSnapshot(molecule));
+    for (Index i = 0; i < molecule.atomCount(); ++i)
+      molecule.atom(i).setPosition3d(molecule.atom(i).position3d() +
+                                     Vector3(0.0, 1.0, 0.0));
+  }
+
+  std::atomic<int> errors(0);
+  std::vector<std::thread> threads;
+  for (int s = 0; s < 4; ++s) {
+    threads.push_back(std::thread([&, s]() {
+      for (int iteration = 0; iteration < 200; ++iteration) {
+        MoleculeSnapshot snapshot(snapshots[s]);
+        const Array<Vector3>& positions = snapshot.atomPositions3d();
+        for (Index i = 0; i < positions.size(); ++i) {
+          if (positions[i] != Vector3(1.5 * i, s, 0.0))
+            ++errors;
+        }
+      }
+    }));
+  }
+  for (int iteration = 0; iteration < 200; ++iteration) {
+    MoleculeSnapshot snapshot(molecule);
+    molecule.atom(iteration).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  }
+  for (size_t t = 0; t < threads.size(); ++t)
+    threads[t].join();
+  EXPECT_EQ(errors.load(), 0);
+}
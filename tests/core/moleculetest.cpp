@@ -109,6 +109,34 @@ TEST_F(MoleculeTest, addAtom)
   EXPECT_EQ(atom2.atomicNumber(), static_cast<unsigned char>(1));
 }
 
+TEST_F(MoleculeTest, addAtoms)
+{
+  Molecule molecule;
+  molecule.addAtom(8);
+
+  Array<unsigned char> atomicNumbers(2, 1);
+  Array<Vector3> positions;
+  positions.push_back(Vector3(1.0, 0.0, 0.0));
+  positions.push_back(Vector3(0.0, 1.0, 0.0));
+  EXPECT_EQ(molecule.addAtoms(atomicNumbers, positions), static_cast<Index>(1));
+  EXPECT_EQ(molecule.atomCount(), static_cast<Index>(3));
+  EXPECT_EQ(molecule.atomicNumber(2), static_cast<unsigned char>(1));
+  // The first atom had no position, it is placed at the origin.
+  ASSERT_EQ(molecule.atomPositions3d().size(), static_cast<size_t>(3));
+  EXPECT_EQ(molecule.atomPosition3d(0), Vector3::Zero());
+  EXPECT_EQ(molecule.atomPosition3d(2), Vector3(0.0, 1.0, 0.0));
+
+  Array<std::pair<Index, Index>> pairs;
+  pairs.push_back(std::make_pair(Index(1), Index(0)));
+  pairs.push_back(std::make_pair(Index(0), Index(2)));
+  Array<unsigned char> orders(2, 1);
+  EXPECT_EQ(molecule.addBonds(pairs, orders), static_cast<Index>(0));
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(2));
+  EXPECT_EQ(molecule.bond(0).atom1().index(), static_cast<Index>(0));
+  EXPECT_EQ(molecule.bond(0).atom2().index(), static_cast<Index>(1));
+  EXPECT_EQ(molecule.graph().edgeCount(), static_cast<size_t>(2));
+}
+
 TEST_F(MoleculeTest, removeAtom)
 {
   Molecule molecule;
@@ -282,3 +310,122 @@ TEST_F(MoleculeTest, assignment)
 
   assertEqual(m_testMolecule, assign);
 }
+
+TEST_F(MoleculeTest, atomProperties)
+{
+  Molecule molecule;
+  molecule.addAtom(6);
+  molecule.addAtom(7);
+  molecule.addAtom(8);
+  EXPECT_FALSE(molecule.hasAtomProperty("charge"));
+  EXPECT_TRUE(molecule.atomProperty("charge").empty());
+  EXPECT_EQ(molecule.atomProperty(0, "charge"), 0.0);
+
+  Array<double> charges;
+  charges.push_back(-0.1);
+  charges.push_back(-0.2);
+  EXPECT_FALSE(molecule.setAtomProperty("charge", charges));
+  charges.push_back(-0.3);
+  EXPECT_TRUE(molecule.setAtomProperty("charge", charges));
+  EXPECT_TRUE(molecule.setAtomProperty(2, "bFactor", 12.5));
+  EXPECT_FALSE(molecule.setAtomProperty(3, "bFactor", 1.0));
+  ASSERT_EQ(molecule.atomPropertyNames().size(), static_cast<size_t>(2));
+  EXPECT_EQ(molecule.atomPropertyNames()[0], "bFactor");
+  EXPECT_EQ(molecule.atomProperty("bFactor").size(), static_cast<size_t>(3));
+  EXPECT_EQ(molecule.atomProperty(0, "bFactor"), 0.0);
+
+  // New atoms get zeros, removed atoms are replaced by the last one.
+  molecule.addAtom(1);
+  EXPECT_EQ(molecule.atomProperty("charge").size(), static_cast<size_t>(4));
+  EXPECT_EQ(molecule.atomProperty(3, "charge"), 0.0);
+  molecule.setAtomProperty(3, "charge", 0.4);
+  molecule.addAtoms(Array<unsigned char>(2, 1), Array<Vector3>());
+  EXPECT_EQ(molecule.atomProperty("bFactor").size(), static_cast<size_t>(6));
+  molecule.removeAtom(static_cast<Index>(1));
+  ASSERT_EQ(molecule.atomProperty("charge").size(), static_cast<size_t>(5));
+  EXPECT_EQ(molecule.atomProperty(0, "charge"), -0.1);
+  EXPECT_EQ(molecule.atomProperty(1, "charge"), 0.0);
+  EXPECT_EQ(molecule.atomProperty(2, "charge"), -0.3);
+  EXPECT_EQ(molecule.atomProperty(3, "charge"), 0.4);
+  EXPECT_EQ(molecule.atomProperty(2, "bFactor"), 12.5);
+
+  Molecule copy(molecule);
+  EXPECT_EQ(copy.atomProperty(3, "charge"), 0.4);
+  molecule.removeAtomProperty("charge");
+  EXPECT_FALSE(molecule.hasAtomProperty("charge"));
+  EXPECT_TRUE(copy.hasAtomProperty("charge"));
+  molecule.clearAtoms();
+  EXPECT_TRUE(molecule.atomProperty("bFactor").empty());
+}
+
+TEST_F(MoleculeTest, bondProperties)
+{
+  Molecule molecule;
+  for (int i = 0; i < 4; ++i)
+    molecule.addAtom(6);
+  molecule.addBond(0, 1, 1);
+  molecule.addBond(1, 2, 1);
+  EXPECT_TRUE(molecule.setBondProperty(1, "length", 1.5));
+  EXPECT_FALSE(molecule.setBondProperty(2, "length", 1.5));
+  molecule.addBond(2, 3, 2);
+  EXPECT_EQ(molecule.bondProperty("length").size(), static_cast<size_t>(3));
+  molecule.setBondProperty(2, "length", 1.3);
+
+  // Removing an atom removes its bonds and their properties.
+  molecule.removeAtom(static_cast<Index>(0));
+  ASSERT_EQ(molecule.bondProperty("length").size(), static_cast<size_t>(2));
+  EXPECT_EQ(molecule.bondProperty(0, "length"), 1.3);
+  EXPECT_EQ(molecule.bondProperty(1, "length"), 1.5);
+  EXPECT_EQ(molecule.bondPropertyNames().size(), static_cast<size_t>(1));
+  molecule.clearBonds();
+  EXPECT_TRUE(molecule.hasBondProperty("length"));
+  EXPECT_TRUE(molecule.bondProperty("length").empty());
+}
+
+TEST_F(MoleculeTest, clear)
+{
+  Molecule molecule;
+  molecule.setData("name", std::string("ethene"));
+  molecule.addAtom(6).setPosition3d(Vector3(0, 0, 0));
+  molecule.addAtom(6).setPosition3d(Vector3(1.3, 0, 0));
+  molecule.addBond(0, 1, 2);
+  molecule.setAtomProperty(0, "charge", -0.2);
+  molecule.addMesh();
+  size_t capacity = molecule.atomicNumbers().capacity();
+
+  molecule.clear();
+  EXPECT_EQ(molecule.atomCount(), static_cast<Index>(0));
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(0));
+  EXPECT_TRUE(molecule.atomPositions3d().empty());
+  EXPECT_FALSE(molecule.hasData("name"));
+  EXPECT_FALSE(molecule.hasAtomProperty("charge"));
+  EXPECT_EQ(molecule.meshCount(), static_cast<Index>(0));
+  EXPECT_EQ(molecule.atomicNumbers().capacity(), capacity);
+
+  // The molecule can be filled again as if it were new.
+  molecule.addAtom(8);
+  molecule.addAtom(1);
+  molecule.addBond(0, 1);
+  EXPECT_EQ(molecule.atomCount(), static_cast<Index>(2));
+  EXPECT_EQ(molecule.bonds(0).size(), static_cast<size_t>(1));
+  EXPECT_EQ(molecule.graph().size(), static_cast<size_t>(2));
+}
+
+TEST_F(MoleculeTest, coordinate3dArray)
+{
+  Molecule molecule;
+  molecule.addAtom(6);
+  Array<Vector3> frame(1, Vector3(1, 2, 3));
+  molecule.setCoordinate3d(frame, 0);
+  EXPECT_EQ(molecule.coordinate3dArray(1), nullptr);
+  EXPECT_EQ(molecule.coordinate3dArray(-1), nullptr);
+
+  // Edits in place do not reach copies sharing the frame.
+  Molecule copy(molecule);
+  Array<Vector3>* positions = molecule.coordinate3dArray(0);
+  ASSERT_NE(positions, nullptr);
+  (*positions)[0] = Vector3(4, 5, 6);
+  EXPECT_EQ(molecule.coordinate3d(0)[0], Vector3(4, 5, 6));
+  EXPECT_EQ(copy.coordinate3d(0)[0], Vector3(1, 2, 3));
+  EXPECT_EQ(frame[0], Vector3(1, 2, 3));
+}
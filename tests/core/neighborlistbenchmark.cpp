@@ -0,0 +1,98 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/neighborlist.h>
+
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::NeighborList;
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// Random points at about the atom density of a liquid, 0.1 per cubic Angstrom.
+Array<Vector3> randomPoints(size_t count)
+{
+  const Real size = std::cbrt(count / 0.1);
+  std::mt19937 generator(8);
+  std::uniform_real_distribution<Real> distribution(0.0, size);
+  Array<Vector3> points;
+  points.reserve(count);
+  for (size_t i = 0; i < count; ++i) {
+    Real x = distribution(generator);
+    Real y = distribution(generator);
+    Real z = distribution(generator);
+    points.push_back(Vector3(x, y, z));
+  }
+  return points;
+}
+
+void report(const char* name, Clock::time_point start, size_t result)
+{
+  double ms = std::chrono::duration<double, std::milli>(Clock::now() - start)
+                .count();
+  cout << "  " << name << ": " << ms << " ms (" << result << ")" << endl;
+}
+} // End anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  std::vector<size_t> counts;
+  for (int i = 1; i < argc; ++i)
+    counts.push_back(std::strtoul(argv[i], nullptr, 10));
+  if (counts.empty())
+    counts = { 10000, 30000, 100000, 300000 };
+
+  const Real radius = 3.0;
+  for (size_t c = 0; c < counts.size(); ++c) {
+    const Array<Vector3> points = randomPoints(counts[c]);
+    cout << points.size() << " points, radius " << radius << endl;
+
+    Clock::time_point start = Clock::now();
+    NeighborList list;
+    list.build(points, radius);
+    report("build", start, list.size());
+
+    start = Clock::now();
+    size_t pairCount = list.pairs(radius).size();
+    report("pairs", start, pairCount);
+
+    start = Clock::now();
+    size_t neighborCount = 0;
+    for (Index i = 0; i < points.size(); ++i)
+      neighborCount += list.neighbors(i, radius).size();
+    report("neighbors of every point", start, neighborCount);
+
+    // The linear scan the cell list replaces, only for the smaller systems.
+    if (points.size() <= 10000) {
+      start = Clock::now();
+      size_t bruteCount = 0;
+      for (Index i = 0; i < points.size(); ++i) {
+        for (Index j = i + 1; j < points.size(); ++j) {
+          if ((points[i] - points[j]).squaredNorm() <= radius * radius)
+            ++bruteCount;
+        }
+      }
+      report("brute force pairs", start, bruteCount);
+      if (bruteCount != pairCount) {
+        cout << "Pair counts differ" << endl;
+        return 1;
+      }
+    }
+  }
+
+  return 0;
+}
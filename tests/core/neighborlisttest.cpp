@@ -0,0 +1,176 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/neighborlist.h>
+#include <avogadro/core/unitcell.h>
+
+#include <algorithm>
+#include <random>
+#include <utility>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::NeighborList;
+using Avogadro::Core::UnitCell;
+
+namespace {
+
+Array<Vector3> randomPoints(size_t count, Real size, unsigned int seed)
+{
+  std::mt19937 generator(seed);
+  std::uniform_real_distribution<Real> distribution(0.0, size);
+  Array<Vector3> points;
+  for (size_t i = 0; i < count; ++i) {
+    Real x = distribution(generator);
+    Real y = distribution(generator);
+    Real z = distribution(generator);
+    points.push_back(Vector3(x, y, z));
+  }
+  return points;
+}
+
+std::vector<Index> bruteForce(const NeighborList& list, const Vector3& point,
+                              Real radius)
+{
+  std::vector<Index> result;
+  for (Index i = 0; i < list.size(); ++i) {
+    if (list.squaredDistance(point, list.position(i)) <= radius * radius)
+      result.push_back(i);
+  }
+  return result;
+}
+}
+
+TEST(NeighborListTest, radius)
+{
+  Array<Vector3> points = randomPoints(1000, 20.0, 1);
+  NeighborList list;
+  list.build(points, 2.0);
+  EXPECT_EQ(list.size(), points.size());
+  EXPECT_FALSE(list.isPeriodic());
+
+  Array<Vector3> queries = randomPoints(50, 24.0, 2);
+  for (size_t i = 0; i < queries.size(); ++i) {
+    Vector3 query = queries[i] - Vector3(2.0, 2.0, 2.0);
+    EXPECT_EQ(list.neighbors(query, 2.5), bruteForce(list, query, 2.5));
+    EXPECT_EQ(list.neighbors(query, 0.7), bruteForce(list, query, 0.7));
+  }
+
+  std::vector<Index> self = list.neighbors(Index(10), 3.0);
+  std::vector<Index> expected = bruteForce(list, points[10], 3.0);
+  expected.erase(std::find(expected.begin(), expected.end(), Index(10)));
+  EXPECT_EQ(self, expected);
+}
+
+TEST(NeighborListTest, periodic)
+{
+  UnitCell cell(12.0, 14.0, 10.0, 80.0 * M_PI / 180.0, 95.0 * M_PI / 180.0,
+                110.0 * M_PI / 180.0);
+  Array<Vector3> fractional = randomPoints(800, 1.0, 3);
+  Array<Vector3> points;
+  for (size_t i = 0; i < fractional.size(); ++i)
+    points.push_back(cell.toCartesian(fractional[i]));
+
+  NeighborList list;
+  list.build(points, 1.5, &cell);
+  EXPECT_TRUE(list.isPeriodic());
+
+  for (size_t i = 0; i < 50; ++i) {
+    std::vector<Index> expected = bruteForce(list, points[i], 3.0);
+    EXPECT_EQ(list.neighbors(points[i], 3.0), expected);
+    // Queries outside the cell see the periodic images.
+    Vector3 shifted = points[i] + cell.imageOffset(2, -1, 1);
+    EXPECT_EQ(list.neighbors(shifted, 3.0), expected);
+  }
+
+  // An atom by a cell face is a neighbor of one by the opposite face.
+  Array<Vector3> pair;
+  pair.push_back(cell.toCartesian(Vector3(0.02, 0.5, 0.5)));
+  pair.push_back(cell.toCartesian(Vector3(0.98, 0.5, 0.5)));
+  list.build(pair, 2.0, &cell);
+  EXPECT_EQ(list.neighbors(Index(0), 1.0).size(), static_cast<size_t>(1));
+}
+
+TEST(NeighborListTest, nearest)
+{
+  Array<Vector3> points = randomPoints(500, 15.0, 4);
+  NeighborList list;
+  list.build(points, 1.0);
+
+  Vector3 query(7.0, 3.0, 11.0);
+  std::vector<std::pair<Real, Index>> sorted;
+  for (Index i = 0; i < points.size(); ++i)
+    sorted.push_back(std::make_pair((points[i] - query).squaredNorm(), i));
+  std::sort(sorted.begin(), sorted.end());
+
+  std::vector<Index> nearest = list.nearest(query, 12);
+  ASSERT_EQ(nearest.size(), static_cast<size_t>(12));
+  for (size_t i = 0; i < nearest.size(); ++i)
+    EXPECT_EQ(nearest[i], sorted[i].second);
+
+  // Far away queries and k larger than the list.
+  EXPECT_EQ(list.nearest(Vector3(100.0, 0.0, 0.0), 600).size(),
+            points.size());
+  EXPECT_TRUE(NeighborList().nearest(query, 3).empty());
+}
+
+TEST(NeighborListTest, updates)
+{
+  Array<Vector3> points = randomPoints(300, 10.0, 5);
+  NeighborList list;
+  list.build(points, 1.5);
+
+  Array<Vector3> moved = randomPoints(300, 14.0, 6);
+  for (Index i = 0; i < 100; ++i)
+    list.updatePosition(i, moved[i] - Vector3(2.0, 2.0, 2.0));
+  Index added = list.addPosition(Vector3(-5.0, 5.0, 5.0));
+  EXPECT_EQ(added, static_cast<Index>(300));
+
+  for (Index i = 0; i < list.size(); i += 7) {
+    EXPECT_EQ(list.neighbors(list.position(i), 2.0),
+              bruteForce(list, list.position(i), 2.0));
+  }
+  EXPECT_EQ(list.neighbors(Vector3(-5.0, 5.0, 5.0), 0.1).size(),
+            static_cast<size_t>(1));
+}
+
+TEST(NeighborListTest, pairs)
+{
+  Array<Vector3> points = randomPoints(400, 12.0, 7);
+  NeighborList list;
+  list.build(points, 2.0);
+
+  std::vector<std::pair<Index, Index>> expected;
+  for (Index i = 0; i < points.size(); ++i) {
+    for (Index j = i + 1; j < points.size(); ++j) {
+      if ((points[i] - points[j]).norm() <= 2.0)
+        expected.push_back(std::make_pair(i, j));
+    }
+  }
+  EXPECT_EQ(list.pairs(2.0), expected);
+}
+
+TEST(NeighborListTest, perceiveBonds)
+{
+  // A water molecule and a distant hydrogen molecule.
+  Molecule molecule;
+  molecule.addAtom(8).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  molecule.addAtom(1).setPosition3d(Vector3(0.96, 0.0, 0.0));
+  molecule.addAtom(1).setPosition3d(Vector3(-0.24, 0.93, 0.0));
+  molecule.addAtom(1).setPosition3d(Vector3(20.0, 0.0, 0.0));
+  molecule.addAtom(1).setPosition3d(Vector3(20.74, 0.0, 0.0));
+  molecule.perceiveBondsSimple();
+  // Hydrogen pairs are never bonded by the simple perception.
+  EXPECT_EQ(molecule.bondCount(), static_cast<Index>(2));
+  EXPECT_EQ(molecule.bond(0).atom1().index(), static_cast<Index>(0));
+  EXPECT_EQ(molecule.bond(0).atom2().index(), static_cast<Index>(1));
+  EXPECT_EQ(molecule.bond(1).atom2().index(), static_cast<Index>(2));
+}
@@ -0,0 +1,74 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/ringperceiver.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::RingPerceiver;
+using std::cout;
+using std::endl;
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+// A chain with a phenyl ring every 20 atoms, ringCount rings in all. With a
+// few thousand rings this is roughly the size of a protein.
+void buildChain(Molecule& molecule, size_t ringCount)
+{
+  Array<std::pair<Index, Index>> pairs;
+  Index previous = 0;
+  Index atom = 1;
+  for (size_t i = 0; i < ringCount; ++i) {
+    for (size_t j = 0; j < 14; ++j, ++atom) {
+      pairs.push_back(std::make_pair(previous, atom));
+      previous = atom;
+    }
+    pairs.push_back(std::make_pair(previous, atom));
+    for (Index k = 0; k < 5; ++k)
+      pairs.push_back(std::make_pair(atom + k, atom + k + 1));
+    pairs.push_back(std::make_pair(atom, atom + 5));
+    previous = atom + 5;
+    atom += 6;
+  }
+  molecule.addAtoms(Array<unsigned char>(atom, 6), Array<Avogadro::Vector3>());
+  molecule.addBonds(pairs, Array<unsigned char>(pairs.size(), 1));
+}
+} // End anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  std::vector<size_t> counts;
+  for (int i = 1; i < argc; ++i)
+    counts.push_back(std::strtoul(argv[i], nullptr, 10));
+  if (counts.empty())
+    counts = { 100, 1000, 5000, 20000 };
+
+  for (size_t c = 0; c < counts.size(); ++c) {
+    Molecule molecule;
+    buildChain(molecule, counts[c]);
+
+    Clock::time_point start = Clock::now();
+    RingPerceiver perceiver(&molecule);
+    size_t ringCount = perceiver.rings().size();
+    double ms = std::chrono::duration<double, std::milli>(Clock::now() - start)
+                  .count();
+    cout << molecule.atomCount() << " atoms, " << molecule.bondCount()
+         << " bonds: " << ringCount << " rings in " << ms << " ms" << endl;
+    if (ringCount != counts[c]) {
+      cout << "Expected " << counts[c] << " rings" << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
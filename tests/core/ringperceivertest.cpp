@@ -57,3 +57,110 @@ TEST(RingPerceiverTest, ethanol)
   std::vector<std::vector<size_t>> rings = perceiver.rings();
   EXPECT_EQ(rings.size(), static_cast<size_t>(0));
 }
+
+namespace {
+// Add a ring of carbon atoms bonded in sequence, returning its first atom.
+size_t addRing(Molecule& molecule, size_t size)
+{
+  size_t first = molecule.atomCount();
+  for (size_t i = 0; i < size; ++i)
+    molecule.addAtom(6);
+  for (size_t i = 0; i < size; ++i)
+    molecule.addBond(first + i, first + (i + 1) % size, 1);
+  return first;
+}
+}
+
+TEST(RingPerceiverTest, naphthalene)
+{
+  Molecule molecule;
+  size_t first = addRing(molecule, 10);
+  // Fuse the two six membered rings across atoms 0 and 5.
+  molecule.addBond(first, first + 5, 1);
+  // Hydrogens do not add rings.
+  for (size_t i = 1; i < 10; ++i) {
+    if (i == 5)
+      continue;
+    molecule.addBond(first + i, molecule.addAtom(1).index(), 1);
+  }
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t>> rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(2));
+  EXPECT_EQ(rings[0].size(), static_cast<size_t>(6));
+  EXPECT_EQ(rings[1].size(), static_cast<size_t>(6));
+}
+
+TEST(RingPerceiverTest, cubane)
+{
+  Molecule molecule;
+  addRing(molecule, 4);
+  addRing(molecule, 4);
+  for (size_t i = 0; i < 4; ++i)
+    molecule.addBond(i, i + 4, 1);
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t>> rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(5));
+  for (size_t i = 0; i < rings.size(); ++i)
+    EXPECT_EQ(rings[i].size(), static_cast<size_t>(4));
+}
+
+TEST(RingPerceiverTest, ringSystems)
+{
+  // Biphenyl, a spiro compound and a separate cyclopropane.
+  Molecule molecule;
+  size_t phenyl1 = addRing(molecule, 6);
+  size_t phenyl2 = addRing(molecule, 6);
+  molecule.addBond(phenyl1, phenyl2, 1);
+  size_t spiro = addRing(molecule, 5);
+  size_t cyclopentane = molecule.atomCount();
+  for (size_t i = 0; i < 4; ++i)
+    molecule.addAtom(6);
+  molecule.addBond(spiro, cyclopentane, 1);
+  for (size_t i = 0; i < 3; ++i)
+    molecule.addBond(cyclopentane + i, cyclopentane + i + 1, 1);
+  molecule.addBond(cyclopentane + 3, spiro, 1);
+  addRing(molecule, 3);
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t>> rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(5));
+  EXPECT_EQ(rings[0].size(), static_cast<size_t>(3));
+  EXPECT_EQ(rings[1].size(), static_cast<size_t>(5));
+  EXPECT_EQ(rings[2].size(), static_cast<size_t>(5));
+  EXPECT_EQ(rings[3].size(), static_cast<size_t>(6));
+  EXPECT_EQ(rings[4].size(), static_cast<size_t>(6));
+
+  // Each ring only contains bonded atoms of the molecule.
+  for (size_t i = 0; i < rings.size(); ++i) {
+    const std::vector<size_t>& ring = rings[i];
+    for (size_t j = 0; j < ring.size(); ++j) {
+      EXPECT_TRUE(molecule.graph().containsEdge(ring[j],
+                                                ring[(j + 1) % ring.size()]));
+    }
+  }
+}
+
+TEST(RingPerceiverTest, chainOfRings)
+{
+  // A chain with a phenyl ring every 20 atoms. ringperceiverbenchmark times
+  // the same structure at the size of a protein.
+  Molecule molecule;
+  size_t previous = molecule.addAtom(6).index();
+  for (size_t i = 0; i < 50; ++i) {
+    for (size_t j = 0; j < 14; ++j) {
+      size_t atom = molecule.addAtom(6).index();
+      molecule.addBond(previous, atom, 1);
+      previous = atom;
+    }
+    size_t ring = addRing(molecule, 6);
+    molecule.addBond(previous, ring, 1);
+  }
+
+  RingPerceiver perceiver(&molecule);
+  std::vector<std::vector<size_t>> rings = perceiver.rings();
+  ASSERT_EQ(rings.size(), static_cast<size_t>(50));
+  for (size_t i = 0; i < rings.size(); ++i)
+    EXPECT_EQ(rings[i].size(), static_cast<size_t>(6));
+}
@@ -0,0 +1,180 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/rmsdcalculator.h>
+
+#include <Eigen/Geometry>
+
+#include <cmath>
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::Matrix3;
+using Avogadro::MatrixX;
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::RmsdCalculator;
+
+namespace {
+
+std::vector<Vector3> points()
+{
+  std::vector<Vector3> result;
+  result.push_back(Vector3(0.0, 0.0, 0.0));
+  result.push_back(Vector3(1.5, 0.0, 0.0));
+  result.push_back(Vector3(1.5, 1.2, 0.3));
+  result.push_back(Vector3(-0.4, 0.8, 1.1));
+  result.push_back(Vector3(0.7, -1.3, 0.6));
+  return result;
+}
+
+std::vector<Vector3> transformed(const std::vector<Vector3>& input)
+{
+  Matrix3 rotation(
+    Eigen::AngleAxisd(0.8, Vector3(1.0, 2.0, -0.5).normalized())
+      .toRotationMatrix());
+  Vector3 translation(3.0, -2.0, 7.5);
+  std::vector<Vector3> result;
+  for (size_t i = 0; i < input.size(); ++i)
+    result.push_back(rotation * input[i] + translation);
+  return result;
+}
+
+// A molecule with three frames: the points, the points rotated and
+// translated, and the points with the first atom displaced.
+void setupTrajectory(Molecule& molecule)
+{
+  std::vector<Vector3> frame0 = points();
+  std::vector<Vector3> frame1 = transformed(frame0);
+  std::vector<Vector3> frame2 = frame0;
+  frame2[0] += Vector3(0.0, 0.0, 2.0);
+
+  for (size_t i = 0; i < frame0.size(); ++i)
+    molecule.addAtom(6);
+  molecule.setCoordinate3d(Array<Vector3>(frame0.begin(), frame0.end()), 0);
+  molecule.setCoordinate3d(Array<Vector3>(frame1.begin(), frame1.end()), 1);
+  molecule.setCoordinate3d(Array<Vector3>(frame2.begin(), frame2.end()), 2);
+  molecule.setAtomPositions3d(Array<Vector3>(frame2.begin(), frame2.end()));
+}
+}
+
+TEST(RmsdCalculatorTest, superposition)
+{
+  std::vector<Vector3> a = points();
+  std::vector<Vector3> b = transformed(a);
+
+  EXPECT_GT(RmsdCalculator::rmsd(a, b, false), 1.0);
+
+  Matrix3 rotation;
+  Vector3 translation;
+  EXPECT_NEAR(RmsdCalculator::rmsd(a, b, true, &rotation, &translation), 0.0,
+              1e-6);
+  for (size_t i = 0; i < a.size(); ++i)
+    EXPECT_LT((a[i] - (rotation * b[i] + translation)).norm(), 1e-8);
+  EXPECT_NEAR(rotation.determinant(), 1.0, 1e-10);
+}
+
+TEST(RmsdCalculatorTest, reflection)
+{
+  // A mirror image can not be superimposed with a proper rotation.
+  std::vector<Vector3> a = points();
+  std::vector<Vector3> b = a;
+  for (size_t i = 0; i < b.size(); ++i)
+    b[i].z() = -b[i].z();
+
+  Matrix3 rotation;
+  EXPECT_GT(RmsdCalculator::rmsd(a, b, true, &rotation), 0.1);
+  EXPECT_NEAR(rotation.determinant(), 1.0, 1e-10);
+}
+
+TEST(RmsdCalculatorTest, rmsdToFrame)
+{
+  Molecule molecule;
+  setupTrajectory(molecule);
+  RmsdCalculator calculator(&molecule);
+  EXPECT_EQ(calculator.frameCount(), 3);
+
+  std::vector<Real> rmsd = calculator.rmsdToFrame(0);
+  ASSERT_EQ(rmsd.size(), static_cast<size_t>(3));
+  EXPECT_NEAR(rmsd[0], 0.0, 1e-6);
+  EXPECT_NEAR(rmsd[1], 0.0, 1e-6);
+  EXPECT_GT(rmsd[2], 0.1);
+  // Moving one atom by 2 Angstrom is at most sqrt(4 / 5) before alignment.
+  EXPECT_LT(rmsd[2], std::sqrt(4.0 / 5.0));
+
+  calculator.setAlign(false);
+  rmsd = calculator.rmsdToFrame(0);
+  ASSERT_EQ(rmsd.size(), static_cast<size_t>(3));
+  EXPECT_GT(rmsd[1], 1.0);
+  EXPECT_NEAR(rmsd[2], std::sqrt(4.0 / 5.0), 1e-10);
+
+  EXPECT_TRUE(calculator.rmsdToFrame(3).empty());
+
+  // The displayed coordinates are untouched.
+  EXPECT_TRUE(molecule.atomPositions3d()[0].isApprox(
+    points()[0] + Vector3(0.0, 0.0, 2.0)));
+}
+
+TEST(RmsdCalculatorTest, atomSubset)
+{
+  Molecule molecule;
+  setupTrajectory(molecule);
+  RmsdCalculator calculator(&molecule);
+
+  // Without the displaced atom all frames superimpose.
+  std::vector<Index> atoms;
+  atoms.push_back(1);
+  atoms.push_back(2);
+  atoms.push_back(3);
+  atoms.push_back(4);
+  calculator.setAtoms(atoms);
+  std::vector<Real> rmsd = calculator.rmsdToFrame(2);
+  ASSERT_EQ(rmsd.size(), static_cast<size_t>(3));
+  for (size_t i = 0; i < rmsd.size(); ++i)
+    EXPECT_NEAR(rmsd[i], 0.0, 1e-6);
+
+  atoms.push_back(5);
+  calculator.setAtoms(atoms);
+  EXPECT_TRUE(calculator.rmsdToFrame(0).empty());
+}
+
+TEST(RmsdCalculatorTest, pairwiseRmsd)
+{
+  Molecule molecule;
+  setupTrajectory(molecule);
+  RmsdCalculator calculator(&molecule);
+
+  MatrixX matrix = calculator.pairwiseRmsd();
+  ASSERT_EQ(matrix.rows(), 3);
+  ASSERT_EQ(matrix.cols(), 3);
+  std::vector<Real> fromFirst = calculator.rmsdToFrame(0);
+  for (Index i = 0; i < 3; ++i) {
+    EXPECT_EQ(matrix(i, i), 0.0);
+    EXPECT_NEAR(matrix(0, i), fromFirst[i], 1e-6);
+    for (Index j = 0; j < 3; ++j)
+      EXPECT_EQ(matrix(i, j), matrix(j, i));
+  }
+  EXPECT_NEAR(matrix(1, 2), matrix(0, 2), 1e-6);
+}
+
+TEST(RmsdCalculatorTest, noCoordinateSets)
+{
+  Molecule molecule;
+  molecule.addAtom(6).setPosition3d(Vector3(1.0, 0.0, 0.0));
+  RmsdCalculator calculator(&molecule);
+  EXPECT_EQ(calculator.frameCount(), 1);
+  std::vector<Real> rmsd = calculator.rmsdToFrame(0);
+  ASSERT_EQ(rmsd.size(), static_cast<size_t>(1));
+  EXPECT_EQ(rmsd[0], 0.0);
+
+  RmsdCalculator empty;
+  EXPECT_EQ(empty.frameCount(), 0);
+  EXPECT_TRUE(empty.rmsdToFrame(0).empty());
+  EXPECT_EQ(empty.pairwiseRmsd().size(), 0);
+}
@@ -0,0 +1,149 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/selection.h>
+
+#include <vector>
+
+using Avogadro::Index;
+using Avogadro::MaxIndex;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::Selection;
+
+TEST(SelectionTest, setAndTest)
+{
+  Selection selection(130);
+  EXPECT_EQ(selection.size(), static_cast<Index>(130));
+  EXPECT_TRUE(selection.none());
+  selection.set(0);
+  selection.set(64);
+  selection.set(129);
+  selection.set(130); // Out of range, ignored.
+  EXPECT_TRUE(selection.test(0));
+  EXPECT_TRUE(selection.test(64));
+  EXPECT_TRUE(selection.test(129));
+  EXPECT_FALSE(selection.test(130));
+  EXPECT_FALSE(selection.test(1));
+  EXPECT_EQ(selection.count(), static_cast<Index>(3));
+  selection.set(64, false);
+  selection.flip(1);
+  EXPECT_FALSE(selection.test(64));
+  EXPECT_TRUE(selection.test(1));
+  EXPECT_EQ(selection.count(), static_cast<Index>(3));
+}
+
+TEST(SelectionTest, ranges)
+{
+  Selection selection(200);
+  selection.setRange(10, 150);
+  EXPECT_EQ(selection.count(), static_cast<Index>(140));
+  EXPECT_FALSE(selection.test(9));
+  EXPECT_TRUE(selection.test(10));
+  EXPECT_TRUE(selection.test(149));
+  EXPECT_FALSE(selection.test(150));
+
+  selection.setRange(60, 70, false);
+  EXPECT_EQ(selection.count(), static_cast<Index>(130));
+  selection.flipRange(0, 20);
+  EXPECT_EQ(selection.count(), static_cast<Index>(130));
+  EXPECT_TRUE(selection.test(0));
+  EXPECT_FALSE(selection.test(10));
+
+  // Ranges are clipped to the size.
+  selection.setRange(190, 1000);
+  EXPECT_EQ(selection.count(), static_cast<Index>(140));
+
+  selection.setAll();
+  EXPECT_EQ(selection.count(), static_cast<Index>(200));
+  selection.flipAll();
+  EXPECT_TRUE(selection.none());
+  selection.flipAll();
+  EXPECT_EQ(selection.count(), static_cast<Index>(200));
+}
+
+TEST(SelectionTest, iterate)
+{
+  Selection selection(300);
+  EXPECT_EQ(selection.first(), MaxIndex);
+  const Index expected[] = { 3, 63, 64, 65, 200, 299 };
+  for (Index i : expected)
+    selection.set(i);
+
+  std::vector<Index> visited;
+  for (Index i = selection.first(); i != MaxIndex; i = selection.next(i))
+    visited.push_back(i);
+  EXPECT_EQ(visited, std::vector<Index>(expected, expected + 6));
+  EXPECT_EQ(selection.indices(), visited);
+}
+
+TEST(SelectionTest, setOperations)
+{
+  Selection a(100);
+  Selection b(70);
+  a.setRange(0, 50);
+  b.setRange(40, 70);
+
+  Selection united = a;
+  united |= b;
+  EXPECT_EQ(united.count(), static_cast<Index>(70));
+  EXPECT_EQ(united.size(), static_cast<Index>(100));
+
+  Selection both = a;
+  both &= b;
+  EXPECT_EQ(both.count(), static_cast<Index>(10));
+  EXPECT_TRUE(both.test(40));
+  EXPECT_FALSE(both.test(50));
+
+  Selection either = a;
+  either ^= b;
+  EXPECT_EQ(either.count(), static_cast<Index>(60));
+
+  Selection onlyA = a;
+  onlyA.subtract(b);
+  EXPECT_EQ(onlyA.count(), static_cast<Index>(40));
+  EXPECT_FALSE(onlyA.test(45));
+
+  // Bits of a longer selection do not leak past the size.
+  Selection small(10);
+  Selection large(64);
+  large.setAll();
+  small |= large;
+  EXPECT_EQ(small.count(), static_cast<Index>(10));
+  small.resize(64);
+  EXPECT_EQ(small.count(), static_cast<Index>(10));
+  EXPECT_TRUE(small == small);
+  EXPECT_TRUE(small != large);
+}
+
+TEST(SelectionTest, moleculeRemoval)
+{
+  Molecule molecule;
+  for (int i = 0; i < 5; ++i)
+    molecule.addAtom(6);
+  molecule.addBond(0, 1);
+  molecule.addBond(1, 2);
+  molecule.addBond(3, 4);
+  molecule.setAtomSelected(1, true);
+  molecule.setAtomSelected(4, true);
+  molecule.setBondSelected(2, true);
+  EXPECT_TRUE(molecule.bondSelected(2));
+
+  // Atom 4 moves into slot 0, and bond 2 into the slot of bond 0.
+  molecule.removeAtom(static_cast<Index>(0));
+  EXPECT_EQ(molecule.atomSelection().count(), static_cast<Index>(2));
+  EXPECT_TRUE(molecule.atomSelected(0));
+  EXPECT_TRUE(molecule.atomSelected(1));
+  EXPECT_FALSE(molecule.atomSelected(3));
+  EXPECT_TRUE(molecule.bondSelected(0));
+  EXPECT_EQ(molecule.bondSelection().size(), molecule.bondCount());
+
+  molecule.atomSelection().flipAll();
+  EXPECT_FALSE(molecule.atomSelected(0));
+  EXPECT_TRUE(molecule.atomSelected(2));
+  EXPECT_FALSE(molecule.isSelectionEmpty());
+  molecule.atomSelection().setAll(false);
+  EXPECT_TRUE(molecule.isSelectionEmpty());
+}
@@ -505,3 +505,22 @@ TEST(SpaceGroupTest, reduceToAsymmetricUnit)
   ASSERT_EQ(mol2.atomCount(), 4);
   ASSERT_EQ(mol2.atomicNumbers().size(), 4);
 }
+
+TEST(SpaceGroupTest, getTransforms)
+{
+  // The operations are parsed once and then reused.
+  Vector3 v(0.1, 0.2, 0.3);
+  for (int repeat = 0; repeat < 2; ++repeat) {
+    // P -1: x,y,z -x,-y,-z
+    Avogadro::Core::Array<Vector3> transforms =
+      SpaceGroups::getTransforms(2, v);
+    ASSERT_EQ(transforms.size(), SpaceGroups::transformsCount(2));
+    ASSERT_EQ(transforms.size(), 2);
+    EXPECT_TRUE(transforms[0].isApprox(v));
+    EXPECT_TRUE(transforms[1].isApprox(-v));
+  }
+  Avogadro::Core::Array<Vector3> transforms =
+    SpaceGroups::getTransforms(298, v);
+  EXPECT_EQ(transforms.size(), SpaceGroups::transformsCount(298));
+  EXPECT_EQ(SpaceGroups::getTransforms(531, v).size(), 0);
+}
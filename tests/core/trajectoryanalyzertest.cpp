@@ -0,0 +1,187 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/trajectoryanalyzer.h>
+#include <avogadro/core/unitcell.h>
+
+#include <random>
+#include <vector>
+
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::TrajectoryAnalyzer;
+using Avogadro::Core::UnitCell;
+
+namespace {
+
+const Real halfPi = 0.5 * M_PI;
+
+// A periodic simple cubic lattice of argon.
+void setupLattice(Molecule& molecule, int size, Real spacing)
+{
+  Real edge = size * spacing;
+  molecule.setUnitCell(new UnitCell(edge, edge, edge, halfPi, halfPi, halfPi));
+  for (int i = 0; i < size; ++i) {
+    for (int j = 0; j < size; ++j) {
+      for (int k = 0; k < size; ++k)
+        molecule.addAtom(18).setPosition3d(Vector3(i, j, k) * spacing);
+    }
+  }
+}
+}
+
+TEST(TrajectoryAnalyzerTest, latticeRdf)
+{
+  Molecule molecule;
+  setupLattice(molecule, 6, 3.0);
+  TrajectoryAnalyzer analyzer(&molecule);
+  EXPECT_EQ(analyzer.frameCount(), 1);
+
+  TrajectoryAnalyzer::RadialDistribution rdf =
+    analyzer.radialDistribution(18, 18, 9.0, 72);
+  ASSERT_EQ(rdf.radii.size(), static_cast<size_t>(72));
+  EXPECT_NEAR(rdf.radii.back(), 8.9375, 1e-10);
+
+  // The first shell has 6 neighbors at 3 Angstrom, the second 12 at 4.24.
+  for (size_t bin = 0; bin < 24; ++bin)
+    EXPECT_EQ(rdf.values[bin], 0.0);
+  EXPECT_GT(rdf.values[24], 1.0);
+  EXPECT_NEAR(rdf.coordination[24], 6.0, 1e-10);
+  EXPECT_NEAR(rdf.coordination[32], 6.0, 1e-10);
+  EXPECT_NEAR(rdf.coordination[33], 18.0, 1e-10);
+
+  // g(r) integrates to the coordination number.
+  Real density = molecule.atomCount() / molecule.unitCell()->volume();
+  Real integral = 0.0;
+  for (size_t bin = 0; bin < 34; ++bin) {
+    Real inner = bin * 0.125;
+    Real outer = inner + 0.125;
+    integral += rdf.values[bin] * density * 4.0 / 3.0 * M_PI *
+                (outer * outer * outer - inner * inner * inner);
+  }
+  EXPECT_NEAR(integral, 18.0 * molecule.atomCount() /
+                          (molecule.atomCount() - 1.0),
+              1e-8);
+
+  std::vector<Real> histogram = analyzer.coordinationHistogram(18, 0, 3.2);
+  ASSERT_EQ(histogram.size(), static_cast<size_t>(7));
+  EXPECT_NEAR(histogram[6], 1.0, 1e-12);
+  EXPECT_EQ(histogram[0], 0.0);
+}
+
+TEST(TrajectoryAnalyzerTest, periodicImages)
+{
+  // Radii beyond half the cell see further images, a small cell gives the
+  // same distribution as a supercell of it.
+  Molecule small;
+  setupLattice(small, 2, 3.0);
+  Molecule large;
+  setupLattice(large, 4, 3.0);
+  TrajectoryAnalyzer::RadialDistribution smallRdf =
+    TrajectoryAnalyzer(&small).radialDistribution(0, 0, 7.0, 50);
+  TrajectoryAnalyzer::RadialDistribution largeRdf =
+    TrajectoryAnalyzer(&large).radialDistribution(0, 0, 7.0, 50);
+  ASSERT_EQ(smallRdf.coordination.size(), static_cast<size_t>(50));
+  for (size_t bin = 0; bin < 50; ++bin) {
+    EXPECT_NEAR(smallRdf.coordination[bin], largeRdf.coordination[bin], 1e-10);
+    // The normalization differs by N / (N - 1).
+    EXPECT_NEAR(smallRdf.values[bin] * 7.0 / 8.0,
+                largeRdf.values[bin] * 63.0 / 64.0, 1e-10);
+  }
+  // 6 + 12 + 8 + 6 + 24 neighbors below 7 Angstrom.
+  EXPECT_NEAR(smallRdf.coordination.back(), 56.0, 1e-10);
+
+  std::vector<Real> histogram =
+    TrajectoryAnalyzer(&small).coordinationHistogram(18, 18, 4.5);
+  ASSERT_EQ(histogram.size(), static_cast<size_t>(19));
+  EXPECT_NEAR(histogram[18], 1.0, 1e-12);
+}
+
+TEST(TrajectoryAnalyzerTest, idealGas)
+{
+  // Uncorrelated points have g(r) = 1.
+  Molecule molecule;
+  molecule.setUnitCell(new UnitCell(12.0, 12.0, 12.0, halfPi, halfPi, halfPi));
+  std::mt19937 generator(11);
+  std::uniform_real_distribution<Real> distribution(0.0, 12.0);
+  for (int i = 0; i < 400; ++i)
+    molecule.addAtom(i % 2 ? 8 : 1);
+  for (int frame = 0; frame < 4; ++frame) {
+    Array<Vector3> positions;
+    for (int i = 0; i < 400; ++i) {
+      Real x = distribution(generator);
+      Real y = distribution(generator);
+      Real z = distribution(generator);
+      positions.push_back(Vector3(x, y, z));
+    }
+    molecule.setCoordinate3d(positions, frame);
+  }
+
+  TrajectoryAnalyzer analyzer(&molecule);
+  EXPECT_EQ(analyzer.frameCount(), 4);
+  TrajectoryAnalyzer::RadialDistribution rdf =
+    analyzer.radialDistribution(8, 1, 6.0, 12);
+  ASSERT_EQ(rdf.values.size(), static_cast<size_t>(12));
+  for (size_t bin = 4; bin < 12; ++bin)
+    EXPECT_NEAR(rdf.values[bin], 1.0, 0.1);
+  // 200 hydrogens in 1728 cubic Angstrom.
+  EXPECT_NEAR(rdf.coordination.back(), 4.0 / 3.0 * M_PI * 216.0 / 8.64, 5.0);
+
+  std::vector<Real> histogram = analyzer.coordinationHistogram(8, 1, 3.0);
+  Real sum = 0.0;
+  for (size_t n = 0; n < histogram.size(); ++n)
+    sum += histogram[n];
+  EXPECT_NEAR(sum, 1.0, 1e-12);
+}
+
+TEST(TrajectoryAnalyzerTest, meanSquareDisplacement)
+{
+  Molecule molecule;
+  molecule.setUnitCell(new UnitCell(10.0, 10.0, 10.0, halfPi, halfPi, halfPi));
+  molecule.addAtom(6);
+  molecule.addAtom(8);
+  // The carbon moves 1.5 Angstrom per frame along a and wraps around the
+  // cell, the oxygen stays put.
+  for (int frame = 0; frame < 20; ++frame) {
+    Array<Vector3> positions;
+    Real x = 1.5 * frame;
+    positions.push_back(Vector3(x - 10.0 * std::floor(x / 10.0), 5.0, 5.0));
+    positions.push_back(Vector3(2.0, 2.0, 2.0));
+    molecule.setCoordinate3d(positions, frame);
+  }
+
+  TrajectoryAnalyzer analyzer(&molecule);
+  std::vector<Real> carbon = analyzer.meanSquareDisplacement(6);
+  ASSERT_EQ(carbon.size(), static_cast<size_t>(20));
+  for (size_t lag = 0; lag < carbon.size(); ++lag)
+    EXPECT_NEAR(carbon[lag], 2.25 * lag * lag, 1e-8);
+
+  std::vector<Real> all = analyzer.meanSquareDisplacement();
+  EXPECT_NEAR(all[4], 0.5 * 2.25 * 16.0, 1e-8);
+  std::vector<Real> oxygen = analyzer.meanSquareDisplacement(8);
+  EXPECT_NEAR(oxygen[19], 0.0, 1e-12);
+}
+
+TEST(TrajectoryAnalyzerTest, empty)
+{
+  TrajectoryAnalyzer analyzer;
+  EXPECT_EQ(analyzer.frameCount(), 0);
+  EXPECT_TRUE(analyzer.radialDistribution().values.empty());
+  EXPECT_TRUE(analyzer.meanSquareDisplacement().empty());
+
+  Molecule molecule;
+  molecule.addAtom(6).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  analyzer.setMolecule(&molecule);
+  // A single atom has no pairs.
+  EXPECT_TRUE(analyzer.radialDistribution(6, 6).values.empty());
+  EXPECT_TRUE(analyzer.radialDistribution(8, 6).values.empty());
+  std::vector<Real> histogram = analyzer.coordinationHistogram(6, 6, 2.0);
+  ASSERT_EQ(histogram.size(), static_cast<size_t>(1));
+  EXPECT_EQ(histogram[0], 1.0);
+}
@@ -0,0 +1,268 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/array.h>
+#include <avogadro/core/molecule.h>
+#include <avogadro/core/unitcell.h>
+#include <avogadro/core/xrdcalculator.h>
+
+#include <cmath>
+#include <vector>
+
+using Avogadro::Real;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::Core::Molecule;
+using Avogadro::Core::UnitCell;
+using Avogadro::Core::XrdCalculator;
+
+namespace {
+
+const Real halfPi = 0.5 * M_PI;
+
+// Rock salt, a face centered cubic lattice with a two atom basis.
+void setupRockSalt(Molecule& molecule, Real a)
+{
+  UnitCell* cell = new UnitCell(a, a, a, halfPi, halfPi, halfPi);
+  molecule.setUnitCell(cell);
+  const Vector3 lattice[4] = { Vector3(0.0, 0.0, 0.0), Vector3(0.5, 0.5, 0.0),
+                               Vector3(0.5, 0.0, 0.5),
+                               Vector3(0.0, 0.5, 0.5) };
+  for (int i = 0; i < 4; ++i) {
+    molecule.addAtom(11).setPosition3d(cell->toCartesian(lattice[i]));
+    molecule.addAtom(17).setPosition3d(
+      cell->toCartesian(lattice[i] + Vector3(0.5, 0.0, 0.0)));
+  }
+}
+
+// Cesium chloride, a simple cubic lattice with a two atom basis.
+void setupCesiumChloride(Molecule& molecule, Real a)
+{
+  UnitCell* cell = new UnitCell(a, a, a, halfPi, halfPi, halfPi);
+  molecule.setUnitCell(cell);
+  molecule.addAtom(55).setPosition3d(Vector3(0.0, 0.0, 0.0));
+  molecule.addAtom(17).setPosition3d(
+    cell->toCartesian(Vector3(0.5, 0.5, 0.5)));
+}
+
+Real braggAngle(Real wavelength, Real d)
+{
+  return 2.0 * std::asin(0.5 * wavelength / d) * 180.0 / M_PI;
+}
+
+const XrdCalculator::Reflection* findPeak(
+  const std::vector<XrdCalculator::Reflection>& peaks, Real twoTheta)
+{
+  for (size_t i = 0; i < peaks.size(); ++i) {
+    if (std::fabs(peaks[i].twoTheta - twoTheta) < 1e-6)
+      return &peaks[i];
+  }
+  return nullptr;
+}
+}
+
+TEST(XrdCalculatorTest, formFactor)
+{
+  XrdCalculator calculator;
+  // At s = 0 the form factor is the number of electrons.
+  EXPECT_NEAR(calculator.formFactor(6, 0.0), 6.0, 1e-3);
+  EXPECT_NEAR(calculator.formFactor(8, 0.0), 8.0, 1e-3);
+  EXPECT_LT(calculator.formFactor(26, 0.5), calculator.formFactor(26, 0.2));
+  EXPECT_EQ(calculator.formFactor(0, 0.0), 0.0);
+  // The tabulated coefficients cover H to Cf, with f(0) within 0.06 of Z.
+  for (unsigned char z = 1; z <= 98; ++z)
+    EXPECT_NEAR(calculator.formFactor(z, 0.0), z, 0.06);
+  // Fe: a1 exp(-b1 s^2) + ... + c with a1 = 11.7695, b1 = 4.7611, ...
+  EXPECT_NEAR(calculator.formFactor(26, 0.5),
+              11.7695 * std::exp(-4.7611 * 0.25) +
+                7.3573 * std::exp(-0.3072 * 0.25) +
+                3.5222 * std::exp(-15.3535 * 0.25) +
+                2.3045 * std::exp(-76.8805 * 0.25) + 1.0369,
+              1e-10);
+  // Heavier elements use the Moliere screened atom.
+  EXPECT_NEAR(calculator.formFactor(99, 0.0), 99.0, 1e-10);
+
+  const Real coefficients[9] = { 1.0, 0.0, 1.0, 0.0, 1.0, 0.0, 1.0, 0.0, 1.0 };
+  calculator.setFormFactorCoefficients(26, coefficients);
+  EXPECT_NEAR(calculator.formFactor(26, 0.3), 5.0, 1e-10);
+}
+
+TEST(XrdCalculatorTest, rockSalt)
+{
+  Molecule molecule;
+  const Real a = 5.64;
+  setupRockSalt(molecule, a);
+
+  XrdCalculator calculator;
+  calculator.setWavelength(1.5406);
+  calculator.setMaximumTwoTheta(90.0);
+  std::vector<XrdCalculator::Reflection> peaks =
+    calculator.reflections(molecule);
+  ASSERT_FALSE(peaks.empty());
+
+  // Only reflections with all even or all odd indices are allowed.
+  for (size_t i = 0; i < peaks.size(); ++i) {
+    const XrdCalculator::Reflection& peak = peaks[i];
+    EXPECT_TRUE((peak.h + peak.k) % 2 == 0 && (peak.k + peak.l) % 2 == 0);
+    EXPECT_NEAR(peak.dSpacing,
+                a / std::sqrt(Real(peak.h * peak.h + peak.k * peak.k +
+                                   peak.l * peak.l)),
+                1e-8);
+    if (i > 0) {
+      EXPECT_GT(peak.twoTheta, peaks[i - 1].twoTheta);
+    }
+  }
+  EXPECT_EQ(findPeak(peaks, braggAngle(1.5406, a)), nullptr);
+
+  const XrdCalculator::Reflection* peak111 =
+    findPeak(peaks, braggAngle(1.5406, a / std::sqrt(3.0)));
+  const XrdCalculator::Reflection* peak200 =
+    findPeak(peaks, braggAngle(1.5406, a / 2.0));
+  ASSERT_NE(peak111, nullptr);
+  ASSERT_NE(peak200, nullptr);
+  EXPECT_EQ(peak111->multiplicity, 8);
+  EXPECT_EQ(peak200->multiplicity, 6);
+  EXPECT_EQ(peak200->h, 2);
+  // (200) is the strongest line of rock salt, (111) is weak since the Na and
+  // Cl contributions are out of phase.
+  EXPECT_NEAR(peak200->intensity, 100.0, 1e-10);
+  EXPECT_LT(peak111->intensity, 20.0);
+}
+
+// Relative intensities of |F|^2 times the Lorentz-polarization factor for Cu
+// K-alpha1, with F from the Cromer-Mann form factors of the International
+// Tables. Thermal motion is not included, so the high angle lines are
+// stronger than in measured patterns.
+TEST(XrdCalculatorTest, referenceIntensities)
+{
+  struct Line
+  {
+    int h2k2l2;
+    Real intensity;
+  };
+  const Real wavelength = 1.5406;
+
+  // NaCl, F = 4 (f_Na + f_Cl) for even and 4 (f_Na - f_Cl) for odd indices.
+  const Line rockSaltLines[] = { { 3, 8.139 },  { 4, 100.0 },  { 8, 65.844 },
+                                 { 11, 1.984 }, { 12, 21.229 }, { 16, 9.315 },
+                                 { 19, 0.998 }, { 20, 24.835 }, { 24, 18.42 } };
+  Molecule rockSalt;
+  const Real a = 5.6402;
+  setupRockSalt(rockSalt, a);
+  XrdCalculator calculator;
+  calculator.setWavelength(wavelength);
+  calculator.setMaximumTwoTheta(90.0);
+  std::vector<XrdCalculator::Reflection> peaks =
+    calculator.reflections(rockSalt);
+  EXPECT_EQ(peaks.size(), sizeof(rockSaltLines) / sizeof(Line));
+  for (const Line& line : rockSaltLines) {
+    const XrdCalculator::Reflection* peak =
+      findPeak(peaks, braggAngle(wavelength, a / std::sqrt(line.h2k2l2)));
+    ASSERT_NE(peak, nullptr) << line.h2k2l2;
+    EXPECT_NEAR(peak->intensity, line.intensity, 0.01) << line.h2k2l2;
+  }
+
+  // CsCl, F = f_Cs + f_Cl for even and f_Cs - f_Cl for odd h + k + l.
+  const Line cesiumChlorideLines[] = {
+    { 1, 36.665 },  { 2, 100.0 },  { 3, 12.205 }, { 4, 17.789 },
+    { 5, 17.319 },  { 6, 36.647 }, { 8, 11.269 }, { 9, 8.432 },
+    { 10, 15.564 }, { 11, 4.906 }, { 12, 3.926 }, { 13, 3.864 },
+    { 14, 19.332 }
+  };
+  Molecule cesiumChloride;
+  const Real b = 4.123;
+  setupCesiumChloride(cesiumChloride, b);
+  peaks = calculator.reflections(cesiumChloride);
+  EXPECT_EQ(peaks.size(), sizeof(cesiumChlorideLines) / sizeof(Line));
+  for (const Line& line : cesiumChlorideLines) {
+    const XrdCalculator::Reflection* peak =
+      findPeak(peaks, braggAngle(wavelength, b / std::sqrt(line.h2k2l2)));
+    ASSERT_NE(peak, nullptr) << line.h2k2l2;
+    EXPECT_NEAR(peak->intensity, line.intensity, 0.01) << line.h2k2l2;
+  }
+}
+
+TEST(XrdCalculatorTest, bodyCentered)
+{
+  const Real a = 2.87;
+  UnitCell cell(a, a, a, halfPi, halfPi, halfPi);
+  Array<unsigned char> atomicNumbers(2, 26);
+  Array<Vector3> fractional;
+  fractional.push_back(Vector3(0.0, 0.0, 0.0));
+  fractional.push_back(Vector3(0.5, 0.5, 0.5));
+
+  XrdCalculator calculator;
+  std::vector<XrdCalculator::Reflection> peaks =
+    calculator.reflections(cell, atomicNumbers, fractional);
+  ASSERT_FALSE(peaks.empty());
+  // (100) is absent, the first line is (110).
+  EXPECT_NEAR(peaks[0].twoTheta,
+              braggAngle(calculator.wavelength(), a / std::sqrt(2.0)), 1e-8);
+  EXPECT_EQ(peaks[0].multiplicity, 12);
+  for (size_t i = 0; i < peaks.size(); ++i)
+    EXPECT_EQ((peaks[i].h + peaks[i].k + peaks[i].l) % 2, 0);
+}
+
+TEST(XrdCalculatorTest, pattern)
+{
+  Molecule molecule;
+  setupRockSalt(molecule, 5.64);
+
+  XrdCalculator calculator;
+  calculator.setNumberOfPoints(1801);
+  calculator.setMaximumTwoTheta(90.0);
+  calculator.setPeakWidth(0.2);
+  XrdCalculator::Pattern pattern = calculator.pattern(molecule);
+  ASSERT_EQ(pattern.size(), static_cast<size_t>(1801));
+  EXPECT_EQ(pattern.front().first, 0.0);
+  EXPECT_NEAR(pattern.back().first, 90.0, 1e-10);
+
+  // The maximum is at the (200) line, away from the peaks it is zero.
+  size_t maximum = 0;
+  for (size_t i = 0; i < pattern.size(); ++i) {
+    if (pattern[i].second > pattern[maximum].second)
+      maximum = i;
+  }
+  EXPECT_NEAR(pattern[maximum].first,
+              braggAngle(calculator.wavelength(), 2.82), 0.05);
+  EXPECT_GT(pattern[maximum].second, 90.0);
+  EXPECT_EQ(pattern[200].second, 0.0);
+}
+
+TEST(XrdCalculatorTest, batches)
+{
+  Molecule molecule;
+  setupRockSalt(molecule, 5.64);
+  Array<Vector3> positions = molecule.atomPositions3d();
+  for (int frame = 0; frame < 4; ++frame) {
+    Array<Vector3> frameCoordinates(positions);
+    for (size_t i = 0; i < frameCoordinates.size(); ++i)
+      frameCoordinates[i] *= 1.0 + 0.01 * frame;
+    molecule.setCoordinate3d(frameCoordinates, frame);
+  }
+
+  XrdCalculator calculator;
+  calculator.setNumberOfPoints(200);
+  std::vector<XrdCalculator::Pattern> frames =
+    calculator.framePatterns(molecule);
+  ASSERT_EQ(frames.size(), static_cast<size_t>(4));
+  for (int frame = 0; frame < 4; ++frame)
+    EXPECT_EQ(frames[frame], calculator.pattern(molecule, frame));
+
+  Molecule noCell;
+  noCell.addAtom(6);
+  std::vector<const Molecule*> molecules;
+  molecules.push_back(&molecule);
+  molecules.push_back(&noCell);
+  molecules.push_back(nullptr);
+  std::vector<XrdCalculator::Pattern> patterns =
+    calculator.patterns(molecules);
+  ASSERT_EQ(patterns.size(), static_cast<size_t>(3));
+  EXPECT_EQ(patterns[0], calculator.pattern(molecule));
+  EXPECT_TRUE(patterns[1].empty());
+  EXPECT_TRUE(patterns[2].empty());
+  EXPECT_TRUE(calculator.reflections(noCell).empty());
+  EXPECT_TRUE(calculator.reflections(molecule, 4).empty());
+}
@@ -96,6 +96,28 @@ TEST(CjsonTest, bonds)
   EXPECT_EQ(bond.order(), static_cast<unsigned char>(1));
 }
 
+TEST(CjsonTest, repeatedBonds)
+{
+  // Repeated connections are added once, invalid ones are skipped, and the
+  // orders stay with the connection they were listed for.
+  const std::string cjsonStr =
+    "{\"chemical json\": 0, \"atoms\": {\"elements\": {\"number\": "
+    "[6, 6, 8]}, \"coords\": {\"3d\": [0, 0, 0, 1.5, 0, 0, 2.7, 0, 0]}}, "
+    "\"bonds\": {\"connections\": {\"index\": [0, 1, 1, 0, 1, 2, 2, 2, "
+    "1, 5]}, \"order\": [1, 3, 2, 1, 1]}}";
+  CjsonFormat cjson;
+  Molecule molecule;
+  EXPECT_TRUE(cjson.readString(cjsonStr, molecule));
+  ASSERT_EQ(molecule.atomCount(), static_cast<size_t>(3));
+  EXPECT_EQ(molecule.atom(2).position3d().x(), 2.7);
+  ASSERT_EQ(molecule.bondCount(), static_cast<size_t>(2));
+  EXPECT_EQ(molecule.bond(0).atom2().index(), static_cast<size_t>(1));
+  EXPECT_EQ(molecule.bond(0).order(), static_cast<unsigned char>(1));
+  EXPECT_EQ(molecule.bond(1).atom1().index(), static_cast<size_t>(1));
+  EXPECT_EQ(molecule.bond(1).atom2().index(), static_cast<size_t>(2));
+  EXPECT_EQ(molecule.bond(1).order(), static_cast<unsigned char>(2));
+}
+
 TEST(CjsonTest, crystal)
 {
   CjsonFormat cjson;
@@ -115,3 +115,22 @@ TEST(LammpsTest, modes)
   EXPECT_TRUE(format.isMode(FileFormat::Read | FileFormat::MultiMolecule));
   EXPECT_TRUE(format.isMode(FileFormat::MultiMolecule));
 }
+
+TEST(LammpsTest, malformedAtomCount)
+{
+  const std::string dump = "ITEM: TIMESTEP\n"
+                           "0\n"
+                           "ITEM: NUMBER OF ATOMS\n"
+                           "1000000000000\n"
+                           "ITEM: BOX BOUNDS pp pp pp\n"
+                           "0 10\n"
+                           "0 10\n"
+                           "0 10\n"
+                           "ITEM: ATOMS id type x y z\n"
+                           "1 1 0 0 0\n"
+                           "2 1 0 0 1\n";
+  LammpsTrajectoryFormat format;
+  Molecule molecule;
+  EXPECT_FALSE(format.readString(dump, molecule));
+  EXPECT_FALSE(format.error().empty());
+}
@@ -152,6 +152,56 @@ TEST(XyzTest, modes)
   EXPECT_TRUE(format.isMode(FileFormat::MultiMolecule));
 }
 
+TEST(XyzTest, malformedAtomCount)
+{
+  XyzFormat xyz;
+  Molecule molecule;
+  // Negative and corrupt counts are read errors, not allocation failures.
+  EXPECT_FALSE(xyz.readString("-1\nnegative\nH 0 0 0\n", molecule));
+  EXPECT_FALSE(xyz.error().empty());
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(0));
+
+  XyzFormat huge;
+  EXPECT_FALSE(
+    huge.readString("1000000000000\nhuge\nH 0 0 0\nH 0 0 1\n", molecule));
+  EXPECT_FALSE(huge.error().empty());
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(0));
+
+  XyzFormat truncated;
+  EXPECT_FALSE(truncated.readString("3\ntruncated\nH 0 0 0\n", molecule));
+  EXPECT_FALSE(truncated.error().empty());
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(0));
+}
+
+namespace {
+// A stream buffer that can report its position but not seek to its end, like
+// some pipes and compressed streams.
+class NoEndSeekBuffer : public std::stringbuf
+{
+public:
+  explicit NoEndSeekBuffer(const std::string& data) : std::stringbuf(data) {}
+
+protected:
+  pos_type seekoff(off_type off, std::ios_base::seekdir dir,
+                   std::ios_base::openmode which) override
+  {
+    if (dir == std::ios_base::end)
+      return pos_type(off_type(-1));
+    return std::stringbuf::seekoff(off, dir, which);
+  }
+};
+}
+
+TEST(XyzTest, readWithoutEndSeek)
+{
+  NoEndSeekBuffer buffer("2\nno end seek\nH 0 0 0\nH 0 0 0.74\n");
+  std::istream stream(&buffer);
+  XyzFormat xyz;
+  Molecule molecule;
+  EXPECT_TRUE(xyz.read(stream, molecule)) << xyz.error();
+  EXPECT_EQ(molecule.atomCount(), static_cast<size_t>(2));
+}
+
 TEST(DISABLED_XyzTest, readMulti)
 {
   XyzFormat multi;
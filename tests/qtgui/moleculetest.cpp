@@ -23,6 +23,7 @@
 #include <avogadro/qtgui/molecule.h>
 #include <avogadro/qtgui/persistentatom.h>
 #include <avogadro/qtgui/persistentbond.h>
+#include <avogadro/qtgui/rwmolecule.h>
 
 #include "utils.h"
 
@@ -35,6 +36,39 @@ using Avogadro::Core::Bond;
 using Avogadro::Core::Color3f;
 using Avogadro::Core::Mesh;
 using Avogadro::Index;
+using Avogadro::MaxIndex;
+
+namespace {
+
+// Check that the forward (unique ID -> index) and reverse (index -> unique ID)
+// maps agree for every live atom and bond.
+void checkUniqueIds(const Molecule& molecule)
+{
+  const Array<Index>& atomIds = molecule.atomUniqueIds();
+  Index liveAtoms = 0;
+  for (Index uid = 0; uid < atomIds.size(); ++uid) {
+    if (atomIds[uid] == MaxIndex)
+      continue;
+    ++liveAtoms;
+    ASSERT_LT(atomIds[uid], molecule.atomCount()) << " for atom uid " << uid;
+    EXPECT_EQ(uid, molecule.atomUniqueId(atomIds[uid])) << " for atom uid "
+                                                        << uid;
+  }
+  EXPECT_EQ(molecule.atomCount(), liveAtoms);
+
+  const Array<Index>& bondIds = molecule.bondUniqueIds();
+  Index liveBonds = 0;
+  for (Index uid = 0; uid < bondIds.size(); ++uid) {
+    if (bondIds[uid] == MaxIndex)
+      continue;
+    ++liveBonds;
+    ASSERT_LT(bondIds[uid], molecule.bondCount()) << " for bond uid " << uid;
+    EXPECT_EQ(uid, molecule.bondUniqueId(bondIds[uid])) << " for bond uid "
+                                                        << uid;
+  }
+  EXPECT_EQ(molecule.bondCount(), liveBonds);
+}
+}
 
 class MoleculeTest : public testing::Test
 {
@@ -423,6 +457,84 @@ TEST_F(MoleculeTest, uniqueBondRestore)
   EXPECT_EQ(molecule.bondByUniqueId(uid[2]).order(), 3);
 }
 
+TEST_F(MoleculeTest, uniqueIdRoundTrip)
+{
+  Molecule molecule;
+  for (unsigned char i = 0; i < 12; ++i)
+    molecule.addAtom(i % 8 + 1);
+  // A ring plus a few cross links, so removals move bonds around too.
+  for (Index i = 0; i < 12; ++i)
+    molecule.addBond(i, (i + 1) % 12, 1);
+  for (Index i = 0; i < 12; i += 3)
+    molecule.addBond(i, (i + 6) % 12, 2);
+  checkUniqueIds(molecule);
+
+  // Remove the first, a middle and the last atom; each swap-remove moves the
+  // last atom (and bond) into the freed slot.
+  Index removedFirst = molecule.atomUniqueId(Index(0));
+  Index movedLast = molecule.atomUniqueId(molecule.atomCount() - 1);
+  EXPECT_TRUE(molecule.removeAtom(Index(0)));
+  checkUniqueIds(molecule);
+  EXPECT_FALSE(molecule.atomByUniqueId(removedFirst).isValid());
+  EXPECT_EQ(0, molecule.atomByUniqueId(movedLast).index());
+
+  EXPECT_TRUE(molecule.removeAtom(Index(5)));
+  checkUniqueIds(molecule);
+  EXPECT_TRUE(molecule.removeAtom(molecule.atomCount() - 1));
+  checkUniqueIds(molecule);
+
+  // Swap-remove bonds directly as well.
+  EXPECT_TRUE(molecule.removeBond(Index(0)));
+  checkUniqueIds(molecule);
+  EXPECT_TRUE(molecule.removeBond(molecule.bondCount() - 1));
+  checkUniqueIds(molecule);
+
+  // Re-adding with the freed unique ID must restore both directions.
+  Atom restored = molecule.addAtom(6, removedFirst);
+  ASSERT_TRUE(restored.isValid());
+  EXPECT_EQ(removedFirst, molecule.atomUniqueId(restored));
+  EXPECT_TRUE(molecule.atomByUniqueId(removedFirst) == restored);
+  EXPECT_FALSE(molecule.addAtom(6, removedFirst).isValid());
+  checkUniqueIds(molecule);
+
+  // Removing every atom leaves only dead unique IDs behind.
+  while (molecule.atomCount())
+    EXPECT_TRUE(molecule.removeAtom(molecule.atomCount() / 2));
+  checkUniqueIds(molecule);
+  EXPECT_EQ(0, molecule.bondCount());
+}
+
+TEST_F(MoleculeTest, clear)
+{
+  Molecule molecule;
+  Avogadro::QtGui::RWMolecule* editable = molecule.undoMolecule();
+  editable->addAtom(6);
+  editable->addAtom(8);
+  editable->addBond(0, 1, 2);
+  ASSERT_LT(0, editable->undoStack().count());
+
+  unsigned int lastChange = Molecule::NoChange;
+  QObject::connect(&molecule, &Molecule::changed,
+                   [&](unsigned int change) { lastChange = change; });
+  molecule.clear();
+  EXPECT_EQ(0, molecule.atomCount());
+  EXPECT_EQ(0, molecule.bondCount());
+  EXPECT_TRUE(molecule.atomUniqueIds().empty());
+  EXPECT_EQ(static_cast<unsigned int>(Molecule::Atoms | Molecule::Bonds |
+                                      Molecule::Removed),
+            lastChange);
+
+  // Undoing past the clear would refer to atoms that are gone.
+  EXPECT_EQ(0, editable->undoStack().count());
+  Atom atom = molecule.addAtom(1);
+  EXPECT_EQ(0, molecule.atomUniqueId(atom));
+
+  // Molecules built from a Core::Molecule have no undo history to clear.
+  Molecule copy(static_cast<const Avogadro::Core::Molecule&>(molecule));
+  copy.clear();
+  EXPECT_EQ(0, copy.atomCount());
+}
+
 TEST_F(MoleculeTest, atomCount)
 {
   Molecule mol;
@@ -696,3 +808,79 @@ TEST_F(MoleculeTest, baseAssignment)
             b[1].atom2().atomicNumber());
   EXPECT_FALSE(qtMolecule.bondByUniqueId(2).isValid());
 }
+
+TEST_F(MoleculeTest, changeTransactions)
+{
+  typedef Molecule::IndexRanges IndexRanges;
+  Molecule molecule;
+  int changedCount = 0;
+  int rangesCount = 0;
+  unsigned int lastChange = Molecule::NoChange;
+  IndexRanges lastAtoms;
+  IndexRanges lastBonds;
+  QObject::connect(&molecule, &Molecule::changed,
+                   [&](unsigned int) { ++changedCount; });
+  QObject::connect(&molecule, &Molecule::changedRanges,
+                   [&](unsigned int change, const IndexRanges& atoms,
+                       const IndexRanges& bonds) {
+                     ++rangesCount;
+                     lastChange = change;
+                     lastAtoms = atoms;
+                     lastBonds = bonds;
+                   });
+
+  // Queued connections need the range type to be known to Qt.
+  EXPECT_NE(static_cast<int>(QMetaType::UnknownType),
+            QMetaType::type("Avogadro::QtGui::Molecule::IndexRanges"));
+
+  // Outside a transaction every change is emitted straight away.
+  molecule.emitAtomsChanged(Molecule::Modified, 2, 4);
+  EXPECT_EQ(1, changedCount);
+  EXPECT_EQ(1, rangesCount);
+  EXPECT_EQ(static_cast<unsigned int>(Molecule::Atoms | Molecule::Modified),
+            lastChange);
+  EXPECT_EQ(IndexRanges(1, std::make_pair(Index(2), Index(4))), lastAtoms);
+  EXPECT_TRUE(lastBonds.empty());
+
+  // Nested transactions only emit at the outermost endChanges(), once, with
+  // the ranges sorted and joined where they overlap or touch.
+  molecule.beginChanges();
+  molecule.emitAtomsChanged(Molecule::Modified, 7, 10);
+  molecule.beginChanges();
+  EXPECT_TRUE(molecule.inChanges());
+  molecule.emitAtomsChanged(Molecule::Modified, 0, 2);
+  molecule.emitAtomsChanged(Molecule::Modified, 5, 8);
+  molecule.emitBondsChanged(Molecule::Added, 3, 4);
+  molecule.endChanges();
+  EXPECT_TRUE(molecule.inChanges());
+  EXPECT_EQ(1, changedCount);
+  molecule.emitAtomsChanged(Molecule::Modified, 2, 3);
+  molecule.emitBondsChanged(Molecule::Added, 1, 3);
+  molecule.endChanges();
+  EXPECT_FALSE(molecule.inChanges());
+  EXPECT_EQ(2, changedCount);
+  EXPECT_EQ(2, rangesCount);
+  EXPECT_EQ(static_cast<unsigned int>(Molecule::Atoms | Molecule::Bonds |
+                                      Molecule::Modified | Molecule::Added),
+            lastChange);
+  IndexRanges atoms;
+  atoms.push_back(std::make_pair(Index(0), Index(3)));
+  atoms.push_back(std::make_pair(Index(5), Index(10)));
+  EXPECT_EQ(atoms, lastAtoms);
+  EXPECT_EQ(IndexRanges(1, std::make_pair(Index(1), Index(4))), lastBonds);
+
+  // A change without a range covers everything.
+  molecule.beginChanges();
+  molecule.emitAtomsChanged(Molecule::Modified, 4, 6);
+  molecule.emitChanged(Molecule::Atoms | Molecule::Removed);
+  molecule.endChanges();
+  EXPECT_EQ(3, rangesCount);
+  EXPECT_EQ(IndexRanges(1, std::make_pair(Index(0), Avogadro::MaxIndex)),
+            lastAtoms);
+
+  // An empty transaction emits nothing.
+  molecule.beginChanges();
+  molecule.endChanges();
+  EXPECT_EQ(3, changedCount);
+  EXPECT_EQ(3, rangesCount);
+}
@@ -26,6 +26,7 @@ using Avogadro::Core::Array;
 using Avogadro::QtGui::RWMolecule;
 using Avogadro::QtGui::Molecule;
 using Avogadro::Index;
+using Avogadro::MaxIndex;
 using Avogadro::Real;
 using Avogadro::Vector3;
 
@@ -240,6 +241,86 @@ TEST(RWMoleculeTest, removeAtom)
 #undef VALIDATE_BOND
 }
 
+namespace {
+
+// Check that the unique ID maps of the underlying molecule agree with the
+// RWMolecule lookups in both directions.
+void checkUniqueIds(const RWMolecule& mol)
+{
+  const Array<Index>& atomIds = mol.molecule().atomUniqueIds();
+  Index liveAtoms = 0;
+  for (Index uid = 0; uid < atomIds.size(); ++uid) {
+    if (atomIds[uid] == MaxIndex)
+      continue;
+    ++liveAtoms;
+    ASSERT_LT(atomIds[uid], mol.atomCount()) << " for atom uid " << uid;
+    EXPECT_EQ(uid, mol.atomUniqueId(atomIds[uid])) << " for atom uid " << uid;
+    EXPECT_EQ(atomIds[uid], mol.atomByUniqueId(uid).index());
+  }
+  EXPECT_EQ(mol.atomCount(), liveAtoms);
+
+  const Array<Index>& bondIds = mol.molecule().bondUniqueIds();
+  Index liveBonds = 0;
+  for (Index uid = 0; uid < bondIds.size(); ++uid) {
+    if (bondIds[uid] == MaxIndex)
+      continue;
+    ++liveBonds;
+    ASSERT_LT(bondIds[uid], mol.bondCount()) << " for bond uid " << uid;
+    EXPECT_EQ(uid, mol.bondUniqueId(bondIds[uid])) << " for bond uid " << uid;
+    EXPECT_EQ(bondIds[uid], mol.bondByUniqueId(uid).index());
+  }
+  EXPECT_EQ(mol.bondCount(), liveBonds);
+}
+}
+
+TEST(RWMoleculeTest, uniqueIdUndoRedo)
+{
+  Molecule m;
+  RWMolecule mol(m);
+
+  for (unsigned char i = 0; i < 10; ++i)
+    mol.addAtom(i + 1);
+  for (Index i = 0; i < 10; ++i)
+    mol.addBond(i, (i + 1) % 10, 1);
+  for (Index i = 0; i < 5; ++i)
+    mol.addBond(i, i + 5, 2);
+  checkUniqueIds(mol);
+
+  // Record the per-uid state so undo can be compared exactly.
+  const Array<Index> atomIds = m.atomUniqueIds();
+  const Array<Index> bondIds = m.bondUniqueIds();
+  const int baseIndex = mol.undoStack().index();
+
+  // Swap-removes from the front, the middle and the back.
+  EXPECT_TRUE(mol.removeAtom(0));
+  checkUniqueIds(mol);
+  EXPECT_TRUE(mol.removeAtom(4));
+  checkUniqueIds(mol);
+  EXPECT_TRUE(mol.removeBond(mol.bondCount() - 1));
+  checkUniqueIds(mol);
+  EXPECT_TRUE(mol.removeAtom(mol.atomCount() - 1));
+  checkUniqueIds(mol);
+  EXPECT_TRUE(mol.removeBond(0));
+  checkUniqueIds(mol);
+
+  const Array<Index> removedAtomIds = m.atomUniqueIds();
+  const Array<Index> removedBondIds = m.bondUniqueIds();
+
+  while (mol.undoStack().index() > baseIndex) {
+    mol.undoStack().undo();
+    checkUniqueIds(mol);
+  }
+  EXPECT_EQ(atomIds, m.atomUniqueIds());
+  EXPECT_EQ(bondIds, m.bondUniqueIds());
+
+  while (mol.undoStack().index() < mol.undoStack().count()) {
+    mol.undoStack().redo();
+    checkUniqueIds(mol);
+  }
+  EXPECT_EQ(removedAtomIds, m.atomUniqueIds());
+  EXPECT_EQ(removedBondIds, m.bondUniqueIds());
+}
+
 TEST(RWMoleculeTest, clearAtoms)
 {
   Molecule m;
@@ -423,6 +504,109 @@ TEST(RWMoleculeTest, setAtomPositions3d)
                          mol.atomPositions3d().end(), pos.begin()));
 }
 
+TEST(RWMoleculeTest, mergeSparsePositions3d)
+{
+  Molecule m;
+  RWMolecule mol(m);
+  for (int i = 0; i < 10; ++i)
+    mol.addAtom(6);
+  const Array<Vector3> orig(mol.atomPositions3d());
+  const int base = mol.undoStack().count();
+
+  // Overlapping single atom moves, as a drag produces, merge into one step
+  // that keeps the first old and the last new value of each atom.
+  mol.setInteractive(true);
+  Array<Vector3> pos(orig);
+  pos[2] = Vector3(1, 0, 0);
+  ASSERT_TRUE(mol.setAtomPositions3d(pos));
+  pos[7] = Vector3(0, 1, 0);
+  ASSERT_TRUE(mol.setAtomPositions3d(pos));
+  pos[2] = Vector3(2, 0, 0);
+  pos[5] = Vector3(0, 0, 1);
+  ASSERT_TRUE(mol.setAtomPositions3d(pos));
+  mol.setInteractive(false);
+  EXPECT_EQ(base + 1, mol.undoStack().count());
+  EXPECT_TRUE(pos == mol.atomPositions3d());
+
+  mol.undoStack().undo();
+  EXPECT_TRUE(orig == mol.atomPositions3d());
+  mol.undoStack().redo();
+  EXPECT_TRUE(pos == mol.atomPositions3d());
+
+  // Moving most atoms switches the merged step to whole arrays, recovering the
+  // old values of the sparse part, and later sparse moves are folded in.
+  mol.setInteractive(true);
+  for (Index i = 0; i < pos.size(); ++i)
+    pos[i] += Vector3(0, 0, 5);
+  pos[0] = Vector3(3, 3, 3);
+  ASSERT_TRUE(mol.setAtomPositions3d(pos));
+  pos[9] = Vector3(4, 4, 4);
+  ASSERT_TRUE(mol.setAtomPositions3d(pos));
+  mol.setInteractive(false);
+  EXPECT_EQ(base + 1, mol.undoStack().count());
+
+  mol.undoStack().undo();
+  EXPECT_TRUE(orig == mol.atomPositions3d());
+  mol.undoStack().redo();
+  EXPECT_TRUE(pos == mol.atomPositions3d());
+}
+
+TEST(RWMoleculeTest, mergePositions3dAcrossResize)
+{
+  Molecule m;
+  RWMolecule mol(m);
+  for (int i = 0; i < 4; ++i)
+    mol.addAtom(6, false);
+  ASSERT_EQ(0, mol.atomPositions3d().size());
+  const int base = mol.undoStack().count();
+
+  // Going from no positions to four is a size change, so the first step is
+  // stored whole; the sparse move after it is merged into it.
+  mol.setInteractive(true);
+  Array<Vector3> pos(4, Vector3::Zero());
+  pos[0] = Vector3(1, 1, 1);
+  ASSERT_TRUE(mol.setAtomPositions3d(pos));
+  pos[2] = Vector3(2, 2, 2);
+  ASSERT_TRUE(mol.setAtomPositions3d(pos));
+  const Array<Vector3> fourAtoms(pos);
+
+  // Adding an atom resizes the array between the moves and stops merging.
+  mol.addAtom(7);
+  pos.push_back(Vector3::Zero());
+  pos[4] = Vector3(5, 5, 5);
+  ASSERT_TRUE(mol.setAtomPositions3d(pos));
+  pos[1] = Vector3(6, 6, 6);
+  ASSERT_TRUE(mol.setAtomPositions3d(pos));
+  mol.setInteractive(false);
+  EXPECT_EQ(base + 3, mol.undoStack().count());
+  EXPECT_TRUE(pos == mol.atomPositions3d());
+
+  mol.undoStack().undo();
+  Array<Vector3> added(fourAtoms);
+  added.push_back(Vector3::Zero());
+  EXPECT_TRUE(added == mol.atomPositions3d());
+  mol.undoStack().undo();
+  EXPECT_TRUE(fourAtoms == mol.atomPositions3d());
+  mol.undoStack().undo();
+  EXPECT_EQ(0, mol.atomPositions3d().size());
+
+  mol.undoStack().redo();
+  EXPECT_TRUE(fourAtoms == mol.atomPositions3d());
+  mol.undoStack().redo();
+  mol.undoStack().redo();
+  EXPECT_TRUE(pos == mol.atomPositions3d());
+}
+
+TEST(RWMoleculeTest, undoLimit)
+{
+  Molecule m;
+  RWMolecule mol(m);
+  EXPECT_LT(0, mol.undoStack().undoLimit());
+  for (int i = 0; i < mol.undoStack().undoLimit() + 10; ++i)
+    mol.addAtom(1);
+  EXPECT_EQ(mol.undoStack().undoLimit(), mol.undoStack().count());
+}
+
 TEST(RWMoleculeTest, setAtomPosition3d)
 {
   Molecule m;
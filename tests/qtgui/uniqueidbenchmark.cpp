@@ -0,0 +1,119 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <avogadro/core/array.h>
+#include <avogadro/qtgui/molecule.h>
+#include <avogadro/qtgui/rwmolecule.h>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QString>
+#include <QtWidgets/QUndoStack>
+
+#include <cstdlib>
+#include <iostream>
+#include <utility>
+
+using Avogadro::Index;
+using Avogadro::Vector3;
+using Avogadro::Core::Array;
+using Avogadro::QtGui::Molecule;
+using Avogadro::QtGui::RWMolecule;
+using std::cout;
+using std::endl;
+
+namespace {
+
+// A chain of atomCount atoms, optionally bonded to their neighbours.
+void buildChain(Molecule& molecule, Index atomCount, bool bonded)
+{
+  Array<unsigned char> numbers(atomCount, 6);
+  Array<Vector3> positions;
+  positions.reserve(atomCount);
+  for (Index i = 0; i < atomCount; ++i)
+    positions.push_back(Vector3(1.5 * i, 0.0, 0.0));
+  molecule.addAtoms(numbers, positions);
+  if (!bonded)
+    return;
+
+  Array<std::pair<Index, Index>> pairs;
+  pairs.reserve(atomCount - 1);
+  for (Index i = 1; i < atomCount; ++i)
+    pairs.push_back(std::make_pair(i - 1, i));
+  molecule.addBonds(pairs, Array<unsigned char>(pairs.size(), 1));
+}
+
+// The atom indices to delete, from a fixed linear congruential sequence so
+// runs are comparable. Each index is valid at the time it is removed.
+Array<Index> removalOrder(Index atomCount, Index removeCount)
+{
+  Array<Index> order;
+  order.reserve(removeCount);
+  unsigned long long state = 12345;
+  for (Index i = 0; i < removeCount; ++i) {
+    state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+    order.push_back(static_cast<Index>((state >> 33) % (atomCount - i)));
+  }
+  return order;
+}
+
+void report(const char* name, const QElapsedTimer& timer, Index count)
+{
+  cout << name << ": " << timer.elapsed() << " ms, "
+       << 1.e3 * timer.elapsed() / count << " us per atom" << endl;
+}
+} // End anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  const Index atomCount = argc > 1 ? std::atol(argv[1]) : 100000;
+  const Index removeCount = argc > 2 ? std::atol(argv[2]) : 10000;
+  if (removeCount > atomCount) {
+    cout << "Cannot remove " << removeCount << " of " << atomCount << " atoms"
+         << endl;
+    return 1;
+  }
+  const Array<Index> order = removalOrder(atomCount, removeCount);
+  cout << "Removing " << removeCount << " of " << atomCount << " atoms" << endl;
+
+  // Without bonds the removal cost is the unique ID bookkeeping alone; with
+  // bonds it also includes finding and removing the bonds to each atom.
+  QElapsedTimer timer;
+  for (int bonded = 0; bonded < 2; ++bonded) {
+    cout << (bonded ? "Bonded chain" : "Unbonded atoms") << endl;
+    {
+      Molecule molecule;
+      buildChain(molecule, atomCount, bonded != 0);
+      timer.start();
+      for (Index i = 0; i < order.size(); ++i)
+        molecule.removeAtom(order[i]);
+      report("  Molecule::removeAtom", timer, removeCount);
+    }
+
+    Molecule molecule;
+    buildChain(molecule, atomCount, bonded != 0);
+    RWMolecule rwMolecule(molecule);
+    QUndoStack& stack = rwMolecule.undoStack();
+
+    timer.start();
+    stack.beginMacro(QStringLiteral("Remove Atoms"));
+    for (Index i = 0; i < order.size(); ++i)
+      rwMolecule.removeAtom(order[i]);
+    stack.endMacro();
+    report("  RWMolecule::removeAtom", timer, removeCount);
+
+    timer.start();
+    stack.undo();
+    report("  RWMolecule undo", timer, removeCount);
+
+    timer.start();
+    stack.redo();
+    report("  RWMolecule redo", timer, removeCount);
+
+    if (molecule.atomCount() != atomCount - removeCount) {
+      cout << "Unexpected atom count " << molecule.atomCount() << endl;
+      return 1;
+    }
+  }
+
+  return 0;
+}
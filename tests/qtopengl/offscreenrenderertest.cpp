@@ -0,0 +1,93 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <avogadro/qtopengl/offscreenrenderer.h>
+
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+#include <QtCore/QTemporaryDir>
+#include <QtGui/QImage>
+#include <QtWidgets/QApplication>
+
+#include <cstdlib>
+#include <iostream>
+
+using Avogadro::QtOpenGL::OffscreenRenderer;
+
+namespace {
+
+bool writeFile(const QString& fileName, const char* contents)
+{
+  QFile file(fileName);
+  if (!file.open(QFile::WriteOnly))
+    return false;
+  return file.write(contents) >= 0;
+}
+
+int fail(const char* message)
+{
+  std::cerr << message << std::endl;
+  return EXIT_FAILURE;
+}
+} // End anonymous namespace
+
+int offscreenrenderertest(int argc, char* argv[])
+{
+  QApplication app(argc, argv);
+
+  QTemporaryDir dir;
+  if (!dir.isValid())
+    return fail("Could not create a temporary directory.");
+  QDir output(dir.path());
+  const QString water = output.absoluteFilePath("water.xyz");
+  const QString methane = output.absoluteFilePath("methane.xyz");
+  const QString missing = output.absoluteFilePath("missing.xyz");
+  if (!writeFile(water, "3\nwater\n"
+                        "O 0.000 0.000 0.000\n"
+                        "H 0.757 0.586 0.000\n"
+                        "H -0.757 0.586 0.000\n") ||
+      !writeFile(methane, "5\nmethane\n"
+                          "C 0.000 0.000 0.000\n"
+                          "H 0.629 0.629 0.629\n"
+                          "H -0.629 -0.629 0.629\n"
+                          "H -0.629 0.629 -0.629\n"
+                          "H 0.629 -0.629 -0.629\n")) {
+    return fail("Could not write the input files.");
+  }
+
+  OffscreenRenderer renderer;
+  if (!renderer.initialize(64, 48)) {
+    std::cerr << renderer.error().toStdString() << std::endl;
+    return fail("Could not initialize the offscreen renderer.");
+  }
+
+  // The unreadable file is skipped and reported, the others are rendered.
+  QStringList fileNames;
+  fileNames << water << missing << methane;
+  if (renderer.renderFiles(fileNames, output.path()) != 2)
+    return fail("Expected two images to be written.");
+  if (!renderer.error().contains("missing.xyz"))
+    return fail("The unreadable file was not reported.");
+
+  QStringList images;
+  images << "water.png"
+         << "methane.png";
+  foreach (const QString& name, images) {
+    QImage image(output.absoluteFilePath(name));
+    if (image.width() != 64 || image.height() != 48)
+      return fail("A rendered image is missing or has the wrong size.");
+  }
+  if (output.exists("missing.png"))
+    return fail("An image was written for the unreadable file.");
+
+  // Later renders use the new size.
+  if (!renderer.resize(32, 32) || !renderer.isValid())
+    return fail("Could not resize the offscreen renderer.");
+  if (renderer.renderFiles(QStringList() << water, output.path()) != 1 ||
+      QImage(output.absoluteFilePath("water.png")).size() != QSize(32, 32)) {
+    return fail("The resized render is missing or has the wrong size.");
+  }
+
+  return EXIT_SUCCESS;
+}
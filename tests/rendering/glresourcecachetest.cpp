@@ -0,0 +1,143 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/vector.h>
+#include <avogadro/rendering/glresourcecache.h>
+
+using Avogadro::Rendering::GLResourceCache;
+using Avogadro::Vector3f;
+
+TEST(GLResourceCacheTest, current)
+{
+  GLResourceCache* defaultCache = GLResourceCache::current();
+  ASSERT_NE(defaultCache, nullptr);
+
+  GLResourceCache* cache = new GLResourceCache;
+  GLResourceCache* previous = GLResourceCache::setCurrent(cache);
+  EXPECT_EQ(GLResourceCache::current(), cache);
+  GLResourceCache::setCurrent(previous);
+  EXPECT_EQ(GLResourceCache::current(), defaultCache);
+
+  // Deleting the current cache restores the default one.
+  GLResourceCache::setCurrent(cache);
+  delete cache;
+  EXPECT_EQ(GLResourceCache::current(), defaultCache);
+}
+
+TEST(GLResourceCacheTest, hash)
+{
+  Vector3f a(1.f, 2.f, 3.f);
+  Vector3f b(1.f, 2.f, 3.f);
+  Vector3f c(3.f, 2.f, 1.f);
+  EXPECT_EQ(GLResourceCache::hashValue(a, 0), GLResourceCache::hashValue(b, 0));
+  EXPECT_NE(GLResourceCache::hashValue(a, 0), GLResourceCache::hashValue(c, 0));
+  uint64_t ab = GLResourceCache::hashValue(b, GLResourceCache::hashValue(a, 0));
+  uint64_t ac = GLResourceCache::hashValue(c, GLResourceCache::hashValue(a, 0));
+  EXPECT_NE(ab, ac);
+}
+
+TEST(GLResourceCacheTest, sharedBuffers)
+{
+  GLResourceCache cache;
+  int molecule1 = 0;
+  int molecule2 = 0;
+
+  bool created = false;
+  GLResourceCache::GeometryBuffers* buffers1 =
+    cache.acquireBuffers(&molecule1, "spheres", 42, created);
+  EXPECT_TRUE(created);
+
+  // The same geometry in another view shares the buffers.
+  GLResourceCache::GeometryBuffers* buffers2 =
+    cache.acquireBuffers(&molecule1, "spheres", 42, created);
+  EXPECT_FALSE(created);
+  EXPECT_EQ(buffers1, buffers2);
+  EXPECT_EQ(cache.bufferCount(), 1u);
+
+  // Different contents, kinds or molecules do not.
+  cache.acquireBuffers(&molecule1, "spheres", 43, created);
+  EXPECT_TRUE(created);
+  cache.acquireBuffers(&molecule1, "cylinders", 42, created);
+  EXPECT_TRUE(created);
+  cache.acquireBuffers(&molecule2, "spheres", 42, created);
+  EXPECT_TRUE(created);
+  EXPECT_EQ(cache.bufferCount(), 4u);
+
+  cache.releaseBuffers(buffers1);
+  EXPECT_EQ(cache.bufferCount(), 4u);
+  cache.releaseBuffers(buffers2);
+  EXPECT_EQ(cache.bufferCount(), 3u);
+}
+
+TEST(GLResourceCacheTest, bufferHandle)
+{
+  GLResourceCache cache;
+  int molecule = 0;
+  {
+    GLResourceCache::BufferHandle handle1;
+    GLResourceCache::BufferHandle handle2;
+    EXPECT_TRUE(handle1.acquire(&cache, &molecule, "mesh", 1));
+    EXPECT_FALSE(handle2.acquire(&cache, &molecule, "mesh", 1));
+    EXPECT_EQ(handle1.cache(), &cache);
+
+    // Reacquiring the same geometry keeps the buffers alive.
+    EXPECT_FALSE(handle1.acquire(&cache, &molecule, "mesh", 1));
+    EXPECT_EQ(cache.bufferCount(), 1u);
+
+    EXPECT_TRUE(handle2.acquire(&cache, &molecule, "mesh", 2));
+    EXPECT_EQ(cache.bufferCount(), 2u);
+    handle1.release();
+    EXPECT_EQ(handle1.cache(), nullptr);
+    EXPECT_EQ(cache.bufferCount(), 1u);
+  }
+  EXPECT_EQ(cache.bufferCount(), 0u);
+}
+
+namespace {
+// Counts its live instances, to check when the cache deletes resources.
+class CountedResource : public GLResourceCache::Resource
+{
+public:
+  explicit CountedResource(int& count) : m_count(count) { ++m_count; }
+  ~CountedResource() override { --m_count; }
+
+private:
+  int& m_count;
+};
+}
+
+TEST(GLResourceCacheTest, resources)
+{
+  int live = 0;
+  int owner1 = 0;
+  int owner2 = 0;
+  {
+    GLResourceCache cache;
+    EXPECT_EQ(cache.resource(&owner1, "texture"), nullptr);
+
+    CountedResource* first = new CountedResource(live);
+    cache.setResource(&owner1, "texture", first);
+    cache.setResource(&owner2, "texture", new CountedResource(live));
+    cache.setResource(&owner1, "mesh", new CountedResource(live));
+    EXPECT_EQ(cache.resource(&owner1, "texture"), first);
+    EXPECT_EQ(cache.resourceCount(), 3u);
+    EXPECT_EQ(live, 3);
+
+    // Storing the same resource again keeps it, replacing it deletes it.
+    cache.setResource(&owner1, "texture", first);
+    EXPECT_EQ(live, 3);
+    CountedResource* second = new CountedResource(live);
+    cache.setResource(&owner1, "texture", second);
+    EXPECT_EQ(cache.resource(&owner1, "texture"), second);
+    EXPECT_EQ(live, 3);
+
+    cache.setResource(&owner2, "texture", nullptr);
+    EXPECT_EQ(cache.resource(&owner2, "texture"), nullptr);
+    EXPECT_EQ(cache.resourceCount(), 2u);
+    EXPECT_EQ(live, 2);
+  }
+  // The remaining resources go with the cache.
+  EXPECT_EQ(live, 0);
+}
@@ -0,0 +1,189 @@
+/* This source file is part of the Avogadro project.
+   It is released under the 3-Clause BSD License, see "LICENSE". */
+
+#include <gtest/gtest.h>
+
+#include <avogadro/core/vector.h>
+#include <avogadro/rendering/camera.h>
+#include <avogadro/rendering/geometrynode.h>
+#include <avogadro/rendering/groupnode.h>
+#include <avogadro/rendering/povrayvisitor.h>
+#include <avogadro/rendering/spheregeometry.h>
+
+#include <sstream>
+#include <string>
+
+using Avogadro::Rendering::Camera;
+using Avogadro::Rendering::GeometryNode;
+using Avogadro::Rendering::GroupNode;
+using Avogadro::Rendering::POVRayVisitor;
+using Avogadro::Rendering::SphereGeometry;
+using Avogadro::Vector3f;
+using Avogadro::Vector3ub;
+
+namespace {
+size_t countOf(const std::string& str, const std::string& token)
+{
+  size_t count = 0;
+  for (size_t pos = str.find(token); pos != std::string::npos;
+       pos = str.find(token, pos + token.size())) {
+    ++count;
+  }
+  return count;
+}
+
+const int sceneSpheres = 20000;
+
+Vector3f sceneCenter(int i)
+{
+  return Vector3f(i * 0.5f, i * 0.25f, -i * 0.125f);
+}
+
+Vector3ub sceneColor(int i)
+{
+  return i % 2 ? Vector3ub(255, 0, 0) : Vector3ub(0, 0, 255);
+}
+
+// Enough spheres to be split over several chunks.
+void buildScene(GroupNode& root)
+{
+  GeometryNode* geometry = new GeometryNode;
+  root.addChild(geometry);
+  SphereGeometry* spheres = new SphereGeometry;
+  geometry->addDrawable(spheres);
+  for (int i = 0; i < sceneSpheres; ++i)
+    spheres->addSphere(sceneCenter(i), sceneColor(i), 1.0f);
+}
+
+// The scene written by buildScene(), formatted serially with the same stream
+// settings the visitor uses.
+std::string serialScene(bool useUnions)
+{
+  std::ostringstream out;
+  if (!useUnions) {
+    for (int i = 0; i < sceneSpheres; ++i) {
+      Vector3f c = sceneCenter(i);
+      Vector3ub color = sceneColor(i);
+      out << "sphere {\n\t<" << c[0] << ", " << c[1] << ", " << c[2]
+          << ">, " << 1.0f << "\n\tpigment { rgbt <" << color[0] / 255.0f
+          << ", " << color[1] / 255.0f << ", " << color[2] / 255.0f
+          << ", 0.0> }\n}\n";
+    }
+    return out.str();
+  }
+  // Colors are grouped in order of first appearance: blue, then red.
+  for (int first = 0; first < 2; ++first) {
+    out << "union {\n";
+    for (int i = first; i < sceneSpheres; i += 2) {
+      Vector3f c = sceneCenter(i);
+      out << "\tsphere { <" << c[0] << ", " << c[1] << ", " << c[2] << ">, "
+          << 1.0f << " }\n";
+    }
+    Vector3ub color = sceneColor(first);
+    out << "\tpigment { rgbt <" << color[0] / 255.0f << ", "
+        << color[1] / 255.0f << ", " << color[2] / 255.0f << ", 0.0> }\n}\n";
+  }
+  return out.str();
+}
+
+// The primitives of a scene, without the camera, light and default finish.
+std::string sceneBody(const std::string& scene)
+{
+  const std::string header = "metallic 0.5}\n}\n\n";
+  size_t pos = scene.find(header);
+  return pos == std::string::npos ? std::string()
+                                  : scene.substr(pos + header.size());
+}
+}
+
+TEST(POVRayVisitorTest, matchesSerialFormatting)
+{
+  GroupNode root;
+  buildScene(root);
+  Camera camera;
+
+  POVRayVisitor visitor(camera);
+  visitor.begin();
+  root.accept(visitor);
+  EXPECT_EQ(sceneBody(visitor.end()), serialScene(true));
+
+  visitor.setUseUnions(false);
+  visitor.begin();
+  root.accept(visitor);
+  EXPECT_EQ(sceneBody(visitor.end()), serialScene(false));
+}
+
+TEST(POVRayVisitorTest, smallScene)
+{
+  GroupNode root;
+  GeometryNode* geometry = new GeometryNode;
+  root.addChild(geometry);
+  SphereGeometry* spheres = new SphereGeometry;
+  geometry->addDrawable(spheres);
+  spheres->addSphere(Vector3f(0.f, 1.f, 2.f), Vector3ub(255, 0, 0), 1.5f);
+  spheres->addSphere(Vector3f(-1.f, 0.5f, 0.f), Vector3ub(255, 0, 0), 1.f);
+  Camera camera;
+
+  POVRayVisitor visitor(camera);
+  visitor.begin();
+  root.accept(visitor);
+  EXPECT_EQ(sceneBody(visitor.end()), "union {\n"
+                                      "\tsphere { <0, 1, 2>, 1.5 }\n"
+                                      "\tsphere { <-1, 0.5, 0>, 1 }\n"
+                                      "\tpigment { rgbt <1, 0, 0, 0.0> }\n"
+                                      "}\n");
+
+  visitor.setUseUnions(false);
+  visitor.begin();
+  root.accept(visitor);
+  EXPECT_EQ(sceneBody(visitor.end()), "sphere {\n"
+                                      "\t<0, 1, 2>, 1.5\n"
+                                      "\tpigment { rgbt <1, 0, 0, 0.0> }\n"
+                                      "}\n"
+                                      "sphere {\n"
+                                      "\t<-1, 0.5, 0>, 1\n"
+                                      "\tpigment { rgbt <1, 0, 0, 0.0> }\n"
+                                      "}\n");
+}
+
+TEST(POVRayVisitorTest, streamMatchesBuffer)
+{
+  GroupNode root;
+  buildScene(root);
+  Camera camera;
+
+  POVRayVisitor visitor(camera);
+  visitor.begin();
+  root.accept(visitor);
+  std::string buffered = visitor.end();
+
+  std::ostringstream stream;
+  visitor.begin(stream);
+  root.accept(visitor);
+  EXPECT_TRUE(visitor.end().empty());
+
+  EXPECT_EQ(buffered, stream.str());
+}
+
+TEST(POVRayVisitorTest, unions)
+{
+  GroupNode root;
+  buildScene(root);
+  Camera camera;
+
+  POVRayVisitor visitor(camera);
+  visitor.begin();
+  root.accept(visitor);
+  std::string scene = visitor.end();
+  EXPECT_EQ(countOf(scene, "union {"), 2u);
+  EXPECT_EQ(countOf(scene, "sphere {"), 20000u);
+  EXPECT_EQ(countOf(scene, "pigment"), 2u);
+
+  visitor.setUseUnions(false);
+  visitor.begin();
+  root.accept(visitor);
+  scene = visitor.end();
+  EXPECT_EQ(countOf(scene, "union {"), 0u);
+  EXPECT_EQ(countOf(scene, "sphere {"), 20000u);
+  EXPECT_EQ(countOf(scene, "pigment"), 20000u);
+}